@@ -2296,6 +2296,10 @@ namespace Legion {
       std::vector<FieldID>                          file_fields; // normal files
       std::map<FieldID,/*file name*/const char*>    field_files; // hdf5 files
       bool                                          local_files;
+      // For read-only normal files, map the file directly into a
+      // CPU-visible memory instead of staging the data through copies;
+      // pages are read from the file when tasks first touch them
+      bool                                          mmap_file /*= false*/;
     public:
       // Data for external instances
       LayoutConstraintSet                           constraints;
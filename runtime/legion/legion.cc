@@ -2005,8 +2005,8 @@ namespace Legion {
                                    const bool restr/*= true*/,
                                    const bool map/*= true*/)
       : resource(r), handle(h), parent(p), restricted(restr), mapped(map),
-        file_name(NULL), mode(LEGION_FILE_READ_ONLY), footprint(0),
-        static_dependences(NULL)
+        file_name(NULL), mode(LEGION_FILE_READ_ONLY), local_files(false),
+        mmap_file(false), footprint(0), static_dependences(NULL)
     //--------------------------------------------------------------------------
     {
     }
@@ -2397,6 +2397,8 @@ namespace Legion {
     {
       if (impl != NULL)
       {
+        if (Internal::implicit_context != NULL)
+          Internal::implicit_context->record_ready_poll();
         if (subscribe)
           impl->subscribe();
         const Internal::ApEvent ready = impl->get_ready_event();
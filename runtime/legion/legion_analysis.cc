@@ -5024,6 +5024,19 @@ namespace Legion {
 #endif
 #ifndef NON_AGGRESSIVE_AGGREGATORS
       std::set<RtEvent> recorded_events;
+#endif
+#ifndef LEGION_SPY
+      // Destinations that are copied to and then immediately reduced to
+      // can have both done at once by an out-of-place reduction
+      if (manage_dst_events && !trace_info.recording &&
+          !sources.empty() && !reductions.empty())
+        issue_out_of_place_reductions(trace_info, precondition,
+#ifdef NON_AGGRESSIVE_AGGREGATORS
+                                      effects
+#else
+                                      recorded_events
+#endif
+                                      );
 #endif
       // Perform updates from any sources first
       if (!sources.empty())
@@ -5413,6 +5426,84 @@ namespace Legion {
       }
     } 
 
+    //--------------------------------------------------------------------------
+    void CopyFillAggregator::issue_out_of_place_reductions(
+                                            const PhysicalTraceInfo &trace_info,
+                                            const ApEvent precondition,
+                                            std::set<RtEvent> &recorded_events)
+    //--------------------------------------------------------------------------
+    {
+      // The copy and the reduction have to be for the same requirement,
+      // otherwise they are left to be performed in place
+      if (src_index != dst_index)
+        return;
+      LegionMap<InstanceView*,FieldMaskSet<Update> > &first_reductions =
+        reductions.front();
+      for (LegionMap<InstanceView*,FieldMaskSet<Update> >::iterator sit =
+            sources.begin(); sit != sources.end(); /*nothing*/)
+      {
+        // Look for a single copy and a single reduction in the first
+        // epoch that cover exactly the same fields of the destination
+        LegionMap<InstanceView*,FieldMaskSet<Update> >::iterator rfinder =
+          first_reductions.find(sit->first);
+        if ((rfinder == first_reductions.end()) || 
+            (sit->second.size() != 1) || (rfinder->second.size() != 1) ||
+            (sit->second.get_valid_mask() != rfinder->second.get_valid_mask()))
+        {
+          sit++;
+          continue;
+        }
+        Update *copy = sit->second.begin()->first;
+        Update *reduction = rfinder->second.begin()->first;
+        std::map<InstanceView*,std::vector<CopyUpdate*> > base_copies;
+        std::map<InstanceView*,std::vector<CopyUpdate*> > red_copies;
+        std::vector<FillUpdate*> fills;
+        copy->sort_updates(base_copies, fills);
+        reduction->sort_updates(red_copies, fills);
+        if (!fills.empty())
+        {
+          sit++;
+          continue;
+        }
+        CopyUpdate *base = base_copies.begin()->second.front();
+        CopyUpdate *red = red_copies.begin()->second.front();
+        // They also have to be over the same points
+        if ((base->redop > 0) || (red->redop == 0) || 
+            (base->expr != red->expr) ||
+            base->source->is_reduction_view())
+        {
+          sit++;
+          continue;
+        }
+        PhysicalManager *dst_manager = sit->first->get_manager();
+        PhysicalManager *base_manager = base->source->get_manager();
+        PhysicalManager *red_manager = red->source->get_manager();
+        if (dst_manager->is_collective_manager() ||
+            base_manager->is_collective_manager() ||
+            red_manager->is_collective_manager() ||
+            !IndividualManager::supports_out_of_place_reduction(
+              red_manager->get_memory(), base_manager->get_memory(),
+              dst_manager->get_memory()))
+        {
+          sit++;
+          continue;
+        }
+        const ApEvent result = 
+          dst_manager->as_individual_manager()->reduce_from_base(
+              base->source, red->source, sit->first, red->redop, precondition,
+              predicate_guard, base->expr, op, dst_index,
+              sit->second.get_valid_mask(), trace_info,
+              recorded_events, effects);
+        if (result.exists() && track_events)
+          events.insert(result);
+        // These updates are done so we can remove them now
+        delete copy;
+        delete reduction;
+        first_reductions.erase(rfinder);
+        sources.erase(sit++);
+      }
+    }
+
     //--------------------------------------------------------------------------
     /*static*/ void CopyFillAggregator::handle_aggregation(const void *args)
     //--------------------------------------------------------------------------
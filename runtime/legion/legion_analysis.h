@@ -1550,6 +1550,9 @@ namespace Legion {
                         const bool manage_dst_events,
                         const bool restricted_output,
                         std::vector<ApEvent> *dst_events);
+      void issue_out_of_place_reductions(const PhysicalTraceInfo &trace_info,
+                                         const ApEvent precondition,
+                                         std::set<RtEvent> &recorded_events);
     public:
       inline void clear_update_fields(void) 
         { update_fields.clear(); } 
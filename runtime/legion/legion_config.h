@@ -340,6 +340,18 @@
 #ifndef LEGION_DEFAULT_MAX_TEMPLATES_PER_TRACE
 #define LEGION_DEFAULT_MAX_TEMPLATES_PER_TRACE  16
 #endif
+// Minimum number of operations in an automatically detected trace
+#ifndef LEGION_DEFAULT_AUTO_TRACE_MIN_LENGTH
+#define LEGION_DEFAULT_AUTO_TRACE_MIN_LENGTH  5
+#endif
+// Maximum number of operations held back while looking for traces.
+// Held back operations have not started their dependence analysis, so
+// this bounds how far automatic tracing can delay the pipeline. When the
+// window fills up the oldest half is issued untraced, so traces longer
+// than half the window may never be detected (-lg:auto_trace_window)
+#ifndef LEGION_DEFAULT_AUTO_TRACE_WINDOW
+#define LEGION_DEFAULT_AUTO_TRACE_WINDOW  128
+#endif
 // Default number of replay tasks to run in parallel
 #ifndef DEFAULT_MAX_REPLAY_PARALLELISM // For backwards compatibility
 #ifndef LEGION_DEFAULT_MAX_REPLAY_PARALLELISM
@@ -451,6 +463,18 @@
 #define LEGION_MAX_BVH_FANOUT             16
 #endif
 
+// Number of shards in the concurrent lookup tables of the region tree
+// forest (must be a power of two)
+#ifndef LEGION_LOOKUP_TABLE_SHARDS
+#define LEGION_LOOKUP_TABLE_SHARDS        64
+#endif
+// Maximum number of index space operations of each kind that the region
+// tree forest caches before evicting the least recently used ones
+// (zero means the cache is unbounded)
+#ifndef LEGION_DEFAULT_EXPRESSION_CACHE_SIZE
+#define LEGION_DEFAULT_EXPRESSION_CACHE_SIZE 0
+#endif
+
 // Maximum number of non-replayable templates before warnings
 #ifndef LEGION_NON_REPLAYABLE_WARNING
 #define LEGION_NON_REPLAYABLE_WARNING     5
@@ -1330,6 +1354,7 @@ typedef enum legion_error_t {
   ERROR_INVALID_OUTPUT_REGION_FIELD = 624,
   ERROR_FUTURE_SIZE_BOUNDS_EXCEEDED = 625,
   ERROR_ILLEGAL_CONCURRENT_EXECUTION = 626,
+  ERROR_ATTACH_MMAP_FILE_MODE = 627,
 
 
 
@@ -2838,7 +2838,9 @@ namespace Legion {
         deferred_commit_comp_queue(CompletionQueue::NO_QUEUE),
         post_task_comp_queue(CompletionQueue::NO_QUEUE), 
         current_trace(NULL), previous_trace(NULL),
-        physical_trace_replay_status(0), valid_wait_event(false), 
+        physical_trace_replay_status(0), auto_tracer(NULL),
+        auto_trace_next_index(SIZE_MAX), issuing_auto_trace(false),
+        valid_wait_event(false), 
         outstanding_subtasks(0), pending_subtasks(0), pending_frames(0),
         currently_active_context(false), current_mapping_fence(NULL),
         mapping_fence_gen(0), current_mapping_fence_index(0), 
@@ -2864,6 +2866,13 @@ namespace Legion {
       context_configuration.max_templates_per_trace =
         LEGION_DEFAULT_MAX_TEMPLATES_PER_TRACE;
       context_configuration.mutable_priority = false;
+      // Automatic tracing relies on seeing operations in program order
+      // before they are issued so it does not work with in-order execution
+      // and it would perturb the context indexes logged by Legion Spy
+      if (runtime->auto_trace && !remote_context && !runtime->no_tracing &&
+          !runtime->program_order_execution && !runtime->legion_spy_enabled)
+        auto_tracer = new AutoTraceDetector(this, 
+            runtime->auto_trace_min_length, runtime->auto_trace_window);
       // If we have an owner, clone our local fields from its context
       // and also compute the coordinates for this context in the task tree
       if (owner != NULL)
@@ -2903,6 +2912,8 @@ namespace Legion {
     InnerContext::~InnerContext(void)
     //--------------------------------------------------------------------------
     {
+      if (auto_tracer != NULL)
+        delete auto_tracer;
       if (!remote_instances.empty())
         free_remote_contexts();
       if (ready_comp_queue.exists())
@@ -6413,7 +6424,12 @@ namespace Legion {
       AutoProvenance provenance(launcher.provenance);
       // Quick out for predicate false
       if (launcher.predicate == Predicate::FALSE_PRED)
+      {
+        // Anything held back for automatic tracing has to be issued
+        // before this resolves so it cannot get ahead of it
+        flush_auto_trace_operations();
         return predicate_task_false(launcher, provenance);
+      }
       IndividualTask *task = runtime->get_available_individual_task();
       Future result = task->initialize_task(this, launcher, provenance,
                                             true/*track parent*/,
@@ -6460,8 +6476,13 @@ namespace Legion {
       }
       // Quick out for predicate false
       if (launcher.predicate == Predicate::FALSE_PRED)
+      {
+        // Anything held back for automatic tracing has to be issued
+        // before this resolves so it cannot get ahead of it
+        flush_auto_trace_operations();
         return predicate_index_task_false(total_children_count++, launcher,
                                           provenance);
+      }
       IndexSpace launch_space = launcher.launch_space;
       if (!launch_space.exists())
         launch_space = find_index_launch_space(launcher.launch_domain,
@@ -6518,7 +6539,12 @@ namespace Legion {
       }
       // Quick out for predicate false
       if (launcher.predicate == Predicate::FALSE_PRED)
+      {
+        // Anything held back for automatic tracing has to be issued
+        // before this resolves so it cannot get ahead of it
+        flush_auto_trace_operations();
         return predicate_index_task_reduce_false(launcher, provenance);
+      }
       IndexSpace launch_space = launcher.launch_space;
       if (!launch_space.exists())
         launch_space = find_index_launch_space(launcher.launch_domain,
@@ -7484,6 +7510,9 @@ namespace Legion {
     void InnerContext::progress_unordered_operations(void)
     //--------------------------------------------------------------------------
     {
+      // Issue anything held back for automatic tracing first so that the
+      // unordered operations do not get ahead of it
+      flush_auto_trace_operations();
       RtEvent precondition;
       Operation *op = NULL;
       {
@@ -7752,6 +7781,8 @@ namespace Legion {
     void InnerContext::perform_window_wait(void)
     //--------------------------------------------------------------------------
     {
+      // Operations we are holding back might be the ones we need to drain
+      flush_auto_trace_operations();
       RtEvent wait_event;
       // Take the context lock in exclusive mode
       {
@@ -7870,6 +7901,10 @@ namespace Legion {
                                                bool outermost)
     //--------------------------------------------------------------------------
     {
+      // See if this is an operation to hold back for automatic tracing
+      if (!unordered && !auto_trace_reserved.empty() &&
+          buffer_auto_trace_operation(op))
+        return true;
       // Launch the task to perform the prepipeline stage for the operation
       if (op->has_prepipeline_stage())
         add_to_prepipeline_queue(op);
@@ -8601,10 +8636,11 @@ namespace Legion {
                       const std::vector<StaticDependence> *dependences)
     //--------------------------------------------------------------------------
     {
+      const size_t result = (auto_tracer != NULL) ?
+        reserve_auto_trace_index(op) : total_children_count++;
       // If we are performing a trace mark that the child has a trace
       if (current_trace != NULL)
         op->set_trace(current_trace, dependences);
-      size_t result = total_children_count++;
       const size_t outstanding_count =
         outstanding_children_count.fetch_add(1) + 1;
       // Only need to check if we are not tracing by frames
@@ -8637,6 +8673,10 @@ namespace Legion {
       // If we're still in the middle of a trace then don't do any insertions
       if (current_trace != NULL)
         return;
+      // Same thing if we are holding back operations for automatic tracing
+      // since they already have older context indexes
+      if (!end_task && is_holding_auto_trace_operations())
+        return;
       // We need the child op lock here so we can add these to this
       // list of executing children as well
       AutoLock child_lock(child_op_lock);
@@ -9745,6 +9785,201 @@ namespace Legion {
     {
       if (current_trace != NULL)
         current_trace->record_blocking_call();
+      else
+        // The application might be waiting on an operation that we
+        // are still holding back looking for an automatic trace
+        flush_auto_trace_operations();
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::record_ready_poll(void)
+    //--------------------------------------------------------------------------
+    {
+      // The application might be spinning until an operation that we are
+      // still holding back for an automatic trace is ready, so issue them
+      // on every poll to make sure it makes progress
+      if (current_trace == NULL)
+        flush_auto_trace_operations();
+    }
+
+    //--------------------------------------------------------------------------
+    size_t InnerContext::reserve_auto_trace_index(Operation *op)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(auto_tracer != NULL);
+#endif
+      // Trace operations that we are issuing for an automatic trace 
+      // get the index that we set aside for them
+      if (auto_trace_next_index != SIZE_MAX)
+      {
+        const size_t result = auto_trace_next_index;
+        auto_trace_next_index = SIZE_MAX;
+        return result;
+      }
+      if ((current_trace == NULL) && AutoTraceDetector::is_traceable(op))
+      {
+        auto_trace_reserved.push_back(op);
+        return total_children_count++;
+      }
+      // Anything else has to come after all the operations we are holding
+      flush_auto_trace_operations();
+      return total_children_count++;
+    }
+
+    //--------------------------------------------------------------------------
+    bool InnerContext::buffer_auto_trace_operation(Operation *op)
+    //--------------------------------------------------------------------------
+    {
+      std::vector<Operation*>::iterator finder = 
+        std::find(auto_trace_reserved.begin(), auto_trace_reserved.end(), op);
+      if (finder == auto_trace_reserved.end())
+        return false;
+      auto_trace_reserved.erase(finder);
+      // Tasks do not know about their output regions until after they
+      // are registered so check again now that the operation is complete
+      if (!AutoTraceDetector::is_traceable(op))
+      {
+        flush_auto_trace_operations();
+        return false;
+      }
+      // Unordered operations get the next context index when they are
+      // inserted so we cannot keep holding operations back while there
+      // are some waiting or they would end up ahead of older operations
+      if (has_pending_unordered_operations())
+      {
+        flush_auto_trace_operations();
+        return false;
+      }
+      AutoTraceDetector::Match match;
+      if (auto_tracer->record_operation(op, match))
+      {
+        issue_untraced_operations(match.start);
+        // The trace complete operation takes the next context index so
+        // we can only issue the trace if nothing else has been registered
+        // since the last operation in the trace
+        if (auto_trace_reserved.empty())
+          issue_auto_trace(match.tid, match.length);
+        else
+          issue_untraced_operations(match.length);
+      }
+      else if (auto_tracer->full())
+        issue_untraced_operations(auto_tracer->size() / 2);
+      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::flush_auto_trace_operations(void)
+    //--------------------------------------------------------------------------
+    {
+      if ((auto_tracer != NULL) && !auto_tracer->empty())
+        issue_untraced_operations(auto_tracer->size());
+    }
+
+    //--------------------------------------------------------------------------
+    bool InnerContext::is_holding_auto_trace_operations(void) const
+    //--------------------------------------------------------------------------
+    {
+      if (auto_tracer == NULL)
+        return false;
+      return (issuing_auto_trace || !auto_tracer->empty());
+    }
+
+    //--------------------------------------------------------------------------
+    bool InnerContext::has_pending_unordered_operations(void)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock d_lock(dependence_lock);
+      return !unordered_ops.empty();
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::issue_untraced_operations(size_t count)
+    //--------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < count; idx++)
+        add_to_dependence_queue(auto_tracer->pop_operation(false/*traced*/));
+    }
+
+    //--------------------------------------------------------------------------
+    void InnerContext::issue_auto_trace(TraceID tid, size_t count)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(current_trace == NULL);
+      assert(count == auto_tracer->size());
+      assert(count > 0);
+#endif
+      // This mirrors begin_trace and end_trace except that the operations
+      // in the trace were registered before we knew they would be traced
+      const bool logical_only = runtime->no_physical_tracing;
+      std::map<TraceID,LegionTrace*>::const_iterator finder = traces.find(tid);
+      LegionTrace *trace = NULL;
+      if (finder == traces.end())
+      {
+        trace = new DynamicTrace(tid, this, logical_only, NULL/*provenance*/);
+        traces[tid] = trace;
+        trace->add_reference();
+      }
+      else
+        trace = finder->second;
+      trace->clear_blocking_call();
+      // Pull the operations out of the buffer first so that any flushes
+      // while issuing the trace operations do not issue them untraced
+      std::vector<Operation*> traced_ops(count);
+      for (unsigned idx = 0; idx < count; idx++)
+        traced_ops[idx] = auto_tracer->pop_operation(true/*traced*/);
+#ifdef DEBUG_LEGION
+      assert(auto_trace_reserved.empty());
+      assert((traced_ops.back()->get_ctx_index() + 1) == total_children_count);
+#endif
+      // The begin and replay operations share the context index of the
+      // first operation in the trace. Fence analysis only considers
+      // operations with strictly smaller indexes so they still cover
+      // everything issued before the trace and nothing inside of it.
+      const size_t first_index = traced_ops.front()->get_ctx_index();
+      auto_trace_next_index = first_index;
+      // Unordered operations cannot be inserted until the whole trace
+      // has been issued since they would get newer context indexes
+      issuing_auto_trace = true;
+      TraceBeginOp *begin = runtime->get_available_begin_op();
+      begin->initialize_begin(this, trace, NULL/*provenance*/);
+      add_to_dependence_queue(begin);
+      if (!logical_only)
+      {
+        auto_trace_next_index = first_index;
+        TraceReplayOp *replay = runtime->get_available_replay_op();
+        replay->initialize_replay(this, trace, NULL/*provenance*/);
+        physical_trace_replay_status.store(replay->get_mapped_event().id);
+        add_to_dependence_queue(replay);
+      }
+      current_trace = trace;
+      for (std::vector<Operation*>::const_iterator it =
+            traced_ops.begin(); it != traced_ops.end(); it++)
+      {
+        (*it)->set_trace(trace, NULL/*dependences*/);
+        add_to_dependence_queue(*it);
+      }
+      issuing_auto_trace = false;
+      // The complete operation gets the next index like anything else
+      // since the traced operations were the last ones to be registered
+      if (trace->is_fixed())
+      {
+        TraceCompleteOp *complete_op = runtime->get_available_trace_op();
+        complete_op->initialize_complete(this, trace->has_blocking_call(),
+                                         NULL/*provenance*/);
+        current_trace = NULL;
+        add_to_dependence_queue(complete_op);
+      }
+      else
+      {
+        TraceCaptureOp *capture_op = runtime->get_available_capture_op();
+        capture_op->initialize_capture(this, trace->has_blocking_call(),
+                                       false/*deprecated*/, NULL/*provenance*/);
+        trace->fix_trace(NULL/*provenance*/);
+        current_trace = NULL;
+        add_to_dependence_queue(capture_op);
+      }
     }
 
     //--------------------------------------------------------------------------
@@ -10895,6 +11130,11 @@ namespace Legion {
                                 const void *metadataptr, size_t metadatasize)
     //--------------------------------------------------------------------------
     {
+      if (auto_tracer != NULL)
+      {
+        flush_auto_trace_operations();
+        auto_tracer->report_statistics();
+      }
       // See if we have any local regions or fields that need to be deallocated
       std::vector<LogicalRegion> local_regions_to_delete;
       std::map<FieldSpace,std::set<FieldID> > local_fields_to_delete;
@@ -11736,6 +11976,13 @@ namespace Legion {
         unordered_ops_epoch(MIN_UNORDERED_OPS_EPOCH)
     //--------------------------------------------------------------------------
     {
+      // Automatic tracing would need every shard to agree on the traces
+      // that it finds so we do not support it for replicated contexts yet
+      if (auto_tracer != NULL)
+      {
+        delete auto_tracer;
+        auto_tracer = NULL;
+      }
       // Get our allocation barriers
 #ifdef DEBUG_LEGION_COLLECTIVES
       collective_guard_reentrant = false;
@@ -18350,6 +18597,7 @@ namespace Legion {
           hasher.hash(launcher.file_name, strlen(launcher.file_name), 
                       "file_name");
         hasher.hash(launcher.mode, "mode");
+        hasher.hash(launcher.mmap_file, "mmap_file");
         for (std::vector<FieldID>::const_iterator it = 
               launcher.file_fields.begin(); it != 
               launcher.file_fields.end(); it++)
@@ -23439,6 +23687,12 @@ namespace Legion {
     {
     }
 
+    //--------------------------------------------------------------------------
+    void LeafContext::record_ready_poll(void)
+    //--------------------------------------------------------------------------
+    {
+    }
+
     //--------------------------------------------------------------------------
     void LeafContext::issue_frame(FrameOp *frame, ApEvent frame_termination)
     //--------------------------------------------------------------------------
@@ -548,6 +548,7 @@ namespace Legion {
       virtual void invalidate_trace_cache(LegionTrace *trace,
                                           Operation *invalidator) = 0;
       virtual void record_blocking_call(void) = 0;
+      virtual void record_ready_poll(void) = 0;
     public:
       virtual void issue_frame(FrameOp *frame, ApEvent frame_termination) = 0;
       virtual void perform_frame_issue(FrameOp *frame, 
@@ -1632,6 +1633,16 @@ namespace Legion {
       virtual void invalidate_trace_cache(LegionTrace *trace,
                                           Operation *invalidator);
       virtual void record_blocking_call(void);
+      virtual void record_ready_poll(void);
+    protected:
+      // Automatic trace detection (-lg:auto_trace)
+      size_t reserve_auto_trace_index(Operation *op);
+      bool buffer_auto_trace_operation(Operation *op);
+      void flush_auto_trace_operations(void);
+      void issue_untraced_operations(size_t count);
+      void issue_auto_trace(TraceID tid, size_t count);
+      bool is_holding_auto_trace_operations(void) const;
+      bool has_pending_unordered_operations(void);
     public:
       virtual void issue_frame(FrameOp *frame, ApEvent frame_termination);
       virtual void perform_frame_issue(FrameOp *frame, 
@@ -1905,6 +1916,15 @@ namespace Legion {
       // ID is either 0 for not replaying, 1 for replaying, or
       // the event id for signaling that the status isn't ready 
       std::atomic<realm_id_t> physical_trace_replay_status;
+      // Operations held back while looking for automatic traces along
+      // with the traceable operations that have been registered but not
+      // yet added to the dependence queue
+      AutoTraceDetector *auto_tracer;
+      std::vector<Operation*> auto_trace_reserved;
+      // Context index to hand out to the next trace operation we issue
+      // for an automatic trace
+      size_t auto_trace_next_index;
+      bool issuing_auto_trace;
       bool valid_wait_event;
       RtUserEvent window_wait;
       std::deque<ApEvent> frame_events;
@@ -3723,6 +3743,7 @@ namespace Legion {
       virtual void invalidate_trace_cache(LegionTrace *trace,
                                           Operation *invalidator);
       virtual void record_blocking_call(void);
+      virtual void record_ready_poll(void);
     public:
       virtual void issue_frame(FrameOp *frame, ApEvent frame_termination);
       virtual void perform_frame_issue(FrameOp *frame, 
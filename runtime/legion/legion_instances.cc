@@ -2615,6 +2615,123 @@ namespace Legion {
       return result;
     }
 
+    //--------------------------------------------------------------------------
+    ApEvent IndividualManager::reduce_from_base(InstanceView *base_view,
+                                         InstanceView *red_view,
+                                         InstanceView *dst_view,
+                                         ReductionOpID redop,
+                                         ApEvent precondition,
+                                         PredEvent predicate_guard,
+                                         IndexSpaceExpression *copy_expression,
+                                         Operation *op, const unsigned index,
+                                         const FieldMask &copy_mask,
+                                         const PhysicalTraceInfo &trace_info,
+                                         std::set<RtEvent> &recorded_events,
+                                         std::set<RtEvent> &applied_events)
+    //--------------------------------------------------------------------------
+    {
+      PhysicalManager *base_manager = base_view->get_manager();
+      PhysicalManager *red_manager = red_view->get_manager();
+#ifdef DEBUG_LEGION
+      assert(dst_view->manager == this);
+      assert(red_manager->is_reduction_manager());
+      assert(!base_manager->is_reduction_manager());
+      assert(!trace_info.recording);
+      assert(redop > 0);
+      assert(supports_out_of_place_reduction(red_manager->get_memory(),
+                                    base_manager->get_memory(), get_memory()));
+#endif
+      // The destination is overwritten rather than reduced to so this
+      // looks like a normal copy to the destination and two readers
+      const UniqueID op_id = op->get_unique_op_id();
+      std::set<ApEvent> preconditions;
+      if (precondition.exists())
+        preconditions.insert(precondition);
+      const ApEvent dst_pre = dst_view->find_copy_preconditions(
+          false/*reading*/, 0/*redop*/, copy_mask, copy_expression,
+          op_id, index, applied_events, trace_info);
+      if (dst_pre.exists())
+        preconditions.insert(dst_pre);
+      const ApEvent base_pre = base_view->find_copy_preconditions(
+          true/*reading*/, 0/*redop*/, copy_mask, copy_expression,
+          op_id, index, applied_events, trace_info);
+      if (base_pre.exists())
+        preconditions.insert(base_pre);
+      const ApEvent red_pre = red_view->find_copy_preconditions(
+          true/*reading*/, 0/*redop*/, copy_mask, copy_expression,
+          op_id, index, applied_events, trace_info);
+      if (red_pre.exists())
+        preconditions.insert(red_pre);
+      if (!preconditions.empty())
+        precondition = Runtime::merge_events(&trace_info, preconditions);
+      // All three instances iterate the fields in the same order
+      std::vector<CopySrcDstField> dst_fields, base_fields, src_fields;
+      compute_copy_offsets(copy_mask, dst_fields);
+      base_manager->compute_copy_offsets(copy_mask, base_fields);
+      red_manager->compute_copy_offsets(copy_mask, src_fields);
+#ifdef DEBUG_LEGION
+      assert(dst_fields.size() == base_fields.size());
+      assert(dst_fields.size() == src_fields.size());
+#endif
+      // No reservations are needed because nobody else can be reducing
+      // to the destination while we're writing it
+      for (unsigned idx = 0; idx < dst_fields.size(); idx++)
+        dst_fields[idx].set_redop(redop, false/*fold*/, true/*exclusive*/)
+          .set_redop_base(base_fields[idx].inst, base_fields[idx].field_id,
+                          base_fields[idx].subfield_offset);
+      const std::vector<Reservation> no_reservations;
+      const ApEvent result = copy_expression->issue_copy(op, trace_info,
+                                         dst_fields, src_fields,
+                                         no_reservations,
+#ifdef LEGION_SPY
+                                         red_manager->tree_id, tree_id,
+#endif
+                                         precondition, predicate_guard,
+                                         red_manager->get_unique_event(),
+                                         unique_event);
+      if (result.exists())
+      {
+        base_view->add_copy_user(true/*reading*/, 0/*redop*/, result,
+            copy_mask, copy_expression, op_id, index,
+            recorded_events, trace_info.recording, runtime->address_space);
+        red_view->add_copy_user(true/*reading*/, 0/*redop*/, result,
+            copy_mask, copy_expression, op_id, index,
+            recorded_events, trace_info.recording, runtime->address_space);
+        dst_view->add_copy_user(false/*reading*/, 0/*redop*/, result,
+            copy_mask, copy_expression, op_id, index,
+            recorded_events, trace_info.recording, runtime->address_space);
+      }
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ bool IndividualManager::supports_out_of_place_reduction(
+                     Memory red_memory, Memory base_memory, Memory dst_memory)
+    //--------------------------------------------------------------------------
+    {
+      // Realm performs out-of-place reductions on the CPU of the node
+      // that owns the destination and needs direct access to both the
+      // reduction instance and the base
+      if ((red_memory.address_space() != dst_memory.address_space()) ||
+          (base_memory.address_space() != dst_memory.address_space()))
+        return false;
+      const Memory memories[3] = { red_memory, base_memory, dst_memory };
+      for (unsigned idx = 0; idx < 3; idx++)
+      {
+        switch (memories[idx].kind())
+        {
+          case Memory::SYSTEM_MEM:
+          case Memory::REGDMA_MEM:
+          case Memory::SOCKET_MEM:
+          case Memory::Z_COPY_MEM:
+            break;
+          default:
+            return false;
+        }
+      }
+      return true;
+    }
+
     //--------------------------------------------------------------------------
     void IndividualManager::compute_copy_offsets(const FieldMask &copy_mask,
                                            std::vector<CopySrcDstField> &fields)
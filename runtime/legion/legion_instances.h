@@ -563,6 +563,23 @@ namespace Legion {
                                 const bool copy_restricted);
       virtual void compute_copy_offsets(const FieldMask &copy_mask,
                              std::vector<CopySrcDstField> &fields);
+      // Overwrite the destination with the result of applying the
+      // reduction instance to the base instance in a single copy
+      ApEvent reduce_from_base(InstanceView *base_view,
+                               InstanceView *red_view,
+                               InstanceView *dst_view,
+                               ReductionOpID redop,
+                               ApEvent precondition,
+                               PredEvent predicate_guard,
+                               IndexSpaceExpression *expression,
+                               Operation *op, const unsigned index,
+                               const FieldMask &copy_mask,
+                               const PhysicalTraceInfo &trace_info,
+                               std::set<RtEvent> &recorded_events,
+                               std::set<RtEvent> &applied_events);
+      static bool supports_out_of_place_reduction(Memory red_memory,
+                                                  Memory base_memory,
+                                                  Memory dst_memory);
     public:
       void initialize_across_helper(CopyAcrossHelper *across_helper,
                                     const FieldMask &mask,
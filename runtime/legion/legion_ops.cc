@@ -20143,6 +20143,14 @@ namespace Legion {
                   launcher.file_fields.end(); it++)
               requirement.add_field(*it);
             file_mode = launcher.mode;       
+            mmap_file = launcher.mmap_file;
+            if (mmap_file && (file_mode != LEGION_FILE_READ_ONLY))
+              REPORT_LEGION_ERROR(ERROR_ATTACH_MMAP_FILE_MODE,
+                              "Invalid file attach operation in task %s "
+                              "(ID %lld). Only files attached with "
+                              "LEGION_FILE_READ_ONLY can be memory mapped.",
+                              parent_ctx->get_task_name(),
+                              parent_ctx->get_unique_id())
             break;
           }
         case LEGION_EXTERNAL_HDF5_FILE:
@@ -20291,6 +20299,7 @@ namespace Legion {
       termination_event = ApEvent::NO_AP_EVENT;
       restricted = true;
       local_files = false;
+      mmap_file = false;
     }
 
     //--------------------------------------------------------------------------
@@ -20553,9 +20562,11 @@ namespace Legion {
 	      field_ids[idx] = *it;
             }
             result = node->create_file_instance(file_name, field_ids, sizes, 
-                                                file_mode, ready_event);
-            constraints.specialized_constraint = 
-              SpecializedConstraint(LEGION_GENERIC_FILE_SPECIALIZE);           
+                                        file_mode, mmap_file, ready_event);
+            // mapped files are normal affine instances in a CPU memory
+            constraints.specialized_constraint = mmap_file ?
+              SpecializedConstraint(LEGION_AFFINE_SPECIALIZE) :
+              SpecializedConstraint(LEGION_GENERIC_FILE_SPECIALIZE);
             constraints.field_constraint = 
               FieldConstraint(requirement.privilege_fields, 
                               false/*contiguous*/, false/*inorder*/);
@@ -3880,6 +3880,7 @@ namespace Legion {
       bool restricted;
       bool mapping;
       bool local_files;
+      bool mmap_file;
     };
 
     /**
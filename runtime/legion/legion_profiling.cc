@@ -1506,8 +1506,37 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(target_proc.exists());
 #endif
-      if (!strcmp(serializer_type, "binary")) 
-      {
+      // The binary serializer optionally takes a compression kind as
+      // -lg:serializer binary:<gzip|none>, by default it compresses
+      // whenever we have zlib support
+      const char *compression_name = NULL;
+      if (!strncmp(serializer_type, "binary:", 7))
+        compression_name = serializer_type + 7;
+      if (!strcmp(serializer_type, "binary") || (compression_name != NULL))
+      {
+#ifdef LEGION_USE_ZLIB
+        LegionProfBinarySerializer::CompressionKind compression =
+          LegionProfBinarySerializer::GZIP_COMPRESSION;
+#else
+        LegionProfBinarySerializer::CompressionKind compression =
+          LegionProfBinarySerializer::NO_COMPRESSION;
+#endif
+        if (compression_name != NULL)
+        {
+          if (!strcmp(compression_name, "none"))
+            compression = LegionProfBinarySerializer::NO_COMPRESSION;
+#ifdef LEGION_USE_ZLIB
+          else if (!strcmp(compression_name, "gzip"))
+            compression = LegionProfBinarySerializer::GZIP_COMPRESSION;
+#endif
+          else
+            REPORT_LEGION_ERROR(ERROR_INVALID_PROFILER_SERIALIZER,
+                "Invalid compression for binary serializer (%s), must be "
+#ifdef LEGION_USE_ZLIB
+                "'gzip' or "
+#endif
+                "'none'\n", compression_name)
+        }
         if (prof_logfile == NULL) 
           REPORT_LEGION_ERROR(ERROR_UNKNOWN_PROFILER_OPTION,
               "ERROR: Please specify -lg:prof_logfile "
@@ -1521,7 +1550,8 @@ namespace Legion {
             REPORT_LEGION_ERROR(ERROR_MISSING_PROFILER_OPTION,
                 "ERROR: The logfile name must contain '%%' "
                 "which will be replaced with the node id\n")
-          serializer = new LegionProfBinarySerializer(filename.c_str());
+          serializer = new LegionProfBinarySerializer(runtime, filename,
+                                         compression, footprint_threshold);
         }
         else
         {
@@ -1529,9 +1559,28 @@ namespace Legion {
           std::stringstream ss;
           ss << filename.substr(0, pct) << target.address_space() <<
                 filename.substr(pct + 1);
-          serializer = new LegionProfBinarySerializer(ss.str());
+          serializer = new LegionProfBinarySerializer(runtime, ss.str(),
+                                         compression, footprint_threshold);
         }
       } 
+      else if (!strcmp(serializer_type, "summary"))
+      {
+        if (prof_logfile == NULL) 
+          REPORT_LEGION_ERROR(ERROR_UNKNOWN_PROFILER_OPTION,
+              "ERROR: Please specify -lg:prof_logfile "
+              "<logfile_name> when running with -lg:serializer summary")
+        // Only node 0 writes the aggregated summary
+        std::string filename(prof_logfile);
+        size_t pct = filename.find_first_of('%', 0);
+        if (pct != std::string::npos)
+        {
+          std::stringstream ss;
+          ss << filename.substr(0, pct) << target.address_space() <<
+                filename.substr(pct + 1);
+          filename = ss.str();
+        }
+        serializer = new LegionProfSummarySerializer(runtime, filename);
+      }
       else if (!strcmp(serializer_type, "ascii")) 
       {
         if (prof_logfile != NULL) 
@@ -1544,8 +1593,9 @@ namespace Legion {
       } 
       else 
         REPORT_LEGION_ERROR(ERROR_INVALID_PROFILER_SERIALIZER,
-                "Invalid serializer (%s), must be 'binary' "
-                "or 'ascii'\n", serializer_type)
+                "Invalid serializer (%s), must be 'binary', "
+                "'binary:<compression>', 'summary' or 'ascii'\n",
+                serializer_type)
 
       for (unsigned idx = 0; idx < num_meta_tasks; idx++)
       {
@@ -2346,6 +2396,19 @@ namespace Legion {
             instances.begin(); it != instances.end(); it++) {
         (*it)->dump_state(serializer);
       }  
+      serializer->flush();
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfiler::handle_remote_summary(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      LegionProfSummarySerializer *summary = 
+        dynamic_cast<LegionProfSummarySerializer*>(serializer);
+#ifdef DEBUG_LEGION
+      assert(summary != NULL);
+#endif
+      summary->handle_remote_summary(derez);
     }
 
     //--------------------------------------------------------------------------
@@ -2474,7 +2537,14 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       size_t footprint = total_memory_footprint.fetch_add(diff) + diff;
-      if (footprint > output_footprint_threshold)
+      // Aggregating serializers fold every record in as soon as it arrives
+      // so we never hold on to more than the records of a single call
+      if (serializer->is_aggregating())
+      {
+        diff = inst->dump_inter(serializer, double(1 << 20));
+        total_memory_footprint.fetch_sub(diff);
+      }
+      else if (footprint > output_footprint_threshold)
       {
         // An important bit of logic here, if we're over the threshold then
         // we want to have a little bit of a feedback loop so the more over
@@ -598,6 +598,8 @@ namespace Legion {
     public:
       // Dump all the results
       void finalize(void);
+      // Aggregate a summary sent from a remote node in summary mode
+      void handle_remote_summary(Deserializer &derez);
     public:
       void record_instance_creation(PhysicalInstance inst, Memory memory,
                                     UniqueID op_id, timestamp_t create);
@@ -15,16 +15,127 @@ namespace Legion {
     extern Realm::Logger log_prof;
 
     //--------------------------------------------------------------------------
-    LegionProfBinarySerializer::LegionProfBinarySerializer(std::string filename)
+    LegionProfBinarySerializer::LegionProfBinarySerializer(Runtime *rt,
+                     std::string filename, CompressionKind kind, size_t thresh)
+      : runtime(rt), compression(kind), footprint_threshold(thresh),
+        chunk((char*)malloc(CHUNK_SIZE)), chunk_used(0), pending_bytes(0)
     //--------------------------------------------------------------------------
     {
-      f = lp_fopen(filename, "wb");
+      f = fopen(filename.c_str(), "wb");
       if (!f)
         REPORT_LEGION_ERROR(ERROR_INVALID_PROFILER_FILE,
             "Unable to open legion logfile %s for writing!", filename.c_str())
+#ifdef LEGION_USE_ZLIB
+      if (compression == GZIP_COMPRESSION)
+      {
+        zstream.zalloc = Z_NULL;
+        zstream.zfree = Z_NULL;
+        zstream.opaque = Z_NULL;
+        // 16 + MAX_WBITS asks for a gzip header and trailer
+        if (deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+              16 + MAX_WBITS, 8/*memLevel*/, Z_DEFAULT_STRATEGY) != Z_OK)
+          REPORT_LEGION_ERROR(ERROR_INVALID_PROFILER_FILE,
+              "Unable to initialize compression for legion logfile %s",
+              filename.c_str())
+        compressed.resize(deflateBound(&zstream, CHUNK_SIZE));
+      }
+#else
+      assert(compression == NO_COMPRESSION);
+#endif
       writePreamble();
     }
 
+    //--------------------------------------------------------------------------
+    inline void LegionProfBinarySerializer::lp_append(const void *data,
+                                                      size_t num_bytes)
+    //--------------------------------------------------------------------------
+    {
+      if ((chunk_used + num_bytes) > CHUNK_SIZE)
+      {
+        issue_chunk();
+        // Strings are the only thing that can be bigger than a chunk
+        if (num_bytes > CHUNK_SIZE)
+        {
+          if (last_flush.exists() && !last_flush.has_triggered())
+            last_flush.wait();
+          write_chunk((const char*)data, num_bytes);
+          return;
+        }
+      }
+      memcpy(chunk + chunk_used, data, num_bytes);
+      chunk_used += num_bytes;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfBinarySerializer::issue_chunk(void)
+    //--------------------------------------------------------------------------
+    {
+      if (chunk_used == 0)
+        return;
+      // Apply back pressure if the flushes have fallen too far behind
+      const size_t pending = pending_bytes.fetch_add(chunk_used) + chunk_used;
+      if ((pending > footprint_threshold) && last_flush.exists() &&
+          !last_flush.has_triggered())
+        last_flush.wait();
+      FlushChunkArgs args(this, chunk, chunk_used);
+      last_flush = runtime->issue_runtime_meta_task(args,
+          LG_THROUGHPUT_WORK_PRIORITY, last_flush);
+      chunk = (char*)malloc(CHUNK_SIZE);
+      chunk_used = 0;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfBinarySerializer::write_chunk(const char *buffer,
+                                                 size_t size)
+    //--------------------------------------------------------------------------
+    {
+#ifdef LEGION_USE_ZLIB
+      if (compression == GZIP_COMPRESSION)
+      {
+        // Each chunk is compressed into its own gzip member, gzip readers
+        // decode concatenated members as a single stream
+        if (compressed.size() < deflateBound(&zstream, size))
+          compressed.resize(deflateBound(&zstream, size));
+        zstream.next_in = (Bytef*)buffer;
+        zstream.avail_in = size;
+        zstream.next_out = (Bytef*)&compressed.front();
+        zstream.avail_out = compressed.size();
+#ifndef NDEBUG
+        const int result =
+#endif
+          deflate(&zstream, Z_FINISH);
+        assert(result == Z_STREAM_END);
+        const size_t compressed_size = compressed.size() - zstream.avail_out;
+        deflateReset(&zstream);
+        fwrite(&compressed.front(), compressed_size, 1, f);
+        return;
+      }
+#endif
+      fwrite(buffer, size, 1, f);
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ void LegionProfBinarySerializer::handle_flush_chunk(
+                                                               const void *args)
+    //--------------------------------------------------------------------------
+    {
+      const FlushChunkArgs *fargs = (const FlushChunkArgs*)args;
+      fargs->serializer->write_chunk(fargs->buffer, fargs->size);
+      free(fargs->buffer);
+      fargs->serializer->pending_bytes.fetch_sub(fargs->size);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfBinarySerializer::flush(void)
+    //--------------------------------------------------------------------------
+    {
+      issue_chunk();
+      if (last_flush.exists() && !last_flush.has_triggered())
+        last_flush.wait();
+      last_flush = RtEvent::NO_RT_EVENT;
+      fflush(f);
+    }
+
     // Every legion prof instance that you want to serialize must be written 
     // in the preamble. The preamble defines the format that we'll use for 
     // the serialization.
@@ -426,7 +537,7 @@ namespace Legion {
       ss << std::endl;
       std::string preamble = ss.str();
 
-      lp_fwrite(f, preamble.c_str(), strlen(preamble.c_str()));
+      lp_append(preamble.c_str(), strlen(preamble.c_str()));
     }
 
 
@@ -436,10 +547,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = MAPPER_CALL_DESC_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(mapper_call_desc.kind), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(mapper_call_desc.kind), 
                 sizeof(mapper_call_desc.kind));
-      lp_fwrite(f, mapper_call_desc.name, strlen(mapper_call_desc.name) + 1);
+      lp_append(mapper_call_desc.name, strlen(mapper_call_desc.name) + 1);
     }
 
     //--------------------------------------------------------------------------
@@ -448,10 +559,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = RUNTIME_CALL_DESC_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(runtime_call_desc.kind), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(runtime_call_desc.kind), 
                 sizeof(runtime_call_desc.kind));
-      lp_fwrite(f, runtime_call_desc.name, strlen(runtime_call_desc.name) + 1);
+      lp_append(runtime_call_desc.name, strlen(runtime_call_desc.name) + 1);
     }
 
     //--------------------------------------------------------------------------
@@ -460,11 +571,11 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = META_DESC_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(meta_desc.kind), sizeof(meta_desc.kind));
-      lp_fwrite(f, (char*)&(meta_desc.message), sizeof(meta_desc.message));
-      lp_fwrite(f, (char*)&(meta_desc.ordered_vc),sizeof(meta_desc.ordered_vc));
-      lp_fwrite(f, meta_desc.name, strlen(meta_desc.name) + 1);
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(meta_desc.kind), sizeof(meta_desc.kind));
+      lp_append((char*)&(meta_desc.message), sizeof(meta_desc.message));
+      lp_append((char*)&(meta_desc.ordered_vc),sizeof(meta_desc.ordered_vc));
+      lp_append(meta_desc.name, strlen(meta_desc.name) + 1);
     }
 
     //--------------------------------------------------------------------------
@@ -473,9 +584,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = OP_DESC_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(op_desc.kind), sizeof(op_desc.kind));
-      lp_fwrite(f, op_desc.name, strlen(op_desc.name) + 1);
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(op_desc.kind), sizeof(op_desc.kind));
+      lp_append(op_desc.name, strlen(op_desc.name) + 1);
     }
 
 
@@ -486,8 +597,8 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = MAX_DIM_DESC_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(max_dim_desc.max_dim),
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(max_dim_desc.max_dim),
 		sizeof(max_dim_desc.max_dim));
 
     }
@@ -497,13 +608,13 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INDEX_SPACE_POINT_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*) &(ispace_point_desc.unique_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*) &(ispace_point_desc.unique_id), 
                 sizeof(ispace_point_desc.unique_id));
-      lp_fwrite(f, (char*) &(ispace_point_desc.dim), 
+      lp_append((char*) &(ispace_point_desc.dim), 
                 sizeof(ispace_point_desc.dim));
 #define DIMFUNC(DIM) \
-      lp_fwrite(f, (char*) &(ispace_point_desc.points[DIM-1]), \
+      lp_append((char*) &(ispace_point_desc.points[DIM-1]), \
                 sizeof(ispace_point_desc.points[DIM-1]));
       LEGION_FOREACH_N(DIMFUNC)
 #undef DIMFUNC
@@ -515,18 +626,18 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INDEX_SPACE_RECT_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*) &(ispace_rect_desc.unique_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*) &(ispace_rect_desc.unique_id), 
                 sizeof(ispace_rect_desc.unique_id));
-      lp_fwrite(f, (char*) &(ispace_rect_desc.dim),
+      lp_append((char*) &(ispace_rect_desc.dim),
                 sizeof(ispace_rect_desc.dim));
 #define DIMFUNC(DIM) \
-      lp_fwrite(f, (char*) &(ispace_rect_desc.rect_lo[DIM-1]), \
+      lp_append((char*) &(ispace_rect_desc.rect_lo[DIM-1]), \
                 sizeof(ispace_rect_desc.rect_lo[DIM-1]));
       LEGION_FOREACH_N(DIMFUNC)
 #undef DIMFUNC
 #define DIMFUNC(DIM) \
-      lp_fwrite(f, (char*) &(ispace_rect_desc.rect_hi[DIM-1]), \
+      lp_append((char*) &(ispace_rect_desc.rect_hi[DIM-1]), \
                 sizeof(ispace_rect_desc.rect_hi[DIM-1]));
       LEGION_FOREACH_N(DIMFUNC)
 #undef DIMFUNC
@@ -538,8 +649,8 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INDEX_SPACE_EMPTY_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*) &(ispace_empty_desc.unique_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*) &(ispace_empty_desc.unique_id), 
                 sizeof(ispace_empty_desc.unique_id));
     }
 
@@ -549,12 +660,12 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = FIELD_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*) &(field_desc.unique_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*) &(field_desc.unique_id), 
                 sizeof(field_desc.unique_id));
-      lp_fwrite(f, (char*) &(field_desc.field_id), sizeof(field_desc.field_id));
-      lp_fwrite(f, (char*) &(field_desc.size), sizeof(field_desc.size));
-      lp_fwrite(f, field_desc.name, strlen(field_desc.name)+1);
+      lp_append((char*) &(field_desc.field_id), sizeof(field_desc.field_id));
+      lp_append((char*) &(field_desc.size), sizeof(field_desc.size));
+      lp_append(field_desc.name, strlen(field_desc.name)+1);
     }
 
     //--------------------------------------------------------------------------
@@ -563,10 +674,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = FIELD_SPACE_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*) &(field_space_desc.unique_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*) &(field_space_desc.unique_id), 
                 sizeof(field_space_desc.unique_id));
-      lp_fwrite(f, field_space_desc.name, strlen(field_space_desc.name)+1);
+      lp_append(field_space_desc.name, strlen(field_space_desc.name)+1);
     }
 
     //--------------------------------------------------------------------------
@@ -575,9 +686,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INDEX_PART_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*) &(index_part_desc.unique_id), sizeof(UniqueID));
-      lp_fwrite(f, index_part_desc.name, strlen(index_part_desc.name)+1);
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*) &(index_part_desc.unique_id), sizeof(UniqueID));
+      lp_append(index_part_desc.name, strlen(index_part_desc.name)+1);
     }
 
     //--------------------------------------------------------------------------
@@ -586,9 +697,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INDEX_SPACE_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*) &(index_space_desc.unique_id), sizeof(UniqueID));
-      lp_fwrite(f, index_space_desc.name, strlen(index_space_desc.name)+1);
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*) &(index_space_desc.unique_id), sizeof(UniqueID));
+      lp_append(index_space_desc.name, strlen(index_space_desc.name)+1);
     }
 
     //--------------------------------------------------------------------------
@@ -597,9 +708,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INDEX_SUBSPACE_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(index_subspace_desc.parent_id), sizeof(IDType));
-      lp_fwrite(f, (char*)&(index_subspace_desc.unique_id), sizeof(IDType));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(index_subspace_desc.parent_id), sizeof(IDType));
+      lp_append((char*)&(index_subspace_desc.unique_id), sizeof(IDType));
     }
 
     //--------------------------------------------------------------------------
@@ -608,11 +719,11 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INDEX_PARTITION_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(index_part_desc.parent_id), sizeof(IDType));
-      lp_fwrite(f, (char*)&(index_part_desc.unique_id), sizeof(IDType));
-      lp_fwrite(f, (char*)&(index_part_desc.disjoint), sizeof(bool));
-      lp_fwrite(f, (char*)&(index_part_desc.point), sizeof(LegionColor));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(index_part_desc.parent_id), sizeof(IDType));
+      lp_append((char*)&(index_part_desc.unique_id), sizeof(IDType));
+      lp_append((char*)&(index_part_desc.disjoint), sizeof(bool));
+      lp_append((char*)&(index_part_desc.point), sizeof(LegionColor));
     }
 
     //--------------------------------------------------------------------------
@@ -621,11 +732,11 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = LOGICAL_REGION_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(lr_desc.ispace_id), sizeof(IDType));
-      lp_fwrite(f, (char*)&(lr_desc.fspace_id), sizeof(unsigned));
-      lp_fwrite(f, (char*)&(lr_desc.tree_id), sizeof(unsigned));
-      lp_fwrite(f, lr_desc.name, strlen(lr_desc.name)+1);
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(lr_desc.ispace_id), sizeof(IDType));
+      lp_append((char*)&(lr_desc.fspace_id), sizeof(unsigned));
+      lp_append((char*)&(lr_desc.tree_id), sizeof(unsigned));
+      lp_append(lr_desc.name, strlen(lr_desc.name)+1);
     }
 
     //--------------------------------------------------------------------------
@@ -634,12 +745,12 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = PHYSICAL_INST_REGION_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(phy_instance_rdesc.op_id), sizeof(UniqueID));
-      lp_fwrite(f, (char*)&(phy_instance_rdesc.inst_id), sizeof(IDType));
-      lp_fwrite(f, (char*)&(phy_instance_rdesc.ispace_id), sizeof(IDType));
-      lp_fwrite(f, (char*)&(phy_instance_rdesc.fspace_id), sizeof(unsigned));
-      lp_fwrite(f, (char*)&(phy_instance_rdesc.tree_id), sizeof(unsigned));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(phy_instance_rdesc.op_id), sizeof(UniqueID));
+      lp_append((char*)&(phy_instance_rdesc.inst_id), sizeof(IDType));
+      lp_append((char*)&(phy_instance_rdesc.ispace_id), sizeof(IDType));
+      lp_append((char*)&(phy_instance_rdesc.fspace_id), sizeof(unsigned));
+      lp_append((char*)&(phy_instance_rdesc.tree_id), sizeof(unsigned));
     }
 
     //--------------------------------------------------------------------------
@@ -649,14 +760,14 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = PHYSICAL_INST_LAYOUT_DIM_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(phy_instance_dim_order_rdesc.op_id),
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(phy_instance_dim_order_rdesc.op_id),
                 sizeof(UniqueID));
-      lp_fwrite(f, (char*)&(phy_instance_dim_order_rdesc.inst_id),
+      lp_append((char*)&(phy_instance_dim_order_rdesc.inst_id),
                 sizeof(IDType));
-      lp_fwrite(f, (char*)&(phy_instance_dim_order_rdesc.dim),
+      lp_append((char*)&(phy_instance_dim_order_rdesc.dim),
                 sizeof(unsigned));
-      lp_fwrite(f, (char*)&(phy_instance_dim_order_rdesc.k),
+      lp_append((char*)&(phy_instance_dim_order_rdesc.k),
                 sizeof(unsigned));
     }
     //--------------------------------------------------------------------------
@@ -666,18 +777,18 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = PHYSICAL_INST_LAYOUT_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(phy_instance_layout_rdesc.op_id),sizeof(UniqueID));
-      lp_fwrite(f, (char*)&(phy_instance_layout_rdesc.inst_id),sizeof(InstID));
-      lp_fwrite(f, (char*)&(phy_instance_layout_rdesc.field_id),
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(phy_instance_layout_rdesc.op_id),sizeof(UniqueID));
+      lp_append((char*)&(phy_instance_layout_rdesc.inst_id),sizeof(InstID));
+      lp_append((char*)&(phy_instance_layout_rdesc.field_id),
                 sizeof(unsigned));
-      lp_fwrite(f, (char*)&(phy_instance_layout_rdesc.fspace_id),
+      lp_append((char*)&(phy_instance_layout_rdesc.fspace_id),
                 sizeof(unsigned));
-      lp_fwrite(f, (char*)&(phy_instance_layout_rdesc.has_align),
+      lp_append((char*)&(phy_instance_layout_rdesc.has_align),
                 sizeof(bool));
-      lp_fwrite(f, (char*)&(phy_instance_layout_rdesc.eqk),
+      lp_append((char*)&(phy_instance_layout_rdesc.eqk),
                 sizeof(unsigned));
-      lp_fwrite(f, (char*)&(phy_instance_layout_rdesc.alignment),
+      lp_append((char*)&(phy_instance_layout_rdesc.alignment),
                 sizeof(unsigned));
     }
 
@@ -688,11 +799,11 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INDEX_SPACE_SIZE_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(size_desc.id),sizeof(UniqueID));
-      lp_fwrite(f, (char*)&(size_desc.dense_size),sizeof(unsigned long long));
-      lp_fwrite(f, (char*)&(size_desc.sparse_size),sizeof(unsigned long long));
-      lp_fwrite(f, (char*)&(size_desc.is_sparse),sizeof(bool));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(size_desc.id),sizeof(UniqueID));
+      lp_append((char*)&(size_desc.dense_size),sizeof(unsigned long long));
+      lp_append((char*)&(size_desc.sparse_size),sizeof(unsigned long long));
+      lp_append((char*)&(size_desc.is_sparse),sizeof(bool));
     }
 
     //--------------------------------------------------------------------------
@@ -701,10 +812,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = TASK_KIND_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(task_kind.task_id), sizeof(task_kind.task_id));
-      lp_fwrite(f, task_kind.name, strlen(task_kind.name) + 1);
-      lp_fwrite(f, (char*)&(task_kind.overwrite), sizeof(task_kind.overwrite));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(task_kind.task_id), sizeof(task_kind.task_id));
+      lp_append(task_kind.name, strlen(task_kind.name) + 1);
+      lp_append((char*)&(task_kind.overwrite), sizeof(task_kind.overwrite));
     }
 
     //--------------------------------------------------------------------------
@@ -713,11 +824,11 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = TASK_VARIANT_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(task_variant.task_id),sizeof(task_variant.task_id));
-      lp_fwrite(f, (char*)&(task_variant.variant_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(task_variant.task_id),sizeof(task_variant.task_id));
+      lp_append((char*)&(task_variant.variant_id), 
                 sizeof(task_variant.variant_id));
-      lp_fwrite(f, task_variant.name, strlen(task_variant.name) + 1);
+      lp_append(task_variant.name, strlen(task_variant.name) + 1);
     }
 
     //--------------------------------------------------------------------------
@@ -726,18 +837,18 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = OPERATION_INSTANCE_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(operation_instance.op_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(operation_instance.op_id), 
                 sizeof(operation_instance.op_id));
-      lp_fwrite(f, (char*)&(operation_instance.parent_id),
+      lp_append((char*)&(operation_instance.parent_id),
                 sizeof(operation_instance.parent_id));
-      lp_fwrite(f, (char*)&(operation_instance.kind),
+      lp_append((char*)&(operation_instance.kind),
                 sizeof(operation_instance.kind));
       if (operation_instance.provenance != NULL)
-        lp_fwrite(f, operation_instance.provenance,
+        lp_append(operation_instance.provenance,
             strlen(operation_instance.provenance) + 1);
       else
-        lp_fwrite(f, "", 1);
+        lp_append("", 1);
     }
 
     //--------------------------------------------------------------------------
@@ -746,9 +857,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = MULTI_TASK_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(multi_task.op_id),   sizeof(multi_task.op_id));
-      lp_fwrite(f, (char*)&(multi_task.task_id), sizeof(multi_task.task_id));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(multi_task.op_id),   sizeof(multi_task.op_id));
+      lp_append((char*)&(multi_task.task_id), sizeof(multi_task.task_id));
     }
 
     //--------------------------------------------------------------------------
@@ -757,10 +868,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = SLICE_OWNER_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(slice_owner.parent_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(slice_owner.parent_id), 
                 sizeof(slice_owner.parent_id));
-      lp_fwrite(f, (char*)&(slice_owner.op_id), sizeof(slice_owner.op_id));
+      lp_append((char*)&(slice_owner.op_id), sizeof(slice_owner.op_id));
     }
 
     //--------------------------------------------------------------------------
@@ -770,13 +881,13 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = TASK_WAIT_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(task_info.op_id),     sizeof(task_info.op_id));
-      lp_fwrite(f, (char*)&(task_info.task_id),   sizeof(task_info.task_id));
-      lp_fwrite(f, (char*)&(task_info.variant_id),sizeof(task_info.variant_id));
-      lp_fwrite(f, (char*)&(wait_info.wait_start),sizeof(wait_info.wait_start));
-      lp_fwrite(f, (char*)&(wait_info.wait_ready),sizeof(wait_info.wait_ready));
-      lp_fwrite(f, (char*)&(wait_info.wait_end),  sizeof(wait_info.wait_end));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(task_info.op_id),     sizeof(task_info.op_id));
+      lp_append((char*)&(task_info.task_id),   sizeof(task_info.task_id));
+      lp_append((char*)&(task_info.variant_id),sizeof(task_info.variant_id));
+      lp_append((char*)&(wait_info.wait_start),sizeof(wait_info.wait_start));
+      lp_append((char*)&(wait_info.wait_ready),sizeof(wait_info.wait_ready));
+      lp_append((char*)&(wait_info.wait_end),  sizeof(wait_info.wait_end));
     }
 
     //--------------------------------------------------------------------------
@@ -786,13 +897,13 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = TASK_WAIT_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(task_info.op_id),     sizeof(task_info.op_id));
-      lp_fwrite(f, (char*)&(task_info.task_id),   sizeof(task_info.task_id));
-      lp_fwrite(f, (char*)&(task_info.variant_id),sizeof(task_info.variant_id));
-      lp_fwrite(f, (char*)&(wait_info.wait_start),sizeof(wait_info.wait_start));
-      lp_fwrite(f, (char*)&(wait_info.wait_ready),sizeof(wait_info.wait_ready));
-      lp_fwrite(f, (char*)&(wait_info.wait_end),  sizeof(wait_info.wait_end));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(task_info.op_id),     sizeof(task_info.op_id));
+      lp_append((char*)&(task_info.task_id),   sizeof(task_info.task_id));
+      lp_append((char*)&(task_info.variant_id),sizeof(task_info.variant_id));
+      lp_append((char*)&(wait_info.wait_start),sizeof(wait_info.wait_start));
+      lp_append((char*)&(wait_info.wait_ready),sizeof(wait_info.wait_ready));
+      lp_append((char*)&(wait_info.wait_end),  sizeof(wait_info.wait_end));
     }
 
     //--------------------------------------------------------------------------
@@ -802,12 +913,12 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = META_WAIT_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(meta_info.op_id),     sizeof(meta_info.op_id));
-      lp_fwrite(f, (char*)&(meta_info.lg_id),     sizeof(meta_info.lg_id));
-      lp_fwrite(f, (char*)&(wait_info.wait_start),sizeof(wait_info.wait_start));
-      lp_fwrite(f, (char*)&(wait_info.wait_ready),sizeof(wait_info.wait_ready));
-      lp_fwrite(f, (char*)&(wait_info.wait_end),  sizeof(wait_info.wait_end));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(meta_info.op_id),     sizeof(meta_info.op_id));
+      lp_append((char*)&(meta_info.lg_id),     sizeof(meta_info.lg_id));
+      lp_append((char*)&(wait_info.wait_start),sizeof(wait_info.wait_start));
+      lp_append((char*)&(wait_info.wait_ready),sizeof(wait_info.wait_ready));
+      lp_append((char*)&(wait_info.wait_end),  sizeof(wait_info.wait_end));
     }
  
     //--------------------------------------------------------------------------
@@ -816,18 +927,18 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = TASK_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(task_info.op_id),     sizeof(task_info.op_id));
-      lp_fwrite(f, (char*)&(task_info.task_id),   sizeof(task_info.task_id));
-      lp_fwrite(f, (char*)&(task_info.variant_id),sizeof(task_info.variant_id));
-      lp_fwrite(f, (char*)&(task_info.proc_id),   sizeof(task_info.proc_id));
-      lp_fwrite(f, (char*)&(task_info.create),    sizeof(task_info.create));
-      lp_fwrite(f, (char*)&(task_info.ready),     sizeof(task_info.ready));
-      lp_fwrite(f, (char*)&(task_info.start),     sizeof(task_info.start));
-      lp_fwrite(f, (char*)&(task_info.stop),      sizeof(task_info.stop));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(task_info.op_id),     sizeof(task_info.op_id));
+      lp_append((char*)&(task_info.task_id),   sizeof(task_info.task_id));
+      lp_append((char*)&(task_info.variant_id),sizeof(task_info.variant_id));
+      lp_append((char*)&(task_info.proc_id),   sizeof(task_info.proc_id));
+      lp_append((char*)&(task_info.create),    sizeof(task_info.create));
+      lp_append((char*)&(task_info.ready),     sizeof(task_info.ready));
+      lp_append((char*)&(task_info.start),     sizeof(task_info.start));
+      lp_append((char*)&(task_info.stop),      sizeof(task_info.stop));
 #ifdef LEGION_PROF_PROVENANCE
-      lp_fwrite(f, (char*)&(task_info.provenance),sizeof(task_info.provenance));
-      lp_fwrite(f, (char*)&(task_info.finish_event),
+      lp_append((char*)&(task_info.provenance),sizeof(task_info.provenance));
+      lp_append((char*)&(task_info.finish_event),
                                                 sizeof(task_info.finish_event));
 #endif
     }
@@ -838,20 +949,20 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = GPU_TASK_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(task_info.op_id),     sizeof(task_info.op_id));
-      lp_fwrite(f, (char*)&(task_info.task_id),   sizeof(task_info.task_id));
-      lp_fwrite(f, (char*)&(task_info.variant_id),sizeof(task_info.variant_id));
-      lp_fwrite(f, (char*)&(task_info.proc_id),   sizeof(task_info.proc_id));
-      lp_fwrite(f, (char*)&(task_info.create),    sizeof(task_info.create));
-      lp_fwrite(f, (char*)&(task_info.ready),     sizeof(task_info.ready));
-      lp_fwrite(f, (char*)&(task_info.start),     sizeof(task_info.start));
-      lp_fwrite(f, (char*)&(task_info.stop),      sizeof(task_info.stop));
-      lp_fwrite(f, (char*)&(task_info.gpu_start), sizeof(task_info.gpu_start));
-      lp_fwrite(f, (char*)&(task_info.gpu_stop),  sizeof(task_info.gpu_stop));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(task_info.op_id),     sizeof(task_info.op_id));
+      lp_append((char*)&(task_info.task_id),   sizeof(task_info.task_id));
+      lp_append((char*)&(task_info.variant_id),sizeof(task_info.variant_id));
+      lp_append((char*)&(task_info.proc_id),   sizeof(task_info.proc_id));
+      lp_append((char*)&(task_info.create),    sizeof(task_info.create));
+      lp_append((char*)&(task_info.ready),     sizeof(task_info.ready));
+      lp_append((char*)&(task_info.start),     sizeof(task_info.start));
+      lp_append((char*)&(task_info.stop),      sizeof(task_info.stop));
+      lp_append((char*)&(task_info.gpu_start), sizeof(task_info.gpu_start));
+      lp_append((char*)&(task_info.gpu_stop),  sizeof(task_info.gpu_stop));
 #ifdef LEGION_PROF_PROVENANCE
-      lp_fwrite(f, (char*)&(task_info.provenance),sizeof(task_info.provenance));
-      lp_fwrite(f, (char*)&(task_info.finish_event),
+      lp_append((char*)&(task_info.provenance),sizeof(task_info.provenance));
+      lp_append((char*)&(task_info.finish_event),
                                                 sizeof(task_info.finish_event));
 #endif
     }
@@ -862,17 +973,17 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = META_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(meta_info.op_id),   sizeof(meta_info.op_id));
-      lp_fwrite(f, (char*)&(meta_info.lg_id),   sizeof(meta_info.lg_id));
-      lp_fwrite(f, (char*)&(meta_info.proc_id), sizeof(meta_info.proc_id));
-      lp_fwrite(f, (char*)&(meta_info.create),  sizeof(meta_info.create));
-      lp_fwrite(f, (char*)&(meta_info.ready),   sizeof(meta_info.ready));
-      lp_fwrite(f, (char*)&(meta_info.start),   sizeof(meta_info.start));
-      lp_fwrite(f, (char*)&(meta_info.stop),    sizeof(meta_info.stop));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(meta_info.op_id),   sizeof(meta_info.op_id));
+      lp_append((char*)&(meta_info.lg_id),   sizeof(meta_info.lg_id));
+      lp_append((char*)&(meta_info.proc_id), sizeof(meta_info.proc_id));
+      lp_append((char*)&(meta_info.create),  sizeof(meta_info.create));
+      lp_append((char*)&(meta_info.ready),   sizeof(meta_info.ready));
+      lp_append((char*)&(meta_info.start),   sizeof(meta_info.start));
+      lp_append((char*)&(meta_info.stop),    sizeof(meta_info.stop));
 #ifdef LEGION_PROF_PROVENANCE
-      lp_fwrite(f, (char*)&(meta_info.provenance),sizeof(meta_info.provenance));
-      lp_fwrite(f, (char*)&(meta_info.finish_event),
+      lp_append((char*)&(meta_info.provenance),sizeof(meta_info.provenance));
+      lp_append((char*)&(meta_info.finish_event),
                                                 sizeof(meta_info.finish_event));
 #endif
     }
@@ -883,20 +994,20 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = COPY_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-
-      lp_fwrite(f, (char*)&(copy_info.op_id),  sizeof(copy_info.op_id));
-      lp_fwrite(f, (char*)&(copy_info.src),    sizeof(copy_info.src));
-      lp_fwrite(f, (char*)&(copy_info.dst),    sizeof(copy_info.dst));
-      lp_fwrite(f, (char*)&(copy_info.size),   sizeof(copy_info.size));
-      lp_fwrite(f, (char*)&(copy_info.create), sizeof(copy_info.create));
-      lp_fwrite(f, (char*)&(copy_info.ready),  sizeof(copy_info.ready));
-      lp_fwrite(f, (char*)&(copy_info.start),  sizeof(copy_info.start));
-      lp_fwrite(f, (char*)&(copy_info.stop),   sizeof(copy_info.stop));
-      lp_fwrite(f, (char*)&(copy_info.fevent),sizeof(copy_info.fevent.id));
-      lp_fwrite(f, (char*)&(copy_info.num_requests),   sizeof(copy_info.num_requests));
+      lp_append((char*)&ID, sizeof(ID));
+
+      lp_append((char*)&(copy_info.op_id),  sizeof(copy_info.op_id));
+      lp_append((char*)&(copy_info.src),    sizeof(copy_info.src));
+      lp_append((char*)&(copy_info.dst),    sizeof(copy_info.dst));
+      lp_append((char*)&(copy_info.size),   sizeof(copy_info.size));
+      lp_append((char*)&(copy_info.create), sizeof(copy_info.create));
+      lp_append((char*)&(copy_info.ready),  sizeof(copy_info.ready));
+      lp_append((char*)&(copy_info.start),  sizeof(copy_info.start));
+      lp_append((char*)&(copy_info.stop),   sizeof(copy_info.stop));
+      lp_append((char*)&(copy_info.fevent),sizeof(copy_info.fevent.id));
+      lp_append((char*)&(copy_info.num_requests),   sizeof(copy_info.num_requests));
 #ifdef LEGION_PROF_PROVENANCE
-      lp_fwrite(f, (char*)&(copy_info.provenance),sizeof(copy_info.provenance));
+      lp_append((char*)&(copy_info.provenance),sizeof(copy_info.provenance));
 #endif
     }
 
@@ -907,14 +1018,14 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = COPY_INST_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(copy_info.op_id),     sizeof(copy_info.op_id));
-      lp_fwrite(f, (char*)&(copy_inst.src_inst_id),sizeof(copy_inst.src_inst_id));
-      lp_fwrite(f, (char*)&(copy_inst.dst_inst_id),sizeof(copy_inst.dst_inst_id));
-      lp_fwrite(f, (char*)&(copy_info.fevent),sizeof(copy_info.fevent.id));
-      lp_fwrite(f, (char*)&(copy_inst.num_fields),sizeof(copy_inst.num_fields));
-      lp_fwrite(f, (char*)&(copy_inst.request_type),sizeof(copy_inst.request_type));
-      lp_fwrite(f, (char*)&(copy_inst.num_hops),sizeof(copy_inst.num_hops));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(copy_info.op_id),     sizeof(copy_info.op_id));
+      lp_append((char*)&(copy_inst.src_inst_id),sizeof(copy_inst.src_inst_id));
+      lp_append((char*)&(copy_inst.dst_inst_id),sizeof(copy_inst.dst_inst_id));
+      lp_append((char*)&(copy_info.fevent),sizeof(copy_info.fevent.id));
+      lp_append((char*)&(copy_inst.num_fields),sizeof(copy_inst.num_fields));
+      lp_append((char*)&(copy_inst.request_type),sizeof(copy_inst.request_type));
+      lp_append((char*)&(copy_inst.num_hops),sizeof(copy_inst.num_hops));
     }
 
     //--------------------------------------------------------------------------
@@ -923,16 +1034,16 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = FILL_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-
-      lp_fwrite(f, (char*)&(fill_info.op_id),  sizeof(fill_info.op_id));
-      lp_fwrite(f, (char*)&(fill_info.dst),    sizeof(fill_info.dst));
-      lp_fwrite(f, (char*)&(fill_info.create), sizeof(fill_info.create));
-      lp_fwrite(f, (char*)&(fill_info.ready),  sizeof(fill_info.ready));
-      lp_fwrite(f, (char*)&(fill_info.start),  sizeof(fill_info.start));
-      lp_fwrite(f, (char*)&(fill_info.stop),   sizeof(fill_info.stop));
+      lp_append((char*)&ID, sizeof(ID));
+
+      lp_append((char*)&(fill_info.op_id),  sizeof(fill_info.op_id));
+      lp_append((char*)&(fill_info.dst),    sizeof(fill_info.dst));
+      lp_append((char*)&(fill_info.create), sizeof(fill_info.create));
+      lp_append((char*)&(fill_info.ready),  sizeof(fill_info.ready));
+      lp_append((char*)&(fill_info.start),  sizeof(fill_info.start));
+      lp_append((char*)&(fill_info.stop),   sizeof(fill_info.stop));
 #ifdef LEGION_PROF_PROVENANCE
-      lp_fwrite(f, (char*)&(fill_info.provenance),sizeof(fill_info.provenance));
+      lp_append((char*)&(fill_info.provenance),sizeof(fill_info.provenance));
 #endif
     }
 
@@ -942,15 +1053,15 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INST_CREATE_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(inst_create_info.op_id),   
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(inst_create_info.op_id),   
                 sizeof(inst_create_info.op_id));
-      lp_fwrite(f, (char*)&(inst_create_info.inst_id), 
+      lp_append((char*)&(inst_create_info.inst_id), 
                 sizeof(inst_create_info.inst_id));
-      lp_fwrite(f, (char*)&(inst_create_info.create),  
+      lp_append((char*)&(inst_create_info.create),  
                 sizeof(inst_create_info.create));
 #ifdef LEGION_PROF_PROVENANCE
-      lp_fwrite(f, (char*)&(inst_create_info.provenance),
+      lp_append((char*)&(inst_create_info.provenance),
                 sizeof(inst_create_info.provenance));
 #endif
     }
@@ -961,14 +1072,14 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INST_USAGE_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(inst_usage_info.op_id),   
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(inst_usage_info.op_id),   
                 sizeof(inst_usage_info.op_id));
-      lp_fwrite(f, (char*)&(inst_usage_info.inst_id), 
+      lp_append((char*)&(inst_usage_info.inst_id), 
                 sizeof(inst_usage_info.inst_id));
-      lp_fwrite(f, (char*)&(inst_usage_info.mem_id),  
+      lp_append((char*)&(inst_usage_info.mem_id),  
                 sizeof(inst_usage_info.mem_id));
-      lp_fwrite(f, (char*)&(inst_usage_info.size),    
+      lp_append((char*)&(inst_usage_info.size),    
                 sizeof(inst_usage_info.size));
     }
 
@@ -978,16 +1089,16 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = INST_TIMELINE_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(inst_timeline_info.op_id),   
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(inst_timeline_info.op_id),   
                 sizeof(inst_timeline_info.op_id));
-      lp_fwrite(f, (char*)&(inst_timeline_info.inst_id), 
+      lp_append((char*)&(inst_timeline_info.inst_id), 
                 sizeof(inst_timeline_info.inst_id));
-      lp_fwrite(f, (char*)&(inst_timeline_info.create),  
+      lp_append((char*)&(inst_timeline_info.create),  
                 sizeof(inst_timeline_info.create));
-      lp_fwrite(f, (char*)&(inst_timeline_info.ready),  
+      lp_append((char*)&(inst_timeline_info.ready),  
                 sizeof(inst_timeline_info.ready));
-      lp_fwrite(f, (char*)&(inst_timeline_info.destroy), 
+      lp_append((char*)&(inst_timeline_info.destroy), 
                 sizeof(inst_timeline_info.destroy));
     }
 
@@ -997,21 +1108,21 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = PARTITION_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(partition_info.op_id),
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(partition_info.op_id),
                 sizeof(partition_info.op_id));
-      lp_fwrite(f, (char*)&(partition_info.part_op),
+      lp_append((char*)&(partition_info.part_op),
                 sizeof(partition_info.part_op));
-      lp_fwrite(f, (char*)&(partition_info.create),
+      lp_append((char*)&(partition_info.create),
                 sizeof(partition_info.create));
-      lp_fwrite(f, (char*)&(partition_info.ready),
+      lp_append((char*)&(partition_info.ready),
                 sizeof(partition_info.ready));
-      lp_fwrite(f, (char*)&(partition_info.start),
+      lp_append((char*)&(partition_info.start),
                 sizeof(partition_info.start));
-      lp_fwrite(f, (char*)&(partition_info.stop),
+      lp_append((char*)&(partition_info.stop),
                 sizeof(partition_info.stop));
 #ifdef LEGION_PROF_PROVENANCE
-      lp_fwrite(f, (char*)&(partition_info.provenance),
+      lp_append((char*)&(partition_info.provenance),
                 sizeof(partition_info.provenance));
 #endif
     }
@@ -1022,16 +1133,16 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = MAPPER_CALL_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(mapper_call_info.kind),    
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(mapper_call_info.kind),    
                 sizeof(mapper_call_info.kind));
-      lp_fwrite(f, (char*)&(mapper_call_info.op_id),   
+      lp_append((char*)&(mapper_call_info.op_id),   
                 sizeof(mapper_call_info.op_id));
-      lp_fwrite(f, (char*)&(mapper_call_info.start),   
+      lp_append((char*)&(mapper_call_info.start),   
                 sizeof(mapper_call_info.start));
-      lp_fwrite(f, (char*)&(mapper_call_info.stop),    
+      lp_append((char*)&(mapper_call_info.stop),    
                 sizeof(mapper_call_info.stop));
-      lp_fwrite(f, (char*)&(mapper_call_info.proc_id), 
+      lp_append((char*)&(mapper_call_info.proc_id), 
                 sizeof(mapper_call_info.proc_id));
     }
 
@@ -1041,14 +1152,14 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = RUNTIME_CALL_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(runtime_call_info.kind),    
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(runtime_call_info.kind),    
                 sizeof(runtime_call_info.kind));
-      lp_fwrite(f, (char*)&(runtime_call_info.start),   
+      lp_append((char*)&(runtime_call_info.start),   
                 sizeof(runtime_call_info.start));
-      lp_fwrite(f, (char*)&(runtime_call_info.stop),    
+      lp_append((char*)&(runtime_call_info.stop),    
                 sizeof(runtime_call_info.stop));
-      lp_fwrite(f, (char*)&(runtime_call_info.proc_id), 
+      lp_append((char*)&(runtime_call_info.proc_id), 
                 sizeof(runtime_call_info.proc_id));
     }
 
@@ -1058,9 +1169,9 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = PROC_DESC_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(proc_desc.proc_id), sizeof(proc_desc.proc_id));
-      lp_fwrite(f, (char*)&(proc_desc.kind),    sizeof(proc_desc.kind));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(proc_desc.proc_id), sizeof(proc_desc.proc_id));
+      lp_append((char*)&(proc_desc.kind),    sizeof(proc_desc.kind));
     }
     //--------------------------------------------------------------------------
     void LegionProfBinarySerializer::serialize(
@@ -1068,10 +1179,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = MEM_DESC_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(mem_desc.mem_id),   sizeof(mem_desc.mem_id));
-      lp_fwrite(f, (char*)&(mem_desc.kind),     sizeof(mem_desc.kind));
-      lp_fwrite(f, (char*)&(mem_desc.capacity), sizeof(mem_desc.capacity));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(mem_desc.mem_id),   sizeof(mem_desc.mem_id));
+      lp_append((char*)&(mem_desc.kind),     sizeof(mem_desc.kind));
+      lp_append((char*)&(mem_desc.capacity), sizeof(mem_desc.capacity));
     }
 
     //--------------------------------------------------------------------------
@@ -1080,11 +1191,11 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = PROC_MEM_DESC_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*) &(pm.proc_id), sizeof(pm.proc_id));
-      lp_fwrite(f, (char*) &(pm.mem_id), sizeof(pm.mem_id));
-      lp_fwrite(f, (char*) &(pm.bandwidth), sizeof(pm.bandwidth));
-      lp_fwrite(f, (char*) &(pm.latency), sizeof(pm.latency));
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*) &(pm.proc_id), sizeof(pm.proc_id));
+      lp_append((char*) &(pm.mem_id), sizeof(pm.mem_id));
+      lp_append((char*) &(pm.bandwidth), sizeof(pm.bandwidth));
+      lp_append((char*) &(pm.latency), sizeof(pm.latency));
     }
 
 
@@ -1095,12 +1206,12 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       int ID = PROFTASK_INFO_ID;
-      lp_fwrite(f, (char*)&ID, sizeof(ID));
-      lp_fwrite(f, (char*)&(proftask_info.proc_id), 
+      lp_append((char*)&ID, sizeof(ID));
+      lp_append((char*)&(proftask_info.proc_id), 
                 sizeof(proftask_info.proc_id));
-      lp_fwrite(f, (char*)&(proftask_info.op_id), sizeof(proftask_info.op_id));
-      lp_fwrite(f, (char*)&(proftask_info.start), sizeof(proftask_info.start));
-      lp_fwrite(f, (char*)&(proftask_info.stop),  sizeof(proftask_info.stop));
+      lp_append((char*)&(proftask_info.op_id), sizeof(proftask_info.op_id));
+      lp_append((char*)&(proftask_info.start), sizeof(proftask_info.start));
+      lp_append((char*)&(proftask_info.stop),  sizeof(proftask_info.stop));
     }
 #endif
 
@@ -1108,11 +1219,465 @@ namespace Legion {
     LegionProfBinarySerializer::~LegionProfBinarySerializer()
     //--------------------------------------------------------------------------
     {
-      lp_fflush(f, Z_FULL_FLUSH);
-      lp_fclose(f);
+      // Anything left over is written directly since the runtime
+      // may no longer be able to run meta-tasks
+#ifdef DEBUG_LEGION
+      assert(!last_flush.exists() || last_flush.has_triggered());
+#endif
+      if (chunk_used > 0)
+        write_chunk(chunk, chunk_used);
+      free(chunk);
+#ifdef LEGION_USE_ZLIB
+      if (compression == GZIP_COMPRESSION)
+        deflateEnd(&zstream);
+#endif
+      fclose(f);
+    }
+
+
+
+    //////////////////////// LegionProfSummarySerializer //////////////////////
+
+    //--------------------------------------------------------------------------
+    LegionProfSummarySerializer::Histogram::Histogram(void)
+      : count(0), bytes(0), total(0), min(0), max(0)
+    //--------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < NUM_BUCKETS; idx++)
+        buckets[idx] = 0;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::Histogram::record(timestamp_t start,
+                                  timestamp_t stop, unsigned long long size)
+    //--------------------------------------------------------------------------
+    {
+      // Timestamps are unsigned so clamp intervals that look backwards
+      const timestamp_t latency = (stop > start) ? (stop - start) : 0;
+      if ((count == 0) || (latency < min))
+        min = latency;
+      if (latency > max)
+        max = latency;
+      count++;
+      bytes += size;
+      total += latency;
+      // Bucket i holds latencies in [2^(i-1), 2^i) nanoseconds
+      unsigned bucket = 0;
+      while ((bucket < (NUM_BUCKETS-1)) && ((latency >> bucket) > 0))
+        bucket++;
+      buckets[bucket]++;
     }
 
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::Histogram::merge(const Histogram &rhs)
+    //--------------------------------------------------------------------------
+    {
+      if (rhs.count == 0)
+        return;
+      if ((count == 0) || (rhs.min < min))
+        min = rhs.min;
+      if (rhs.max > max)
+        max = rhs.max;
+      count += rhs.count;
+      bytes += rhs.bytes;
+      total += rhs.total;
+      for (unsigned idx = 0; idx < NUM_BUCKETS; idx++)
+        buckets[idx] += rhs.buckets[idx];
+    }
+
+    //--------------------------------------------------------------------------
+    timestamp_t LegionProfSummarySerializer::Histogram::percentile(
+                                                         double fraction) const
+    //--------------------------------------------------------------------------
+    {
+      // Report the upper bound of the bucket containing the percentile
+      const unsigned long long target = 
+        (unsigned long long)(fraction * count + 0.5);
+      unsigned long long seen = 0;
+      for (unsigned idx = 0; idx < NUM_BUCKETS; idx++)
+      {
+        seen += buckets[idx];
+        if ((seen >= target) && (seen > 0))
+          return std::min(max, timestamp_t(1) << idx);
+      }
+      return max;
+    }
+
+    template<typename K, typename V>
+    static inline void merge_summary_map(std::map<K,V> &lhs,
+                                         const std::map<K,V> &rhs)
+    {
+      for (typename std::map<K,V>::const_iterator it = 
+            rhs.begin(); it != rhs.end(); it++)
+        lhs[it->first].merge(it->second);
+    }
+
+    template<typename K>
+    static inline void pack_summary_key(Serializer &rez, const K &key)
+    {
+      rez.serialize(key);
+    }
+
+    template<typename K1, typename K2>
+    static inline void pack_summary_key(Serializer &rez,
+                                        const std::pair<K1,K2> &key)
+    {
+      rez.serialize(key.first);
+      rez.serialize(key.second);
+    }
+
+    template<typename K>
+    static inline void unpack_summary_key(Deserializer &derez, K &key)
+    {
+      derez.deserialize(key);
+    }
+
+    template<typename K1, typename K2>
+    static inline void unpack_summary_key(Deserializer &derez,
+                                          std::pair<K1,K2> &key)
+    {
+      derez.deserialize(key.first);
+      derez.deserialize(key.second);
+    }
+
+    template<typename K, typename V>
+    static inline void pack_summary_map(Serializer &rez,
+                                        const std::map<K,V> &map)
+    {
+      rez.serialize<size_t>(map.size());
+      for (typename std::map<K,V>::const_iterator it = 
+            map.begin(); it != map.end(); it++)
+      {
+        pack_summary_key(rez, it->first);
+        rez.serialize(it->second);
+      }
+    }
+
+    template<typename K, typename V>
+    static inline void unpack_summary_map(Deserializer &derez,
+                                          std::map<K,V> &map)
+    {
+      size_t num_entries;
+      derez.deserialize(num_entries);
+      for (unsigned idx = 0; idx < num_entries; idx++)
+      {
+        K key;
+        unpack_summary_key(derez, key);
+        derez.deserialize(map[key]);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::Summary::merge(const Summary &rhs)
+    //--------------------------------------------------------------------------
+    {
+      merge_summary_map(tasks, rhs.tasks);
+      merge_summary_map(meta_tasks, rhs.meta_tasks);
+      merge_summary_map(mapper_calls, rhs.mapper_calls);
+      merge_summary_map(runtime_calls, rhs.runtime_calls);
+      merge_summary_map(copies, rhs.copies);
+      merge_summary_map(fills, rhs.fills);
+      proc_kinds.insert(rhs.proc_kinds.begin(), rhs.proc_kinds.end());
+      mem_kinds.insert(rhs.mem_kinds.begin(), rhs.mem_kinds.end());
+    }
 
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::Summary::pack(Serializer &rez) const
+    //--------------------------------------------------------------------------
+    {
+      pack_summary_map(rez, tasks);
+      pack_summary_map(rez, meta_tasks);
+      pack_summary_map(rez, mapper_calls);
+      pack_summary_map(rez, runtime_calls);
+      pack_summary_map(rez, copies);
+      pack_summary_map(rez, fills);
+      pack_summary_map(rez, proc_kinds);
+      pack_summary_map(rez, mem_kinds);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::Summary::unpack(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      unpack_summary_map(derez, tasks);
+      unpack_summary_map(derez, meta_tasks);
+      unpack_summary_map(derez, mapper_calls);
+      unpack_summary_map(derez, runtime_calls);
+      unpack_summary_map(derez, copies);
+      unpack_summary_map(derez, fills);
+      unpack_summary_map(derez, proc_kinds);
+      unpack_summary_map(derez, mem_kinds);
+    }
+
+    //--------------------------------------------------------------------------
+    LegionProfSummarySerializer::LegionProfSummarySerializer(Runtime *rt,
+                                                         std::string name)
+      : runtime(rt), filename(name), expected_remote(
+          std::min(rt->num_profiling_nodes, rt->total_address_spaces) - 1),
+        received_remote(0)
+    //--------------------------------------------------------------------------
+    {
+      if ((runtime->address_space == 0) && (expected_remote > 0))
+        remote_done = Runtime::create_rt_user_event();
+    }
+
+    //--------------------------------------------------------------------------
+    LegionProfSummarySerializer::~LegionProfSummarySerializer()
+    //--------------------------------------------------------------------------
+    {
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::flush(void)
+    //--------------------------------------------------------------------------
+    {
+      if (runtime->address_space > 0)
+      {
+        Serializer rez;
+        {
+          AutoLock s_lock(summary_lock);
+          local.pack(rez);
+        }
+        runtime->send_profiler_summary(0/*target*/, rez);
+        return;
+      }
+      if (remote_done.exists() && !remote_done.has_triggered())
+        remote_done.wait();
+      AutoLock s_lock(summary_lock);
+      write_summary();
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::handle_remote_summary(
+                                                           Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+      Summary summary;
+      summary.unpack(derez);
+      AutoLock s_lock(summary_lock);
+      local.merge(summary);
+#ifdef DEBUG_LEGION
+      assert(received_remote < expected_remote);
+#endif
+      if (++received_remote == expected_remote)
+        Runtime::trigger_event(remote_done);
+    }
+
+    //--------------------------------------------------------------------------
+    static void write_histogram(FILE *f, const char *label,
+              const LegionProfSummarySerializer::Histogram &hist, bool bytes)
+    //--------------------------------------------------------------------------
+    {
+      // All latencies are reported in microseconds
+      fprintf(f, "%s count=%llu mean=%.3f min=%.3f p50=%.3f p90=%.3f "
+              "p99=%.3f max=%.3f", label, hist.count,
+              double(hist.total) / (1e3 * hist.count), 1e-3 * hist.min,
+              1e-3 * hist.percentile(0.5), 1e-3 * hist.percentile(0.9),
+              1e-3 * hist.percentile(0.99), 1e-3 * hist.max);
+      if (bytes)
+        fprintf(f, " bytes=%llu", hist.bytes);
+      fprintf(f, "\n");
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::write_summary(void) const
+    //--------------------------------------------------------------------------
+    {
+      FILE *f = fopen(filename.c_str(), "w");
+      if (!f)
+        REPORT_LEGION_ERROR(ERROR_INVALID_PROFILER_FILE,
+            "Unable to open legion logfile %s for writing!", filename.c_str())
+      fprintf(f, "# Legion profiling summary from %d node(s), "
+              "latencies in microseconds\n", expected_remote + 1);
+      char label[256];
+      fprintf(f, "[tasks]\n");
+      for (std::map<ProcKey,Histogram>::const_iterator it = 
+            local.tasks.begin(); it != local.tasks.end(); it++)
+      {
+        std::map<TaskID,std::string>::const_iterator finder = 
+          task_names.find(it->first.first);
+        std::map<ProcID,ProcKind>::const_iterator kind = 
+          local.proc_kinds.find(it->first.second);
+        snprintf(label, sizeof(label), "%s (%u) proc=" IDFMT " kind=%d",
+            (finder == task_names.end()) ? "unknown" : finder->second.c_str(),
+            it->first.first, it->first.second,
+            (kind == local.proc_kinds.end()) ? -1 : int(kind->second));
+        write_histogram(f, label, it->second, false/*bytes*/);
+      }
+      const std::map<ProcKey,Histogram> *const call_maps[3] = 
+        { &local.meta_tasks, &local.mapper_calls, &local.runtime_calls };
+      const std::map<unsigned,std::string> *const call_names[3] = 
+        { &meta_names, &mapper_call_names, &runtime_call_names };
+      const char *const call_sections[3] = 
+        { "[meta-tasks]", "[mapper-calls]", "[runtime-calls]" };
+      for (unsigned idx = 0; idx < 3; idx++)
+      {
+        fprintf(f, "%s\n", call_sections[idx]);
+        for (std::map<ProcKey,Histogram>::const_iterator it = 
+              call_maps[idx]->begin(); it != call_maps[idx]->end(); it++)
+        {
+          std::map<unsigned,std::string>::const_iterator finder =
+            call_names[idx]->find(it->first.first);
+          snprintf(label, sizeof(label), "%s (%u) proc=" IDFMT,
+              (finder == call_names[idx]->end()) ? "unknown" :
+              finder->second.c_str(), it->first.first, it->first.second);
+          write_histogram(f, label, it->second, false/*bytes*/);
+        }
+      }
+      fprintf(f, "[copies]\n");
+      for (std::map<ChannelKey,Histogram>::const_iterator it = 
+            local.copies.begin(); it != local.copies.end(); it++)
+      {
+        std::map<MemID,MemKind>::const_iterator src_kind =
+          local.mem_kinds.find(it->first.first);
+        std::map<MemID,MemKind>::const_iterator dst_kind =
+          local.mem_kinds.find(it->first.second);
+        snprintf(label, sizeof(label), "src=" IDFMT " kind=%d dst=" IDFMT
+            " kind=%d", it->first.first,
+            (src_kind == local.mem_kinds.end()) ? -1 : int(src_kind->second),
+            it->first.second,
+            (dst_kind == local.mem_kinds.end()) ? -1 : int(dst_kind->second));
+        write_histogram(f, label, it->second, true/*bytes*/);
+      }
+      fprintf(f, "[fills]\n");
+      for (std::map<ChannelKey,Histogram>::const_iterator it = 
+            local.fills.begin(); it != local.fills.end(); it++)
+      {
+        std::map<MemID,MemKind>::const_iterator dst_kind =
+          local.mem_kinds.find(it->first.second);
+        snprintf(label, sizeof(label), "dst=" IDFMT " kind=%d",
+            it->first.second,
+            (dst_kind == local.mem_kinds.end()) ? -1 : int(dst_kind->second));
+        write_histogram(f, label, it->second, false/*bytes*/);
+      }
+      fclose(f);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                const LegionProfDesc::MapperCallDesc &call_desc)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      mapper_call_names[call_desc.kind] = call_desc.name;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                               const LegionProfDesc::RuntimeCallDesc &call_desc)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      runtime_call_names[call_desc.kind] = call_desc.name;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                      const LegionProfDesc::MetaDesc &meta_desc)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      meta_names[meta_desc.kind] = meta_desc.name;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                 const LegionProfInstance::TaskKind &task_kind)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      if (task_kind.overwrite || 
+          (task_names.find(task_kind.task_id) == task_names.end()))
+        task_names[task_kind.task_id] = task_kind.name;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                 const LegionProfInstance::TaskInfo &task_info)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.tasks[ProcKey(task_info.task_id, task_info.proc_id)].record(
+          task_info.start, task_info.stop);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                              const LegionProfInstance::GPUTaskInfo &task_info)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.tasks[ProcKey(task_info.task_id, task_info.proc_id)].record(
+          task_info.start, task_info.stop);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                 const LegionProfInstance::MetaInfo &meta_info)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.meta_tasks[ProcKey(meta_info.lg_id, meta_info.proc_id)].record(
+          meta_info.start, meta_info.stop);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                 const LegionProfInstance::CopyInfo &copy_info)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.copies[ChannelKey(copy_info.src, copy_info.dst)].record(
+          copy_info.start, copy_info.stop, copy_info.size);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                 const LegionProfInstance::FillInfo &fill_info)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.fills[ChannelKey(0, fill_info.dst)].record(
+          fill_info.start, fill_info.stop);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                          const LegionProfInstance::MapperCallInfo &call_info)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.mapper_calls[ProcKey(call_info.kind, call_info.proc_id)].record(
+          call_info.start, call_info.stop);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                         const LegionProfInstance::RuntimeCallInfo &call_info)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.runtime_calls[ProcKey(call_info.kind, call_info.proc_id)].record(
+          call_info.start, call_info.stop);
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                const LegionProfInstance::ProcDesc &proc_desc)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.proc_kinds[proc_desc.proc_id] = proc_desc.kind;
+    }
+
+    //--------------------------------------------------------------------------
+    void LegionProfSummarySerializer::serialize(
+                                  const LegionProfInstance::MemDesc &mem_desc)
+    //--------------------------------------------------------------------------
+    {
+      AutoLock s_lock(summary_lock);
+      local.mem_kinds[mem_desc.mem_id] = mem_desc.kind;
+    }
 
     ///////////////////////// LegionProfASCIISerializer ///////////////////////
 
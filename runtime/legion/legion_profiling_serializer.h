@@ -15,23 +15,13 @@
 #ifndef __LEGION_PROFILING_SERIALIZER_H__
 #define __LEGION_PROFILING_SERIALIZER_H__
 
+#include <map>
 #include <string>
 #include <stdio.h>
 #include "legion/legion_profiling.h"
 
 #ifdef LEGION_USE_ZLIB
 #include <zlib.h>
-// lp_fopen expects filename to be a std::string
-#define lp_fopen(filename, mode)      gzopen(filename.c_str(),mode)
-#define lp_fwrite(f, data, num_bytes) gzwrite(f,data,num_bytes)
-#define lp_fflush(f, mode)            gzflush(f,mode)
-#define lp_fclose(f)                  gzclose(f)
-#else
-// lp_fopen expects filename to be a std::string
-#define lp_fopen(filename, mode)      fopen(filename.c_str(),mode)
-#define lp_fwrite(f, data, num_bytes) fwrite(data,num_bytes,1,f)
-#define lp_fflush(f, mode)            fflush(f)
-#define lp_fclose(f)                  fclose(f)
 #endif
 
 namespace Legion {
@@ -42,6 +32,12 @@ namespace Legion {
       virtual ~LegionProfSerializer() {};
 
       virtual bool is_thread_safe(void) const = 0;
+      // Serializers that only aggregate records want to see them as soon
+      // as they arrive so the profiler does not have to buffer them
+      virtual bool is_aggregating(void) const { return false; }
+      // Push out any buffered data and wait for it to be written, called
+      // once by the profiler after all the instances have been dumped
+      virtual void flush(void) { }
       // You must override the following functions in your implementation
       virtual void serialize(const LegionProfDesc::MapperCallDesc&) = 0;
       virtual void serialize(const LegionProfDesc::RuntimeCallDesc&) = 0;
@@ -99,14 +95,39 @@ namespace Legion {
     };
 
     // This is the Internal Binary Format Serializer
+    // Records are appended to an in-memory chunk which is handed off to a
+    // meta-task on the utility processors to be compressed (each chunk as
+    // an independent gzip member) and written out once it fills up
     class LegionProfBinarySerializer: public LegionProfSerializer {
     public:
-      LegionProfBinarySerializer(std::string filename);
+      enum CompressionKind {
+        NO_COMPRESSION,
+        GZIP_COMPRESSION,
+      };
+      static const size_t CHUNK_SIZE = 4 << 20;
+      struct FlushChunkArgs : public LgTaskArgs<FlushChunkArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_FLUSH_PROFILER_CHUNK_TASK_ID;
+      public:
+        FlushChunkArgs(LegionProfBinarySerializer *s, char *b, size_t sz)
+          : LgTaskArgs<FlushChunkArgs>(implicit_provenance),
+            serializer(s), buffer(b), size(sz) { }
+      public:
+        LegionProfBinarySerializer *const serializer;
+        char *const buffer;
+        const size_t size;
+      };
+    public:
+      LegionProfBinarySerializer(Runtime *runtime, std::string filename,
+                                 CompressionKind compression,
+                                 size_t footprint_threshold);
       ~LegionProfBinarySerializer();
 
       void writePreamble();
 
       bool is_thread_safe(void) const { return false; }
+      virtual void flush(void);
+      static void handle_flush_chunk(const void *args);
       // Serialize Methods
       void serialize(const LegionProfDesc::MapperCallDesc&);
       void serialize(const LegionProfDesc::RuntimeCallDesc&);
@@ -158,10 +179,24 @@ namespace Legion {
       void serialize(const LegionProfInstance::ProfTaskInfo&);
 #endif
     private:
-#ifdef LEGION_USE_ZLIB
-      gzFile f;
-#else
+      inline void lp_append(const void *data, size_t num_bytes);
+      void issue_chunk(void);
+      void write_chunk(const char *buffer, size_t size);
+    private:
+      Runtime *const runtime;
       FILE *f;
+      const CompressionKind compression;
+      // Bound on the bytes handed off but not yet written
+      const size_t footprint_threshold;
+      char *chunk;
+      size_t chunk_used;
+      // Chunks are written in order by chaining each flush on the last
+      RtEvent last_flush;
+      std::atomic<size_t> pending_bytes;
+#ifdef LEGION_USE_ZLIB
+      // Only touched by the flush tasks which are serialized
+      z_stream zstream;
+      std::vector<char> compressed;
 #endif
       enum LegionProfInstanceIDs {
         MESSAGE_DESC_ID,
@@ -214,6 +249,125 @@ namespace Legion {
       };
     };
 
+    // Low-overhead serializer for production runs: rather than writing out
+    // every record it folds them into latency histograms and byte counters
+    // per task kind, processor and channel as they arrive, so the memory
+    // footprint depends on the number of kinds and not the number of
+    // records. At finalization every profiled node sends its summary to
+    // node 0 which writes a single text summary.
+    class LegionProfSummarySerializer: public LegionProfSerializer {
+    public:
+      // Latencies in nanoseconds bucketed by powers of two
+      struct Histogram {
+      public:
+        static const unsigned NUM_BUCKETS = 48;
+      public:
+        Histogram(void);
+      public:
+        void record(timestamp_t start, timestamp_t stop,
+                    unsigned long long bytes = 0);
+        void merge(const Histogram &rhs);
+        timestamp_t percentile(double fraction) const;
+      public:
+        unsigned long long count, bytes;
+        timestamp_t total, min, max;
+        unsigned long long buckets[NUM_BUCKETS];
+      };
+      // (kind, processor) for tasks, meta-tasks and calls
+      typedef std::pair<unsigned,ProcID> ProcKey;
+      // (source, destination) for copies and fills
+      typedef std::pair<MemID,MemID> ChannelKey;
+      struct Summary {
+      public:
+        void merge(const Summary &rhs);
+        void pack(Serializer &rez) const;
+        void unpack(Deserializer &derez);
+      public:
+        std::map<ProcKey,Histogram> tasks, meta_tasks;
+        std::map<ProcKey,Histogram> mapper_calls, runtime_calls;
+        std::map<ChannelKey,Histogram> copies, fills;
+        std::map<ProcID,ProcKind> proc_kinds;
+        std::map<MemID,MemKind> mem_kinds;
+      };
+    public:
+      LegionProfSummarySerializer(Runtime *runtime, std::string filename);
+      ~LegionProfSummarySerializer();
+
+      bool is_thread_safe(void) const { return true; }
+      virtual bool is_aggregating(void) const { return true; }
+      virtual void flush(void);
+      void handle_remote_summary(Deserializer &derez);
+      // Serialize Methods
+      void serialize(const LegionProfDesc::MapperCallDesc&);
+      void serialize(const LegionProfDesc::RuntimeCallDesc&);
+      void serialize(const LegionProfDesc::MetaDesc&);
+      void serialize(const LegionProfDesc::OpDesc&) { }
+      void serialize(const LegionProfDesc::MaxDimDesc&) { }
+      void serialize(const LegionProfInstance::IndexSpacePointDesc&) { }
+      void serialize(const LegionProfInstance::IndexSpaceRectDesc&) { }
+      void serialize(const LegionProfInstance::IndexSpaceEmptyDesc&) { }
+      void serialize(const LegionProfInstance::FieldDesc&) { }
+      void serialize(const LegionProfInstance::FieldSpaceDesc&) { }
+      void serialize(const LegionProfInstance::IndexPartDesc&) { }
+      void serialize(const LegionProfInstance::IndexPartitionDesc&) { }
+      void serialize(const LegionProfInstance::IndexSpaceDesc&) { }
+      void serialize(const LegionProfInstance::IndexSubSpaceDesc&) { }
+      void serialize(const LegionProfInstance::LogicalRegionDesc&) { }
+      void serialize(const LegionProfInstance::PhysicalInstRegionDesc&) { }
+      void serialize(const LegionProfInstance::PhysicalInstLayoutDesc&) { }
+      void serialize(const LegionProfInstance::PhysicalInstDimOrderDesc&) { }
+      void serialize(const LegionProfInstance::IndexSpaceSizeDesc&) { }
+      void serialize(const LegionProfInstance::TaskKind&);
+      void serialize(const LegionProfInstance::TaskVariant&) { }
+      void serialize(const LegionProfInstance::OperationInstance&) { }
+      void serialize(const LegionProfInstance::MultiTask&) { }
+      void serialize(const LegionProfInstance::SliceOwner&) { }
+      void serialize(const LegionProfInstance::WaitInfo,
+                     const LegionProfInstance::TaskInfo&) { }
+      void serialize(const LegionProfInstance::WaitInfo,
+                     const LegionProfInstance::GPUTaskInfo&) { }
+      void serialize(const LegionProfInstance::WaitInfo,
+                     const LegionProfInstance::MetaInfo&) { }
+      void serialize(const LegionProfInstance::TaskInfo&);
+      void serialize(const LegionProfInstance::MetaInfo&);
+      void serialize(const LegionProfInstance::CopyInfo&);
+      void serialize(const LegionProfInstance::FillInfo&);
+      void serialize(const LegionProfInstance::InstCreateInfo&) { }
+      void serialize(const LegionProfInstance::InstUsageInfo&) { }
+      void serialize(const LegionProfInstance::InstTimelineInfo&) { }
+      void serialize(const LegionProfInstance::PartitionInfo&) { }
+      void serialize(const LegionProfInstance::MapperCallInfo&);
+      void serialize(const LegionProfInstance::RuntimeCallInfo&);
+      void serialize(const LegionProfInstance::GPUTaskInfo&);
+      void serialize(const LegionProfInstance::CopyInstInfo&,
+                     const LegionProfInstance::CopyInfo&) { }
+      void serialize(const LegionProfInstance::ProcDesc&);
+      void serialize(const LegionProfInstance::MemDesc&);
+      void serialize(const LegionProfInstance::ProcMemDesc&) { }
+#ifdef LEGION_PROF_SELF_PROFILE
+      void serialize(const LegionProfInstance::ProfTaskInfo&) { }
+#endif
+    private:
+      void write_summary(void) const;
+    private:
+      Runtime *const runtime;
+      const std::string filename;
+      // Number of other nodes that will send us their summaries
+      const unsigned expected_remote;
+      // Records are folded in by whichever thread produced them and remote
+      // summaries arrive from message handlers so everything is protected
+      // by the summary lock
+      mutable LocalLock summary_lock;
+      Summary local;
+      // Names are only needed on node 0 where the summary is written
+      std::map<TaskID,std::string> task_names;
+      std::map<unsigned,std::string> meta_names;
+      std::map<unsigned,std::string> mapper_call_names;
+      std::map<unsigned,std::string> runtime_call_names;
+      unsigned received_remote;
+      RtUserEvent remote_done;
+    };
+
     // This is the Old ASCII Serializer
     class LegionProfASCIISerializer: public LegionProfSerializer {
     public:
@@ -38,6 +38,7 @@
 #endif
 
 #include "legion/legion_config.h"
+#include "realm/redop.h"
 
 #include <cstdint>
 
@@ -102,6 +103,8 @@ namespace Legion {
 
     static const int32_t identity = 0;
     static constexpr int REDOP_ID = LEGION_REDOP_SUM_INT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_SUM;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -117,6 +120,8 @@ namespace Legion {
 
     static const int64_t identity = 0;
     static constexpr int REDOP_ID = LEGION_REDOP_SUM_INT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_SUM;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -162,6 +167,8 @@ namespace Legion {
 
     static const uint32_t identity = 0;
     static constexpr int REDOP_ID = LEGION_REDOP_SUM_UINT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_SUM;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -177,6 +184,8 @@ namespace Legion {
 
     static const uint64_t identity = 0;
     static constexpr int REDOP_ID = LEGION_REDOP_SUM_UINT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_SUM;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -209,6 +218,8 @@ namespace Legion {
 
     static const float identity;
     static constexpr int REDOP_ID = LEGION_REDOP_SUM_FLOAT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_SUM;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -224,6 +235,8 @@ namespace Legion {
 
     static const double identity;
     static constexpr int REDOP_ID = LEGION_REDOP_SUM_FLOAT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_SUM;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -550,6 +563,8 @@ namespace Legion {
 
     static const int32_t identity = 1;
     static constexpr int REDOP_ID = LEGION_REDOP_PROD_INT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_PROD;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -565,6 +580,8 @@ namespace Legion {
 
     static const int64_t identity = 1;
     static constexpr int REDOP_ID = LEGION_REDOP_PROD_INT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_PROD;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -610,6 +627,8 @@ namespace Legion {
 
     static const uint32_t identity = 1;
     static constexpr int REDOP_ID = LEGION_REDOP_PROD_UINT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_PROD;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -625,6 +644,8 @@ namespace Legion {
 
     static const uint64_t identity = 1;
     static constexpr int REDOP_ID = LEGION_REDOP_PROD_UINT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_PROD;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -657,6 +678,8 @@ namespace Legion {
 
     static const float identity;
     static constexpr int REDOP_ID = LEGION_REDOP_PROD_FLOAT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_PROD;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -672,6 +695,8 @@ namespace Legion {
 
     static const double identity;
     static constexpr int REDOP_ID = LEGION_REDOP_PROD_FLOAT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_PROD;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -979,6 +1004,8 @@ namespace Legion {
 
     static const int32_t identity = INT_MIN;
     static constexpr int REDOP_ID = LEGION_REDOP_MAX_INT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MAX;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -994,6 +1021,8 @@ namespace Legion {
 
     static const int64_t identity = LLONG_MIN;
     static constexpr int REDOP_ID = LEGION_REDOP_MAX_INT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MAX;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1039,6 +1068,8 @@ namespace Legion {
 
     static const uint32_t identity = 0;
     static constexpr int REDOP_ID = LEGION_REDOP_MAX_UINT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MAX;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1054,6 +1085,8 @@ namespace Legion {
 
     static const uint64_t identity = 0;
     static constexpr int REDOP_ID = LEGION_REDOP_MAX_UINT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MAX;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1086,6 +1119,8 @@ namespace Legion {
 
     static const float identity;
     static constexpr int REDOP_ID = LEGION_REDOP_MAX_FLOAT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MAX;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1101,6 +1136,8 @@ namespace Legion {
 
     static const double identity;
     static constexpr int REDOP_ID = LEGION_REDOP_MAX_FLOAT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MAX;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1167,6 +1204,8 @@ namespace Legion {
 
     static const int32_t identity = INT_MAX;
     static constexpr int REDOP_ID = LEGION_REDOP_MIN_INT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MIN;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1182,6 +1221,8 @@ namespace Legion {
 
     static const int64_t identity = LLONG_MAX;
     static constexpr int REDOP_ID = LEGION_REDOP_MIN_INT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MIN;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1227,6 +1268,8 @@ namespace Legion {
 
     static const uint32_t identity = UINT_MAX;
     static constexpr int REDOP_ID = LEGION_REDOP_MIN_UINT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MIN;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1242,6 +1285,8 @@ namespace Legion {
 
     static const uint64_t identity = ULLONG_MAX;
     static constexpr int REDOP_ID = LEGION_REDOP_MIN_UINT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MIN;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1274,6 +1319,8 @@ namespace Legion {
 
     static const float identity;
     static constexpr int REDOP_ID = LEGION_REDOP_MIN_FLOAT32;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MIN;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1289,6 +1336,8 @@ namespace Legion {
 
     static const double identity;
     static constexpr int REDOP_ID = LEGION_REDOP_MIN_FLOAT64;
+    static constexpr Realm::ReductionKernels::DenseKind dense_kind =
+      Realm::ReductionKernels::DENSE_MIN;
 
     template<bool EXCLUSIVE> __CUDA_HD__
     static void apply(LHS &lhs, RHS rhs);
@@ -1137,6 +1137,318 @@ namespace Legion {
       deps.push_back(record);
     }
 
+    /////////////////////////////////////////////////////////////
+    // AutoTraceDetector
+    /////////////////////////////////////////////////////////////
+
+    // Base for the rolling hashes over the operation stream
+    static const uint64_t AUTO_TRACE_HASH_BASE = 0x100000001b3ULL;
+
+    //--------------------------------------------------------------------------
+    static inline uint64_t combine_auto_trace_hash(uint64_t hash,
+                                                   uint64_t value)
+    //--------------------------------------------------------------------------
+    {
+      return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+    }
+
+    //--------------------------------------------------------------------------
+    static uint64_t hash_auto_trace_domain(uint64_t hash, const Domain &domain)
+    //--------------------------------------------------------------------------
+    {
+      const int dim = domain.get_dim();
+      hash = combine_auto_trace_hash(hash, dim);
+      if (dim == 0)
+        return hash;
+      hash = combine_auto_trace_hash(hash, domain.is_id);
+      const DomainPoint lo = domain.lo(), hi = domain.hi();
+      for (int idx = 0; idx < dim; idx++)
+      {
+        hash = combine_auto_trace_hash(hash, lo[idx]);
+        hash = combine_auto_trace_hash(hash, hi[idx]);
+      }
+      return hash;
+    }
+
+    //--------------------------------------------------------------------------
+    static uint64_t hash_auto_trace_buffer(uint64_t hash, const void *buffer,
+                                           size_t size)
+    //--------------------------------------------------------------------------
+    {
+      hash = combine_auto_trace_hash(hash, size);
+      const uint8_t *bytes = static_cast<const uint8_t*>(buffer);
+      size_t offset = 0;
+      for ( ; (offset + sizeof(uint64_t)) <= size; offset += sizeof(uint64_t))
+      {
+        uint64_t word;
+        memcpy(&word, bytes + offset, sizeof(word));
+        hash = combine_auto_trace_hash(hash, word);
+      }
+      for ( ; offset < size; offset++)
+        hash = combine_auto_trace_hash(hash, bytes[offset]);
+      return hash;
+    }
+
+    //--------------------------------------------------------------------------
+    static uint64_t hash_auto_trace_requirements(uint64_t hash,
+                                    const std::vector<RegionRequirement> &reqs)
+    //--------------------------------------------------------------------------
+    {
+      hash = combine_auto_trace_hash(hash, reqs.size());
+      for (std::vector<RegionRequirement>::const_iterator it =
+            reqs.begin(); it != reqs.end(); it++)
+      {
+        hash = combine_auto_trace_hash(hash, it->handle_type);
+        if (it->handle_type == LEGION_PARTITION_PROJECTION)
+          hash = combine_auto_trace_hash(hash,
+              it->partition.get_index_partition().get_id());
+        else
+          hash = combine_auto_trace_hash(hash,
+              it->region.get_index_space().get_id());
+        hash = combine_auto_trace_hash(hash, it->parent.get_tree_id());
+        hash = combine_auto_trace_hash(hash,
+            it->parent.get_index_space().get_id());
+        hash = combine_auto_trace_hash(hash,
+            it->parent.get_field_space().get_id());
+        hash = combine_auto_trace_hash(hash, it->projection);
+        hash = combine_auto_trace_hash(hash, it->privilege);
+        hash = combine_auto_trace_hash(hash, it->prop);
+        hash = combine_auto_trace_hash(hash, it->redop);
+        hash = combine_auto_trace_hash(hash, it->flags);
+        hash = combine_auto_trace_hash(hash, it->privilege_fields.size());
+        for (std::set<FieldID>::const_iterator fit =
+              it->privilege_fields.begin(); fit !=
+              it->privilege_fields.end(); fit++)
+          hash = combine_auto_trace_hash(hash, *fit);
+      }
+      return hash;
+    }
+
+    //--------------------------------------------------------------------------
+    AutoTraceDetector::AutoTraceDetector(InnerContext *ctx, unsigned min_len,
+                                         unsigned win)
+      : context(ctx), min_length(std::max(min_len, 1U)),
+        window(std::max(win, 2*std::max(min_len, 1U))),
+        traced_ops(0), untraced_ops(0)
+    //--------------------------------------------------------------------------
+    {
+      prefix.push_back(0);
+      powers.push_back(1);
+    }
+
+    //--------------------------------------------------------------------------
+    AutoTraceDetector::~AutoTraceDetector(void)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(buffer.empty());
+#endif
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ bool AutoTraceDetector::is_traceable(Operation *op)
+    //--------------------------------------------------------------------------
+    {
+      switch (op->get_operation_kind())
+      {
+        case Operation::TASK_OP_KIND:
+          {
+            const Task *task = op->get_mappable()->as_task();
+            // Output regions change shape every time they are run
+            return task->output_regions.empty();
+          }
+        case Operation::COPY_OP_KIND:
+        case Operation::FILL_OP_KIND:
+          return true;
+        default:
+          break;
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    /*static*/ uint64_t AutoTraceDetector::hash_operation(Operation *op)
+    //--------------------------------------------------------------------------
+    {
+      uint64_t hash = combine_auto_trace_hash(0, op->get_operation_kind());
+      const Mappable *mappable = op->get_mappable();
+      // Operations only match if the mapper would see the same thing and
+      // they are guarded in the same way
+      hash = combine_auto_trace_hash(hash, mappable->map_id);
+      hash = combine_auto_trace_hash(hash, mappable->tag);
+      hash = combine_auto_trace_hash(hash, op->is_predicated_op());
+      switch (op->get_operation_kind())
+      {
+        case Operation::TASK_OP_KIND:
+          {
+            const Task *task = mappable->as_task();
+            hash = combine_auto_trace_hash(hash, task->task_id);
+            hash = combine_auto_trace_hash(hash, task->is_index_space);
+            if (task->is_index_space)
+              hash = hash_auto_trace_domain(hash, task->index_domain);
+            hash = hash_auto_trace_requirements(hash, task->regions);
+            hash = hash_auto_trace_buffer(hash, task->args, task->arglen);
+            break;
+          }
+        case Operation::COPY_OP_KIND:
+          {
+            const Copy *copy = mappable->as_copy();
+            hash = combine_auto_trace_hash(hash, copy->is_index_space);
+            if (copy->is_index_space)
+              hash = hash_auto_trace_domain(hash, copy->index_domain);
+            hash = hash_auto_trace_requirements(hash, copy->src_requirements);
+            hash = hash_auto_trace_requirements(hash, copy->dst_requirements);
+            hash = hash_auto_trace_requirements(hash,
+                                        copy->src_indirect_requirements);
+            hash = hash_auto_trace_requirements(hash,
+                                        copy->dst_indirect_requirements);
+            break;
+          }
+        case Operation::FILL_OP_KIND:
+          {
+            const Fill *fill = mappable->as_fill();
+            hash = combine_auto_trace_hash(hash, fill->is_index_space);
+            if (fill->is_index_space)
+              hash = hash_auto_trace_domain(hash, fill->index_domain);
+            const std::vector<RegionRequirement> reqs(1, fill->requirement);
+            hash = hash_auto_trace_requirements(hash, reqs);
+            break;
+          }
+        default:
+          assert(false);
+      }
+      return hash;
+    }
+
+    //--------------------------------------------------------------------------
+    bool AutoTraceDetector::record_operation(Operation *op, Match &match)
+    //--------------------------------------------------------------------------
+    {
+      const uint64_t hash = hash_operation(op);
+      buffer.push_back(op);
+      history.push_back(hash);
+      prefix.push_back(prefix.back() * AUTO_TRACE_HASH_BASE + hash);
+      if (powers.size() < prefix.size())
+        powers.push_back(powers.back() * AUTO_TRACE_HASH_BASE);
+      const size_t total = history.size();
+      const size_t buffered = buffer.size();
+      // First see if the end of the buffer is a trace that we already know
+      // about, preferring the longest such trace
+      for (std::set<size_t>::const_reverse_iterator it =
+            known_lengths.rbegin(); it != known_lengths.rend(); it++)
+      {
+        const size_t length = *it;
+        if (length > buffered)
+          continue;
+        const uint64_t key = compute_range_hash(total - length, length);
+        std::map<std::pair<uint64_t,size_t>,KnownTrace>::iterator finder =
+          known_traces.find(std::make_pair(key, length));
+        if (finder == known_traces.end())
+          continue;
+        if (!std::equal(finder->second.hashes.begin(),
+              finder->second.hashes.end(), history.end() - length))
+          continue;
+        finder->second.replays++;
+        match.start = buffered - length;
+        match.length = length;
+        match.tid = finder->second.tid;
+        return true;
+      }
+      // Otherwise look for the shortest sequence at the end of the buffer
+      // that repeats the sequence issued just before it
+      for (size_t length = min_length;
+            (length <= buffered) && ((2*length) <= total); length++)
+      {
+        const uint64_t key = compute_range_hash(total - length, length);
+        if (key != compute_range_hash(total - 2*length, length))
+          continue;
+        if (!equal_ranges(total - 2*length, total - length, length))
+          continue;
+        KnownTrace &trace = known_traces[std::make_pair(key, length)];
+        trace.tid = context->generate_dynamic_trace_id();
+        trace.hashes.assign(history.end() - length, history.end());
+        trace.replays = 0;
+        known_lengths.insert(length);
+        log_tracing.info("Automatically detected trace %d of %zd operations "
+            "in task %s (UID %lld)", trace.tid, length,
+            context->get_task_name(), context->get_unique_id());
+        match.start = buffered - length;
+        match.length = length;
+        match.tid = trace.tid;
+        return true;
+      }
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    Operation* AutoTraceDetector::pop_operation(bool traced)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(!buffer.empty());
+#endif
+      Operation *result = buffer.front();
+      buffer.pop_front();
+      if (traced)
+        traced_ops++;
+      else
+        untraced_ops++;
+      trim_history();
+      return result;
+    }
+
+    //--------------------------------------------------------------------------
+    void AutoTraceDetector::report_statistics(void) const
+    //--------------------------------------------------------------------------
+    {
+      if ((traced_ops + untraced_ops) == 0)
+        return;
+      uint64_t replays = 0;
+      for (std::map<std::pair<uint64_t,size_t>,KnownTrace>::const_iterator
+            it = known_traces.begin(); it != known_traces.end(); it++)
+        replays += it->second.replays;
+      log_tracing.print("Auto tracing in task %s (UID %lld): %zd traces "
+          "detected, %lld replays, %lld operations traced (hits), %lld "
+          "operations not traced (misses), %.1f%% hit rate",
+          context->get_task_name(), context->get_unique_id(),
+          known_traces.size(), (long long)replays, (long long)traced_ops,
+          (long long)untraced_ops,
+          100.0 * traced_ops / (traced_ops + untraced_ops));
+    }
+
+    //--------------------------------------------------------------------------
+    uint64_t AutoTraceDetector::compute_range_hash(size_t start,
+                                                   size_t length) const
+    //--------------------------------------------------------------------------
+    {
+      return prefix[start + length] - prefix[start] * powers[length];
+    }
+
+    //--------------------------------------------------------------------------
+    bool AutoTraceDetector::equal_ranges(size_t first, size_t second,
+                                         size_t length) const
+    //--------------------------------------------------------------------------
+    {
+      return std::equal(history.begin() + first,
+          history.begin() + first + length, history.begin() + second);
+    }
+
+    //--------------------------------------------------------------------------
+    void AutoTraceDetector::trim_history(void)
+    //--------------------------------------------------------------------------
+    {
+      // We only ever need the buffered operations plus one more window
+      // of history to find a repeat, so only rebuild the prefix hashes
+      // once we have accumulated twice that much
+      if (history.size() < (4*window))
+        return;
+      history.erase(history.begin(), history.end() - 2*window);
+      prefix.resize(1);
+      for (std::vector<uint64_t>::const_iterator it =
+            history.begin(); it != history.end(); it++)
+        prefix.push_back(prefix.back() * AUTO_TRACE_HASH_BASE + *it);
+    }
+
     /////////////////////////////////////////////////////////////
     // TraceOp 
     /////////////////////////////////////////////////////////////
@@ -3904,6 +4216,10 @@ namespace Legion {
         pending_transitive_reduction.load();
       if (transitive_reduction != NULL)
         delete transitive_reduction;
+      for (std::vector<SubgraphReplay>::const_iterator it =
+            replay_subgraphs.begin(); it != replay_subgraphs.end(); it++)
+        if (it->subgraph.exists())
+          it->subgraph.destroy();
     }
 
     //--------------------------------------------------------------------------
@@ -4157,6 +4473,17 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(slice_idx < slices.size());
 #endif
+      if (!replay_subgraphs.empty() &&
+          replay_subgraphs[slice_idx].subgraph.exists())
+      {
+        execute_subgraph_replay(replay_subgraphs[slice_idx], recurrent_replay);
+        return;
+      }
+      if (!compiled_slices.empty())
+      {
+        execute_compiled_slice(compiled_slices[slice_idx], recurrent_replay);
+        return;
+      }
       // should be able to read front() even while new maps for operations 
       // are begin appended to the back of 'operations'
       std::map<TraceLocalID,Memoizable*> &ops = operations.front();
@@ -4166,6 +4493,85 @@ namespace Legion {
         (*it)->execute(events, user_events, ops, recurrent_replay);
     }
 
+    //--------------------------------------------------------------------------
+    void PhysicalTemplate::execute_compiled_slice(const CompiledSlice &slice,
+                                                  bool recurrent_replay)
+    //--------------------------------------------------------------------------
+    {
+      std::map<TraceLocalID,Memoizable*> &ops = operations.front();
+      const unsigned *const operands = slice.operands.data();
+      // Events are not added or removed while we are replaying so it
+      // is safe to index directly into the slots 
+      ApEvent *const slots = events.data();
+      std::vector<ApEvent> to_merge;
+      to_merge.reserve(slice.max_merge);
+      for (std::vector<ReplayCode>::const_iterator it =
+            slice.code.begin(); it != slice.code.end(); it++)
+      {
+        switch (it->opcode)
+        {
+          case REPLAY_MERGE_EVENT:
+            {
+              to_merge.clear();
+              for (unsigned idx = 0; idx < it->count; idx++)
+                to_merge.push_back(slots[operands[it->arg + idx]]);
+              slots[it->lhs] = Runtime::merge_events(NULL, to_merge);
+              break;
+            }
+          case REPLAY_TRIGGER_EVENT:
+            {
+              // The slot holds the user event created for it earlier
+              Realm::UserEvent to_trigger;
+              to_trigger.id = slots[it->lhs].id;
+#ifdef DEBUG_LEGION
+              assert(to_trigger.exists());
+#endif
+              Runtime::trigger_event(NULL, ApUserEvent(to_trigger),
+                                     slots[it->arg]);
+              break;
+            }
+          case REPLAY_CREATE_USER_EVENT:
+            {
+              slots[it->lhs] = Runtime::create_ap_user_event(NULL);
+              break;
+            }
+          case REPLAY_ASSIGN_FENCE:
+            {
+              slots[it->lhs] = fence_completion;
+              break;
+            }
+          case REPLAY_EXECUTE:
+            {
+              slice.instructions[it->arg]->execute(events, user_events,
+                                                   ops, recurrent_replay);
+              break;
+            }
+          default:
+            assert(false);
+        }
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    void PhysicalTemplate::execute_subgraph_replay(
+                         const SubgraphReplay &replay, bool recurrent_replay)
+    //--------------------------------------------------------------------------
+    {
+      execute_compiled_slice(replay.prologue, recurrent_replay);
+      std::vector<Realm::Event> preconditions(replay.preconditions.size());
+      for (unsigned idx = 0; idx < preconditions.size(); idx++)
+        preconditions[idx] = events[replay.preconditions[idx]];
+      std::vector<Realm::Event> postconditions(replay.postconditions.size());
+      const ApEvent done(replay.subgraph.instantiate(NULL, 0,
+            Realm::ProfilingRequestSet(), preconditions, postconditions));
+      for (unsigned idx = 0; idx < postconditions.size(); idx++)
+        events[replay.postconditions[idx]] = ApEvent(postconditions[idx]);
+      for (std::vector<unsigned>::const_iterator it =
+            replay.completions.begin(); it != replay.completions.end(); it++)
+        events[*it] = done;
+      execute_compiled_slice(replay.epilogue, recurrent_replay);
+    }
+
     //--------------------------------------------------------------------------
     void PhysicalTemplate::issue_summary_operations(
           InnerContext* context, Operation *invalidator, Provenance *provenance)
@@ -4198,6 +4604,10 @@ namespace Legion {
         return;
       }
       optimize(op, false/*do transitive reduction inline*/);
+      if (!trace->runtime->no_compiled_replay)
+        compile_replay();
+      if (trace->runtime->subgraph_replay)
+        compile_subgraph();
       std::fill(events.begin(), events.end(), ApEvent::NO_AP_EVENT);
       event_map.clear();
       // Defer performing the transitive reduction because it might
@@ -5860,6 +6270,532 @@ namespace Legion {
       }
     }
 
+    //--------------------------------------------------------------------------
+    void PhysicalTemplate::compile_replay(void)
+    //--------------------------------------------------------------------------
+    {
+      compiled_slices.clear();
+      compiled_slices.resize(slices.size());
+      // Dependence level of the instruction producing each event slot,
+      // slots that are not produced by an instruction in a slice are
+      // either frontiers or crossing events and are ready at level 0
+      std::vector<unsigned> slot_levels(events.size(), 0);
+      for (unsigned sidx = 0; sidx < slices.size(); sidx++)
+        lower_slice(slices[sidx], compiled_slices[sidx], slot_levels);
+    }
+
+    //--------------------------------------------------------------------------
+    void PhysicalTemplate::lower_slice(const std::vector<Instruction*> &slice,
+                                       CompiledSlice &compiled,
+                                       std::vector<unsigned> &slot_levels) const
+    //--------------------------------------------------------------------------
+    {
+      std::vector<unsigned> lhs_slots(slice.size());
+      std::vector<std::vector<unsigned> > rhs_slots(slice.size());
+      std::vector<std::pair<unsigned,unsigned> > order;
+      order.reserve(slice.size());
+      // Instructions for the same operation stay in program order since
+      // they can have side effects on the operation that are not
+      // visible in the events that they use
+      std::map<TraceLocalID,unsigned> owner_levels;
+      for (unsigned idx = 0; idx < slice.size(); idx++)
+      {
+        Instruction *inst = slice[idx];
+        find_instruction_events(inst, lhs_slots[idx], rhs_slots[idx]);
+        // Complete replays were pushed to the end of the slice
+        // and need to stay there
+        if (inst->get_kind() == COMPLETE_REPLAY)
+        {
+          order.push_back(std::make_pair(UINT_MAX, idx));
+          continue;
+        }
+        unsigned level = 0;
+        for (std::vector<unsigned>::const_iterator it =
+              rhs_slots[idx].begin(); it != rhs_slots[idx].end(); it++)
+          level = std::max(level, slot_levels[*it] + 1);
+        std::map<TraceLocalID,unsigned>::iterator finder =
+          owner_levels.find(inst->owner);
+        if (finder != owner_levels.end())
+        {
+          level = std::max(level, finder->second);
+          finder->second = level;
+        }
+        else
+          owner_levels[inst->owner] = level;
+        if (lhs_slots[idx] != NO_INDEX)
+          slot_levels[lhs_slots[idx]] = level;
+        if (compiled.levels <= level)
+          compiled.levels = level + 1;
+        order.push_back(std::make_pair(level, idx));
+      }
+      // Sorting on the pair keeps program order within each level
+      std::sort(order.begin(), order.end());
+      compiled.code.reserve(slice.size());
+      for (std::vector<std::pair<unsigned,unsigned> >::const_iterator it =
+            order.begin(); it != order.end(); it++)
+      {
+        const unsigned idx = it->second;
+        Instruction *inst = slice[idx];
+        ReplayCode code;
+        code.lhs = lhs_slots[idx];
+        code.arg = 0;
+        code.count = 0;
+        switch (inst->get_kind())
+        {
+          case MERGE_EVENT:
+            {
+              const std::vector<unsigned> &rhs = rhs_slots[idx];
+              code.opcode = REPLAY_MERGE_EVENT;
+              code.arg = compiled.operands.size();
+              code.count = rhs.size();
+              compiled.operands.insert(compiled.operands.end(),
+                                       rhs.begin(), rhs.end());
+              if (compiled.max_merge < code.count)
+                compiled.max_merge = code.count;
+              break;
+            }
+          case TRIGGER_EVENT:
+            {
+              TriggerEvent *trigger = inst->as_trigger_event();
+              code.opcode = REPLAY_TRIGGER_EVENT;
+              code.lhs = trigger->lhs;
+              code.arg = trigger->rhs;
+              break;
+            }
+          case CREATE_AP_USER_EVENT:
+            {
+              code.opcode = REPLAY_CREATE_USER_EVENT;
+              break;
+            }
+          case ASSIGN_FENCE_COMPLETION:
+            {
+              code.opcode = REPLAY_ASSIGN_FENCE;
+              break;
+            }
+          default:
+            {
+              code.opcode = REPLAY_EXECUTE;
+              code.arg = compiled.instructions.size();
+              compiled.instructions.push_back(inst);
+              break;
+            }
+        }
+        compiled.code.push_back(code);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    static inline bool has_indirect_fields(
+                                const std::vector<CopySrcDstField> &fields)
+    //--------------------------------------------------------------------------
+    {
+      for (std::vector<CopySrcDstField>::const_iterator it =
+            fields.begin(); it != fields.end(); it++)
+        if (it->indirect_index >= 0)
+          return true;
+      return false;
+    }
+
+    //--------------------------------------------------------------------------
+    void PhysicalTemplate::compile_subgraph(void)
+    //--------------------------------------------------------------------------
+    {
+      // Any previous replays have already instantiated them
+      for (std::vector<SubgraphReplay>::const_iterator it =
+            replay_subgraphs.begin(); it != replay_subgraphs.end(); it++)
+        if (it->subgraph.exists())
+          it->subgraph.destroy();
+      replay_subgraphs.clear();
+#ifndef LEGION_SPY
+      // Lowered copies and fills skip the profiling requests of the normal
+      // replay path so we only do this if nobody is profiling them
+      if ((trace->runtime->profiler != NULL) || !supports_subgraph_replay())
+        return;
+      // Each slice gets its own subgraph so that they can still be replayed
+      // in parallel, events from other slices are crossing events that are
+      // made before the replay starts so they are just preconditions
+      replay_subgraphs.resize(slices.size());
+      bool has_subgraph = false;
+      for (unsigned sidx = 0; sidx < slices.size(); sidx++)
+      {
+        compile_slice_subgraph(slices[sidx], replay_subgraphs[sidx]);
+        if (replay_subgraphs[sidx].subgraph.exists())
+          has_subgraph = true;
+      }
+      if (!has_subgraph)
+        replay_subgraphs.clear();
+#endif
+    }
+
+    //--------------------------------------------------------------------------
+    void PhysicalTemplate::compile_slice_subgraph(
+           const std::vector<Instruction*> &program, SubgraphReplay &replay)
+    //--------------------------------------------------------------------------
+    {
+      std::vector<unsigned> lhs_slots(program.size());
+      std::vector<std::vector<unsigned> > rhs_slots(program.size());
+      std::vector<unsigned> producers(events.size(), NO_INDEX);
+      std::vector<Realm::IndexSpaceGeneric> spaces(program.size());
+      std::vector<bool> lowered(program.size(), false);
+      bool has_lowered = false;
+      for (unsigned idx = 0; idx < program.size(); idx++)
+      {
+        Instruction *inst = program[idx];
+        find_instruction_events(inst, lhs_slots[idx], rhs_slots[idx]);
+        if (lhs_slots[idx] != NO_INDEX)
+          producers[lhs_slots[idx]] = idx;
+        IndexSpaceExpression *expr = NULL;
+        switch (inst->get_kind())
+        {
+          case ISSUE_COPY:
+            {
+              IssueCopy *copy = inst->as_issue_copy();
+              if (!copy->reservations.empty() ||
+                  has_indirect_fields(copy->src_fields) ||
+                  has_indirect_fields(copy->dst_fields))
+                continue;
+              expr = copy->expr;
+              break;
+            }
+          case ISSUE_FILL:
+            {
+              IssueFill *fill = inst->as_issue_fill();
+              if (has_indirect_fields(fill->fields))
+                continue;
+              expr = fill->expr;
+              break;
+            }
+          default:
+            continue;
+        }
+        // The index space has to be known now since it is baked into
+        // the subgraph instead of being waited on with each replay
+        const ApEvent ready =
+          expr->get_generic_index_space(spaces[idx], true/*tight*/);
+        if (ready.exists() && !ready.has_triggered())
+          continue;
+        lowered[idx] = true;
+        has_lowered = true;
+      }
+      if (!has_lowered)
+        return;
+      // Host instructions replay either before the subgraph is instantiated
+      // (stage 0) or after it (stage 1) if they need the result of one of
+      // the lowered copies. Lowered copies that would need a host result
+      // from after the instantiation go back to being issued on the host
+      // so iterate until we reach a fixed point.
+      std::vector<unsigned> stages(program.size(), 0);
+      std::vector<unsigned> to_visit;
+      std::set<unsigned> visited;
+      bool changed = true;
+      while (changed)
+      {
+        changed = false;
+        std::map<TraceLocalID,unsigned> owner_stages;
+        for (unsigned idx = 0; idx < program.size(); idx++)
+        {
+          if (lowered[idx])
+            continue;
+          unsigned stage = 0;
+          const InstructionKind kind = program[idx]->get_kind();
+          if ((kind == SET_EFFECTS) || (kind == COMPLETE_REPLAY))
+            stage = 1;
+          else
+          {
+            for (std::vector<unsigned>::const_iterator it =
+                  rhs_slots[idx].begin(); it != rhs_slots[idx].end(); it++)
+            {
+              const unsigned producer = producers[*it];
+              if ((producer != NO_INDEX) &&
+                  (lowered[producer] || (stages[producer] > 0)))
+              {
+                stage = 1;
+                break;
+              }
+            }
+          }
+          std::map<TraceLocalID,unsigned>::iterator finder =
+            owner_stages.find(program[idx]->owner);
+          if (finder != owner_stages.end())
+          {
+            if (stage < finder->second)
+              stage = finder->second;
+            else
+              finder->second = stage;
+          }
+          else
+            owner_stages[program[idx]->owner] = stage;
+          stages[idx] = stage;
+        }
+        // Merges after the instantiation can be folded into the
+        // dependences of the subgraph but nothing else can
+        for (unsigned idx = 0; idx < program.size(); idx++)
+        {
+          if (!lowered[idx])
+            continue;
+          visited.clear();
+          to_visit = rhs_slots[idx];
+          while (!to_visit.empty())
+          {
+            const unsigned slot = to_visit.back();
+            to_visit.pop_back();
+            if (!visited.insert(slot).second)
+              continue;
+            const unsigned producer = producers[slot];
+            if ((producer == NO_INDEX) || lowered[producer] ||
+                (stages[producer] == 0))
+              continue;
+            if (program[producer]->get_kind() != MERGE_EVENT)
+            {
+              lowered[idx] = false;
+              changed = true;
+              break;
+            }
+            to_visit.insert(to_visit.end(), rhs_slots[producer].begin(),
+                            rhs_slots[producer].end());
+          }
+        }
+      }
+      // Walk backwards to find which results are still needed on the host,
+      // merges after the instantiation that only feed lowered copies are
+      // dead since they were folded into the subgraph
+      std::vector<bool> host_used(events.size(), false);
+      for (std::map<unsigned,unsigned>::const_iterator it =
+            frontiers.begin(); it != frontiers.end(); it++)
+        host_used[it->first] = true;
+      std::vector<bool> elided(program.size(), false);
+      for (int idx = program.size() - 1; idx >= 0; idx--)
+      {
+        if (lowered[idx])
+          continue;
+        if ((stages[idx] > 0) && (program[idx]->get_kind() == MERGE_EVENT) &&
+            !host_used[lhs_slots[idx]])
+        {
+          elided[idx] = true;
+          continue;
+        }
+        for (std::vector<unsigned>::const_iterator it =
+              rhs_slots[idx].begin(); it != rhs_slots[idx].end(); it++)
+          host_used[*it] = true;
+      }
+      Realm::SubgraphDefinition definition;
+      definition.concurrency_mode =
+        Realm::SubgraphDefinition::INSTANTIATION_ORDER;
+      std::vector<unsigned> copy_indexes(program.size(), NO_INDEX);
+      std::map<unsigned,unsigned> external_preconditions;
+      std::vector<Instruction*> prologue, epilogue;
+      for (unsigned idx = 0; idx < program.size(); idx++)
+      {
+        if (!lowered[idx])
+        {
+          if (elided[idx])
+            replay.completions.push_back(lhs_slots[idx]);
+          else if (stages[idx] == 0)
+            prologue.push_back(program[idx]);
+          else
+            epilogue.push_back(program[idx]);
+          continue;
+        }
+        const unsigned copy_index = definition.copies.size();
+        copy_indexes[idx] = copy_index;
+        definition.copies.resize(copy_index + 1);
+        Realm::SubgraphDefinition::CopyDesc &desc = definition.copies.back();
+        desc.space = spaces[idx];
+        if (program[idx]->get_kind() == ISSUE_COPY)
+        {
+          IssueCopy *copy = program[idx]->as_issue_copy();
+          desc.srcs = copy->src_fields;
+          desc.dsts = copy->dst_fields;
+          desc.priority = copy->priority;
+        }
+        else
+        {
+          // Fills are copies from fill values, split the fill value
+          // across the fields the same way that Realm does for fills
+          IssueFill *fill = program[idx]->as_issue_fill();
+          desc.dsts = fill->fields;
+          desc.srcs.resize(desc.dsts.size());
+          size_t offset = 0;
+          for (unsigned fidx = 0; fidx < desc.dsts.size(); fidx++)
+          {
+#ifdef DEBUG_LEGION
+            assert((offset + desc.dsts[fidx].size) <= fill->fill_size);
+#endif
+            desc.srcs[fidx].set_fill(
+                static_cast<const char*>(fill->fill_value) + offset,
+                desc.dsts[fidx].size);
+            if ((offset > 0) || (desc.dsts[fidx].size != fill->fill_size))
+              offset += desc.dsts[fidx].size;
+          }
+          desc.priority = fill->priority;
+        }
+        // Find the copies and external events that this one depends on
+        visited.clear();
+        to_visit = rhs_slots[idx];
+        while (!to_visit.empty())
+        {
+          const unsigned slot = to_visit.back();
+          to_visit.pop_back();
+          if (!visited.insert(slot).second)
+            continue;
+          const unsigned producer = producers[slot];
+          Realm::SubgraphDefinition::Dependency dependence;
+          dependence.tgt_op_kind = Realm::SubgraphDefinition::OPKIND_COPY;
+          dependence.tgt_op_index = copy_index;
+          if ((producer != NO_INDEX) && lowered[producer])
+          {
+#ifdef DEBUG_LEGION
+            assert(copy_indexes[producer] != NO_INDEX);
+#endif
+            dependence.src_op_kind = Realm::SubgraphDefinition::OPKIND_COPY;
+            dependence.src_op_index = copy_indexes[producer];
+          }
+          else if ((producer != NO_INDEX) && (stages[producer] > 0))
+          {
+            to_visit.insert(to_visit.end(), rhs_slots[producer].begin(),
+                            rhs_slots[producer].end());
+            continue;
+          }
+          else
+          {
+            std::map<unsigned,unsigned>::const_iterator finder =
+              external_preconditions.find(slot);
+            if (finder == external_preconditions.end())
+            {
+              finder = external_preconditions.insert(std::make_pair(slot,
+                    replay.preconditions.size())).first;
+              replay.preconditions.push_back(slot);
+            }
+            dependence.src_op_kind =
+              Realm::SubgraphDefinition::OPKIND_EXT_PRECOND;
+            dependence.src_op_index = finder->second;
+          }
+          definition.dependencies.push_back(dependence);
+        }
+        // Only results still needed by the host are produced precisely,
+        // everyone else can wait for the whole subgraph to be done
+        if (host_used[lhs_slots[idx]])
+        {
+          Realm::SubgraphDefinition::Dependency dependence;
+          dependence.src_op_kind = Realm::SubgraphDefinition::OPKIND_COPY;
+          dependence.src_op_index = copy_index;
+          dependence.tgt_op_kind =
+            Realm::SubgraphDefinition::OPKIND_EXT_POSTCOND;
+          dependence.tgt_op_index = replay.postconditions.size();
+          definition.dependencies.push_back(dependence);
+          replay.postconditions.push_back(lhs_slots[idx]);
+        }
+        else
+          replay.completions.push_back(lhs_slots[idx]);
+      }
+      const RtEvent created(Realm::Subgraph::create_subgraph(
+            replay.subgraph, definition,
+            Realm::ProfilingRequestSet()));
+      if (created.exists() && !created.has_triggered())
+        created.wait();
+      std::vector<unsigned> slot_levels(events.size(), 0);
+      lower_slice(prologue, replay.prologue, slot_levels);
+      std::fill(slot_levels.begin(), slot_levels.end(), 0);
+      lower_slice(epilogue, replay.epilogue, slot_levels);
+    }
+
+    //--------------------------------------------------------------------------
+    void PhysicalTemplate::find_instruction_events(Instruction *inst,
+                          unsigned &lhs, std::vector<unsigned> &rhs) const
+    //--------------------------------------------------------------------------
+    {
+      lhs = NO_INDEX;
+      switch (inst->get_kind())
+      {
+        case GET_TERM_EVENT:
+          {
+            lhs = inst->as_get_term_event()->lhs;
+            break;
+          }
+        case CREATE_AP_USER_EVENT:
+          {
+            lhs = inst->as_create_ap_user_event()->lhs;
+            break;
+          }
+        case TRIGGER_EVENT:
+          {
+            // Triggering uses the user event so it depends on its creation
+            TriggerEvent *trigger = inst->as_trigger_event();
+            rhs.push_back(trigger->lhs);
+            rhs.push_back(trigger->rhs);
+            break;
+          }
+        case MERGE_EVENT:
+          {
+            MergeEvent *merge = inst->as_merge_event();
+            lhs = merge->lhs;
+            rhs.insert(rhs.end(), merge->rhs.begin(), merge->rhs.end());
+            break;
+          }
+        case ASSIGN_FENCE_COMPLETION:
+          {
+            lhs = inst->as_assignment_fence_completion()->lhs;
+            break;
+          }
+        case ISSUE_COPY:
+          {
+            IssueCopy *copy = inst->as_issue_copy();
+            lhs = copy->lhs;
+            rhs.push_back(copy->precondition_idx);
+            break;
+          }
+        case ISSUE_FILL:
+          {
+            IssueFill *fill = inst->as_issue_fill();
+            lhs = fill->lhs;
+            rhs.push_back(fill->precondition_idx);
+            break;
+          }
+        case ISSUE_ACROSS:
+          {
+            IssueAcross *across = inst->as_issue_across();
+            lhs = across->lhs;
+            rhs.push_back(across->copy_precondition);
+            if (across->collective_precondition != 0)
+              rhs.push_back(across->collective_precondition);
+            if (across->src_indirect_precondition != 0)
+              rhs.push_back(across->src_indirect_precondition);
+            if (across->dst_indirect_precondition != 0)
+              rhs.push_back(across->dst_indirect_precondition);
+            break;
+          }
+        case SET_OP_SYNC_EVENT:
+          {
+            lhs = inst->as_set_op_sync_event()->lhs;
+            break;
+          }
+        case SET_EFFECTS:
+          {
+            rhs.push_back(inst->as_set_effects()->rhs);
+            break;
+          }
+        case COMPLETE_REPLAY:
+          {
+            rhs.push_back(inst->as_complete_replay()->rhs);
+            break;
+          }
+        case BARRIER_ARRIVAL:
+          {
+            BarrierArrival *arrival = inst->as_barrier_arrival();
+            lhs = arrival->lhs;
+            rhs.push_back(arrival->rhs);
+            break;
+          }
+        case BARRIER_ADVANCE:
+          {
+            lhs = inst->as_barrier_advance()->lhs;
+            break;
+          }
+        default:
+          assert(false);
+      }
+    }
+
     //--------------------------------------------------------------------------
     void PhysicalTemplate::dump_template(void)
     //--------------------------------------------------------------------------
@@ -5870,9 +6806,26 @@ namespace Legion {
         << " (UID " << ctx->get_unique_id() << ") ####";
       for (unsigned sidx = 0; sidx < replay_parallelism; ++sidx)
       {
-        log_tracing.info() << "[Slice " << sidx << "]";
+        if (!compiled_slices.empty())
+          log_tracing.info() << "[Slice " << sidx << "] (" 
+            << compiled_slices[sidx].code.size() << " codes, "
+            << compiled_slices[sidx].levels << " levels)";
+        else
+          log_tracing.info() << "[Slice " << sidx << "]";
         dump_instructions(slices[sidx]);
       }
+      for (unsigned sidx = 0; sidx < replay_subgraphs.size(); sidx++)
+      {
+        const SubgraphReplay &replay = replay_subgraphs[sidx];
+        if (!replay.subgraph.exists())
+          continue;
+        log_tracing.info() << "[Subgraph " << sidx << "] " << std::hex
+          << replay.subgraph.id << std::dec << " ("
+          << replay.prologue.code.size() << " codes before, "
+          << replay.epilogue.code.size() << " codes after, "
+          << replay.preconditions.size() << " preconditions, "
+          << replay.postconditions.size() << " postconditions)";
+      }
       for (std::map<unsigned, unsigned>::iterator it = frontiers.begin();
            it != frontiers.end(); ++it)
         log_tracing.info() << "  events[" << it->second << "] = events["
@@ -6707,6 +7660,11 @@ namespace Legion {
         // We also need to rerun the propagate copies analysis to
         // remove any mergers which contain only a single input
         propagate_copies(NULL/*don't need the gen out*/);
+        // The slices have changed so lower them again
+        if (!runtime->no_compiled_replay)
+          compile_replay();
+        if (runtime->subgraph_replay)
+          compile_subgraph();
         // If it was requested that we dump the traces do that now
         if (runtime->dump_physical_traces)
           dump_template();
@@ -306,6 +306,74 @@ namespace Legion {
       bool tracing;
     };
 
+    /**
+     * \class AutoTraceDetector
+     * This class watches the stream of operations issued by an inner
+     * context when automatic tracing is enabled (-lg:auto_trace). The
+     * context holds back traceable operations in this buffer while we
+     * look for a repeated sequence using rolling hashes over the recent
+     * history of the stream. Once a sequence has been seen twice it is
+     * assigned a trace ID and every later occurrence that shows up at
+     * the end of the buffer is traced under that ID. Operations that do
+     * not end up in a trace are handed back to be issued normally.
+     */
+    class AutoTraceDetector {
+    public:
+      struct Match {
+      public:
+        size_t start; // number of buffered ops to issue before the trace
+        size_t length; // number of buffered ops in the trace
+        TraceID tid;
+      };
+    public:
+      AutoTraceDetector(InnerContext *ctx, unsigned min_length,
+                        unsigned window);
+      AutoTraceDetector(const AutoTraceDetector &rhs) = delete;
+      ~AutoTraceDetector(void);
+    public:
+      AutoTraceDetector& operator=(const AutoTraceDetector &rhs) = delete;
+    public:
+      static bool is_traceable(Operation *op);
+      static uint64_t hash_operation(Operation *op);
+    public:
+      // Buffer a traceable operation and return true if the end of
+      // the buffer now matches a trace
+      bool record_operation(Operation *op, Match &match);
+      // Remove the oldest buffered operation
+      Operation* pop_operation(bool traced);
+      inline Operation* front(void) const { return buffer.front(); }
+      inline bool empty(void) const { return buffer.empty(); }
+      inline size_t size(void) const { return buffer.size(); }
+      inline bool full(void) const { return (buffer.size() >= window); }
+      void report_statistics(void) const;
+    protected:
+      uint64_t compute_range_hash(size_t start, size_t length) const;
+      bool equal_ranges(size_t first, size_t second, size_t length) const;
+      void trim_history(void);
+    protected:
+      struct KnownTrace {
+      public:
+        TraceID tid;
+        std::vector<uint64_t> hashes;
+        uint64_t replays;
+      };
+    public:
+      InnerContext *const context;
+      const size_t min_length;
+      const size_t window;
+    protected:
+      std::deque<Operation*> buffer;
+      // Hashes of recently issued and buffered operations, the last
+      // buffer.size() of which correspond to the buffered operations
+      std::vector<uint64_t> history;
+      // Rolling prefix hashes over the history and powers of the base
+      std::vector<uint64_t> prefix, powers;
+      std::map<std::pair<uint64_t,size_t>,KnownTrace> known_traces;
+      std::set<size_t> known_lengths;
+    protected:
+      uint64_t traced_ops, untraced_ops;
+    };
+
     class TraceOp : public FenceOp {
     public:
       TraceOp(Runtime *rt);
@@ -828,6 +896,60 @@ namespace Legion {
         FieldMask mask;
       };
       typedef LegionVector<InstanceUser> InstUsers;
+      // Opcodes for the lowered form of the replay slices
+      enum ReplayOpcode {
+        REPLAY_MERGE_EVENT,
+        REPLAY_TRIGGER_EVENT,
+        REPLAY_CREATE_USER_EVENT,
+        REPLAY_ASSIGN_FENCE,
+        REPLAY_EXECUTE,
+      };
+      struct ReplayCode {
+      public:
+        unsigned opcode;
+        unsigned lhs;
+        // Event to trigger from, offset of the first merge operand, or 
+        // the index of the instruction to execute for everything else
+        unsigned arg;
+        unsigned count;
+      };
+      /**
+       * \struct CompiledSlice
+       * A replay slice lowered to a flat array of codes over the event
+       * slots of the template. Event manipulations are interpreted
+       * directly and everything else falls back to executing the
+       * original instruction. Codes are ordered by dependence level.
+       */
+      struct CompiledSlice {
+      public:
+        CompiledSlice(void) : max_merge(0), levels(0) { }
+      public:
+        std::vector<ReplayCode> code;
+        std::vector<unsigned> operands;
+        std::vector<Instruction*> instructions;
+        unsigned max_merge;
+        unsigned levels;
+      };
+      /**
+       * \struct SubgraphReplay
+       * A slice of a template whose copies and fills have been lowered
+       * onto a Realm subgraph. The rest of the slice's instructions are
+       * replayed on the host in two pieces around the instantiation of
+       * the subgraph. Each slice gets its own subgraph so slices still
+       * replay in parallel.
+       */
+      struct SubgraphReplay {
+      public:
+        SubgraphReplay(void) : subgraph(Realm::Subgraph::NO_SUBGRAPH) { }
+      public:
+        Realm::Subgraph subgraph;
+        CompiledSlice prologue, epilogue;
+        // Slots passed into the subgraph and the ones it produces
+        std::vector<unsigned> preconditions, postconditions;
+        // Slots no longer produced on the host that get the completion
+        // of the subgraph for anyone that looks at them after the replay
+        std::vector<unsigned> completions;
+      };
       struct LastUserResult {
       public:
         LastUserResult(const InstanceUser &u) : user(u) { }
@@ -898,7 +1020,17 @@ namespace Legion {
       void eliminate_dead_code(std::vector<unsigned> &gen);
       void prepare_parallel_replay(const std::vector<unsigned> &gen);
       void push_complete_replays(void);
+      void compile_replay(void);
+      void lower_slice(const std::vector<Instruction*> &slice,
+                       CompiledSlice &compiled,
+                       std::vector<unsigned> &slot_levels) const;
+      void compile_subgraph(void);
+      void compile_slice_subgraph(const std::vector<Instruction*> &program,
+                                  SubgraphReplay &replay);
+      void find_instruction_events(Instruction *inst, unsigned &lhs,
+                                   std::vector<unsigned> &rhs) const;
     protected:
+      virtual bool supports_subgraph_replay(void) const { return true; }
       virtual void sync_compute_frontiers(ReplTraceOp *op,
                           const std::vector<RtEvent> &frontier_events);
       virtual void initialize_generators(std::vector<unsigned> &new_gen);
@@ -922,6 +1054,10 @@ namespace Legion {
     public:
       void register_operation(Operation *op);
       void execute_slice(unsigned slice_idx, bool recurrent_replay);
+      void execute_compiled_slice(const CompiledSlice &slice,
+                                  bool recurrent_replay);
+      void execute_subgraph_replay(const SubgraphReplay &replay,
+                                   bool recurrent_replay);
     public:
       virtual void issue_summary_operations(InnerContext* context,
                                             Operation *invalidator,
@@ -1166,6 +1302,11 @@ namespace Legion {
       std::vector<Instruction*>               instructions;
       std::vector<std::vector<Instruction*> > slices;
       std::vector<std::vector<TraceLocalID> > slice_tasks;
+      // Lowered slices, empty if we are interpreting the instructions
+      std::vector<CompiledSlice>              compiled_slices;
+      // Copies and fills lowered onto a Realm subgraph for each slice,
+      // empty if none of the slices have been lowered
+      std::vector<SubgraphReplay>             replay_subgraphs;
     protected:
       std::map<unsigned/*event*/,unsigned/*consumers*/> crossing_events;
       // Frontiers of a template are a set of users whose events must
@@ -1398,6 +1539,8 @@ namespace Legion {
                                            const FieldMask &mask,
                                            std::set<RtEvent> &applied_events);
       virtual bool are_read_only_users(InstUsers &inst_users);
+      // Barriers and frontiers between shards are not modelled in subgraphs
+      virtual bool supports_subgraph_replay(void) const { return false; }
       virtual void sync_compute_frontiers(ReplTraceOp *op,
                           const std::vector<RtEvent> &frontier_events);
       virtual void initialize_generators(std::vector<unsigned> &new_gen);
@@ -72,6 +72,10 @@ template<unsigned int MAX> class SSETLBitMask;
 template<unsigned int MAX> class AVXBitMask;
 template<unsigned int MAX> class AVXTLBitMask;
 #endif
+#ifdef __AVX512F__
+template<unsigned int MAX> class AVX512BitMask;
+template<unsigned int MAX> class AVX512TLBitMask;
+#endif
 #ifdef __ALTIVEC__
 template<unsigned int MAX> class PPCBitMask;
 template<unsigned int MAX> class PPCTLBitMask;
@@ -418,9 +422,13 @@ namespace Legion {
       LG_DEFER_CONSENSUS_MATCH_TASK_ID,
       LG_DEFER_COLLECTIVE_TASK_ID,
       LG_YIELD_TASK_ID,
+      LG_BUILD_KD_TREE_TASK_ID,
       // this marks the beginning of task IDs tracked by the shutdown algorithm
       LG_BEGIN_SHUTDOWN_TASK_IDS,
       LG_RETRY_SHUTDOWN_TASK_ID = LG_BEGIN_SHUTDOWN_TASK_IDS,
+      // profiler output is waited on explicitly when the profiler is
+      // finalized so it does not need to hold up shutdown (or be profiled)
+      LG_FLUSH_PROFILER_CHUNK_TASK_ID,
       // Message ID goes at the end so we can append additional 
       // message IDs here for the profiler and separate meta-tasks
       LG_MESSAGE_ID,
@@ -537,7 +545,9 @@ namespace Legion {
         "Defer Consensus Match",                                  \
         "Defer Collective Async",                                 \
         "Yield",                                                  \
+        "Build KD Tree",                                          \
         "Retry Shutdown",                                         \
+        "Flush Profiler Chunk",                                   \
         "Remote Message",                                         \
       };
 
@@ -936,6 +946,7 @@ namespace Legion {
       SEND_FREE_FUTURE_INSTANCE,
       SEND_CONCURRENT_RESERVATION_CREATION,
       SEND_CONCURRENT_EXECUTION_ANALYSIS,
+      SEND_PROFILER_SUMMARY,
       SEND_SHUTDOWN_NOTIFICATION,
       SEND_SHUTDOWN_RESPONSE,
       LAST_SEND_KIND, // This one must be last
@@ -1163,6 +1174,7 @@ namespace Legion {
         "Send Free Future Instance",                                  \
         "Send Concurrent Reservation Creation",                       \
         "Send Concurrent Execution Analysis",                         \
+        "Send Profiler Summary",                                      \
         "Send Shutdown Notification",                                 \
         "Send Shutdown Response",                                     \
       };
@@ -1744,6 +1756,7 @@ namespace Legion {
     class LegionTrace;
     class StaticTrace;
     class DynamicTrace;
+    class AutoTraceDetector;
     class TraceCaptureOp;
     class TraceCompleteOp;
     class TraceReplayOp;
@@ -1783,7 +1796,7 @@ namespace Legion {
     template<int DIM, typename T> class IndexSpaceUnion;
     template<int DIM, typename T> class IndexSpaceIntersection;
     template<int DIM, typename T> class IndexSpaceDifference;
-    class ExpressionTrieNode;
+    class ExpressionCache;
     class IndexTreeNode;
     class IndexSpaceNode;
     template<int DIM, typename T> class IndexSpaceNodeT;
@@ -1796,6 +1809,8 @@ namespace Legion {
     class ColorSpaceIterator;
     template<int DIM, typename T> class ColorSpaceIteratorT;
     template<int DIM, typename T, typename RT = void> class KDNode;
+    class KDTreeBuilder;
+    template<int DIM, typename T, typename RT> class FlatKDTree;
 
     class RegionTreeContext;
     class RegionTreePath;
@@ -2257,7 +2272,21 @@ namespace Legion {
 #define LEGION_FIELD_MASK_FIELD_MASK          0x3F
 #define LEGION_FIELD_MASK_FIELD_ALL_ONES      0xFFFFFFFFFFFFFFFF
 
-#if defined(__AVX__)
+#if defined(__AVX512F__)
+#if (LEGION_MAX_FIELDS > 512)
+    typedef AVX512TLBitMask<LEGION_MAX_FIELDS> FieldMask;
+#elif (LEGION_MAX_FIELDS > 256)
+    typedef AVX512BitMask<LEGION_MAX_FIELDS> FieldMask;
+#elif (LEGION_MAX_FIELDS > 128)
+    typedef AVXBitMask<LEGION_MAX_FIELDS> FieldMask;
+#elif (LEGION_MAX_FIELDS > 64)
+    typedef SSEBitMask<LEGION_MAX_FIELDS> FieldMask;
+#else
+    typedef BitMask<LEGION_FIELD_MASK_FIELD_TYPE,LEGION_MAX_FIELDS,
+                    LEGION_FIELD_MASK_FIELD_SHIFT,
+                    LEGION_FIELD_MASK_FIELD_MASK> FieldMask;
+#endif
+#elif defined(__AVX__)
 #if (LEGION_MAX_FIELDS > 256)
     typedef AVXTLBitMask<LEGION_MAX_FIELDS> FieldMask;
 #elif (LEGION_MAX_FIELDS > 128)
@@ -2324,7 +2353,21 @@ namespace Legion {
 #define LEGION_NODE_MASK_NODE_MASK           0x3F
 #define LEGION_NODE_MASK_NODE_ALL_ONES       0xFFFFFFFFFFFFFFFF
 
-#if defined(__AVX__)
+#if defined(__AVX512F__)
+#if (LEGION_MAX_NUM_NODES > 512)
+    typedef AVX512TLBitMask<LEGION_MAX_NUM_NODES> NodeMask;
+#elif (LEGION_MAX_NUM_NODES > 256)
+    typedef AVX512BitMask<LEGION_MAX_NUM_NODES> NodeMask;
+#elif (LEGION_MAX_NUM_NODES > 128)
+    typedef AVXBitMask<LEGION_MAX_NUM_NODES> NodeMask;
+#elif (LEGION_MAX_NUM_NODES > 64)
+    typedef SSEBitMask<LEGION_MAX_NUM_NODES> NodeMask;
+#else
+    typedef BitMask<LEGION_NODE_MASK_NODE_TYPE,LEGION_MAX_NUM_NODES,
+                    LEGION_NODE_MASK_NODE_SHIFT,
+                    LEGION_NODE_MASK_NODE_MASK> NodeMask;
+#endif
+#elif defined(__AVX__)
 #if (LEGION_MAX_NUM_NODES > 256)
     typedef AVXTLBitMask<LEGION_MAX_NUM_NODES> NodeMask;
 #elif (LEGION_MAX_NUM_NODES > 128)
@@ -2389,7 +2432,21 @@ namespace Legion {
 #define LEGION_PROC_MASK_PROC_MASK           0x3F
 #define LEGION_PROC_MASK_PROC_ALL_ONES       0xFFFFFFFFFFFFFFFF
 
-#if defined(__AVX__)
+#if defined(__AVX512F__)
+#if (LEGION_MAX_NUM_PROCS > 512)
+    typedef AVX512TLBitMask<LEGION_MAX_NUM_PROCS> ProcessorMask;
+#elif (LEGION_MAX_NUM_PROCS > 256)
+    typedef AVX512BitMask<LEGION_MAX_NUM_PROCS> ProcessorMask;
+#elif (LEGION_MAX_NUM_PROCS > 128)
+    typedef AVXBitMask<LEGION_MAX_NUM_PROCS> ProcessorMask;
+#elif (LEGION_MAX_NUM_PROCS > 64)
+    typedef SSEBitMask<LEGION_MAX_NUM_PROCS> ProcessorMask;
+#else
+    typedef BitMask<LEGION_PROC_MASK_PROC_TYPE,LEGION_MAX_NUM_PROCS,
+                    LEGION_PROC_MASK_PROC_SHIFT,
+                    LEGION_PROC_MASK_PROC_MASK> ProcessorMask;
+#endif
+#elif defined(__AVX__)
 #if (LEGION_MAX_NUM_PROCS > 256)
     typedef AVXTLBitMask<LEGION_MAX_NUM_PROCS> ProcessorMask;
 #elif (LEGION_MAX_NUM_PROCS > 128)
@@ -99,6 +99,12 @@ namespace Legion {
       template<unsigned int MAX>
       inline void serialize(const AVXTLBitMask<MAX> &mask);
 #endif
+#ifdef __AVX512F__
+      template<unsigned int MAX>
+      inline void serialize(const AVX512BitMask<MAX> &mask);
+      template<unsigned int MAX>
+      inline void serialize(const AVX512TLBitMask<MAX> &mask);
+#endif
 #ifdef __ALTIVEC__
       template<unsigned int MAX>
       inline void serialize(const PPCBitMask<MAX> &mask);
@@ -188,6 +194,12 @@ namespace Legion {
       template<unsigned int MAX>
       inline void deserialize(AVXTLBitMask<MAX> &mask);
 #endif
+#ifdef __AVX512F__
+      template<unsigned int MAX>
+      inline void deserialize(AVX512BitMask<MAX> &mask);
+      template<unsigned int MAX>
+      inline void deserialize(AVX512TLBitMask<MAX> &mask);
+#endif
 #ifdef __ALTIVEC__
       template<unsigned int MAX>
       inline void deserialize(PPCBitMask<MAX> &mask);
@@ -761,6 +773,50 @@ namespace Legion {
       }
     };
 
+    /////////////////////////////////////////////////////////////
+    // Sharded Lookup Table
+    /////////////////////////////////////////////////////////////
+    // A read-mostly concurrent map which is split into shards that each
+    // have their own reader-writer lock so that lookups of different keys
+    // almost never touch the same lock. The HASH functor maps a key to a
+    // 64-bit value that is mixed to pick the shard for the key. Callers 
+    // that need to do more than one operation atomically on a key can 
+    // take the lock of the key's shard themselves.
+    template<typename K, typename V, typename HASH>
+    class ShardedLookupTable {
+    public:
+      static const unsigned SHARDS = LEGION_LOOKUP_TABLE_SHARDS;
+      static_assert((SHARDS & (SHARDS - 1)) == 0, 
+                    "LEGION_LOOKUP_TABLE_SHARDS must be a power of two");
+      struct alignas(64) Shard {
+      public:
+        mutable LocalLock lock;
+        std::map<K,V> entries;
+      };
+    public:
+      ShardedLookupTable(void) { }
+      ShardedLookupTable(const ShardedLookupTable &rhs) = delete;
+      ShardedLookupTable& operator=(const ShardedLookupTable &rhs) = delete;
+    public:
+      inline Shard& get_shard(const K &key);
+      inline const Shard& get_shard(const K &key) const;
+      // These all take the lock on the shard for the key
+      inline bool find(const K &key, V &value) const;
+      inline bool contains(const K &key) const;
+      // Returns false without updating the table if the key already exists
+      inline bool insert(const K &key, const V &value);
+      // Returns false if the key did not exist
+      inline bool erase(const K &key);
+      // Remove the key if it exists and return its value
+      inline bool extract(const K &key, V &value);
+      // Copy out all the values taking each shard lock in turn
+      inline void get_values(std::vector<V> &values) const;
+    protected:
+      static inline unsigned get_shard_index(const K &key);
+    protected:
+      Shard shards[SHARDS];
+    };
+
     /////////////////////////////////////////////////////////////
     // BasicRangeAllocator
     /////////////////////////////////////////////////////////////
@@ -900,6 +956,24 @@ namespace Legion {
     }
 #endif
 
+#ifdef __AVX512F__
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Serializer::serialize(const AVX512BitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.serialize(*this);
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Serializer::serialize(const AVX512TLBitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.serialize(*this);
+    }
+#endif
+
 #ifdef __ALTIVEC__
     //--------------------------------------------------------------------------
     template<unsigned int MAX>
@@ -1141,6 +1215,24 @@ namespace Legion {
     }
 #endif
 
+#ifdef __AVX512F__
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Deserializer::deserialize(AVX512BitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.deserialize(*this);
+    }
+
+    //--------------------------------------------------------------------------
+    template<unsigned int MAX>
+    inline void Deserializer::deserialize(AVX512TLBitMask<MAX> &mask)
+    //--------------------------------------------------------------------------
+    {
+      mask.deserialize(*this);
+    }
+#endif
+
 #ifdef __ALTIVEC__
     //--------------------------------------------------------------------------
     template<unsigned int MAX>
@@ -2250,6 +2342,113 @@ namespace Legion {
       return n;
     }
 
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    /*static*/ inline unsigned 
+              ShardedLookupTable<K,V,HASH>::get_shard_index(const K &key)
+    //-------------------------------------------------------------------------
+    {
+      // Handle IDs are often strided by the number of address spaces so
+      // use a multiplicative hash to spread them over all the shards
+      const uint64_t hash = HASH()(key) * 0x9E3779B97F4A7C15ULL;
+      return (hash >> 32) & (SHARDS - 1);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    inline typename ShardedLookupTable<K,V,HASH>::Shard&
+                      ShardedLookupTable<K,V,HASH>::get_shard(const K &key)
+    //-------------------------------------------------------------------------
+    {
+      return shards[get_shard_index(key)];
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    inline const typename ShardedLookupTable<K,V,HASH>::Shard&
+                ShardedLookupTable<K,V,HASH>::get_shard(const K &key) const
+    //-------------------------------------------------------------------------
+    {
+      return shards[get_shard_index(key)];
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    inline bool ShardedLookupTable<K,V,HASH>::find(const K &key,
+                                                   V &value) const
+    //-------------------------------------------------------------------------
+    {
+      const Shard &shard = get_shard(key);
+      AutoLock s_lock(shard.lock,1,false/*exclusive*/);
+      typename std::map<K,V>::const_iterator finder = shard.entries.find(key);
+      if (finder == shard.entries.end())
+        return false;
+      value = finder->second;
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    inline bool ShardedLookupTable<K,V,HASH>::contains(const K &key) const
+    //-------------------------------------------------------------------------
+    {
+      const Shard &shard = get_shard(key);
+      AutoLock s_lock(shard.lock,1,false/*exclusive*/);
+      return (shard.entries.find(key) != shard.entries.end());
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    inline bool ShardedLookupTable<K,V,HASH>::insert(const K &key,
+                                                     const V &value)
+    //-------------------------------------------------------------------------
+    {
+      Shard &shard = get_shard(key);
+      AutoLock s_lock(shard.lock);
+      return shard.entries.insert(std::make_pair(key, value)).second;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    inline bool ShardedLookupTable<K,V,HASH>::erase(const K &key)
+    //-------------------------------------------------------------------------
+    {
+      Shard &shard = get_shard(key);
+      AutoLock s_lock(shard.lock);
+      return (shard.entries.erase(key) > 0);
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    inline bool ShardedLookupTable<K,V,HASH>::extract(const K &key, V &value)
+    //-------------------------------------------------------------------------
+    {
+      Shard &shard = get_shard(key);
+      AutoLock s_lock(shard.lock);
+      typename std::map<K,V>::iterator finder = shard.entries.find(key);
+      if (finder == shard.entries.end())
+        return false;
+      value = finder->second;
+      shard.entries.erase(finder);
+      return true;
+    }
+
+    //-------------------------------------------------------------------------
+    template<typename K, typename V, typename HASH>
+    inline void ShardedLookupTable<K,V,HASH>::get_values(
+                                                std::vector<V> &values) const
+    //-------------------------------------------------------------------------
+    {
+      for (unsigned idx = 0; idx < SHARDS; idx++)
+      {
+        const Shard &shard = shards[idx];
+        AutoLock s_lock(shard.lock,1,false/*exclusive*/);
+        for (typename std::map<K,V>::const_iterator it = 
+              shard.entries.begin(); it != shard.entries.end(); it++)
+          values.push_back(it->second);
+      }
+    }
+
     //-------------------------------------------------------------------------
     template <typename RT, typename TT>
     inline BasicRangeAllocator<RT,TT>::BasicRangeAllocator(void)
@@ -146,6 +146,10 @@ namespace Legion {
     RegionTreeForest::~RegionTreeForest(void)
     //--------------------------------------------------------------------------
     {
+      union_ops.report_statistics("union", runtime->address_space);
+      intersection_ops.report_statistics("intersection", 
+                                         runtime->address_space);
+      difference_ops.report_statistics("difference", runtime->address_space);
     }
 
     //--------------------------------------------------------------------------
@@ -3703,11 +3707,13 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       CurrentInitializer init(ctx.get_id());
+      // Holding the lookup lock prevents any of the trees from being removed
       AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      // Need to hold references to prevent deletion race
-      for (std::map<RegionTreeID,RegionNode*>::const_iterator it = 
-            tree_nodes.begin(); it != tree_nodes.end(); it++)
-        it->second->visit_node(&init);
+      std::vector<RegionNode*> roots;
+      tree_nodes.get_values(roots);
+      for (std::vector<RegionNode*>::const_iterator it = 
+            roots.begin(); it != roots.end(); it++)
+        (*it)->visit_node(&init);
     }
 #endif
 
@@ -3740,15 +3746,18 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
+        LookupTable<IndexSpace,IndexSpaceNode*>::Shard &shard =
+          index_nodes.get_shard(sp);
+        AutoLock s_lock(shard.lock);
         std::map<IndexSpace,IndexSpaceNode*>::const_iterator it =
-          index_nodes.find(sp);
-        if (it != index_nodes.end())
+          shard.entries.find(sp);
+        if (it != shard.entries.end())
         {
           // Need to remove resource reference if not owner
           delete result;
           return it->second;
         }
-        index_nodes[sp] = result;
+        shard.entries[sp] = result;
         index_space_requests.erase(sp);
         if (parent != NULL)
         {
@@ -3795,16 +3804,19 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
+        LookupTable<IndexSpace,IndexSpaceNode*>::Shard &shard =
+          index_nodes.get_shard(sp);
+        AutoLock s_lock(shard.lock);
         std::map<IndexSpace,IndexSpaceNode*>::const_iterator it =
-          index_nodes.find(sp);
-        if (it != index_nodes.end())
+          shard.entries.find(sp);
+        if (it != shard.entries.end())
         {
           delete result;
           // Free up the event since we didn't use it
           Runtime::trigger_event(NULL, is_ready);
           return it->second;
         }
-        index_nodes[sp] = result;
+        shard.entries[sp] = result;
         index_space_requests.erase(sp);
         // Always add a valid reference from the parent
         parent.add_child(result);
@@ -3847,14 +3859,17 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
+        LookupTable<IndexPartition,IndexPartNode*>::Shard &shard =
+          index_parts.get_shard(p);
+        AutoLock s_lock(shard.lock);
         std::map<IndexPartition,IndexPartNode*>::const_iterator it =
-          index_parts.find(p);
-        if (it != index_parts.end())
+          shard.entries.find(p);
+        if (it != shard.entries.end())
         {
           delete result;
           return it->second;
         }
-        index_parts[p] = result;
+        shard.entries[p] = result;
         index_part_requests.erase(p);
         // If we're the owner add a valid reference that will be removed
         // when we are deleted, 
@@ -3906,15 +3921,18 @@ namespace Legion {
       {
         // Hold the lookup lock while modifying the lookup table
         AutoLock l_lock(lookup_lock);
+        LookupTable<IndexPartition,IndexPartNode*>::Shard &shard =
+          index_parts.get_shard(p);
+        AutoLock s_lock(shard.lock);
         std::map<IndexPartition,IndexPartNode*>::const_iterator it =
-          index_parts.find(p);
-        if (it != index_parts.end())
+          shard.entries.find(p);
+        if (it != shard.entries.end())
         {
           // Need to remove resource reference if not owner
           delete result;
           return it->second;
         }
-        index_parts[p] = result;
+        shard.entries[p] = result;
         index_part_requests.erase(p);
         // If we're the owner add a valid reference that will be removed
         // when we are deleted, 
@@ -3953,14 +3971,17 @@ namespace Legion {
       // Hold the lookup lock while modifying the lookup table
       {
         AutoLock l_lock(lookup_lock);
+        LookupTable<FieldSpace,FieldSpaceNode*>::Shard &shard =
+          field_nodes.get_shard(space);
+        AutoLock s_lock(shard.lock);
         std::map<FieldSpace,FieldSpaceNode*>::const_iterator it =
-          field_nodes.find(space);
-        if (it != field_nodes.end())
+          shard.entries.find(space);
+        if (it != shard.entries.end())
         {
           delete result;
           return it->second;
         }
-        field_nodes[space] = result;
+        shard.entries[space] = result;
         field_space_requests.erase(space);
         // If we're the owner add a valid reference that will be removed
         // when we are deleted, otherwise we're remote so we add a gc 
@@ -3989,14 +4010,17 @@ namespace Legion {
       // Hold the lookup lock while modifying the lookup table
       {
         AutoLock l_lock(lookup_lock);
+        LookupTable<FieldSpace,FieldSpaceNode*>::Shard &shard =
+          field_nodes.get_shard(space);
+        AutoLock s_lock(shard.lock);
         std::map<FieldSpace,FieldSpaceNode*>::const_iterator it =
-          field_nodes.find(space);
-        if (it != field_nodes.end())
+          shard.entries.find(space);
+        if (it != shard.entries.end())
         {
           delete result;
           return it->second;
         }
-        field_nodes[space] = result;
+        shard.entries[space] = result;
         field_space_requests.erase(space);
         // If we're the owner add a valid reference that will be removed
         // when we are deleted, otherwise we're remote so we add a gc 
@@ -4028,14 +4052,13 @@ namespace Legion {
       // Special case for root nodes without dids, we better find them
       if ((parent == NULL) && (did == 0))
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
         // Check to see if it already exists
-        std::map<LogicalRegion,RegionNode*>::const_iterator finder =
-          region_nodes.find(r);
+        RegionNode *result = NULL;
+        region_nodes.find(r, result);
 #ifdef DEBUG_LEGION
-        assert(finder != region_nodes.end());
+        assert(result != NULL);
 #endif
-        return finder->second;
+        return result;
       }
       RtEvent row_ready, col_ready;
       IndexSpaceNode *row_src = get_node(r.index_space, &row_ready);
@@ -4066,10 +4089,13 @@ namespace Legion {
       {
         // Hold the lookup lock when modifying the lookup table
         AutoLock l_lock(lookup_lock);
+        LookupTable<LogicalRegion,RegionNode*>::Shard &shard =
+          region_nodes.get_shard(r);
+        AutoLock s_lock(shard.lock);
         // Check to see if it already exists
         std::map<LogicalRegion,RegionNode*>::const_iterator it =
-          region_nodes.find(r);
-        if (it != region_nodes.end())
+          shard.entries.find(r);
+        if (it != shard.entries.end())
         {
           // It already exists, delete our copy and return
           // the one that has already been made
@@ -4077,15 +4103,15 @@ namespace Legion {
           return it->second;
         }
         // Now we can add it to the map
-        region_nodes[r] = result;
+        shard.entries[r] = result;
         // If this is a top level region add it to the collection
         // of top level tree IDs
         if (parent == NULL)
         {
 #ifdef DEBUG_LEGION
-          assert(tree_nodes.find(r.tree_id) == tree_nodes.end());
+          assert(!tree_nodes.contains(r.tree_id));
 #endif
-          tree_nodes[r.tree_id] = result;
+          tree_nodes.insert(r.tree_id, result);
           region_tree_requests.erase(r.tree_id);
           // If we're the root we get a valid reference on the owner
           // node otherwise we get a gc ref from the owner node
@@ -4135,9 +4161,12 @@ namespace Legion {
       {
         // Hole the lookup lock when modifying the lookup table
         AutoLock l_lock(lookup_lock);
+        LookupTable<LogicalPartition,PartitionNode*>::Shard &shard =
+          part_nodes.get_shard(p);
+        AutoLock s_lock(shard.lock);
         std::map<LogicalPartition,PartitionNode*>::const_iterator it =
-          part_nodes.find(p);
-        if (it != part_nodes.end())
+          shard.entries.find(p);
+        if (it != shard.entries.end())
         {
           // It already exists, delete our copy and
           // return the one that has already been made
@@ -4145,7 +4174,7 @@ namespace Legion {
           return it->second;
         }
         // Now we can put the node in the map
-        part_nodes[p] = result;
+        shard.entries[p] = result;
         // Add gc ref that will be removed when either the root region node
         // or the index partition node has been destroyed
         result->add_base_gc_ref(REGION_TREE_REF);
@@ -4167,10 +4196,12 @@ namespace Legion {
       RtEvent wait_on;
       IndexSpaceNode *result = NULL;
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/); 
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-          index_nodes.find(space);
-        if (finder != index_nodes.end())
+        const LookupTable<IndexSpace,IndexSpaceNode*>::Shard &shard =
+          index_nodes.get_shard(space);
+        AutoLock s_lock(shard.lock,1,false/*exclusive*/);
+        std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder =
+          shard.entries.find(space);
+        if (finder != shard.entries.end())
         {
           if (!finder->second->initialized.exists())
             return finder->second;
@@ -4187,7 +4218,9 @@ namespace Legion {
       {
         if (!wait_on.has_triggered())
           wait_on.wait();
-        AutoLock l_lock(lookup_lock);
+        LookupTable<IndexSpace,IndexSpaceNode*>::Shard &shard =
+          index_nodes.get_shard(space);
+        AutoLock s_lock(shard.lock);
         result->initialized = RtEvent::NO_RT_EVENT;
         return result;
       }
@@ -4200,10 +4233,12 @@ namespace Legion {
         RtEvent pending_wait;
         if (first)
         {
-          AutoLock l_lock(lookup_lock);
-          std::map<IndexSpaceID,RtUserEvent>::iterator finder = 
-            pending_index_spaces.find(space.get_id());
-          if (finder != pending_index_spaces.end())
+          LookupTable<IndexSpaceID,RtUserEvent>::Shard &shard =
+            pending_index_spaces.get_shard(space.get_id());
+          AutoLock s_lock(shard.lock);
+          std::map<IndexSpaceID,RtUserEvent>::iterator finder =
+            shard.entries.find(space.get_id());
+          if (finder != shard.entries.end())
           {
             if (!finder->second.exists())
               finder->second = Runtime::create_rt_user_event();
@@ -4233,10 +4268,9 @@ namespace Legion {
       {
         AutoLock l_lock(lookup_lock);
         // Check to make sure we didn't loose the race
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-          index_nodes.find(space);
-        if (finder != index_nodes.end())
-          return finder->second;
+        IndexSpaceNode *node = NULL;
+        if (index_nodes.find(space, node))
+          return node;
         // Still doesn't exists, see if we sent a request already
         std::map<IndexSpace,RtEvent>::const_iterator wait_finder = 
           index_space_requests.find(space);
@@ -4258,10 +4292,12 @@ namespace Legion {
         // Wait on the event
         wait_on.wait();
         {
-          AutoLock l_lock(lookup_lock);
-          std::map<IndexSpace,IndexSpaceNode*>::iterator finder = 
-              index_nodes.find(space);
-          if (finder != index_nodes.end())
+          LookupTable<IndexSpace,IndexSpaceNode*>::Shard &shard =
+            index_nodes.get_shard(space);
+          AutoLock s_lock(shard.lock);
+          std::map<IndexSpace,IndexSpaceNode*>::iterator finder =
+            shard.entries.find(space);
+          if (finder != shard.entries.end())
           {
             if (finder->second->initialized.exists())
             {
@@ -4309,10 +4345,12 @@ namespace Legion {
       RtEvent wait_on;
       IndexPartNode *result = NULL;
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
+        const LookupTable<IndexPartition,IndexPartNode*>::Shard &shard =
+          index_parts.get_shard(part);
+        AutoLock s_lock(shard.lock,1,false/*exclusive*/);
         std::map<IndexPartition,IndexPartNode*>::const_iterator finder =
-          index_parts.find(part);
-        if (finder != index_parts.end())
+          shard.entries.find(part);
+        if (finder != shard.entries.end())
         {
           if (!finder->second->initialized.exists())
             return finder->second;
@@ -4329,7 +4367,9 @@ namespace Legion {
       {
         if (!wait_on.has_triggered())
           wait_on.wait();
-        AutoLock l_lock(lookup_lock);
+        LookupTable<IndexPartition,IndexPartNode*>::Shard &shard =
+          index_parts.get_shard(part);
+        AutoLock s_lock(shard.lock);
         result->initialized = RtEvent::NO_RT_EVENT;
         return result;
       }
@@ -4343,10 +4383,12 @@ namespace Legion {
         RtEvent pending_wait;
         if (first)
         {
-          AutoLock l_lock(lookup_lock);
-          std::map<IndexPartitionID,RtUserEvent>::iterator finder = 
-            pending_partitions.find(part.get_id());
-          if (finder != pending_partitions.end())
+          LookupTable<IndexPartitionID,RtUserEvent>::Shard &shard =
+            pending_partitions.get_shard(part.get_id());
+          AutoLock s_lock(shard.lock);
+          std::map<IndexPartitionID,RtUserEvent>::iterator finder =
+            shard.entries.find(part.get_id());
+          if (finder != shard.entries.end())
           {
             if (!finder->second.exists())
               finder->second = Runtime::create_rt_user_event();
@@ -4376,10 +4418,9 @@ namespace Legion {
         // Retake the lock in exclusive mode and make
         // sure we didn't loose the race
         AutoLock l_lock(lookup_lock);
-        std::map<IndexPartition,IndexPartNode*>::const_iterator finder =
-          index_parts.find(part);
-        if (finder != index_parts.end())
-          return finder->second;
+        IndexPartNode *node = NULL;
+        if (index_parts.find(part, node))
+          return node;
         // See if we've already sent the request or not
         std::map<IndexPartition,RtEvent>::const_iterator wait_finder = 
           index_part_requests.find(part);
@@ -4401,10 +4442,12 @@ namespace Legion {
         // Wait for the event
         wait_on.wait();
         {
-          AutoLock l_lock(lookup_lock);
-          std::map<IndexPartition,IndexPartNode*>::iterator finder = 
-            index_parts.find(part);
-          if (finder != index_parts.end())
+          LookupTable<IndexPartition,IndexPartNode*>::Shard &shard =
+            index_parts.get_shard(part);
+          AutoLock s_lock(shard.lock);
+          std::map<IndexPartition,IndexPartNode*>::iterator finder =
+            shard.entries.find(part);
+          if (finder != shard.entries.end())
           {
             if (finder->second->initialized.exists())
             {
@@ -4449,10 +4492,12 @@ namespace Legion {
       RtEvent wait_on;
       FieldSpaceNode *result = NULL;
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        std::map<FieldSpace,FieldSpaceNode*>::const_iterator finder = 
-          field_nodes.find(space);
-        if (finder != field_nodes.end())
+        const LookupTable<FieldSpace,FieldSpaceNode*>::Shard &shard =
+          field_nodes.get_shard(space);
+        AutoLock s_lock(shard.lock,1,false/*exclusive*/);
+        std::map<FieldSpace,FieldSpaceNode*>::const_iterator finder =
+          shard.entries.find(space);
+        if (finder != shard.entries.end())
         {
           if (!finder->second->initialized.exists())
             return finder->second;
@@ -4469,7 +4514,9 @@ namespace Legion {
       {
         if (!wait_on.has_triggered())
           wait_on.wait();
-        AutoLock l_lock(lookup_lock);
+        LookupTable<FieldSpace,FieldSpaceNode*>::Shard &shard =
+          field_nodes.get_shard(space);
+        AutoLock s_lock(shard.lock);
         result->initialized = RtEvent::NO_RT_EVENT;
         return result;
       }
@@ -4482,10 +4529,12 @@ namespace Legion {
         RtEvent pending_wait;
         if (first)
         {
-          AutoLock l_lock(lookup_lock);
-          std::map<FieldSpaceID,RtUserEvent>::iterator finder = 
-            pending_field_spaces.find(space.get_id());
-          if (finder != pending_field_spaces.end())
+          LookupTable<FieldSpaceID,RtUserEvent>::Shard &shard =
+            pending_field_spaces.get_shard(space.get_id());
+          AutoLock s_lock(shard.lock);
+          std::map<FieldSpaceID,RtUserEvent>::iterator finder =
+            shard.entries.find(space.get_id());
+          if (finder != shard.entries.end())
           {
             if (!finder->second.exists())
               finder->second = Runtime::create_rt_user_event();
@@ -4513,10 +4562,9 @@ namespace Legion {
         // Retake the lock in exclusive mode and 
         // check to make sure we didn't loose the race
         AutoLock l_lock(lookup_lock);
-        std::map<FieldSpace,FieldSpaceNode*>::const_iterator finder = 
-          field_nodes.find(space);
-        if (finder != field_nodes.end())
-          return finder->second;
+        FieldSpaceNode *node = NULL;
+        if (field_nodes.find(space, node))
+          return node;
         // Now see if we've already sent a request
         std::map<FieldSpace,RtEvent>::const_iterator wait_finder = 
           field_space_requests.find(space);
@@ -4538,10 +4586,12 @@ namespace Legion {
         // Wait for the event to be ready
         wait_on.wait();
         {
-          AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-          std::map<FieldSpace,FieldSpaceNode*>::const_iterator finder = 
-            field_nodes.find(space);
-          if (finder != field_nodes.end())
+          LookupTable<FieldSpace,FieldSpaceNode*>::Shard &shard =
+            field_nodes.get_shard(space);
+          AutoLock s_lock(shard.lock);
+          std::map<FieldSpace,FieldSpaceNode*>::iterator finder =
+            shard.entries.find(space);
+          if (finder != shard.entries.end())
           {
             if (finder->second->initialized.exists())
             {
@@ -4586,10 +4636,12 @@ namespace Legion {
       RegionNode *result = NULL;
       bool has_top_level_region = false;
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        std::map<LogicalRegion,RegionNode*>::const_iterator finder = 
-          region_nodes.find(handle);
-        if (finder != region_nodes.end())
+        const LookupTable<LogicalRegion,RegionNode*>::Shard &shard =
+          region_nodes.get_shard(handle);
+        AutoLock s_lock(shard.lock,1,false/*exclusive*/);
+        std::map<LogicalRegion,RegionNode*>::const_iterator finder =
+          shard.entries.find(handle);
+        if (finder != shard.entries.end())
         {
           if (!finder->second->initialized.exists())
             return finder->second;
@@ -4598,8 +4650,7 @@ namespace Legion {
         }
         // Check to see if we have the top level region
         else if (need_check)
-          has_top_level_region = 
-            (tree_nodes.find(handle.get_tree_id()) != tree_nodes.end());
+          has_top_level_region = tree_nodes.contains(handle.get_tree_id());
         else
           has_top_level_region = true;
       }
@@ -4607,7 +4658,9 @@ namespace Legion {
       {
         if (!wait_on.has_triggered())
           wait_on.wait();
-        AutoLock l_lock(lookup_lock);
+        LookupTable<LogicalRegion,RegionNode*>::Shard &shard =
+          region_nodes.get_shard(handle);
+        AutoLock s_lock(shard.lock);
         result->initialized = RtEvent::NO_RT_EVENT;
         return result;
       }
@@ -4624,10 +4677,12 @@ namespace Legion {
           RtEvent pending_wait;
           if (first)
           {
-            AutoLock l_lock(lookup_lock);
-            std::map<RegionTreeID,RtUserEvent>::iterator finder = 
-              pending_region_trees.find(handle.get_tree_id());
-            if (finder != pending_region_trees.end())
+            LookupTable<RegionTreeID,RtUserEvent>::Shard &shard =
+              pending_region_trees.get_shard(handle.get_tree_id());
+            AutoLock s_lock(shard.lock);
+            std::map<RegionTreeID,RtUserEvent>::iterator finder =
+              shard.entries.find(handle.get_tree_id());
+            if (finder != shard.entries.end())
             {
               if (!finder->second.exists())
                 finder->second = Runtime::create_rt_user_event();
@@ -4647,7 +4702,7 @@ namespace Legion {
         {
           // Retake the lock and make sure we didn't loose the race
           AutoLock l_lock(lookup_lock);
-          if (tree_nodes.find(handle.get_tree_id()) == tree_nodes.end())
+          if (!tree_nodes.contains(handle.get_tree_id()))
           {
             // Still don't have it, see if we need to request it
             std::map<RegionTreeID,RtEvent>::const_iterator finder = 
@@ -4668,10 +4723,9 @@ namespace Legion {
           else
           {
             // We lost the race and it may be here now
-            std::map<LogicalRegion,RegionNode*>::const_iterator it = 
-              region_nodes.find(handle);
-            if (it != region_nodes.end())
-              return it->second;
+            RegionNode *node = NULL;
+            if (region_nodes.find(handle, node))
+              return node;
           }
         }
         // If we did find something to wait on, do that now
@@ -4682,10 +4736,12 @@ namespace Legion {
           {
             // Retake the lock and see again if the handle we
             // were looking for was the top-level node or not
-            AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-            std::map<LogicalRegion,RegionNode*>::const_iterator it = 
-              region_nodes.find(handle);
-            if (it != region_nodes.end())
+            const LookupTable<LogicalRegion,RegionNode*>::Shard &shard =
+              region_nodes.get_shard(handle);
+            AutoLock s_lock(shard.lock,1,false/*exclusive*/);
+            std::map<LogicalRegion,RegionNode*>::const_iterator it =
+              shard.entries.find(handle);
+            if (it != shard.entries.end())
             {
               result = it->second;
               wait_on = result->initialized;
@@ -4697,7 +4753,9 @@ namespace Legion {
             {
               if (!wait_on.has_triggered())
                 wait_on.wait();
-              AutoLock l_lock(lookup_lock);
+              LookupTable<LogicalRegion,RegionNode*>::Shard &shard =
+                region_nodes.get_shard(handle);
+              AutoLock s_lock(shard.lock);
               result->initialized = RtEvent::NO_RT_EVENT;
             }
             return result;
@@ -4730,15 +4788,17 @@ namespace Legion {
         // Even though this is a root node, we'll discover it's already made
         result = create_node(handle, NULL, RtEvent::NO_RT_EVENT, 0/*did*/);
       }
+      LookupTable<LogicalRegion,RegionNode*>::Shard &shard =
+        region_nodes.get_shard(handle);
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
+        AutoLock s_lock(shard.lock,1,false/*exclusive*/);
         if (!result->initialized.exists())
           return result;
         wait_on = result->initialized;
       }
       if (!wait_on.has_triggered())
         wait_on.wait();
-      AutoLock l_lock(lookup_lock);
+      AutoLock s_lock(shard.lock);
       result->initialized = RtEvent::NO_RT_EVENT;
       return result;
     }
@@ -4755,10 +4815,12 @@ namespace Legion {
       PartitionNode *result = NULL;
       // Check to see if the node already exists
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
+        const LookupTable<LogicalPartition,PartitionNode*>::Shard &shard =
+          part_nodes.get_shard(handle);
+        AutoLock s_lock(shard.lock,1,false/*exclusive*/);
         std::map<LogicalPartition,PartitionNode*>::const_iterator it =
-          part_nodes.find(handle);
-        if (it != part_nodes.end())
+          shard.entries.find(handle);
+        if (it != shard.entries.end())
         {
           if (it->second->initialized.exists())
           {
@@ -4773,7 +4835,9 @@ namespace Legion {
       {
         if (!wait_on.has_triggered())
           wait_on.wait();
-        AutoLock l_lock(lookup_lock);
+        LookupTable<LogicalPartition,PartitionNode*>::Shard &shard =
+          part_nodes.get_shard(handle);
+        AutoLock s_lock(shard.lock);
         result->initialized = RtEvent::NO_RT_EVENT;
         return result;
       }
@@ -4789,15 +4853,17 @@ namespace Legion {
       RegionNode *parent = get_node(parent_handle, need_check);
       // Now create our node and return it
       result = create_node(handle, parent);
+      LookupTable<LogicalPartition,PartitionNode*>::Shard &shard =
+        part_nodes.get_shard(handle);
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
+        AutoLock s_lock(shard.lock,1,false/*exclusive*/);
         if (!result->initialized.exists())
           return result;
         wait_on = result->initialized;
       }
       if (!wait_on.has_triggered())
         wait_on.wait();
-      AutoLock l_lock(lookup_lock);
+      AutoLock s_lock(shard.lock);
       result->initialized = RtEvent::NO_RT_EVENT;
       return result;
     }
@@ -4811,22 +4877,20 @@ namespace Legion {
           "Invalid request for tree ID 0 which is never a tree ID")
       RtEvent wait_on;
       RegionNode *result = NULL;
+      if (tree_nodes.find(tid, result))
       {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-        std::map<RegionTreeID,RegionNode*>::const_iterator finder = 
-          tree_nodes.find(tid);
-        if (finder != tree_nodes.end())
+        // The initialized event of the root is protected by
+        // the shard of the region nodes for its handle
+        LookupTable<LogicalRegion,RegionNode*>::Shard &shard =
+          region_nodes.get_shard(result->handle);
         {
-          if (!finder->second->initialized.exists())
-            return finder->second;
-          wait_on = finder->second->initialized;
-          result = finder->second;
+          AutoLock s_lock(shard.lock,1,false/*exclusive*/);
+          if (!result->initialized.exists())
+            return result;
+          wait_on = result->initialized;
         }
-      }
-      if (result != NULL)
-      {
         wait_on.wait();
-        AutoLock l_lock(lookup_lock);
+        AutoLock s_lock(shard.lock);
         result->initialized = RtEvent::NO_RT_EVENT;
         return result;
       }
@@ -4839,10 +4903,12 @@ namespace Legion {
         RtEvent pending_wait;
         if (first)
         {
-          AutoLock l_lock(lookup_lock);
-          std::map<RegionTreeID,RtUserEvent>::iterator finder = 
-            pending_region_trees.find(tid);
-          if (finder != pending_region_trees.end())
+          LookupTable<RegionTreeID,RtUserEvent>::Shard &shard =
+            pending_region_trees.get_shard(tid);
+          AutoLock s_lock(shard.lock);
+          std::map<RegionTreeID,RtUserEvent>::iterator finder =
+            shard.entries.find(tid);
+          if (finder != shard.entries.end())
           {
             if (!finder->second.exists())
               finder->second = Runtime::create_rt_user_event();
@@ -4862,10 +4928,9 @@ namespace Legion {
         // Retake the lock in exclusive mode and check to
         // make sure that we didn't lose the race
         AutoLock l_lock(lookup_lock);
-        std::map<RegionTreeID,RegionNode*>::const_iterator finder = 
-          tree_nodes.find(tid);
-        if (finder != tree_nodes.end())
-          return finder->second;
+        RegionNode *node = NULL;
+        if (tree_nodes.find(tid, node))
+          return node;
         // Now see if we've already send a request
         std::map<RegionTreeID,RtEvent>::const_iterator req_finder =
           region_tree_requests.find(tid);
@@ -4883,30 +4948,22 @@ namespace Legion {
           wait_on = req_finder->second;
       }
       wait_on.wait();
-      AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      std::map<RegionTreeID,RegionNode*>::const_iterator finder = 
-          tree_nodes.find(tid);
-      if (finder == tree_nodes.end())
+      if (!tree_nodes.find(tid, result))
         REPORT_LEGION_ERROR(ERROR_UNABLE_FIND_TOPLEVEL_TREE,
           "Unable to find top-level tree entry for "
                          "region tree %d.  This is either a runtime "
                          "bug or requires Legion fences if names are "
                          "being returned out of the context in which"
                          "they are being created.", tid)
-      return finder->second;
+      return result;
     }
 
     //--------------------------------------------------------------------------
     RtEvent RegionTreeForest::request_node(IndexSpace space)
     //--------------------------------------------------------------------------
     {
-      {
-        AutoLock l_lock(lookup_lock,1,false/*exclusive*/); 
-        std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-          index_nodes.find(space);
-        if (finder != index_nodes.end())
-          return RtEvent::NO_RT_EVENT;
-      }
+      if (index_nodes.contains(space))
+        return RtEvent::NO_RT_EVENT;
       // Couldn't find it, so send a request to the owner node
       AddressSpace owner = IndexSpaceNode::get_owner_space(space, runtime);
       if (owner == runtime->address_space)
@@ -4914,9 +4971,7 @@ namespace Legion {
           "Unable to find entry for index space %x.", space.id)
       AutoLock l_lock(lookup_lock);
       // Check to make sure we didn't loose the race
-      std::map<IndexSpace,IndexSpaceNode*>::const_iterator finder = 
-        index_nodes.find(space);
-      if (finder != index_nodes.end())
+      if (index_nodes.contains(space))
         return RtEvent::NO_RT_EVENT;
       // Still doesn't exists, see if we sent a request already
       std::map<IndexSpace,RtEvent>::const_iterator wait_finder = 
@@ -4939,24 +4994,21 @@ namespace Legion {
     bool RegionTreeForest::has_node(IndexSpace space)
     //--------------------------------------------------------------------------
     {
-      AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      return (index_nodes.find(space) != index_nodes.end());
+      return index_nodes.contains(space);
     }
     
     //--------------------------------------------------------------------------
     bool RegionTreeForest::has_node(IndexPartition part)
     //--------------------------------------------------------------------------
     {
-      AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      return (index_parts.find(part) != index_parts.end());
+      return index_parts.contains(part);
     }
 
     //--------------------------------------------------------------------------
     bool RegionTreeForest::has_node(FieldSpace space)
     //--------------------------------------------------------------------------
     {
-      AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      return (field_nodes.find(space) != field_nodes.end());
+      return field_nodes.contains(space);
     }
 
     //--------------------------------------------------------------------------
@@ -4981,8 +5033,7 @@ namespace Legion {
     bool RegionTreeForest::has_tree(RegionTreeID tid)
     //--------------------------------------------------------------------------
     {
-      AutoLock l_lock(lookup_lock,1,false/*exclusive*/);
-      return (tree_nodes.find(tid) != tree_nodes.end());
+      return tree_nodes.contains(tid);
     }
 
     //--------------------------------------------------------------------------
@@ -4998,13 +5049,9 @@ namespace Legion {
     {
       AutoLock l_lock(lookup_lock);
 #ifdef DEBUG_LEGION
-      std::map<IndexSpace,IndexSpaceNode*>::iterator finder = 
-        index_nodes.find(space);
-      assert(finder != index_nodes.end());
-      index_nodes.erase(finder);
-#else
-      index_nodes.erase(space);
+      assert(index_nodes.contains(space));
 #endif
+      index_nodes.erase(space);
     }
 
     //--------------------------------------------------------------------------
@@ -5014,13 +5061,9 @@ namespace Legion {
       AutoLock l_lock(lookup_lock);
 #ifdef DEBUG_LEGION
       assert(index_part_requests.find(part) == index_part_requests.end());
-      std::map<IndexPartition,IndexPartNode*>::iterator finder = 
-        index_parts.find(part);
-      assert(finder != index_parts.end());
-      index_parts.erase(finder);
-#else
-      index_parts.erase(part);
+      assert(index_parts.contains(part));
 #endif
+      index_parts.erase(part);
     }
 
     //--------------------------------------------------------------------------
@@ -5029,13 +5072,9 @@ namespace Legion {
     {
       AutoLock l_lock(lookup_lock);
 #ifdef DEBUG_LEGION
-      std::map<FieldSpace,FieldSpaceNode*>::iterator finder = 
-        field_nodes.find(space);
-      assert(finder != field_nodes.end());
-      field_nodes.erase(finder);
-#else
-      field_nodes.erase(space);
+      assert(field_nodes.contains(space));
 #endif
+      field_nodes.erase(space);
     }
 
     //--------------------------------------------------------------------------
@@ -5044,23 +5083,12 @@ namespace Legion {
     {
       AutoLock l_lock(lookup_lock);
 #ifdef DEBUG_LEGION
-      if (top)
-      {
-        std::map<RegionTreeID,RegionNode*>::iterator finder = 
-          tree_nodes.find(handle.get_tree_id());
-        assert(finder != tree_nodes.end());
-        tree_nodes.erase(finder);
-      }
-#else
+      assert(!top || tree_nodes.contains(handle.get_tree_id()));
+      assert(region_nodes.contains(handle));
+#endif
       if (top)
         tree_nodes.erase(handle.get_tree_id());
-#endif
-      std::map<LogicalRegion,RegionNode*>::iterator finder = 
-        region_nodes.find(handle);
-#ifdef DEBUG_LEGION
-      assert(finder != region_nodes.end());
-#endif
-      region_nodes.erase(finder);
+      region_nodes.erase(handle);
     }
 
     //--------------------------------------------------------------------------
@@ -5068,12 +5096,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       AutoLock l_lock(lookup_lock);
-      std::map<LogicalPartition,PartitionNode*>::iterator finder = 
-        part_nodes.find(handle);
 #ifdef DEBUG_LEGION
-      assert(finder != part_nodes.end());
+      assert(part_nodes.contains(handle));
 #endif
-      part_nodes.erase(finder);
+      part_nodes.erase(handle);
     }
 
     //--------------------------------------------------------------------------
@@ -5084,11 +5110,10 @@ namespace Legion {
       // We should be the owner for this space
       assert((space % runtime->total_address_spaces) == runtime->address_space);
 #endif
-      AutoLock l_lock(lookup_lock);
 #ifdef DEBUG_LEGION
-      assert(pending_index_spaces.find(space) == pending_index_spaces.end());
+      assert(!pending_index_spaces.contains(space));
 #endif
-      pending_index_spaces[space] = RtUserEvent::NO_RT_USER_EVENT;
+      pending_index_spaces.insert(space, RtUserEvent::NO_RT_USER_EVENT);
     }
 
     //--------------------------------------------------------------------------
@@ -5099,11 +5124,10 @@ namespace Legion {
       // We should be the owner for this space
       assert((pid % runtime->total_address_spaces) == runtime->address_space);
 #endif
-      AutoLock l_lock(lookup_lock);
 #ifdef DEBUG_LEGION
-      assert(pending_partitions.find(pid) == pending_partitions.end());
+      assert(!pending_partitions.contains(pid));
 #endif
-      pending_partitions[pid] = RtUserEvent::NO_RT_USER_EVENT;
+      pending_partitions.insert(pid, RtUserEvent::NO_RT_USER_EVENT);
     }
 
     //--------------------------------------------------------------------------
@@ -5114,11 +5138,10 @@ namespace Legion {
       // We should be the owner for this space
       assert((space % runtime->total_address_spaces) == runtime->address_space);
 #endif
-      AutoLock l_lock(lookup_lock);
 #ifdef DEBUG_LEGION
-      assert(pending_field_spaces.find(space) == pending_field_spaces.end());
+      assert(!pending_field_spaces.contains(space));
 #endif
-      pending_field_spaces[space] = RtUserEvent::NO_RT_USER_EVENT;
+      pending_field_spaces.insert(space, RtUserEvent::NO_RT_USER_EVENT);
     }
 
     //--------------------------------------------------------------------------
@@ -5129,28 +5152,21 @@ namespace Legion {
       // We should be the owner for this space
       assert((tid % runtime->total_address_spaces) == runtime->address_space);
 #endif
-      AutoLock l_lock(lookup_lock);
 #ifdef DEBUG_LEGION
-      assert(pending_region_trees.find(tid) == pending_region_trees.end());
+      assert(!pending_region_trees.contains(tid));
 #endif
-      pending_region_trees[tid] = RtUserEvent::NO_RT_USER_EVENT;
+      pending_region_trees.insert(tid, RtUserEvent::NO_RT_USER_EVENT);
     }
 
     //--------------------------------------------------------------------------
     void RegionTreeForest::revoke_pending_index_space(IndexSpaceID space)
     //--------------------------------------------------------------------------
     {
-      RtUserEvent to_trigger;
-      {
-        AutoLock l_lock(lookup_lock);
-        std::map<IndexSpaceID,RtUserEvent>::iterator finder = 
-          pending_index_spaces.find(space);
 #ifdef DEBUG_LEGION
-        assert(finder != pending_index_spaces.end());
+      assert(pending_index_spaces.contains(space));
 #endif
-        to_trigger = finder->second;
-        pending_index_spaces.erase(finder);
-      }
+      RtUserEvent to_trigger;
+      pending_index_spaces.extract(space, to_trigger);
       if (to_trigger.exists())
         Runtime::trigger_event(to_trigger);
     }
@@ -5159,17 +5175,11 @@ namespace Legion {
     void RegionTreeForest::revoke_pending_partition(IndexPartitionID pid)
     //--------------------------------------------------------------------------
     {
-      RtUserEvent to_trigger;
-      {
-        AutoLock l_lock(lookup_lock);
-        std::map<IndexPartitionID,RtUserEvent>::iterator finder = 
-          pending_partitions.find(pid);
 #ifdef DEBUG_LEGION
-        assert(finder != pending_partitions.end());
+      assert(pending_partitions.contains(pid));
 #endif
-        to_trigger = finder->second;
-        pending_partitions.erase(finder);
-      }
+      RtUserEvent to_trigger;
+      pending_partitions.extract(pid, to_trigger);
       if (to_trigger.exists())
         Runtime::trigger_event(to_trigger);
     }
@@ -5178,17 +5188,11 @@ namespace Legion {
     void RegionTreeForest::revoke_pending_field_space(FieldSpaceID space)
     //--------------------------------------------------------------------------
     {
-      RtUserEvent to_trigger;
-      {
-        AutoLock l_lock(lookup_lock);
-        std::map<FieldSpaceID,RtUserEvent>::iterator finder = 
-          pending_field_spaces.find(space);
 #ifdef DEBUG_LEGION
-        assert(finder != pending_field_spaces.end());
+      assert(pending_field_spaces.contains(space));
 #endif
-        to_trigger = finder->second;
-        pending_field_spaces.erase(finder);
-      }
+      RtUserEvent to_trigger;
+      pending_field_spaces.extract(space, to_trigger);
       if (to_trigger.exists())
         Runtime::trigger_event(to_trigger);
     }
@@ -5197,17 +5201,11 @@ namespace Legion {
     void RegionTreeForest::revoke_pending_region_tree(RegionTreeID tid)
     //--------------------------------------------------------------------------
     {
-      RtUserEvent to_trigger;
-      {
-        AutoLock l_lock(lookup_lock);
-        std::map<RegionTreeID,RtUserEvent>::iterator finder = 
-          pending_region_trees.find(tid);
 #ifdef DEBUG_LEGION
-        assert(finder != pending_region_trees.end());
+      assert(pending_region_trees.contains(tid));
 #endif
-        to_trigger = finder->second;
-        pending_region_trees.erase(finder);
-      }
+      RtUserEvent to_trigger;
+      pending_region_trees.extract(tid, to_trigger);
       if (to_trigger.exists())
         Runtime::trigger_event(to_trigger);
     }
@@ -5602,8 +5600,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       TreeStateLogger dump_logger; 
-      assert(region_nodes.find(region) != region_nodes.end());
-      region_nodes[region]->dump_logical_context(ctx, &dump_logger,
+      RegionNode *node = NULL;
+      region_nodes.find(region, node);
+      assert(node != NULL);
+      node->dump_logical_context(ctx, &dump_logger,
                                  FieldMask(LEGION_FIELD_MASK_FIELD_ALL_ONES));
     }
 
@@ -5613,8 +5613,10 @@ namespace Legion {
     //--------------------------------------------------------------------------
     {
       TreeStateLogger dump_logger;
-      assert(region_nodes.find(region) != region_nodes.end());
-      region_nodes[region]->dump_physical_context(ctx, &dump_logger,
+      RegionNode *node = NULL;
+      region_nodes.find(region, node);
+      assert(node != NULL);
+      node->dump_physical_context(ctx, &dump_logger,
                                 FieldMask(LEGION_FIELD_MASK_FIELD_ALL_ONES));
     }
 #endif
@@ -6056,71 +6058,20 @@ namespace Legion {
       assert(expressions.size() >= 2);
       assert(expressions.size() <= MAX_EXPRESSION_FANOUT);
 #endif
-      IndexSpaceExpression *first = expressions[0];
-      const IndexSpaceExprID key = first->expr_id;
-      // See if we can find it in read-only mode
-      {
-        AutoLock l_lock(lookup_is_op_lock,1,false/*exclusive*/);
-        std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-          finder = union_ops.find(key);
-        if (finder != union_ops.end())
-        {
-          IndexSpaceExpression *result = NULL;
-          ExpressionTrieNode *next = NULL;
-          if (finder->second->find_operation(expressions, result, next) &&
-              result->try_add_live_reference())
-            return result;
-          if (creator == NULL)
-          {
-            UnionOpCreator union_creator(this, first->type_tag, expressions);
-            return next->find_or_create_operation(expressions, union_creator);
-          }
-          else
-            return next->find_or_create_operation(expressions, *creator);
-        }
-      }
-      ExpressionTrieNode *node = NULL;
+      // See if we can find it with just the read-only lock on its stripe
+      IndexSpaceExpression *result = union_ops.find_operation(expressions);
+      if (result != NULL)
+        return result;
       if (creator == NULL)
       {
-        UnionOpCreator union_creator(this, first->type_tag, expressions);
-        // Didn't find it, retake the lock, see if we lost the race
-        // and if no make the actual trie node
-        AutoLock l_lock(lookup_is_op_lock);
-        std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-          finder = union_ops.find(key);
-        if (finder == union_ops.end())
-        {
-          // Didn't lose the race, so make the node
-          node = new ExpressionTrieNode(0/*depth*/, first->expr_id);
-          union_ops[key] = node;
-        }
-        else
-          node = finder->second;
-#ifdef DEBUG_LEGION
-        assert(node != NULL);
-#endif
-        return node->find_or_create_operation(expressions, union_creator);
+        UnionOpCreator union_creator(this, expressions[0]->type_tag, 
+                                     expressions);
+        return union_ops.find_or_create_operation(expressions, union_creator,
+                                              runtime->expression_cache_size);
       }
       else
-      {
-        // Didn't find it, retake the lock, see if we lost the race
-        // and if no make the actual trie node
-        AutoLock l_lock(lookup_is_op_lock);
-        std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-          finder = union_ops.find(key);
-        if (finder == union_ops.end())
-        {
-          // Didn't lose the race, so make the node
-          node = new ExpressionTrieNode(0/*depth*/, first->expr_id);
-          union_ops[key] = node;
-        }
-        else
-          node = finder->second;
-#ifdef DEBUG_LEGION
-        assert(node != NULL);
-#endif
-        return node->find_or_create_operation(expressions, *creator);
-      }
+        return union_ops.find_or_create_operation(expressions, *creator,
+                                              runtime->expression_cache_size);
     }
 
     //--------------------------------------------------------------------------
@@ -6326,74 +6277,21 @@ namespace Legion {
       assert(expressions.size() >= 2);
       assert(expressions.size() <= MAX_EXPRESSION_FANOUT);
 #endif
-      IndexSpaceExpression *first = expressions[0];
-      const IndexSpaceExprID key = first->expr_id;
-      // See if we can find it in read-only mode
-      {
-        AutoLock l_lock(lookup_is_op_lock,1,false/*exclusive*/);
-        std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-          finder = intersection_ops.find(key);
-        if (finder != intersection_ops.end())
-        {
-          IndexSpaceExpression *result = NULL;
-          ExpressionTrieNode *next = NULL;
-          if (finder->second->find_operation(expressions, result, next) &&
-              result->try_add_live_reference())
-            return result;
-          if (creator == NULL)
-          {
-            IntersectionOpCreator inter_creator(this, first->type_tag, 
-                                                expressions);
-            return next->find_or_create_operation(expressions, inter_creator);
-          }
-          else
-            return next->find_or_create_operation(expressions, *creator);
-        }
-      }
-      ExpressionTrieNode *node = NULL;
+      // See if we can find it with just the read-only lock on its stripe
+      IndexSpaceExpression *result = 
+        intersection_ops.find_operation(expressions);
+      if (result != NULL)
+        return result;
       if (creator == NULL)
       {
-        IntersectionOpCreator inter_creator(this, first->type_tag, expressions);
-        // Didn't find it, retake the lock, see if we lost the race
-        // and if not make the actual trie node
-        AutoLock l_lock(lookup_is_op_lock);
-        // See if we lost the race
-        std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-          finder = intersection_ops.find(key);
-        if (finder == intersection_ops.end())
-        {
-          // Didn't lose the race so make the node
-          node = new ExpressionTrieNode(0/*depth*/, first->expr_id);
-          intersection_ops[key] = node;
-        }
-        else
-          node = finder->second;
-#ifdef DEBUG_LEGION
-        assert(node != NULL); 
-#endif
-        return node->find_or_create_operation(expressions, inter_creator);
+        IntersectionOpCreator inter_creator(this, expressions[0]->type_tag,
+                                            expressions);
+        return intersection_ops.find_or_create_operation(expressions,
+                          inter_creator, runtime->expression_cache_size);
       }
       else
-      {
-        // Didn't find it, retake the lock, see if we lost the race
-        // and if not make the actual trie node
-        AutoLock l_lock(lookup_is_op_lock);
-        // See if we lost the race
-        std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-          finder = intersection_ops.find(key);
-        if (finder == intersection_ops.end())
-        {
-          // Didn't lose the race so make the node
-          node = new ExpressionTrieNode(0/*depth*/, first->expr_id);
-          intersection_ops[key] = node;
-        }
-        else
-          node = finder->second;
-#ifdef DEBUG_LEGION
-        assert(node != NULL); 
-#endif
-        return node->find_or_create_operation(expressions, *creator);
-      }
+        return intersection_ops.find_or_create_operation(expressions,
+                          *creator, runtime->expression_cache_size);
     }
     
     //--------------------------------------------------------------------------
@@ -6418,82 +6316,20 @@ namespace Legion {
       std::vector<IndexSpaceExpression*> expressions(2);
       expressions[0] = lhs->get_canonical_expression(this);
       expressions[1] = rhs->get_canonical_expression(this);
-      const IndexSpaceExprID key = expressions[0]->expr_id;
-      // See if we can find it in read-only mode
-      IndexSpaceExpression *result = NULL;
-      {
-        AutoLock l_lock(lookup_is_op_lock,1,false/*exclusive*/);
-        std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-          finder = difference_ops.find(key);
-        if (finder != difference_ops.end())
-        {
-          IndexSpaceExpression *expr = NULL;
-          ExpressionTrieNode *next = NULL;
-          if (finder->second->find_operation(expressions, expr, next) &&
-              expr->try_add_live_reference())
-            result = expr;
-          if (result == NULL)
-          {
-            if (creator == NULL)
-            {
-              DifferenceOpCreator diff_creator(this, lhs->type_tag, 
-                                    expressions[0], expressions[1]);
-              result = next->find_or_create_operation(expressions,diff_creator);
-            }
-            else
-              result = next->find_or_create_operation(expressions, *creator);
-          }
-        }
-      }
-      if (result == NULL)
+      // See if we can find it with just the read-only lock on its stripe
+      IndexSpaceExpression *result = difference_ops.find_operation(expressions);
+      if (result != NULL)
+        return result;
+      if (creator == NULL)
       {
-        ExpressionTrieNode *node = NULL;
-        if (creator == NULL)
-        {
-          DifferenceOpCreator diff_creator(this, lhs->type_tag,
-                                expressions[0], expressions[1]);
-          // Didn't find it, retake the lock, see if we lost the race
-          // and if not make the actual trie node
-          AutoLock l_lock(lookup_is_op_lock);
-          // See if we lost the race
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-            finder = difference_ops.find(key);
-          if (finder == difference_ops.end())
-          {
-            // Didn't lose the race so make the node
-            node = new ExpressionTrieNode(0/*depth*/, expressions[0]->expr_id);
-            difference_ops[key] = node;
-          }
-          else
-            node = finder->second;
-#ifdef DEBUG_LEGION
-          assert(node != NULL);
-#endif
-          result = node->find_or_create_operation(expressions, diff_creator);
-        }
-        else
-        {
-          // Didn't find it, retake the lock, see if we lost the race
-          // and if not make the actual trie node
-          AutoLock l_lock(lookup_is_op_lock);
-          // See if we lost the race
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator 
-            finder = difference_ops.find(key);
-          if (finder == difference_ops.end())
-          {
-            // Didn't lose the race so make the node
-            node = new ExpressionTrieNode(0/*depth*/, expressions[0]->expr_id);
-            difference_ops[key] = node;
-          }
-          else
-            node = finder->second;
-#ifdef DEBUG_LEGION
-          assert(node != NULL);
-#endif
-          result = node->find_or_create_operation(expressions, *creator);
-        }
+        DifferenceOpCreator diff_creator(this, lhs->type_tag,
+                              expressions[0], expressions[1]);
+        return difference_ops.find_or_create_operation(expressions,
+                            diff_creator, runtime->expression_cache_size);
       }
-      return result;
+      else
+        return difference_ops.find_or_create_operation(expressions,
+                            *creator, runtime->expression_cache_size);
     }
 
     //--------------------------------------------------------------------------
@@ -6507,8 +6343,11 @@ namespace Legion {
       if (volume == 0)
         return expr;
       const std::pair<size_t,TypeTag> key(volume, expr->type_tag);
-      AutoLock c_lock(congruence_lock);
-      return expr->find_congruent_expression(canonical_expressions[key]);
+      LookupTable<std::pair<size_t,TypeTag>,
+        std::set<IndexSpaceExpression*> >::Shard &shard = 
+          canonical_expressions.get_shard(key);
+      AutoLock c_lock(shard.lock);
+      return expr->find_congruent_expression(shard.entries[key]);
     }
 
     //--------------------------------------------------------------------------
@@ -6520,15 +6359,18 @@ namespace Legion {
       if (volume == 0)
         return;
       const std::pair<size_t,TypeTag> key(volume, expr->type_tag);
-      AutoLock c_lock(congruence_lock);
-      std::set<IndexSpaceExpression*> &exprs = canonical_expressions[key];
+      LookupTable<std::pair<size_t,TypeTag>,
+        std::set<IndexSpaceExpression*> >::Shard &shard = 
+          canonical_expressions.get_shard(key);
+      AutoLock c_lock(shard.lock);
+      std::set<IndexSpaceExpression*> &exprs = shard.entries[key];
       std::set<IndexSpaceExpression*>::iterator finder = exprs.find(expr);
 #ifdef DEBUG_LEGION
       assert(finder != exprs.end());
 #endif
       exprs.erase(finder);
       if (exprs.empty())
-        canonical_expressions.erase(key);
+        shard.entries.erase(key);
     }
 
     //--------------------------------------------------------------------------
@@ -6539,18 +6381,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(op->op_kind == IndexSpaceOperation::UNION_OP_KIND);
 #endif
-      const IndexSpaceExprID key = exprs[0]->expr_id;
-      AutoLock l_lock(lookup_is_op_lock);
-      std::map<IndexSpaceExprID,ExpressionTrieNode*>::iterator 
-        finder = union_ops.find(key);
-#ifdef DEBUG_LEGION
-      assert(finder != union_ops.end());
-#endif
-      if (finder->second->remove_operation(exprs))
-      {
-        delete finder->second;
-        union_ops.erase(finder);
-      }
+      union_ops.remove_operation(op, exprs);
     }
 
     //--------------------------------------------------------------------------
@@ -6561,18 +6392,7 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(op->op_kind == IndexSpaceOperation::INTERSECT_OP_KIND);
 #endif
-      const IndexSpaceExprID key(exprs[0]->expr_id);
-      AutoLock l_lock(lookup_is_op_lock);
-      std::map<IndexSpaceExprID,ExpressionTrieNode*>::iterator 
-        finder = intersection_ops.find(key);
-#ifdef DEBUG_LEGION
-      assert(finder != intersection_ops.end());
-#endif
-      if (finder->second->remove_operation(exprs))
-      {
-        delete finder->second;
-        intersection_ops.erase(finder);
-      }
+      intersection_ops.remove_operation(op, exprs);
     }
 
     //--------------------------------------------------------------------------
@@ -6583,21 +6403,10 @@ namespace Legion {
 #ifdef DEBUG_LEGION
       assert(op->op_kind == IndexSpaceOperation::DIFFERENCE_OP_KIND);
 #endif
-      const IndexSpaceExprID key = lhs->expr_id;
       std::vector<IndexSpaceExpression*> exprs(2);
       exprs[0] = lhs;
       exprs[1] = rhs;
-      AutoLock l_lock(lookup_is_op_lock);
-      std::map<IndexSpaceExprID,ExpressionTrieNode*>::iterator 
-        finder = difference_ops.find(key);
-#ifdef DEBUG_LEGION
-      assert(finder != difference_ops.end());
-#endif
-      if (finder->second->remove_operation(exprs))
-      {
-        delete finder->second;
-        difference_ops.erase(finder);
-      }
+      difference_ops.remove_operation(op, exprs);
     }
 
     //--------------------------------------------------------------------------
@@ -7415,6 +7224,22 @@ namespace Legion {
         return false;
     }
 
+    //--------------------------------------------------------------------------
+    bool IndexSpaceOperation::is_only_cache_referenced(void)
+    //--------------------------------------------------------------------------
+    {
+      // The expression cache holds one gc reference, anything else that
+      // is using this operation (including other nodes) holds another
+      if (has_remote_instances())
+        return false;
+#ifdef DEBUG_LEGION_GC
+      AutoLock gc(gc_lock,1,false/*exclusive*/);
+      return (gc_references == 1);
+#else
+      return (gc_references.load() == 1);
+#endif
+    }
+
     //--------------------------------------------------------------------------
     void IndexSpaceOperation::add_base_expression_reference(
                                          ReferenceSource source, unsigned count)
@@ -7495,7 +7320,7 @@ namespace Legion {
     }
 
     //--------------------------------------------------------------------------
-    IndexSpaceExpression* OperationCreator::consume(void)
+    IndexSpaceOperation* OperationCreator::consume(void)
     //--------------------------------------------------------------------------
     {
       if (result == NULL)
@@ -7504,349 +7329,250 @@ namespace Legion {
       assert(result != NULL);
 #endif
       // Add an expression reference here since this is going to be put
-      // into the region tree expression trie data structure, the reference
-      // will be removed when the expressions is removed from the trie
+      // into the region tree expression cache, the reference will be 
+      // removed when the expression is invalidated or evicted
       result->add_base_gc_ref(REGION_TREE_REF);
       return result;
     }
 
     /////////////////////////////////////////////////////////////
-    // Expression Trie Node 
+    // Expression Cache 
     /////////////////////////////////////////////////////////////
 
     //--------------------------------------------------------------------------
-    ExpressionTrieNode::ExpressionTrieNode(unsigned d, IndexSpaceExprID id,
-                                           IndexSpaceExpression *op)
-      : depth(d), expr(id), local_operation(op)
+    ExpressionCache::Entry::Entry(IndexSpaceOperation *o, uint64_t stamp,
+                          const std::vector<IndexSpaceExpression*> &expressions)
+      : op(o), last_use(stamp)
     //--------------------------------------------------------------------------
     {
+      operands.resize(expressions.size());
+      for (unsigned idx = 0; idx < expressions.size(); idx++)
+        operands[idx] = expressions[idx]->expr_id;
     }
 
     //--------------------------------------------------------------------------
-    ExpressionTrieNode::ExpressionTrieNode(const ExpressionTrieNode &rhs)
-      : depth(rhs.depth), expr(rhs.expr)
+    bool ExpressionCache::Entry::matches(
+                    const std::vector<IndexSpaceExpression*> &expressions) const
     //--------------------------------------------------------------------------
     {
-      // should never be called
-      assert(false);
+      if (operands.size() != expressions.size())
+        return false;
+      for (unsigned idx = 0; idx < operands.size(); idx++)
+        if (operands[idx] != expressions[idx]->expr_id)
+          return false;
+      return true;
     }
 
     //--------------------------------------------------------------------------
-    ExpressionTrieNode::~ExpressionTrieNode(void)
+    ExpressionCache::ExpressionCache(void)
+      : clock(0), hits(0), misses(0), evictions(0)
     //--------------------------------------------------------------------------
     {
     }
 
     //--------------------------------------------------------------------------
-    ExpressionTrieNode& ExpressionTrieNode::operator=(
-                                                  const ExpressionTrieNode &rhs)
+    ExpressionCache::~ExpressionCache(void)
     //--------------------------------------------------------------------------
     {
-      // should never be called
-      assert(false);
-      return *this;
     }
 
     //--------------------------------------------------------------------------
-    bool ExpressionTrieNode::find_operation(
-                       const std::vector<IndexSpaceExpression*> &expressions,
-                       IndexSpaceExpression *&result, ExpressionTrieNode *&last)
+    /*static*/ uint64_t ExpressionCache::compute_hash(
+                          const std::vector<IndexSpaceExpression*> &expressions)
     //--------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(depth < expressions.size());
-      assert(expressions[depth]->expr_id == expr); // these should match
-#endif
-      // Three cases here
-      if (expressions.size() == (depth+1))
+      // FNV-1a over the operand IDs followed by a final avalanche so 
+      // that both the stripe and the bucket bits see every operand
+      uint64_t hash = 0xcbf29ce484222325ULL ^ expressions.size();
+      for (std::vector<IndexSpaceExpression*>::const_iterator it =
+            expressions.begin(); it != expressions.end(); it++)
+        hash = (hash ^ (*it)->expr_id) * 0x100000001b3ULL;
+      hash ^= (hash >> 33);
+      hash *= 0xff51afd7ed558ccdULL;
+      hash ^= (hash >> 33);
+      return hash;
+    }
+
+    //--------------------------------------------------------------------------
+    IndexSpaceExpression* ExpressionCache::find_operation(
+                          const std::vector<IndexSpaceExpression*> &expressions)
+    //--------------------------------------------------------------------------
+    {
+      const uint64_t hash = compute_hash(expressions);
+      const Stripe &stripe = stripes[get_stripe_index(hash)];
+      AutoLock s_lock(stripe.lock,1,false/*exclusive*/);
+      std::pair<EntryTable::const_iterator,EntryTable::const_iterator>
+        range = stripe.entries.equal_range(hash);
+      for (EntryTable::const_iterator it = range.first; 
+            it != range.second; it++)
       {
-        // We're the node that should have the operation
-        // Check to see if we've made the operation yet
-        if (local_operation != NULL)
-        {
-          result = local_operation;
-          return true;
-        }
-        last = this;
-        return false;
+        if (!it->second.matches(expressions))
+          continue;
+        // If we can't get a live reference then it is being collected
+        // and the caller will need to make a new operation
+        if (!it->second.op->try_add_live_reference())
+          return NULL;
+        it->second.last_use.store(
+            clock.fetch_add(1, std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second.op;
       }
-      else if (expressions.size() == (depth+2))
+      return NULL;
+    }
+
+    //--------------------------------------------------------------------------
+    IndexSpaceExpression* ExpressionCache::find_or_create_operation(
+                          const std::vector<IndexSpaceExpression*> &expressions,
+                          OperationCreator &creator, size_t capacity)
+    //--------------------------------------------------------------------------
+    {
+      const uint64_t hash = compute_hash(expressions);
+      Stripe &stripe = stripes[get_stripe_index(hash)];
+      IndexSpaceOperation *result = NULL;
+      std::vector<IndexSpaceOperation*> victims;
       {
-        // The next node should have the operation, but we might be
-        // storing it until it actually gets made
-        // See if we already have it or we have the next trie node
-        ExpressionTrieNode *next = NULL;
-        const IndexSpaceExprID target_expr = expressions.back()->expr_id;
+        AutoLock s_lock(stripe.lock);
+        const uint64_t stamp = clock.fetch_add(1) + 1;
+        std::pair<EntryTable::iterator,EntryTable::iterator> range =
+          stripe.entries.equal_range(hash);
+        for (EntryTable::iterator it = range.first; it != range.second; it++)
         {
-          AutoLock t_lock(trie_lock,1,false/*exclusive*/);
-          std::map<IndexSpaceExprID,IndexSpaceExpression*>::const_iterator
-            op_finder = operations.find(target_expr);
-          if (op_finder != operations.end())
-          {
-            result = op_finder->second;
-            return true;
-          }
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator
-            node_finder = nodes.find(target_expr);
-          if (node_finder != nodes.end())
-            next = node_finder->second;
-        }
-        // Didn't find either, retake the lock in exclusive mode and then
-        // see if we lost the race, if not make the operation or
-        if (next == NULL)
-        {
-          AutoLock t_lock(trie_lock);
-          std::map<IndexSpaceExprID,IndexSpaceExpression*>::const_iterator
-            op_finder = operations.find(target_expr);
-          if (op_finder != operations.end())
-          {
-            result = op_finder->second;
-            return true;
-          }
-          // Still don't have the op
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator
-            node_finder = nodes.find(target_expr);
-          if (node_finder == nodes.end())
+          if (!it->second.matches(expressions))
+            continue;
+          // See if we lost the race
+          if (it->second.op->try_add_live_reference())
           {
-            last = this;
-            return false;
+            it->second.last_use.store(stamp, std::memory_order_relaxed);
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second.op;
           }
-          else
-            next = node_finder->second;
+          // The old operation is being collected so replace it, it will
+          // not remove the new one since it is no longer in the entry
+          result = creator.consume();
+          it->second.op = result;
+          it->second.last_use.store(stamp, std::memory_order_relaxed);
+          break;
         }
-#ifdef DEBUG_LEGION
-        assert(next != NULL);
-#endif
-        return next->find_operation(expressions, result, last);
-      }
-      else
-      {
-        // Intermediate case 
-        // See if we have the next node, or if we have to make it
-        ExpressionTrieNode *next = NULL;
-        const IndexSpaceExprID target_expr = expressions[depth+1]->expr_id;
+        if (result == NULL)
         {
-          AutoLock t_lock(trie_lock,1,false/*exclusive*/);
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator
-            finder = nodes.find(target_expr);
-          if (finder != nodes.end())
-            next = finder->second;
+          result = creator.consume();
+          stripe.entries.emplace(std::piecewise_construct,
+              std::forward_as_tuple(hash), 
+              std::forward_as_tuple(result, stamp, expressions));
         }
-        // Still don't have it so we have to try and make it
-        if (next == NULL)
+        if (!result->try_add_live_reference())
+          assert(false); // should never hit this
+        misses.fetch_add(1, std::memory_order_relaxed);
+        if (capacity > 0)
         {
-          AutoLock t_lock(trie_lock);
-          // See if we lost the race
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator
-            finder = nodes.find(target_expr);
-          if (finder == nodes.end())
-          {
-            // We have to make the next node, also check to see if we
-            // already made an operation expression for it or not
-            std::map<IndexSpaceExprID,IndexSpaceExpression*>::iterator
-              op_finder = operations.find(target_expr);
-            if (op_finder != operations.end())
-            {
-              next = new ExpressionTrieNode(depth+1, target_expr, 
-                                            op_finder->second);
-              operations.erase(op_finder);    
-            }
-            else
-              next = new ExpressionTrieNode(depth+1, target_expr);
-            nodes[target_expr] = next;
-          }
-          else // lost the race
-            next = finder->second;
+          const size_t limit = 
+            (capacity > STRIPES) ? (capacity / STRIPES) : 1;
+          if (stripe.entries.size() > limit)
+            evict_entries(stripe, limit, victims);
         }
-#ifdef DEBUG_LEGION
-        assert(next != NULL);
-#endif
-        return next->find_operation(expressions, result, last);
       }
+      // Invalidate any evicted operations the same way that we would if
+      // one of their sub-expressions had been deleted
+      for (std::vector<IndexSpaceOperation*>::const_iterator it =
+            victims.begin(); it != victims.end(); it++)
+      {
+        if ((*it)->invalidate_operation() &&
+            (*it)->remove_base_gc_ref(REGION_TREE_REF))
+          assert(false); // should never delete since we have a resource ref
+        if ((*it)->remove_base_resource_ref(REGION_TREE_REF))
+          delete (*it);
+      }
+      return result;
     }
 
     //--------------------------------------------------------------------------
-    IndexSpaceExpression* ExpressionTrieNode::find_or_create_operation(
-                          const std::vector<IndexSpaceExpression*> &expressions,
-                          OperationCreator &creator)
+    void ExpressionCache::evict_entries(Stripe &stripe, size_t limit,
+                                    std::vector<IndexSpaceOperation*> &victims)
     //--------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(depth < expressions.size());
-      assert(expressions[depth]->expr_id == expr); // these should match
-#endif
-      // Three cases here
-      if (expressions.size() == (depth+1))
+      // Evict down to seven eighths of the limit so that the cost of 
+      // finding the least recently used entries is amortized over many
+      // insertions, we must be holding the stripe lock in exclusive mode
+      const size_t total = stripe.entries.size();
+      size_t to_evict = total - limit + (limit / 8);
+      if (to_evict >= total)
+        to_evict = total - 1;
+      if (to_evict == 0)
+        return;
+      // Only operations that nothing else is using can be evicted, since
+      // we hold the stripe lock exclusively nobody can find them and take
+      // a new reference while we are deciding
+      std::vector<std::pair<uint64_t,unsigned> > candidates;
+      std::vector<EntryTable::iterator> iterators;
+      for (EntryTable::iterator it = stripe.entries.begin();
+            it != stripe.entries.end(); it++)
+      {
+        if (!it->second.op->is_only_cache_referenced())
+          continue;
+        candidates.push_back(std::make_pair(
+              it->second.last_use.load(std::memory_order_relaxed),
+              unsigned(iterators.size())));
+        iterators.push_back(it);
+      }
+      if (candidates.empty())
+        return;
+      // Keep the least recently used candidates
+      if (candidates.size() > to_evict)
       {
-        // We're the node that should have the operation
-        // Check to see if we've made the operation yet
-        if ((local_operation != NULL) &&
-            local_operation->try_add_live_reference())
-          return local_operation;
-        // Operation doesn't exist yet, retake the lock and try to make it
-        AutoLock t_lock(trie_lock);
-        if ((local_operation != NULL) &&
-            local_operation->try_add_live_reference())
-          return local_operation;
-        local_operation = creator.consume();
-        if (!local_operation->try_add_live_reference())
-          assert(false); // should never hit this
-        return local_operation;
-      }
-      else if (expressions.size() == (depth+2))
-      {
-        // The next node should have the operation, but we might be
-        // storing it until it actually gets made
-        // See if we already have it or we have the next trie node
-        ExpressionTrieNode *next = NULL;
-        const IndexSpaceExprID target_expr = expressions.back()->expr_id;
-        {
-          AutoLock t_lock(trie_lock,1,false/*exclusive*/);
-          std::map<IndexSpaceExprID,IndexSpaceExpression*>::const_iterator
-            op_finder = operations.find(target_expr);
-          if ((op_finder != operations.end()) &&
-              op_finder->second->try_add_live_reference())
-            return op_finder->second;
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator
-            node_finder = nodes.find(target_expr);
-          if (node_finder != nodes.end())
-            next = node_finder->second;
-        }
-        // Didn't find either, retake the lock in exclusive mode and then
-        // see if we lost the race, if not make the operation or
-        if (next == NULL)
-        {
-          AutoLock t_lock(trie_lock);
-          std::map<IndexSpaceExprID,IndexSpaceExpression*>::const_iterator
-            op_finder = operations.find(target_expr);
-          if ((op_finder != operations.end()) &&
-              op_finder->second->try_add_live_reference())
-            return op_finder->second;
-          // Still don't have the op
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator
-            node_finder = nodes.find(target_expr);
-          if (node_finder == nodes.end())
-          {
-            // Didn't find the sub-node, so make the operation here
-            IndexSpaceExpression *result = creator.consume();
-            operations[target_expr] = result;
-            if (!result->try_add_live_reference())
-              assert(false); // should never hit this
-            return result;
-          }
-          else
-            next = node_finder->second;
-        }
-#ifdef DEBUG_LEGION
-        assert(next != NULL);
-#endif
-        return next->find_or_create_operation(expressions, creator);
+        std::nth_element(candidates.begin(), candidates.begin() + to_evict,
+                         candidates.end());
+        candidates.resize(to_evict);
       }
-      else
+      victims.reserve(candidates.size());
+      for (std::vector<std::pair<uint64_t,unsigned> >::const_iterator it =
+            candidates.begin(); it != candidates.end(); it++)
       {
-        // Intermediate case 
-        // See if we have the next node, or if we have to make it
-        ExpressionTrieNode *next = NULL;
-        const IndexSpaceExprID target_expr = expressions[depth+1]->expr_id;
-        {
-          AutoLock t_lock(trie_lock,1,false/*exclusive*/);
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator
-            finder = nodes.find(target_expr);
-          if (finder != nodes.end())
-            next = finder->second;
-        }
-        // Still don't have it so we have to try and make it
-        if (next == NULL)
-        {
-          AutoLock t_lock(trie_lock);
-          // See if we lost the race
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::const_iterator
-            finder = nodes.find(target_expr);
-          if (finder == nodes.end())
-          {
-            // We have to make the next node, also check to see if we
-            // already made an operation expression for it or not
-            std::map<IndexSpaceExprID,IndexSpaceExpression*>::iterator
-              op_finder = operations.find(target_expr);
-            if (op_finder != operations.end())
-            {
-              next = new ExpressionTrieNode(depth+1, target_expr, 
-                                            op_finder->second);
-              operations.erase(op_finder);
-            }
-            else
-              next = new ExpressionTrieNode(depth+1, target_expr);
-            nodes[target_expr] = next;
-          }
-          else // lost the race
-            next = finder->second;
-        }
-#ifdef DEBUG_LEGION
-        assert(next != NULL);
-#endif
-        return next->find_or_create_operation(expressions, creator);
+        EntryTable::iterator entry = iterators[it->second];
+        IndexSpaceOperation *op = entry->second.op;
+        // Keep the operation from being deleted until we are done
+        // invalidating it after we release the stripe lock
+        op->add_base_resource_ref(REGION_TREE_REF);
+        victims.push_back(op);
+        stripe.entries.erase(entry);
       }
+      evictions.fetch_add(victims.size(), std::memory_order_relaxed);
     }
 
     //--------------------------------------------------------------------------
-    bool ExpressionTrieNode::remove_operation(
+    void ExpressionCache::remove_operation(IndexSpaceOperation *op,
                           const std::vector<IndexSpaceExpression*> &expressions)
     //--------------------------------------------------------------------------
     {
-#ifdef DEBUG_LEGION
-      assert(depth < expressions.size());
-      assert(expressions[depth]->expr_id == expr); // these should match
-#endif
-      // No need for locks here, we're protected by the big lock at the top
-      // Three cases here
-      if (expressions.size() == (depth+1))
-      {
-        // Simple case, clear our local operation
-        local_operation = NULL;
-      }
-      else if (expressions.size() == (depth+2))
-      {
-        // See if we should continue traversing or if we have the operation
-        const IndexSpaceExprID target_expr = expressions.back()->expr_id;
-        std::map<IndexSpaceExprID,IndexSpaceExpression*>::iterator op_finder =
-          operations.find(target_expr);
-        if (op_finder == operations.end())
-        {
-          std::map<IndexSpaceExprID,ExpressionTrieNode*>::iterator
-            node_finder = nodes.find(target_expr);
-#ifdef DEBUG_LEGION
-          assert(node_finder != nodes.end());
-#endif
-          if (node_finder->second->remove_operation(expressions))
-          {
-            delete node_finder->second;
-            nodes.erase(node_finder);
-          }
-        }
-        else
-          operations.erase(op_finder);
-      }
-      else
+      const uint64_t hash = compute_hash(expressions);
+      Stripe &stripe = stripes[get_stripe_index(hash)];
+      AutoLock s_lock(stripe.lock);
+      std::pair<EntryTable::iterator,EntryTable::iterator> range =
+        stripe.entries.equal_range(hash);
+      for (EntryTable::iterator it = range.first; it != range.second; it++)
       {
-        const IndexSpaceExprID target_expr = expressions[depth+1]->expr_id;
-        std::map<IndexSpaceExprID,ExpressionTrieNode*>::iterator finder =
-          nodes.find(target_expr);
-#ifdef DEBUG_LEGION
-        assert(finder != nodes.end());
-#endif
-        if (finder->second->remove_operation(expressions))
-        {
-          delete finder->second;
-          nodes.erase(finder);
-        }
+        // The entry might have been evicted or replaced already
+        if (it->second.op != op)
+          continue;
+        stripe.entries.erase(it);
+        return;
       }
-      if (local_operation != NULL)
-        return false;
-      if (!operations.empty())
-        return false;
-      if (!nodes.empty())
-        return false;
-      return true;
+    }
+
+    //--------------------------------------------------------------------------
+    void ExpressionCache::report_statistics(const char *kind,
+                                            AddressSpaceID space) const
+    //--------------------------------------------------------------------------
+    {
+      const unsigned long long total_hits = hits.load();
+      const unsigned long long total_misses = misses.load();
+      if ((total_hits + total_misses) == 0)
+        return;
+      log_index.info("Expression cache for %s operations on node %d: "
+          "%llu hits, %llu misses (%.1f%% hit rate), %llu evictions", kind,
+          space, total_hits, total_misses, 
+          100.0 * total_hits / (total_hits + total_misses), 
+          (unsigned long long)evictions.load());
     }
 
     /////////////////////////////////////////////////////////////
@@ -11510,6 +11236,18 @@ namespace Legion {
         Runtime::trigger_event(to_trigger);
     }
 
+    /////////////////////////////////////////////////////////////
+    // KD Tree Builder 
+    /////////////////////////////////////////////////////////////
+
+    //--------------------------------------------------------------------------
+    /*static*/ void KDTreeBuilder::handle_build(const void *args)
+    //--------------------------------------------------------------------------
+    {
+      const BuildKDTreeArgs *bargs = (const BuildKDTreeArgs*)args;
+      bargs->builder->build();
+    }
+
     /////////////////////////////////////////////////////////////
     // Field Space Node 
     /////////////////////////////////////////////////////////////
@@ -25,6 +25,7 @@
 #include "legion/field_tree.h"
 
 #include <algorithm>
+#include <unordered_map>
 
 namespace Legion {
   namespace Internal {
@@ -95,7 +96,7 @@ namespace Legion {
       virtual ~OperationCreator(void); 
     public: 
       void produce(IndexSpaceOperation *op);
-      IndexSpaceExpression* consume(void);
+      IndexSpaceOperation* consume(void);
     public:
       virtual void create_operation(void) = 0;
     public:
@@ -103,6 +104,79 @@ namespace Legion {
     protected:
       IndexSpaceOperation *result;
     };
+
+    /**
+     * \class ExpressionCache
+     * This is a hash-consing table for index space operations of one
+     * kind so we can quickly detect common subexpressions. Operations
+     * are keyed on the tuple of the IDs of their operand expressions.
+     * Union and intersection operands are sorted before they get here
+     * so their keys are canonical, while difference operands are kept
+     * in (lhs,rhs) order. The table is split into stripes which each
+     * have their own reader-writer lock so that lookups of different
+     * operand tuples almost never contend with each other. If the table
+     * is given a capacity then the least recently used operations in a
+     * stripe that nothing else is using are evicted once the stripe fills
+     * up. Operations that are still in use are never evicted because the
+     * next lookup would then make a second operation with a different
+     * expression ID for the same operands, so a stripe can stay above its
+     * share of the capacity while all of its operations are live.
+     */
+    class ExpressionCache {
+    public:
+      static const unsigned STRIPES = LEGION_LOOKUP_TABLE_SHARDS;
+      static_assert((STRIPES & (STRIPES - 1)) == 0,
+                    "LEGION_LOOKUP_TABLE_SHARDS must be a power of two");
+      struct Entry {
+      public:
+        Entry(IndexSpaceOperation *op, uint64_t stamp,
+              const std::vector<IndexSpaceExpression*> &expressions);
+      public:
+        bool matches(
+            const std::vector<IndexSpaceExpression*> &expressions) const;
+      public:
+        IndexSpaceOperation *op;
+        std::vector<IndexSpaceExprID> operands;
+        // Logical time of the last lookup of this entry
+        mutable std::atomic<uint64_t> last_use;
+      };
+      typedef std::unordered_multimap<uint64_t/*hash*/,Entry> EntryTable;
+      struct alignas(64) Stripe {
+      public:
+        mutable LocalLock lock;
+        EntryTable entries;
+      };
+    public:
+      ExpressionCache(void);
+      ExpressionCache(const ExpressionCache &rhs) = delete;
+      ~ExpressionCache(void);
+    public:
+      ExpressionCache& operator=(const ExpressionCache &rhs) = delete;
+    public:
+      // Returns the operation with a live reference or NULL if it 
+      // is not in the table or it is already being collected
+      IndexSpaceExpression* find_operation(
+          const std::vector<IndexSpaceExpression*> &expressions);
+      // A capacity of zero means the table is unbounded
+      IndexSpaceExpression* find_or_create_operation(
+          const std::vector<IndexSpaceExpression*> &expressions,
+          OperationCreator &creator, size_t capacity);
+      // Only removes the entry if it still names this operation
+      void remove_operation(IndexSpaceOperation *op,
+          const std::vector<IndexSpaceExpression*> &expressions);
+      void report_statistics(const char *kind, AddressSpaceID space) const;
+    protected:
+      static uint64_t compute_hash(
+          const std::vector<IndexSpaceExpression*> &expressions);
+      static inline unsigned get_stripe_index(uint64_t hash)
+        { return ((hash * 0x9E3779B97F4A7C15ULL) >> 32) & (STRIPES - 1); }
+      void evict_entries(Stripe &stripe, size_t limit,
+                         std::vector<IndexSpaceOperation*> &victims);
+    protected:
+      Stripe stripes[STRIPES];
+      std::atomic<uint64_t> clock;
+      std::atomic<uint64_t> hits, misses, evictions;
+    };
     
     /**
      * \class RegionTreeForest
@@ -112,8 +186,9 @@ namespace Legion {
      * states of the region tree.  We use fine-grained locking on 
      * individual nodes and the node look-up tables to enable easy 
      * updates to the shape of the tree.  Each node has a lock that 
-     * protects the pointers to its child nodes.  There is a creation 
-     * lock that protects the look-up tables.  The logical and physical
+     * protects the pointers to its child nodes.  The look-up tables are
+     * sharded so that lookups rarely contend, and there is a creation
+     * lock that serializes changes to them.  The logical and physical
      * states of each of the nodes are stored using deques which can
      * be appended to without worrying about resizing so we don't 
      * require any locks for accessing state.  Each logical and physical
@@ -997,41 +1072,70 @@ namespace Legion {
     protected:
       mutable LocalLock lookup_lock;
       mutable LocalLock lookup_is_op_lock;
-      mutable LocalLock congruence_lock;
     private:
-      // The lookup lock must be held when accessing these
-      // data structures
-      std::map<IndexSpace,IndexSpaceNode*>     index_nodes;
-      std::map<IndexPartition,IndexPartNode*>  index_parts;
-      std::map<FieldSpace,FieldSpaceNode*>     field_nodes;
-      std::map<LogicalRegion,RegionNode*>     region_nodes;
-      std::map<LogicalPartition,PartitionNode*> part_nodes;
-      std::map<RegionTreeID,RegionNode*>        tree_nodes;
+      struct HandleHasher {
+      public:
+        inline uint64_t operator()(const IndexSpace &h) const
+          { return h.get_id(); }
+        inline uint64_t operator()(const IndexPartition &h) const
+          { return h.get_id(); }
+        inline uint64_t operator()(const FieldSpace &h) const
+          { return h.get_id(); }
+        inline uint64_t operator()(const LogicalRegion &h) const
+          { return (uint64_t(h.get_tree_id()) << 32) | 
+                    h.get_index_space().get_id(); }
+        inline uint64_t operator()(const LogicalPartition &h) const
+          { return (uint64_t(h.get_tree_id()) << 32) | 
+                    h.get_index_partition().get_id(); }
+        // Also covers IndexSpaceID, IndexPartitionID, and FieldSpaceID
+        inline uint64_t operator()(const RegionTreeID &id) const
+          { return id; }
+        // Congruence classes of expressions
+        inline uint64_t operator()(const std::pair<size_t,TypeTag> &k) const
+          { return (uint64_t(k.second) << 48) ^ k.first; }
+      };
+      template<typename K, typename V>
+      using LookupTable = ShardedLookupTable<K,V,HandleHasher>;
+    private:
+      // Lookups only need the lock on the shard of the table for their
+      // handle; the lookup lock must also be held when adding or removing
+      // nodes and it orders those changes with the request maps below
+      // Each RegionNode's initialized event is protected by the shard of
+      // region_nodes for its handle
+      LookupTable<IndexSpace,IndexSpaceNode*>     index_nodes;
+      LookupTable<IndexPartition,IndexPartNode*>  index_parts;
+      LookupTable<FieldSpace,FieldSpaceNode*>     field_nodes;
+      LookupTable<LogicalRegion,RegionNode*>      region_nodes;
+      LookupTable<LogicalPartition,PartitionNode*> part_nodes;
+      LookupTable<RegionTreeID,RegionNode*>       tree_nodes;
     private:
       // pending events for requested nodes
+      // The lookup lock must be held when accessing these
       std::map<IndexSpace,RtEvent>       index_space_requests;
       std::map<IndexPartition,RtEvent>    index_part_requests;
       std::map<FieldSpace,RtEvent>       field_space_requests;
       std::map<RegionTreeID,RtEvent>     region_tree_requests;
     private:
-      std::map<IndexSpaceID,RtUserEvent> pending_index_spaces;
-      std::map<IndexPartitionID,RtUserEvent> pending_partitions;
-      std::map<FieldSpaceID,RtUserEvent> pending_field_spaces;
-      std::map<RegionTreeID,RtUserEvent> pending_region_trees;
+      LookupTable<IndexSpaceID,RtUserEvent> pending_index_spaces;
+      LookupTable<IndexPartitionID,RtUserEvent> pending_partitions;
+      LookupTable<FieldSpaceID,RtUserEvent> pending_field_spaces;
+      LookupTable<RegionTreeID,RtUserEvent> pending_region_trees;
     private:
       // Index space operations
-      std::map<IndexSpaceExprID/*first*/,ExpressionTrieNode*> union_ops;
-      std::map<IndexSpaceExprID/*first*/,ExpressionTrieNode*> intersection_ops;
-      std::map<IndexSpaceExprID/*lhs*/,ExpressionTrieNode*> difference_ops;
-      // Remote expressions
+      ExpressionCache union_ops;
+      ExpressionCache intersection_ops;
+      ExpressionCache difference_ops;
+      // Remote expressions are protected by the lookup_is_op_lock
       std::map<IndexSpaceExprID,IndexSpaceExpression*> remote_expressions;
       std::map<IndexSpaceExprID,RtEvent> pending_remote_expressions;
     private:
       // In order for the symbolic analysis to work, we need to know that
       // we don't have multiple symbols for congruent expressions. This data
       // structure is used to find congruent expressions where they exist
-      std::map<std::pair<size_t,TypeTag>,
-               std::set<IndexSpaceExpression*> > canonical_expressions;
+      // The shard lock for a congruence class must be held while testing
+      // or updating the set of expressions in it
+      LookupTable<std::pair<size_t,TypeTag>,
+                  std::set<IndexSpaceExpression*> > canonical_expressions;
     public:
       static const unsigned MAX_EXPRESSION_FANOUT = 32;
     };
@@ -1347,6 +1451,10 @@ namespace Legion {
       virtual ApEvent get_expr_index_space(void *result, TypeTag tag, 
                                            bool need_tight_result) = 0;
       virtual Domain get_domain(ApEvent &ready, bool need_tight) = 0; 
+      // Type-erased Realm index space for lowering copies and fills
+      // into other Realm constructs such as subgraphs
+      virtual ApEvent get_generic_index_space(Realm::IndexSpaceGeneric &space,
+                                              bool need_tight) = 0;
       virtual void tighten_index_space(void) = 0;
       virtual bool check_empty(void) = 0;
       virtual size_t get_volume(void) = 0;
@@ -1604,6 +1712,8 @@ namespace Legion {
       virtual ApEvent get_expr_index_space(void *result, TypeTag tag, 
                                            bool need_tight_result) = 0;
       virtual Domain get_domain(ApEvent &ready, bool need_tight) = 0;
+      virtual ApEvent get_generic_index_space(Realm::IndexSpaceGeneric &space,
+                                              bool need_tight) = 0;
       virtual void tighten_index_space(void) = 0;
       virtual bool check_empty(void) = 0;
       virtual size_t get_volume(void) = 0;
@@ -1631,6 +1741,10 @@ namespace Legion {
                                                  unsigned count = 1);
       virtual bool remove_tree_expression_reference(DistributedID source,
                                                     unsigned count = 1);
+    public:
+      // True if the only thing holding this operation is the reference
+      // from the expression cache that it was created in
+      bool is_only_cache_referenced(void);
     public:
       virtual bool invalidate_operation(void) = 0;
       virtual void remove_operation(void) = 0;
@@ -1658,6 +1772,8 @@ namespace Legion {
       virtual ApEvent get_expr_index_space(void *result, TypeTag tag,
                                            bool need_tight_result);
       virtual Domain get_domain(ApEvent &ready, bool need_tight);
+      virtual ApEvent get_generic_index_space(Realm::IndexSpaceGeneric &space,
+                                              bool need_tight);
       virtual void tighten_index_space(void);
       virtual bool check_empty(void);
       virtual size_t get_volume(void);
@@ -1920,40 +2036,6 @@ namespace Legion {
       IndexSpaceOperation *operation;
     };
 
-    /**
-     * \class ExpressionTrieNode
-     * This is a class for constructing a trie for index space
-     * expressions so we can quickly detect commmon subexpression
-     * in O(log N)^M time where N is the number of expressions
-     * in total and M is the number of expression in the operation
-     */
-    class ExpressionTrieNode {
-    public:
-      ExpressionTrieNode(unsigned depth, IndexSpaceExprID expr_id, 
-                         IndexSpaceExpression *op = NULL);
-      ExpressionTrieNode(const ExpressionTrieNode &rhs);
-      ~ExpressionTrieNode(void);
-    public:
-      ExpressionTrieNode& operator=(const ExpressionTrieNode &rhs);
-    public:
-      bool find_operation(
-          const std::vector<IndexSpaceExpression*> &expressions,
-          IndexSpaceExpression *&result, ExpressionTrieNode *&last);
-      IndexSpaceExpression* find_or_create_operation( 
-          const std::vector<IndexSpaceExpression*> &expressions,
-          OperationCreator &creator);
-      bool remove_operation(const std::vector<IndexSpaceExpression*> &exprs);
-    public:
-      const unsigned depth;
-      const IndexSpaceExprID expr;
-    protected:
-      IndexSpaceExpression *local_operation;
-      std::map<IndexSpaceExprID,IndexSpaceExpression*> operations;
-      std::map<IndexSpaceExprID,ExpressionTrieNode*> nodes;
-    protected:
-      mutable LocalLock trie_lock;
-    };
-
     /**
      * \class IndexTreeNode
      * The abstract base class for nodes in the index space trees.
@@ -2157,6 +2239,8 @@ namespace Legion {
       virtual ApEvent get_expr_index_space(void *result, TypeTag tag,
                                            bool need_tight_result) = 0;
       virtual Domain get_domain(ApEvent &ready, bool need_tight) = 0;
+      virtual ApEvent get_generic_index_space(Realm::IndexSpaceGeneric &space,
+                                              bool need_tight) = 0;
       virtual bool set_domain(const Domain &domain, AddressSpaceID space,
                               const CollectiveMapping *mapping = NULL) = 0;
       virtual bool set_output_union(
@@ -2340,6 +2424,7 @@ namespace Legion {
 				   const std::vector<Realm::FieldID> &field_ids,
                                    const std::vector<size_t> &field_sizes,
                                    legion_file_mode_t file_mode,
+                                   bool mmap_file,
                                    ApEvent &ready_event) = 0;
       virtual PhysicalInstance create_hdf5_instance(const char *file_name,
                                    const std::vector<Realm::FieldID> &field_ids,
@@ -2410,6 +2495,8 @@ namespace Legion {
       virtual ApEvent get_expr_index_space(void *result, TypeTag tag,
                                            bool need_tight_result);
       virtual Domain get_domain(ApEvent &ready, bool need_tight);
+      virtual ApEvent get_generic_index_space(Realm::IndexSpaceGeneric &space,
+                                              bool need_tight);
       virtual bool set_domain(const Domain &domain, AddressSpaceID space,
                               const CollectiveMapping *mapping = NULL);
       virtual bool set_output_union(
@@ -2620,6 +2707,7 @@ namespace Legion {
                                    const std::vector<Realm::FieldID> &field_ids,
                                    const std::vector<size_t> &field_sizes,
                                    legion_file_mode_t file_mode, 
+                                   bool mmap_file,
                                    ApEvent &ready_event);
       virtual PhysicalInstance create_hdf5_instance(const char *file_name,
                                    const std::vector<Realm::FieldID> &field_ids,
@@ -3256,31 +3344,142 @@ namespace Legion {
     }; 
 
     /**
-     * \class KDNode
-     * A KDNode is used for performing fast interference tests for
+     * \class KDTreeBuilder
+     * An interface for building part of a kd-tree in a meta-task so
+     * that the subtrees of large kd-trees can be constructed in parallel
+     */
+    class KDTreeBuilder {
+    public:
+      struct BuildKDTreeArgs : public LgTaskArgs<BuildKDTreeArgs> {
+      public:
+        static const LgTaskID TASK_ID = LG_BUILD_KD_TREE_TASK_ID;
+      public:
+        BuildKDTreeArgs(KDTreeBuilder *b)
+          : LgTaskArgs<BuildKDTreeArgs>(implicit_provenance), builder(b) { }
+      public:
+        KDTreeBuilder *const builder;
+      };
+    public:
+      virtual ~KDTreeBuilder(void) { }
+      virtual void build(void) = 0;
+    public:
+      static void handle_build(const void *args);
+    };
+
+    /**
+     * \class FlatKDTree
+     * A FlatKDTree is used for performing fast interference tests for
      * expressions against rectangles from child subregions in a partition.
+     * The whole tree lives in a few arrays: nodes are stored in depth-first
+     * order and the rectangles of the leaves are stored as a structure of
+     * arrays so that several of them can be tested against a query at once.
+     * Subtrees with many rectangles are built in parallel by meta-tasks.
      */
     template<int DIM, typename T, typename RT>
-    class KDNode {
+    class FlatKDTree {
     public:
-      KDNode(const Rect<DIM,T> &bounds,
-             std::vector<std::pair<Rect<DIM,T>,RT> > &subrects);
-      KDNode(const KDNode &rhs) = delete;
-      ~KDNode(void);
+      // Don't bother building subtrees in parallel with fewer rectangles
+      static const size_t PARALLEL_BUILD_RECTS = 8192;
     public:
-      KDNode& operator=(const KDNode &rhs) = delete;
+      struct Node {
+      public:
+        Rect<DIM,T> bounds;
+        // Leaves have right == 0 and own the rectangles in the range
+        // [first, first+count), otherwise the left child is the next 
+        // node in the array and right is the index of the right child
+        unsigned right;
+        unsigned first, count;
+      };
+      struct Arrays {
+      public:
+        void append(const Arrays &rhs);
+      public:
+        std::vector<Node> nodes;
+        std::vector<T> lo[DIM], hi[DIM];
+        std::vector<RT> values;
+      };
+      class SubtreeBuilder : public KDTreeBuilder {
+      public:
+        SubtreeBuilder(Runtime *runtime, const Rect<DIM,T> &bounds,
+                       std::vector<std::pair<Rect<DIM,T>,RT> > &subrects);
+      public:
+        virtual void build(void);
+      public:
+        Runtime *const runtime;
+        const Rect<DIM,T> bounds;
+        std::vector<std::pair<Rect<DIM,T>,RT> > subrects;
+        Arrays result;
+      };
+    public:
+      // Runtime can be NULL in which case the tree is built serially
+      FlatKDTree(Runtime *runtime, const Rect<DIM,T> &bounds,
+                 std::vector<std::pair<Rect<DIM,T>,RT> > &subrects);
+      FlatKDTree(const FlatKDTree &rhs) = delete;
     public:
+      FlatKDTree& operator=(const FlatKDTree &rhs) = delete;
+    public:
+      // Values of all the rectangles overlapping any of the tests are
+      // appended to interfering in sorted order without duplicates
       void find_interfering(const Rect<DIM,T> &test,
-                            std::set<RT> &interfering) const;
+                            std::vector<RT> &interfering) const;
+      void find_interfering(const std::vector<Rect<DIM,T> > &tests,
+                            std::vector<RT> &interfering) const;
+      size_t count_rectangles(void) const { return tree.values.size(); }
+    protected:
+      static void build_subtree(Runtime *runtime, const Rect<DIM,T> &bounds,
+                  std::vector<std::pair<Rect<DIM,T>,RT> > &subrects,
+                  Arrays &result);
+      static bool find_split(const Rect<DIM,T> &bounds,
+                  const std::vector<std::pair<Rect<DIM,T>,RT> > &subrects,
+                  Rect<DIM,T> &left_bounds, Rect<DIM,T> &right_bounds);
+      void traverse(unsigned index, const Rect<DIM,T> &test,
+                    std::vector<RT> &interfering) const;
+      void traverse(unsigned index, const std::vector<Rect<DIM,T> > &tests,
+                    std::vector<unsigned> &active, size_t first, size_t last,
+                    std::vector<RT> &interfering) const;
+      void test_leaf(const Node &leaf, const Rect<DIM,T> &test,
+                     std::vector<RT> &interfering) const;
     public:
       const Rect<DIM,T> bounds;
     protected:
-      KDNode<DIM,T,RT> *left;
-      KDNode<DIM,T,RT> *right;
-      std::vector<std::pair<Rect<DIM,T>,RT> > rects;
+      Arrays tree;
+    };
+
+    /**
+     * \class KDBoxTest
+     * Test up to 64 rectangles stored as a structure of arrays for 
+     * overlap with a query rectangle returning a mask of the overlaps.
+     * There are specializations for common coordinate types that
+     * test several rectangles at once with vector instructions.
+     */
+    template<int DIM, typename T>
+    struct KDBoxTest {
+      static inline uint64_t test(const T *const *lo, const T *const *hi,
+                                  unsigned count, const Rect<DIM,T> &rect);
     };
+
+#ifdef __SSE2__
+    template<int DIM>
+    struct KDBoxTest<DIM,int> {
+      static inline uint64_t test(const int *const *lo, const int *const *hi,
+                                  unsigned count, const Rect<DIM,int> &rect);
+    };
+#endif
+
+#ifdef __AVX2__
+    template<int DIM>
+    struct KDBoxTest<DIM,long long> {
+      static inline uint64_t test(const long long *const *lo,
+                                  const long long *const *hi, unsigned count,
+                                  const Rect<DIM,long long> &rect);
+    };
+#endif
     
-    // Specialization for void case
+    /**
+     * \class KDNode
+     * A KDNode is used for computing the number of points in a sparsity
+     * map that overlap with a rectangle.
+     */
     template<int DIM, typename T>
     class KDNode<DIM,T,void> : public KDTree {
     public:
@@ -3336,8 +3535,8 @@ namespace Legion {
       virtual void pack_shard_rects(Serializer &rez, bool clear);
       virtual void unpack_shard_rects(Deserializer &derez);
     protected:
-      KDNode<DIM,T,LegionColor> *kd_root;
-      KDNode<DIM,T,AddressSpaceID> *kd_remote;
+      FlatKDTree<DIM,T,LegionColor> *kd_root;
+      FlatKDTree<DIM,T,AddressSpaceID> *kd_remote;
       RtUserEvent kd_remote_ready;
     protected:
       std::vector<std::pair<Rect<DIM,T>,LegionColor> > *dense_shard_rects;
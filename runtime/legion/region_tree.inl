@@ -1104,6 +1104,18 @@ namespace Legion {
       return DomainT<DIM,T>(result);
     }
 
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T>
+    ApEvent IndexSpaceOperationT<DIM,T>::get_generic_index_space(
+                                Realm::IndexSpaceGeneric &space, bool tight)
+    //--------------------------------------------------------------------------
+    {
+      Realm::IndexSpace<DIM,T> result;
+      const ApEvent ready = get_realm_index_space(result, tight);
+      space = result;
+      return ready;
+    }
+
     //--------------------------------------------------------------------------
     template<int DIM, typename T>
     ApEvent IndexSpaceOperationT<DIM,T>::get_realm_index_space(
@@ -2336,6 +2348,18 @@ namespace Legion {
       return DomainT<DIM,T>(result);
     }
 
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T>
+    ApEvent IndexSpaceNodeT<DIM,T>::get_generic_index_space(
+                                Realm::IndexSpaceGeneric &space, bool need_tight)
+    //--------------------------------------------------------------------------
+    {
+      Realm::IndexSpace<DIM,T> result;
+      const ApEvent ready = get_realm_index_space(result, need_tight);
+      space = result;
+      return ready;
+    }
+
     //--------------------------------------------------------------------------
     template<int DIM, typename T>
     bool IndexSpaceNodeT<DIM,T>::set_domain(const Domain &domain, 
@@ -5640,6 +5664,7 @@ namespace Legion {
                                          const std::vector<Realm::FieldID> &field_ids,
                                          const std::vector<size_t> &field_sizes,
                                          legion_file_mode_t file_mode,
+                                         bool mmap_file,
                                          ApEvent &ready_event)
     //--------------------------------------------------------------------------
     {
@@ -5656,11 +5681,17 @@ namespace Legion {
 							       ilc, dim_order);
 
       Realm::ExternalFileResource res(file_name, file_mode);
+      // Mapped files go straight into a CPU-visible memory
+      const Memory memory = mmap_file ? 
+        res.suggested_mapped_memory() : res.suggested_memory();
+#ifdef DEBUG_LEGION
+      assert(memory.exists());
+#endif
       // No profiling for these kinds of instances currently
       Realm::ProfilingRequestSet requests;
       PhysicalInstance result;
       ready_event = ApEvent(PhysicalInstance::create_external_instance(result, 
-          res.suggested_memory(), ilg, res, requests));
+          memory, ilg, res, requests));
       return result;
     }
 
@@ -6076,138 +6107,210 @@ namespace Legion {
 
     //--------------------------------------------------------------------------
     template<int DIM, typename T, typename RT>
-    KDNode<DIM,T,RT>::KDNode(const Rect<DIM,T> &b,
+    void FlatKDTree<DIM,T,RT>::Arrays::append(const Arrays &rhs)
+    //--------------------------------------------------------------------------
+    {
+      const unsigned node_offset = nodes.size();
+      const unsigned rect_offset = values.size();
+      nodes.insert(nodes.end(), rhs.nodes.begin(), rhs.nodes.end());
+      for (unsigned idx = node_offset; idx < nodes.size(); idx++)
+      {
+        if (nodes[idx].right == 0)
+          nodes[idx].first += rect_offset;
+        else
+          nodes[idx].right += node_offset;
+      }
+      for (int d = 0; d < DIM; d++)
+      {
+        lo[d].insert(lo[d].end(), rhs.lo[d].begin(), rhs.lo[d].end());
+        hi[d].insert(hi[d].end(), rhs.hi[d].begin(), rhs.hi[d].end());
+      }
+      values.insert(values.end(), rhs.values.begin(), rhs.values.end());
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T, typename RT>
+    FlatKDTree<DIM,T,RT>::SubtreeBuilder::SubtreeBuilder(Runtime *rt,
+        const Rect<DIM,T> &b, std::vector<std::pair<Rect<DIM,T>,RT> > &rects)
+      : runtime(rt), bounds(b)
+    //--------------------------------------------------------------------------
+    {
+      subrects.swap(rects);
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T, typename RT>
+    void FlatKDTree<DIM,T,RT>::SubtreeBuilder::build(void)
+    //--------------------------------------------------------------------------
+    {
+      FlatKDTree<DIM,T,RT>::build_subtree(runtime, bounds, subrects, result);
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T, typename RT>
+    FlatKDTree<DIM,T,RT>::FlatKDTree(Runtime *runtime, const Rect<DIM,T> &b,
                              std::vector<std::pair<Rect<DIM,T>,RT> > &subrects)
-      : bounds(b), left(NULL), right(NULL)
+      : bounds(b)
     //--------------------------------------------------------------------------
     {
+      // Make sure all the rectangles are contained in the bounds since
+      // the splitting and the leaf tests both depend on it
+      unsigned valid = 0;
+      for (unsigned idx = 0; idx < subrects.size(); idx++)
+      {
+        const Rect<DIM,T> rect = subrects[idx].first.intersection(bounds);
+        if (rect.empty())
+          continue;
+        subrects[valid].first = rect;
+        subrects[valid].second = subrects[idx].second;
+        valid++;
+      }
+      subrects.resize(valid);
+      build_subtree(runtime, bounds, subrects, tree);
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T, typename RT>
+    /*static*/ void FlatKDTree<DIM,T,RT>::build_subtree(Runtime *runtime,
+          const Rect<DIM,T> &bounds,
+          std::vector<std::pair<Rect<DIM,T>,RT> > &subrects, Arrays &result)
+    //--------------------------------------------------------------------------
+    {
+      const unsigned index = result.nodes.size();
+      result.nodes.resize(index + 1);
+      result.nodes[index].bounds = bounds;
+      result.nodes[index].right = 0;
+      result.nodes[index].first = 0;
+      result.nodes[index].count = 0;
+      Rect<DIM,T> left_bounds, right_bounds;
       // This is the base case
-      if (subrects.size() <= LEGION_MAX_BVH_FANOUT)
+      if ((subrects.size() <= LEGION_MAX_BVH_FANOUT) ||
+          !find_split(bounds, subrects, left_bounds, right_bounds))
       {
-        rects.swap(subrects);
+        Node &leaf = result.nodes[index];
+        leaf.first = result.values.size();
+        leaf.count = subrects.size();
+        for (typename std::vector<std::pair<Rect<DIM,T>,RT> >::const_iterator
+              it = subrects.begin(); it != subrects.end(); it++)
+        {
+          for (int d = 0; d < DIM; d++)
+          {
+            result.lo[d].push_back(it->first.lo[d]);
+            result.hi[d].push_back(it->first.hi[d]);
+          }
+          result.values.push_back(it->second);
+        }
         return;
       }
+      // Sort the subsets into left and right
+      std::vector<std::pair<Rect<DIM,T>,RT> > left_set, right_set;
+      for (typename std::vector<std::pair<Rect<DIM,T>,RT> >::const_iterator
+            it = subrects.begin(); it != subrects.end(); it++)
+      {
+        const Rect<DIM,T> left_rect = it->first.intersection(left_bounds);
+        if (!left_rect.empty())
+          left_set.push_back(std::make_pair(left_rect, it->second));
+        const Rect<DIM,T> right_rect = it->first.intersection(right_bounds);
+        if (!right_rect.empty())
+          right_set.push_back(std::make_pair(right_rect, it->second));
+      }
+      // Always clear the old-subrects before recursing to reduce memory usage
+      {
+        std::vector<std::pair<Rect<DIM,T>,RT> > empty;
+        empty.swap(subrects);
+      }
+      if ((runtime != NULL) && 
+          (left_set.size() >= PARALLEL_BUILD_RECTS) &&
+          (right_set.size() >= PARALLEL_BUILD_RECTS))
+      {
+        // Build the left subtree in a meta-task while we do the right one
+        SubtreeBuilder left_builder(runtime, left_bounds, left_set);
+        KDTreeBuilder::BuildKDTreeArgs args(&left_builder);
+        const RtEvent left_done = 
+          runtime->issue_runtime_meta_task(args, LG_THROUGHPUT_WORK_PRIORITY);
+        Arrays right_result;
+        build_subtree(runtime, right_bounds, right_set, right_result);
+        if (!left_done.has_triggered())
+          left_done.wait();
+        result.append(left_builder.result);
+        result.nodes[index].right = result.nodes.size();
+        result.append(right_result);
+      }
+      else
+      {
+        build_subtree(runtime, left_bounds, left_set, result);
+        result.nodes[index].right = result.nodes.size();
+        build_subtree(runtime, right_bounds, right_set, result);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T, typename RT>
+    /*static*/ bool FlatKDTree<DIM,T,RT>::find_split(const Rect<DIM,T> &bounds,
+                  const std::vector<std::pair<Rect<DIM,T>,RT> > &subrects,
+                  Rect<DIM,T> &left_bounds, Rect<DIM,T> &right_bounds)
+    //--------------------------------------------------------------------------
+    {
       // If we have sub-optimal bad sets we will track them here
       // so we can iterate through other dimensions to look for
       // better splitting planes
       int best_dim = -1;
       float best_cost = 2.f; // worst possible cost
-      Rect<DIM,T> best_left_bounds, best_right_bounds;
-      std::vector<std::pair<Rect<DIM,T>,RT> > best_left_set, best_right_set;
+      const size_t total = subrects.size();
+      std::vector<T> starts(total), stops(total);
       for (int d = 0; d < DIM; d++)
       {
-        // Try to compute a splitting plane for this dimension
-        // Count how many rectangles start and end at each location
-        std::map<std::pair<coord_t,bool/*stop*/>,unsigned> forward_lines;
-        std::map<std::pair<coord_t,bool/*start*/>,unsigned> backward_lines;
-        for (unsigned idx = 0; idx < subrects.size(); idx++)
-        {
-          const Rect<DIM,T> &subset_bounds = subrects[idx].first;
-          // Start forward
-          std::pair<coord_t,bool> start_key(subset_bounds.lo[d],false);
-          std::map<std::pair<coord_t,bool>,unsigned>::iterator finder =
-            forward_lines.find(start_key);
-          if (finder == forward_lines.end())
-            forward_lines[start_key] = 1;
-          else
-            finder->second++;
-          // Start backward 
-          start_key.second = true;
-          finder = backward_lines.find(start_key);
-          if (finder == backward_lines.end())
-            backward_lines[start_key] = 1;
-          else
-            finder->second++;
-          // Stop forward
-          std::pair<coord_t,bool> stop_key(subset_bounds.hi[d],true);
-          finder = forward_lines.find(stop_key);
-          if (finder == forward_lines.end())
-            forward_lines[stop_key] = 1;
-          else
-            finder->second += 1;
-          // Stop backward 
-          stop_key.second = false;
-          finder = backward_lines.find(stop_key);
-          if (finder == backward_lines.end())
-            backward_lines[stop_key] = 1;
-          else
-            finder->second++;
-        }
-        // Construct two lists by scanning from left-to-right and
-        // from right-to-left of the number of rectangles that would
-        // be inlcuded on the left or right side by each splitting plane
-        std::map<coord_t,unsigned> lower_inclusive, upper_exclusive;
-        unsigned count = 0;
-        for (typename std::map<std::pair<coord_t,bool>,unsigned>::const_iterator
-              it = forward_lines.begin(); it != forward_lines.end(); it++)
-        {
-          // Increment first for starts for inclusivity
-          if (!it->first.second)
-            count += it->second;
-          // Always record the count for all splits
-          lower_inclusive[it->first.first] = count;
-        }
-        // If all the lines exist at the same value
-        // then we'll never have a splitting plane
-        if (lower_inclusive.size() == 1)
-          continue;
-        count = 0;
-        for (typename std::map<
-              std::pair<coord_t,bool>,unsigned>::const_reverse_iterator it = 
-              backward_lines.rbegin(); it != backward_lines.rend(); it++)
+        // Sort the start and stop coordinates of the rectangles so we can
+        // sweep over every candidate splitting plane in order, counting the
+        // rectangles that start at or before it (which will be on the left)
+        // and the ones that stop after it (which will be on the right)
+        for (unsigned idx = 0; idx < total; idx++)
         {
-          // Always record the count for all splits
-          upper_exclusive[it->first.first] = count;
-          // Increment last for stops for exclusivity
-          if (!it->first.second)
-            count += it->second;
+          starts[idx] = subrects[idx].first.lo[d];
+          stops[idx] = subrects[idx].first.hi[d];
         }
-#ifdef DEBUG_LEGION
-        assert(lower_inclusive.size() == upper_exclusive.size());
-#endif
+        std::sort(starts.begin(), starts.end());
+        std::sort(stops.begin(), stops.end());
         // We want to take the mini-max of the two numbers in order
         // to try to balance the splitting plane across the two sets
         T split = 0;
-        unsigned split_max = subrects.size();
-        for (std::map<coord_t,unsigned>::const_iterator it =
-              lower_inclusive.begin(); it != lower_inclusive.end(); it++)
-        {
-          const unsigned lower = it->second;
-          const unsigned upper = upper_exclusive[it->first];
-          const unsigned max = (lower > upper) ? lower : upper;
+        size_t split_max = total;
+        size_t lower = 0, stopped = 0, planes = 0;
+        while ((lower < total) || (stopped < total))
+        {
+          const T plane = (lower == total) ? stops[stopped] :
+            (stopped == total) ? starts[lower] :
+            std::min(starts[lower], stops[stopped]);
+          while ((lower < total) && (starts[lower] <= plane))
+            lower++;
+          while ((stopped < total) && (stops[stopped] <= plane))
+            stopped++;
+          planes++;
+          const size_t upper = total - stopped;
+          const size_t max = (lower > upper) ? lower : upper;
           if (max < split_max)
           {
             split_max = max;
-            split = it->first;
+            split = plane;
           }
         }
-        // Check for the case where we can't find a splitting plane
-        if (split_max == subrects.size())
+        // If all the lines exist at the same value
+        // then we'll never have a splitting plane
+        // Also check for the case where we can't find a splitting plane
+        if ((planes == 1) || (split_max == total))
           continue;
-        // Sort the subsets into left and right
-        Rect<DIM,T> left_bounds(bounds);
-        Rect<DIM,T> right_bounds(bounds);
-        left_bounds.hi[d] = split;
-        right_bounds.lo[d] = split+1;
-        std::vector<std::pair<Rect<DIM,T>,RT> > left_set, right_set;
-        for (typename std::vector<std::pair<Rect<DIM,T>,RT> >::const_iterator
-              it = subrects.begin(); it != subrects.end(); it++)
-        {
-          const Rect<DIM,T> left_rect = it->first.intersection(left_bounds);
-          if (!left_rect.empty())
-            left_set.push_back(std::make_pair(left_rect, it->second));
-          const Rect<DIM,T> right_rect = it->first.intersection(right_bounds);
-          if (!right_rect.empty())
-            right_set.push_back(std::make_pair(right_rect, it->second));
-        }
-#ifdef DEBUG_LEGION
-        assert(left_set.size() < subrects.size());
-        assert(right_set.size() < subrects.size());
-#endif
         // Compute the cost of this refinement
         // First get the percentage reductions of both sets
-        float cost_left = float(left_set.size()) / float(subrects.size());
-        float cost_right = float(right_set.size()) / float(subrects.size());
+        const size_t left_count = std::upper_bound(starts.begin(), 
+                                    starts.end(), split) - starts.begin();
+        const size_t right_count = stops.end() - 
+                  std::upper_bound(stops.begin(), stops.end(), split);
+#ifdef DEBUG_LEGION
+        assert(left_count < total);
+        assert(right_count < total);
+#endif
+        float cost_left = float(left_count) / float(total);
+        float cost_right = float(right_count) / float(total);
         // We want to give better scores to sets that are closer together
         // so we'll include the absolute value of the difference in the
         // two costs as part of computing the average cost
@@ -6227,62 +6330,249 @@ namespace Legion {
         {
           best_dim = d;
           best_cost = total_cost;
-          best_left_set.swap(left_set);
-          best_right_set.swap(right_set);
-          best_left_bounds = left_bounds;
-          best_right_bounds = right_bounds;
-        }
-      }
-      // See if we had at least one good refinement
-      if (best_dim >= 0)
-      {
-        // Always clear the old-subrects before recursing to reduce memory usage
-        {
-          std::vector<std::pair<Rect<DIM,T>,RT> > empty;
-          empty.swap(subrects);
+          left_bounds = bounds;
+          right_bounds = bounds;
+          left_bounds.hi[d] = split;
+          right_bounds.lo[d] = split+1;
         }
-        left = new KDNode<DIM,T,RT>(best_left_bounds, best_left_set); 
-        right = new KDNode<DIM,T,RT>(best_right_bounds, best_right_set);
       }
-      else
+      if (best_dim < 0)
       {
         REPORT_LEGION_WARNING(LEGION_WARNING_KDTREE_REFINEMENT_FAILED,
             "Failed to find a refinement for KD tree with %d dimensions "
             "and %zd rectangles. Please report your application to the "
             "Legion developers' mailing list.", DIM, subrects.size())
-        // If we make it here then we couldn't find a splitting plane to refine
-        // anymore so just record all the subrects as our rects
-        rects.swap(subrects);
+        return false;
       }
+      return true;
     }
 
     //--------------------------------------------------------------------------
     template<int DIM, typename T, typename RT>
-    KDNode<DIM,T,RT>::~KDNode(void)
+    void FlatKDTree<DIM,T,RT>::find_interfering(const Rect<DIM,T> &test,
+                                          std::vector<RT> &interfering) const
     //--------------------------------------------------------------------------
     {
-      if (left != NULL)
-        delete left;
-      if (right != NULL)
-        delete right;
+      if (!test.overlaps(bounds))
+        return;
+      const size_t offset = interfering.size();
+      traverse(0/*root*/, test, interfering);
+      std::sort(interfering.begin() + offset, interfering.end());
+      interfering.erase(std::unique(interfering.begin() + offset,
+            interfering.end()), interfering.end());
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T, typename RT>
+    void FlatKDTree<DIM,T,RT>::find_interfering(
+                                   const std::vector<Rect<DIM,T> > &tests,
+                                   std::vector<RT> &interfering) const
+    //--------------------------------------------------------------------------
+    {
+      // All the tests traverse the tree together so each node is only
+      // visited once for the whole batch of tests overlapping it
+      // The active tests for each level of the traversal are kept
+      // on a stack at the end of this vector
+      std::vector<unsigned> active;
+      active.reserve(2 * tests.size());
+      for (unsigned idx = 0; idx < tests.size(); idx++)
+        if (tests[idx].overlaps(bounds))
+          active.push_back(idx);
+      if (active.empty())
+        return;
+      const size_t offset = interfering.size();
+      traverse(0/*root*/, tests, active, 0/*first*/, active.size(), 
+               interfering);
+      std::sort(interfering.begin() + offset, interfering.end());
+      interfering.erase(std::unique(interfering.begin() + offset,
+            interfering.end()), interfering.end());
     }
 
     //--------------------------------------------------------------------------
     template<int DIM, typename T, typename RT>
-    void KDNode<DIM,T,RT>::find_interfering(const Rect<DIM,T> &test,
-                                            std::set<RT> &interfering) const
+    void FlatKDTree<DIM,T,RT>::traverse(unsigned index,
+                  const Rect<DIM,T> &test, std::vector<RT> &interfering) const
     //--------------------------------------------------------------------------
     {
-      if ((left != NULL) && left->bounds.overlaps(test))
-        left->find_interfering(test, interfering);
-      if ((right != NULL) && right->bounds.overlaps(test))
-        right->find_interfering(test, interfering);
-      for (typename std::vector<std::pair<Rect<DIM,T>,RT> >::
-            const_iterator it = rects.begin(); it != rects.end(); it++)
-        if (it->first.overlaps(test))
-          interfering.insert(it->second);
+      const Node &node = tree.nodes[index];
+      if (node.right == 0)
+      {
+        test_leaf(node, test, interfering);
+        return;
+      }
+      if (tree.nodes[index+1].bounds.overlaps(test))
+        traverse(index+1, test, interfering);
+      if (tree.nodes[node.right].bounds.overlaps(test))
+        traverse(node.right, test, interfering);
     }
 
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T, typename RT>
+    void FlatKDTree<DIM,T,RT>::traverse(unsigned index,
+                                    const std::vector<Rect<DIM,T> > &tests,
+                                    std::vector<unsigned> &active,
+                                    size_t first, size_t last,
+                                    std::vector<RT> &interfering) const
+    //--------------------------------------------------------------------------
+    {
+      const Node &node = tree.nodes[index];
+      if (node.right == 0)
+      {
+        for (size_t idx = first; idx < last; idx++)
+          test_leaf(node, tests[active[idx]], interfering);
+        return;
+      }
+      const unsigned children[2] = { index + 1, node.right };
+      for (unsigned child = 0; child < 2; child++)
+      {
+        const Rect<DIM,T> &child_bounds = tree.nodes[children[child]].bounds;
+        const size_t subset = active.size();
+        for (size_t idx = first; idx < last; idx++)
+          if (tests[active[idx]].overlaps(child_bounds))
+            active.push_back(active[idx]);
+        if (subset < active.size())
+          traverse(children[child], tests, active, subset, active.size(),
+                   interfering);
+        active.resize(subset);
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T, typename RT>
+    void FlatKDTree<DIM,T,RT>::test_leaf(const Node &leaf,
+                const Rect<DIM,T> &test, std::vector<RT> &interfering) const
+    //--------------------------------------------------------------------------
+    {
+      // Every rectangle in the leaf is inside the node bounds so
+      // if the test contains them then they all interfere
+      if (test.contains(leaf.bounds))
+      {
+        interfering.insert(interfering.end(), 
+            tree.values.begin() + leaf.first,
+            tree.values.begin() + leaf.first + leaf.count);
+        return;
+      }
+      for (unsigned offset = 0; offset < leaf.count; offset += 64)
+      {
+        const unsigned first = leaf.first + offset;
+        const unsigned count = std::min(leaf.count - offset, 64U);
+        const T *lo[DIM], *hi[DIM];
+        for (int d = 0; d < DIM; d++)
+        {
+          lo[d] = &tree.lo[d][first];
+          hi[d] = &tree.hi[d][first];
+        }
+        uint64_t mask = KDBoxTest<DIM,T>::test(lo, hi, count, test);
+        while (mask != 0)
+        {
+          interfering.push_back(tree.values[first + __builtin_ctzll(mask)]);
+          mask &= (mask - 1);
+        }
+      }
+    }
+
+    //--------------------------------------------------------------------------
+    template<int DIM, typename T>
+    /*static*/ inline uint64_t KDBoxTest<DIM,T>::test(const T *const *lo,
+                 const T *const *hi, unsigned count, const Rect<DIM,T> &rect)
+    //--------------------------------------------------------------------------
+    {
+      uint64_t mask = 0;
+      for (unsigned idx = 0; idx < count; idx++)
+      {
+        bool overlaps = true;
+        for (int d = 0; d < DIM; d++)
+          overlaps = overlaps && 
+            (lo[d][idx] <= rect.hi[d]) && (rect.lo[d] <= hi[d][idx]);
+        if (overlaps)
+          mask |= (uint64_t(1) << idx);
+      }
+      return mask;
+    }
+
+#ifdef __SSE2__
+    //--------------------------------------------------------------------------
+    template<int DIM>
+    /*static*/ inline uint64_t KDBoxTest<DIM,int>::test(const int *const *lo,
+             const int *const *hi, unsigned count, const Rect<DIM,int> &rect)
+    //--------------------------------------------------------------------------
+    {
+      uint64_t mask = 0;
+      unsigned idx = 0;
+      for ( ; (idx + 4) <= count; idx += 4)
+      {
+        // A rectangle misses if it starts after the test 
+        // or stops before it in any dimension
+        __m128i miss = _mm_setzero_si128();
+        for (int d = 0; d < DIM; d++)
+        {
+          const __m128i l = _mm_loadu_si128((const __m128i*)(lo[d] + idx));
+          const __m128i h = _mm_loadu_si128((const __m128i*)(hi[d] + idx));
+          miss = _mm_or_si128(miss, 
+              _mm_cmpgt_epi32(l, _mm_set1_epi32(rect.hi[d])));
+          miss = _mm_or_si128(miss,
+              _mm_cmplt_epi32(h, _mm_set1_epi32(rect.lo[d])));
+        }
+        const unsigned hits = 
+          (~_mm_movemask_ps(_mm_castsi128_ps(miss))) & 0xF;
+        mask |= (uint64_t(hits) << idx);
+      }
+      for ( ; idx < count; idx++)
+      {
+        bool overlaps = true;
+        for (int d = 0; d < DIM; d++)
+          overlaps = overlaps && 
+            (lo[d][idx] <= rect.hi[d]) && (rect.lo[d] <= hi[d][idx]);
+        if (overlaps)
+          mask |= (uint64_t(1) << idx);
+      }
+      return mask;
+    }
+#endif
+
+#ifdef __AVX2__
+    //--------------------------------------------------------------------------
+    template<int DIM>
+    /*static*/ inline uint64_t KDBoxTest<DIM,long long>::test(
+                  const long long *const *lo, const long long *const *hi,
+                  unsigned count, const Rect<DIM,long long> &rect)
+    //--------------------------------------------------------------------------
+    {
+      uint64_t mask = 0;
+      unsigned idx = 0;
+      for ( ; (idx + 4) <= count; idx += 4)
+      {
+        // A rectangle misses if it starts after the test 
+        // or stops before it in any dimension
+        __m256i miss = _mm256_setzero_si256();
+        for (int d = 0; d < DIM; d++)
+        {
+          const __m256i l = 
+            _mm256_loadu_si256((const __m256i*)(lo[d] + idx));
+          const __m256i h = 
+            _mm256_loadu_si256((const __m256i*)(hi[d] + idx));
+          miss = _mm256_or_si256(miss,
+              _mm256_cmpgt_epi64(l, _mm256_set1_epi64x(rect.hi[d])));
+          miss = _mm256_or_si256(miss,
+              _mm256_cmpgt_epi64(_mm256_set1_epi64x(rect.lo[d]), h));
+        }
+        const unsigned hits = 
+          (~_mm256_movemask_pd(_mm256_castsi256_pd(miss))) & 0xF;
+        mask |= (uint64_t(hits) << idx);
+      }
+      for ( ; idx < count; idx++)
+      {
+        bool overlaps = true;
+        for (int d = 0; d < DIM; d++)
+          overlaps = overlaps && 
+            (lo[d][idx] <= rect.hi[d]) && (rect.lo[d] <= hi[d][idx]);
+        if (overlaps)
+          mask |= (uint64_t(1) << idx);
+      }
+      return mask;
+    }
+#endif
+
     //--------------------------------------------------------------------------
     template<int DIM, typename T>
     KDNode<DIM,T,void>::KDNode(const Rect<DIM,T> &b,
@@ -7393,8 +7683,9 @@ namespace Legion {
           } 
           if (parent_ready.exists() && !parent_ready.has_triggered())
             parent_ready.wait();
-          KDNode<DIM,T,LegionColor> *root = 
-           new KDNode<DIM,T,LegionColor>(parent_space.bounds, bounds);
+          FlatKDTree<DIM,T,LegionColor> *root = 
+            new FlatKDTree<DIM,T,LegionColor>(context->runtime,
+                                    parent_space.bounds, bounds);
           AutoLock n_lock(node_lock);
           if (kd_root == NULL)
             kd_root = root;
@@ -7433,8 +7724,8 @@ namespace Legion {
               rects_ready.wait();
             // Once we get the remote rectangles we can build the kd-trees
             if (!sparse_shard_rects->empty())
-              kd_remote = new KDNode<DIM,T,AddressSpaceID>(
-                  parent_space.bounds, *sparse_shard_rects);
+              kd_remote = new FlatKDTree<DIM,T,AddressSpaceID>(
+                  context->runtime, parent_space.bounds, *sparse_shard_rects);
             // Add any local sparse paces into the dense remote rects
             // All the local dense spaces are already included
             for (unsigned idx = 0; idx < current_children.size(); idx++)
@@ -7450,8 +7741,9 @@ namespace Legion {
               for (RectInDomainIterator<DIM,T> it(space); it(); it++)
                 dense_shard_rects->push_back(std::make_pair(*it, child->color));
             }
-            KDNode<DIM,T,LegionColor> *root = new KDNode<DIM,T,LegionColor>(
-                                    parent_space.bounds, *dense_shard_rects);
+            FlatKDTree<DIM,T,LegionColor> *root =
+              new FlatKDTree<DIM,T,LegionColor>(context->runtime,
+                  parent_space.bounds, *dense_shard_rects);
             AutoLock n_lock(node_lock);
             kd_root = root;
             Runtime::trigger_event(kd_remote_ready);
@@ -7466,24 +7758,35 @@ namespace Legion {
         expr->get_expr_index_space(&space, handle.get_type_tag(),true/*tight*/);
       if (space_ready.exists() && !space_ready.has_triggered())
         space_ready.wait();
+      // Test all the rectangles of the expression in one batch
+      std::vector<Rect<DIM,T> > tests;
+      for (RectInDomainIterator<DIM,T> itr(space); itr(); itr++)
+        tests.push_back(*itr);
       // If we have a remote kd tree then we need to query that to see if 
       // we have any remote colors to include
-      std::set<LegionColor> color_set;
+      std::set<LegionColor> remote_colors;
       if ((kd_remote != NULL) && !local)
       {
-        std::set<AddressSpaceID> remote_spaces;
-        for (RectInDomainIterator<DIM,T> itr(space); itr(); itr++)
-          kd_remote->find_interfering(*itr, remote_spaces);
+        std::vector<AddressSpaceID> remote_spaces;
+        kd_remote->find_interfering(tests, remote_spaces);
         if (!remote_spaces.empty())
         {
-          RemoteKDTracker tracker(color_set, context->runtime);
-          tracker.find_remote_interfering(remote_spaces, handle, expr); 
+          const std::set<AddressSpaceID> targets(remote_spaces.begin(),
+                                                 remote_spaces.end());
+          RemoteKDTracker tracker(remote_colors, context->runtime);
+          tracker.find_remote_interfering(targets, handle, expr); 
         }
       }
-      for (RectInDomainIterator<DIM,T> itr(space); itr(); itr++)
-        kd_root->find_interfering(*itr, color_set);
-      if (!color_set.empty())
-        colors.insert(colors.end(), color_set.begin(), color_set.end());
+      if (remote_colors.empty())
+        kd_root->find_interfering(tests, colors);
+      else
+      {
+        std::vector<LegionColor> local_colors;
+        kd_root->find_interfering(tests, local_colors);
+        std::set_union(local_colors.begin(), local_colors.end(),
+            remote_colors.begin(), remote_colors.end(),
+            std::back_inserter(colors));
+      }
       return true;
     }
 
@@ -23,6 +23,7 @@
 #include "legion/region_tree.h"
 #include "legion/legion_spy.h"
 #include "legion/legion_profiling.h"
+#include "legion/legion_profiling_serializer.h"
 #include "legion/legion_instances.h"
 #include "legion/legion_views.h"
 #include "legion/legion_context.h"
@@ -12840,6 +12841,11 @@ namespace Legion {
               runtime->handle_concurrent_execution_analysis(derez);
               break;
             }
+          case SEND_PROFILER_SUMMARY:
+            {
+              runtime->handle_profiler_summary(derez);
+              break;
+            }
           case SEND_SHUTDOWN_NOTIFICATION:
             {
 #ifdef DEBUG_LEGION
@@ -16113,12 +16119,18 @@ namespace Legion {
                       config.max_control_replication_contexts),
         max_local_fields(config.max_local_fields),
         max_replay_parallelism(config.max_replay_parallelism),
+        auto_trace_min_length(config.auto_trace_min_length),
+        auto_trace_window(config.auto_trace_window),
+        expression_cache_size(config.expression_cache_size),
         safe_control_replication(config.safe_control_replication),
         program_order_execution(config.program_order_execution),
         dump_physical_traces(config.dump_physical_traces),
         no_tracing(config.no_tracing),
         no_physical_tracing(config.no_physical_tracing),
+        auto_trace(config.auto_trace),
         no_trace_optimization(config.no_trace_optimization),
+        no_compiled_replay(config.no_compiled_replay),
+        subgraph_replay(config.subgraph_replay),
         no_fence_elision(config.no_fence_elision),
         replay_on_cpus(config.replay_on_cpus),
         verify_partitions(config.verify_partitions),
@@ -16325,12 +16337,18 @@ namespace Legion {
         max_control_replication_contexts(rhs.max_control_replication_contexts),
         max_local_fields(rhs.max_local_fields),
         max_replay_parallelism(rhs.max_replay_parallelism),
+        auto_trace_min_length(rhs.auto_trace_min_length),
+        auto_trace_window(rhs.auto_trace_window),
+        expression_cache_size(rhs.expression_cache_size),
         safe_control_replication(rhs.safe_control_replication),
         program_order_execution(rhs.program_order_execution),
         dump_physical_traces(rhs.dump_physical_traces),
         no_tracing(rhs.no_tracing),
         no_physical_tracing(rhs.no_physical_tracing),
+        auto_trace(rhs.auto_trace),
         no_trace_optimization(rhs.no_trace_optimization),
+        no_compiled_replay(rhs.no_compiled_replay),
+        subgraph_replay(rhs.subgraph_replay),
         no_fence_elision(rhs.no_fence_elision),
         replay_on_cpus(rhs.replay_on_cpus),
         verify_partitions(rhs.verify_partitions),
@@ -23083,6 +23101,16 @@ namespace Legion {
                         true/*flush*/, false/*response*/, true/*shutdown*/);
     }
 
+    //--------------------------------------------------------------------------
+    void Runtime::send_profiler_summary(AddressSpaceID target, Serializer &rez)
+    //--------------------------------------------------------------------------
+    {
+      // Summaries are sent while the runtime is being finalized so they
+      // must not look like new work to the shutdown algorithm
+      find_messenger(target)->send_message<SEND_PROFILER_SUMMARY>(rez,
+                        true/*flush*/, false/*response*/, true/*shutdown*/);
+    }
+
     //--------------------------------------------------------------------------
     void Runtime::send_shutdown_response(AddressSpaceID target, Serializer &rez)
     //--------------------------------------------------------------------------
@@ -23091,6 +23119,16 @@ namespace Legion {
                         true/*flush*/, false/*response*/, true/*shutdown*/);
     }
 
+    //--------------------------------------------------------------------------
+    void Runtime::handle_profiler_summary(Deserializer &derez)
+    //--------------------------------------------------------------------------
+    {
+#ifdef DEBUG_LEGION
+      assert(profiler != NULL);
+#endif
+      profiler->handle_remote_summary(derez);
+    }
+
     //--------------------------------------------------------------------------
     void Runtime::handle_task(Deserializer &derez)
     //--------------------------------------------------------------------------
@@ -29417,8 +29455,17 @@ namespace Legion {
         .add_option_bool("-lg:no_tracing",config.no_tracing, !filter)
         .add_option_bool("-lg:no_physical_tracing",
                          config.no_physical_tracing, !filter)
+        .add_option_bool("-lg:auto_trace", config.auto_trace, !filter)
+        .add_option_int("-lg:auto_trace_min",
+                        config.auto_trace_min_length, !filter)
+        .add_option_int("-lg:auto_trace_window",
+                        config.auto_trace_window, !filter)
         .add_option_bool("-lg:no_trace_optimization",
                          config.no_trace_optimization, !filter)
+        .add_option_bool("-lg:no_compiled_replay",
+                         config.no_compiled_replay, !filter)
+        .add_option_bool("-lg:subgraph_replay",
+                         config.subgraph_replay, !filter)
         .add_option_bool("-lg:no_fence_elision",
                          config.no_fence_elision, !filter)
         .add_option_bool("-lg:replay_on_cpus",
@@ -29445,6 +29492,8 @@ namespace Legion {
         .add_option_int("-lg:message",config.max_message_size, !filter)
         .add_option_int("-lg:epoch", config.gc_epoch_size, !filter)
         .add_option_int("-lg:local", config.max_local_fields, !filter)
+        .add_option_int("-lg:expr_cache",
+                        config.expression_cache_size, !filter)
         .add_option_int("-lg:parallel_replay", 
                         config.max_replay_parallelism, !filter)
         .add_option_bool("-lg:no_dyn",config.disable_independence_tests,!filter)
@@ -31827,6 +31876,11 @@ namespace Legion {
           }
         case LG_YIELD_TASK_ID:
           break; // nothing to do here
+        case LG_BUILD_KD_TREE_TASK_ID:
+          {
+            KDTreeBuilder::handle_build(args);
+            break;
+          }
         case LG_RETRY_SHUTDOWN_TASK_ID:
           {
             const ShutdownManager::RetryShutdownArgs *shutdown_args = 
@@ -31835,6 +31889,11 @@ namespace Legion {
                                                shutdown_args->phase);
             break;
           }
+        case LG_FLUSH_PROFILER_CHUNK_TASK_ID:
+          {
+            LegionProfBinarySerializer::handle_flush_chunk(args);
+            break;
+          }
         default:
           assert(false); // should never get here
       }
@@ -2424,12 +2424,18 @@ namespace Legion {
                         LEGION_DEFAULT_MAX_CONTROL_REPLICATION_CONTEXTS),
             max_local_fields(LEGION_DEFAULT_LOCAL_FIELDS),
             max_replay_parallelism(LEGION_DEFAULT_MAX_REPLAY_PARALLELISM),
+            auto_trace_min_length(LEGION_DEFAULT_AUTO_TRACE_MIN_LENGTH),
+            auto_trace_window(LEGION_DEFAULT_AUTO_TRACE_WINDOW),
+            expression_cache_size(LEGION_DEFAULT_EXPRESSION_CACHE_SIZE),
             safe_control_replication(0),
             program_order_execution(false),
             dump_physical_traces(false),
             no_tracing(false),
             no_physical_tracing(false),
+            auto_trace(false),
             no_trace_optimization(false),
+            no_compiled_replay(false),
+            subgraph_replay(false),
             no_fence_elision(false),
             replay_on_cpus(false),
             verify_partitions(false),
@@ -2479,13 +2485,19 @@ namespace Legion {
         unsigned max_control_replication_contexts;
         unsigned max_local_fields;
         unsigned max_replay_parallelism;
+        unsigned auto_trace_min_length;
+        unsigned auto_trace_window;
+        unsigned expression_cache_size;
         unsigned safe_control_replication;
       public:
         bool program_order_execution;
         bool dump_physical_traces;
         bool no_tracing;
         bool no_physical_tracing;
+        bool auto_trace;
         bool no_trace_optimization;
+        bool no_compiled_replay;
+        bool subgraph_replay;
         bool no_fence_elision;
         bool replay_on_cpus;
         bool verify_partitions;
@@ -2616,13 +2628,19 @@ namespace Legion {
       const unsigned max_control_replication_contexts;
       const unsigned max_local_fields;
       const unsigned max_replay_parallelism;
+      const unsigned auto_trace_min_length;
+      const unsigned auto_trace_window;
+      const unsigned expression_cache_size;
       const unsigned safe_control_replication;
     public:
       const bool program_order_execution;
       const bool dump_physical_traces;
       const bool no_tracing;
       const bool no_physical_tracing;
+      const bool auto_trace;
       const bool no_trace_optimization;
+      const bool no_compiled_replay;
+      const bool subgraph_replay;
       const bool no_fence_elision;
       const bool replay_on_cpus;
       const bool verify_partitions;
@@ -3344,6 +3362,7 @@ namespace Legion {
       void send_create_future_instance_response(AddressSpaceID target,
                                                 Serializer &rez);
       void send_free_future_instance(AddressSpaceID target, Serializer &rez);
+      void send_profiler_summary(AddressSpaceID target, Serializer &rez);
       void send_shutdown_notification(AddressSpaceID target, Serializer &rez);
       void send_shutdown_response(AddressSpaceID target, Serializer &rez);
     public:
@@ -3668,6 +3687,7 @@ namespace Legion {
       void handle_concurrent_reservation_creation(Deserializer &derez,
                                                   AddressSpaceID source);
       void handle_concurrent_execution_analysis(Deserializer &derez);
+      void handle_profiler_summary(Deserializer &derez);
       void handle_shutdown_notification(Deserializer &derez, 
                                         AddressSpaceID source);
       void handle_shutdown_response(Deserializer &derez);
@@ -5836,6 +5856,8 @@ namespace Legion {
           break;
         case SEND_CONCURRENT_EXECUTION_ANALYSIS:
           break;
+        case SEND_PROFILER_SUMMARY:
+          break;
         case SEND_SHUTDOWN_NOTIFICATION:
           return THROUGHPUT_VIRTUAL_CHANNEL;
         case SEND_SHUTDOWN_RESPONSE:
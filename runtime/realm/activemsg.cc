@@ -371,6 +371,9 @@ namespace Realm {
       core_rsrv = 0;
 
     current_block = MessageBlock::new_block(cfg_message_block_size);
+
+    // message handling is on the critical path of remote operations
+    set_latency_sensitive();
   }
 
   IncomingMessageManager::~IncomingMessageManager(void)
@@ -752,7 +755,10 @@ namespace Realm {
 	  if(num < (den * t_estimate))
 	    t_estimate = num / den;
 	}
-	if(work_until.will_expire(t_estimate)) {
+	// always handle at least one message per call - a time limit that
+	//  is shorter than the estimate (e.g. the latency-sensitive slice)
+	//  would otherwise skip this message forever
+	if((num_handled > 0) && work_until.will_expire(t_estimate)) {
 	  // skip this message instead of handling it now
 	  *skipped_tail = current_msg;
 	  skipped_tail = &current_msg->next_msg;
@@ -19,6 +19,7 @@
 #include "realm/timers.h"
 #include "realm/logging.h"
 #include "realm/utils.h"
+#include "realm/sampling.h"
 #include "realm/numa/numasysif.h"
 
 static unsigned ctz(uint64_t v)
@@ -188,10 +189,13 @@ namespace Realm {
 
   BackgroundWorkManager::BackgroundWorkManager(void)
     : num_work_items(0)
+    , slot_generation(0)
     , worker_state(0)
   {
-    for(unsigned i = 0; i < BITMASK_ARRAY_SIZE; i++)
+    for(unsigned i = 0; i < BITMASK_ARRAY_SIZE; i++) {
       active_work_item_mask[i].store(0);
+      latency_work_item_mask[i].store(0);
+    }
 
     for(unsigned i = 0; i < MAX_WORK_ITEMS; i++) {
       work_item_usecounts[i].store(0);
@@ -207,14 +211,40 @@ namespace Realm {
   unsigned BackgroundWorkManager::assign_slot(BackgroundWorkItem *item)
   {
     AutoLock<> al(mutex);
-    // TODO: reuse slots
-    unsigned slot = num_work_items.load();
+    // reuse the lowest released slot if there is one
+    unsigned count = num_work_items.load();
+    unsigned slot = 0;
+    while((slot < count) && (work_items[slot] != 0))
+      slot++;
+    bool reused = (slot < count);
     assert(slot < MAX_WORK_ITEMS);
+
+    // workers cache what they learned about each slot's item, so tell them
+    //  to forget before the new item can be advertised
+    if(reused)
+      slot_generation.fetch_add_acqrel(1);
+
     work_items[slot] = item;
-    int prev = work_item_usecounts[slot].fetch_add_acqrel(1);
-    assert(prev == 0);
-    (void)prev;
-    num_work_items.store_release(slot + 1);
+
+    unsigned elem = slot / BITMASK_BITS;
+    BitMask mask = BitMask(1) << (slot % BITMASK_BITS);
+    if(item->latency_sensitive)
+      latency_work_item_mask[elem].fetch_or(mask);
+
+    if(cfg.profile_busy_time)
+      item->busy_time_gauge = new ProfilingGauges::EventCounter<long long>(stringbuilder() << "realm/bgwork/" << item->name << "/busy time");
+
+    // use count has to go from 0 to 1 - a worker with a stale view of the
+    //  slot's previous occupant may briefly hold a use count of its own
+    while(true) {
+      int expected = 0;
+      if(work_item_usecounts[slot].compare_exchange(expected, 1))
+        break;
+      Thread::yield();
+    }
+
+    if(!reused)
+      num_work_items.store_release(slot + 1);
     return slot;
   }
 
@@ -237,11 +267,45 @@ namespace Realm {
 
     {
       AutoLock<> al(mutex);
-      // NOTE: no reuse of released slots right now
+      // the slot can be reused once this is cleared
+      BackgroundWorkItem *item = work_items[slot];
       work_items[slot] = 0;
+      latency_work_item_mask[elem].fetch_and(~mask);
+      if(item->busy_time_gauge) {
+        delete item->busy_time_gauge;
+        item->busy_time_gauge = 0;
+      }
     }
   }
 
+  bool BackgroundWorkManager::latency_work_waiting(void) const
+  {
+    for(unsigned i = 0; i < BITMASK_ARRAY_SIZE; i++)
+      if((active_work_item_mask[i].load() &
+          latency_work_item_mask[i].load()) != 0)
+        return true;
+    return false;
+  }
+
+  long long BackgroundWorkManager::choose_timeslice(const BackgroundWorkItem *item) const
+  {
+    // an explicit per-item setting wins, otherwise latency-sensitive items
+    //  get the shorter default
+    long long slice = ((item->timeslice > 0) ?
+                         item->timeslice :
+                       item->latency_sensitive ?
+                         cfg.latency_item_timeslice :
+                         cfg.work_item_timeslice);
+
+    // don't make latency-sensitive work wait behind a full-length slice of
+    //  something else
+    if(!item->latency_sensitive && (slice > cfg.latency_item_timeslice) &&
+       latency_work_waiting())
+      slice = cfg.latency_item_timeslice;
+
+    return slice;
+  }
+
   void BackgroundWorkManager::advertise_work(unsigned slot)
   {
     unsigned elem = slot / BITMASK_BITS;
@@ -287,7 +351,9 @@ namespace Realm {
       .add_option_int("-ll:bgnumapin", cfg.pin_numa.val)
       .add_option_int("-ll:bgstack", cfg.worker_stacksize_in_kb.val)
       .add_option_int("-ll:bgspin", cfg.worker_spin_interval.val)
-      .add_option_int("-ll:bgslice", cfg.work_item_timeslice.val);
+      .add_option_int("-ll:bgslice", cfg.work_item_timeslice.val)
+      .add_option_int("-ll:bgslice_lat", cfg.latency_item_timeslice.val)
+      .add_option_bool("-ll:bgprofile", cfg.profile_busy_time.val);
 
     bool ok = cp.parse_command_line(cmdline);
     assert(ok);
@@ -367,6 +433,18 @@ namespace Realm {
       delete *it;
     }
     dedicated_workers.clear();
+
+    // busy time gauges have to go away before the sampling profiler does,
+    //  even if their work items live on a bit longer
+    if(cfg.profile_busy_time) {
+      AutoLock<> al(mutex);
+      unsigned count = num_work_items.load();
+      for(unsigned i = 0; i < count; i++)
+        if(work_items[i] && work_items[i]->busy_time_gauge) {
+          delete work_items[i]->busy_time_gauge;
+          work_items[i]->busy_time_gauge = 0;
+        }
+    }
   }
 
   ////////////////////////////////////////////////////////////////////////
@@ -377,7 +455,10 @@ namespace Realm {
   BackgroundWorkItem::BackgroundWorkItem(const std::string& _name)
     : name(_name)
     , manager(0)
+    , timeslice(-1)
+    , latency_sensitive(false)
     , index(0)
+    , busy_time_gauge(0)
 #ifdef DEBUG_REALM
     , state(STATE_IDLE)
 #endif
@@ -410,7 +491,20 @@ namespace Realm {
 		      << " item=" << this
 		      << " slot=" << index << " name=" << name
 		      << " domain=" << numa_domain
-		      << " timeslice=" << min_timeslice_needed;
+		      << " timeslice=" << min_timeslice_needed
+		      << " latency=" << latency_sensitive;
+  }
+
+  void BackgroundWorkItem::set_timeslice(long long _timeslice_in_ns)
+  {
+    timeslice = _timeslice_in_ns;
+  }
+
+  void BackgroundWorkItem::set_latency_sensitive(bool _latency_sensitive /*= true*/)
+  {
+    // the manager's mask of latency-sensitive slots is set up in assign_slot
+    assert(manager == 0);
+    latency_sensitive = _latency_sensitive;
   }
 
   // mark this work item as active (i.e. having work to do)
@@ -468,6 +562,7 @@ namespace Realm {
     , starting_slot(0)
     , max_timeslice(-1)
     , numa_domain(-1)
+    , known_slot_generation(0)
   {
     for(unsigned i = 0; i < BITMASK_ARRAY_SIZE; i++) {
       known_work_item_mask[i] = 0;
@@ -528,16 +623,27 @@ namespace Realm {
 	did_work = false;
 
 	starting_slot = 0;
-        // TODO: if/when slots are reused, we need a way to invalidate
-        //  our known/allowed masks
       }
 
       // look at a whole BitMask entry at once, skipping over 0's
       unsigned elem = starting_slot / BITMASK_BITS;
       unsigned ofs = starting_slot % BITMASK_BITS;
-      BitMask active_mask = (manager->active_work_item_mask[elem].load() &
+      BitMask active_mask = (manager->active_work_item_mask[elem].load_acquire() &
                              (~BitMask(0) << ofs));
 
+      // if any slots have been reused since we last looked, our known/allowed
+      //  masks may describe the wrong items - this is checked after loading
+      //  the active mask so that we can't see a reused slot's new work
+      //  without also seeing the generation change
+      unsigned cur_generation = manager->slot_generation.load_acquire();
+      if(cur_generation != known_slot_generation) {
+        for(unsigned i = 0; i < BITMASK_ARRAY_SIZE; i++) {
+          known_work_item_mask[i] = 0;
+          allowed_work_item_mask[i] = 0;
+        }
+        known_slot_generation = cur_generation;
+      }
+
       // are there any bits set that we've not seen before?
       BitMask unknown_mask = active_mask & ~known_work_item_mask[elem];
       while(unknown_mask != 0) {
@@ -600,11 +706,6 @@ namespace Realm {
 			    << " slot=" << slot
 			    << " worker=" << this;
 	  long long t_start = Clock::current_time_in_nanoseconds(true /*absolute*/);
-	  // don't spend more than 1ms on any single task before going on to the
-	  //  next thing - TODO: pull this out as a config variable
-	  long long t_quantum = (manager->cfg.work_item_timeslice + t_start);
-	  if((work_until_time > 0) && (work_until_time < t_quantum))
-	    t_quantum = work_until_time;
 
           // increase the use count for this slot - this should NEVER see
           //  an invalid slot because we have claimed a work request and
@@ -614,6 +715,13 @@ namespace Realm {
           (void)prev_usecount;
 
 	  BackgroundWorkItem *item = manager->work_items[slot];
+
+	  // don't spend more than the item's timeslice on it before going on
+	  //  to the next thing
+	  long long timeslice = manager->choose_timeslice(item);
+	  long long t_quantum = (timeslice + t_start);
+	  if((work_until_time > 0) && (work_until_time < t_quantum))
+	    t_quantum = work_until_time;
 #ifdef DEBUG_REALM
 	  item->make_inactive();
 #endif
@@ -627,7 +735,7 @@ namespace Realm {
                 long long now = Clock::current_time_in_nanoseconds(true /*absolute*/);
                 if((work_until_time <= 0) || (work_until_time > now)) {
                   // update t_quantum and then loop back around
-                  t_quantum = (manager->cfg.work_item_timeslice + now);
+                  t_quantum = (timeslice + now);
                   if((work_until_time > 0) && (work_until_time < t_quantum))
                     t_quantum = work_until_time;
                   continue;
@@ -640,6 +748,10 @@ namespace Realm {
             } else
               break;
           }
+	  if(item->busy_time_gauge) {
+	    long long t_stop = Clock::current_time_in_nanoseconds(true /*absolute*/);
+	    *(item->busy_time_gauge) += (t_stop - t_start);
+	  }
 #ifdef REALM_BGWORK_PROFILE
 	  long long t_stop = Clock::current_time_in_nanoseconds(true /*absolute*/);
 	  long long elapsed = t_stop - t_start;
@@ -31,6 +31,10 @@ namespace Realm {
   class BackgroundWorkItem;
   class BackgroundWorkThread;
 
+  namespace ProfilingGauges {
+    template <typename T> class EventCounter;
+  };
+
   class BackgroundWorkManager {
   public:
     BackgroundWorkManager(void);
@@ -44,6 +48,12 @@ namespace Realm {
       WithDefault<size_t, 1024> worker_stacksize_in_kb;
       WithDefault<long long, 0> worker_spin_interval;
       WithDefault<long long, 100000> work_item_timeslice;
+      // default timeslice for latency-sensitive work items, which is also
+      //  the most any other item gets while latency-sensitive work is waiting
+      WithDefault<long long, 20000> latency_item_timeslice;
+      // if set, each work item's busy time is reported via a sampling
+      //  profiler gauge
+      WithDefault<bool, false> profile_busy_time;
     };
 
     void configure_from_cmdline(std::vector<std::string>& cmdline);
@@ -78,6 +88,7 @@ namespace Realm {
       BitMask allowed_work_item_mask[BITMASK_ARRAY_SIZE];
       long long max_timeslice;
       int numa_domain;
+      unsigned known_slot_generation;
     };
   protected:
     friend class BackgroundWorkManager::Worker;
@@ -87,12 +98,22 @@ namespace Realm {
     void release_slot(unsigned slot);
     void advertise_work(unsigned slot);
 
+    // returns true if any latency-sensitive work item is waiting for a worker
+    bool latency_work_waiting(void) const;
+
+    // how long a worker should spend on 'item' before moving on
+    long long choose_timeslice(const BackgroundWorkItem *item) const;
+
     Config cfg;
 
     // mutex protects assignment of work items to slots
     Mutex mutex;
     atomic<unsigned> num_work_items;
     atomic<BitMask> active_work_item_mask[BITMASK_ARRAY_SIZE];
+    atomic<BitMask> latency_work_item_mask[BITMASK_ARRAY_SIZE];
+    // bumped whenever a released slot is reused so that workers know to
+    //  forget what they learned about the slot's previous occupant
+    atomic<unsigned> slot_generation;
 
     atomic<int> work_item_usecounts[MAX_WORK_ITEMS];
     BackgroundWorkItem *work_items[MAX_WORK_ITEMS];
@@ -132,6 +153,15 @@ namespace Realm {
 			int _numa_domain = -1,
 			long long _min_timeslice_needed = -1);
 
+    // overrides the manager's default timeslice for this item (-1 == use
+    //  the default)
+    void set_timeslice(long long _timeslice_in_ns);
+
+    // latency-sensitive items default to a shorter timeslice and limit the
+    //  timeslice of other items while they are waiting - must be called
+    //  before 'add_to_manager'
+    void set_latency_sensitive(bool _latency_sensitive = true);
+
     // perform work, trying to respect the 'work_until' time limit - return
     //  true to request requeuing (this is more efficient than calling
     //  'make_active' at the end of 'do_work') or false if all work has been
@@ -139,6 +169,7 @@ namespace Realm {
     virtual bool do_work(TimeLimit work_until) = 0;
 
   protected:
+    friend class BackgroundWorkManager;
     friend class BackgroundWorkManager::Worker;
 
     // mark this work item as active (i.e. having work to do)
@@ -148,7 +179,10 @@ namespace Realm {
     BackgroundWorkManager *manager;
     int numa_domain;
     long long min_timeslice_needed;
+    long long timeslice;
+    bool latency_sensitive;
     unsigned index;
+    ProfilingGauges::EventCounter<long long> *busy_time_gauge;
 
 #ifdef DEBUG_REALM
   public:
@@ -111,6 +111,13 @@
   #define REALM_THREAD_LOCAL __thread
 #endif
 
+// REALM_RESTRICT - pointer qualifier promising no aliasing
+#ifdef _MSC_VER
+  #define REALM_RESTRICT __restrict
+#else
+  #define REALM_RESTRICT __restrict__
+#endif
+
 // REALM_ASSERT(cond, message) - abort program if 'cond' is not true
 #if defined (__CUDACC__) || defined (__HIPCC__)
 #define REALM_ASSERT(cond, message)  assert(cond)
@@ -22,11 +22,115 @@
 #include "realm/deppart/inst_helper.h"
 #include "realm/logging.h"
 
+#include <type_traits>
+
 namespace Realm {
 
   extern Logger log_part;
   extern Logger log_uop_timing;
 
+  namespace {
+
+    // returns the length of the run of values equal to 'val' at the start of
+    //  a contiguous array - blocks of values are compared without early exits
+    //  so that the compiler can vectorize the comparisons
+    template <typename FT>
+    size_t find_run_length(const FT *vals, size_t count, const FT& val)
+    {
+      static const size_t BLOCK = 16;
+      size_t i = 0;
+      while((i + BLOCK) <= count) {
+	unsigned mismatch = 0;
+	for(size_t j = 0; j < BLOCK; j++)
+	  mismatch |= (vals[i + j] != val) ? 1 : 0;
+	if(mismatch) break;
+	i += BLOCK;
+      }
+      while((i < count) && (vals[i] == val))
+	i++;
+      return i;
+    }
+
+    // finds (or creates) the bitmask for a given field value - consecutive
+    //  strips usually share a value, so the last one is cached
+    template <typename FT, typename BM, bool INTEGRAL = std::is_integral<FT>::value>
+    class ByFieldBitmaskLookup {
+    public:
+      template <typename COLORS>
+      ByFieldBitmaskLookup(std::map<FT, BM *>& _bitmasks, const COLORS& colors)
+	: bitmasks(_bitmasks), last_bm(0)
+      {}
+
+      BM *lookup(const FT& val)
+      {
+	if(last_bm && (val == last_val))
+	  return last_bm;
+	BM *&bmp = bitmasks[val];
+	if(!bmp) bmp = new BM;
+	last_val = val;
+	last_bm = bmp;
+	return bmp;
+      }
+
+    protected:
+      std::map<FT, BM *>& bitmasks;
+      FT last_val;
+      BM *last_bm;
+    };
+
+    // integral field values whose colors span a small range use a flat array
+    //  instead of a map
+    template <typename FT, typename BM>
+    class ByFieldBitmaskLookup<FT, BM, true> {
+    public:
+      // don't bother with a dense index larger than this
+      static const size_t MAX_DENSE_RANGE = 1 << 16;
+
+      template <typename COLORS>
+      ByFieldBitmaskLookup(std::map<FT, BM *>& _bitmasks, const COLORS& colors)
+	: bitmasks(_bitmasks), range_lo(0), range_hi(0)
+      {
+	if(!colors.empty()) {
+	  range_lo = colors.begin()->first;
+	  range_hi = colors.rbegin()->first;
+	  // do the subtraction unsigned so that it can't overflow
+	  unsigned long long span = ((unsigned long long)range_hi -
+				     (unsigned long long)range_lo);
+	  if(span < MAX_DENSE_RANGE)
+	    dense.resize(size_t(span) + 1, 0);
+	}
+      }
+
+      ~ByFieldBitmaskLookup(void)
+      {
+	// move the bitmasks we found into the caller's map
+	for(size_t i = 0; i < dense.size(); i++)
+	  if(dense[i])
+	    bitmasks[FT(range_lo + i)] = dense[i];
+      }
+
+      BM *lookup(const FT& val)
+      {
+	if(!dense.empty() && (val >= range_lo) && (val <= range_hi)) {
+	  BM *&bmp = dense[size_t((unsigned long long)val -
+				  (unsigned long long)range_lo)];
+	  if(!bmp) bmp = new BM;
+	  return bmp;
+	}
+	// values outside the colors' range still get recorded
+	BM *&bmp = bitmasks[val];
+	if(!bmp) bmp = new BM;
+	return bmp;
+      }
+
+    protected:
+      std::map<FT, BM *>& bitmasks;
+      FT range_lo, range_hi;
+      std::vector<BM *> dense;
+    };
+
+  };
+
 
   template <int N, typename T>
   template <typename FT>
@@ -109,37 +213,56 @@ namespace Realm {
     // for now, one access for the whole instance
     AffineAccessor<FT,N,T> a_data(inst, field_offset);
 
+    // rows of a dense (in x) layout can be scanned directly in memory
+    const bool contiguous = (a_data.strides[0] == sizeof(FT));
+
+    ByFieldBitmaskLookup<FT, BM> lookup(bitmasks, sparsity_outputs);
+
     // double iteration - use the instance's space first, since it's probably smaller
     for(IndexSpaceIterator<N,T> it(inst_space); it.valid; it.step()) {
       for(IndexSpaceIterator<N,T> it2(parent_space, it.rect); it2.valid; it2.step()) {
 	const Rect<N,T>& r = it2.rect;
 	Point<N,T> p = r.lo;
 	while(true) {
-	  FT val = a_data.read(p);
-	  Point<N,T> p2 = p;
-	  while(p2.x < r.hi.x) {
-	    Point<N,T> p3 = p2;
-	    p3.x++;
-	    FT val2 = a_data.read(p3);
-	    if(val != val2) {
-	      // record old strip
-	      BM *&bmp = bitmasks[val];
-	      if(!bmp) bmp = new BM;
-	      bmp->add_rect(Rect<N,T>(p,p2));
-	      //std::cout << val << ": " << p << ".." << p2 << std::endl;
-	      val = val2;
-	      p = p3;
+	  if(contiguous) {
+	    const FT *row = a_data.ptr(p);
+	    size_t count = size_t(r.hi.x - p.x) + 1;
+	    size_t ofs = 0;
+	    while(ofs < count) {
+	      FT val = row[ofs];
+	      size_t len = find_run_length(row + ofs, count - ofs, val);
+	      Point<N,T> p1 = p;
+	      p1.x += T(ofs);
+	      Point<N,T> p2 = p1;
+	      p2.x += T(len - 1);
+	      lookup.lookup(val)->add_rect(Rect<N,T>(p1,p2));
+	      ofs += len;
 	    }
-	    p2 = p3;
+	    p.x = r.hi.x;
+	  } else {
+	    FT val = a_data.read(p);
+	    Point<N,T> p2 = p;
+	    while(p2.x < r.hi.x) {
+	      Point<N,T> p3 = p2;
+	      p3.x++;
+	      FT val2 = a_data.read(p3);
+	      if(val != val2) {
+		// record old strip
+		lookup.lookup(val)->add_rect(Rect<N,T>(p,p2));
+		//std::cout << val << ": " << p << ".." << p2 << std::endl;
+		val = val2;
+		p = p3;
+	      }
+	      p2 = p3;
+	    }
+	    // record whatever strip we have at the end
+	    lookup.lookup(val)->add_rect(Rect<N,T>(p,p2));
+	    //std::cout << val << ": " << p << ".." << p2 << std::endl;
+	    p = p2;
 	  }
-	  // record whatever strip we have at the end
-	  BM *&bmp = bitmasks[val];
-	  if(!bmp) bmp = new BM;
-	  bmp->add_rect(Rect<N,T>(p,p2));
-	  //std::cout << val << ": " << p << ".." << p2 << std::endl;
 
 	  // are we done?
-	  if(p2 == r.hi) break;
+	  if(p == r.hi) break;
 
 	  // now go to the next span, if there is one (can't be in 1-D)
 	  assert(N > 1);
@@ -192,10 +315,15 @@ namespace Realm {
       typename std::map<FT, DenseRectangleList<N,T> *>::const_iterator it2 = rect_map.find(it->first);
       if(it2 != rect_map.end()) {
 	impl->contribute_dense_rect_list(it2->second->rects, true /*disjoint*/);
-	delete it2->second;
       } else
 	impl->contribute_nothing();
     }
+
+    // values that don't match any color were still collected
+    for(typename std::map<FT, DenseRectangleList<N,T> *>::const_iterator it = rect_map.begin();
+	it != rect_map.end();
+	it++)
+      delete it->second;
   }
 
   template <int N, typename T, typename FT>
@@ -306,19 +434,31 @@ namespace Realm {
   template <int N, typename T, typename FT>
   void ByFieldOperation<N,T,FT>::execute(void)
   {
-    for(size_t i = 0; i < subspaces.size(); i++)
-      SparsityMapImpl<N,T>::lookup(subspaces[i])->set_contributor_count(field_data.size());
-
+    // large instances are split into several microops along their slowest
+    //  dimension so that the partitioning workers can scan them in parallel
+    std::vector<std::vector<IndexSpace<N,T> > > pieces(field_data.size());
+    size_t total_pieces = 0;
     for(size_t i = 0; i < field_data.size(); i++) {
-      ByFieldMicroOp<N,T,FT> *uop = new ByFieldMicroOp<N,T,FT>(parent,
-							       field_data[i].index_space,
-							       field_data[i].inst,
-							       field_data[i].field_offset);
-      for(size_t j = 0; j < colors.size(); j++)
-	uop->add_sparsity_output(colors[j], subspaces[j]);
-      //uop.set_value_set(colors);
-      uop->dispatch(this, true /* ok to run in this thread */);
+      IndexSpace<N,T> covered(parent.bounds.intersection(field_data[i].index_space.bounds),
+			      parent.sparsity);
+      split_scan_space(covered, DeppartConfig::cfg_byfield_split_size, pieces[i]);
+      total_pieces += pieces[i].size();
     }
+
+    for(size_t i = 0; i < subspaces.size(); i++)
+      SparsityMapImpl<N,T>::lookup(subspaces[i])->set_contributor_count(total_pieces);
+
+    for(size_t i = 0; i < field_data.size(); i++)
+      for(size_t k = 0; k < pieces[i].size(); k++) {
+	ByFieldMicroOp<N,T,FT> *uop = new ByFieldMicroOp<N,T,FT>(pieces[i][k],
+								 field_data[i].index_space,
+								 field_data[i].inst,
+								 field_data[i].field_offset);
+	for(size_t j = 0; j < colors.size(); j++)
+	  uop->add_sparsity_output(colors[j], subspaces[j]);
+	//uop.set_value_set(colors);
+	uop->dispatch(this, true /* ok to run in this thread */);
+      }
   }
 
   template <int N, typename T, typename FT>
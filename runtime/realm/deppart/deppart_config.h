@@ -28,6 +28,10 @@ namespace Realm {
     extern bool cfg_disable_intersection_optimization;
     extern int cfg_max_rects_in_approximation;
     extern bool cfg_worker_threads_sleep;
+    extern size_t cfg_byfield_split_size;
+    extern size_t cfg_image_split_size;
+    extern size_t cfg_preimage_cache_size;
+    extern bool cfg_enable_bitmaps;
 
   };
 
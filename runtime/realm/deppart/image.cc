@@ -535,42 +535,72 @@ namespace Realm {
      uop->dispatch(this, true /* ok to run in this thread */);
     } else {
      // launch full cross-product of image micro ops right away
+     compute_field_pieces();
+     size_t total_pieces = 0;
+     for (size_t i = 0; i < field_pieces.size(); i++)
+      total_pieces += field_pieces[i].size();
      for (size_t i = 0; i < sources.size(); i++)
       SparsityMapImpl<N, T>::lookup(images[i])->set_contributor_count(
-          domain_transform.ptr_data.size() +
-          domain_transform.range_data.size());
-
-     for (size_t i = 0; i < domain_transform.ptr_data.size(); i++) {
-      ImageMicroOp<N, T, N2, T2> *uop = new ImageMicroOp<N, T, N2, T2>(
-          parent, domain_transform.ptr_data[i].index_space,
-          domain_transform.ptr_data[i].inst,
-          domain_transform.ptr_data[i].field_offset, false /*ptrs*/);
-      for (size_t j = 0; j < sources.size(); j++)
-       if (diff_rhss.empty())
-        uop->add_sparsity_output(sources[j], images[j]);
-       else
-        uop->add_sparsity_output_with_difference(sources[j], diff_rhss[j],
-                                                 images[j]);
+          total_pieces);
 
-      uop->dispatch(this, true /* ok to run in this thread */);
-     }
+     std::set<int> all_sources;
+     for (size_t j = 0; j < sources.size(); j++)
+      all_sources.insert(j);
+     for (size_t i = 0; i < field_pieces.size(); i++)
+      launch_microops(i, all_sources);
+    }
+   }
+  }
 
-     for (size_t i = 0; i < domain_transform.range_data.size(); i++) {
-      ImageMicroOp<N, T, N2, T2> *uop = new ImageMicroOp<N, T, N2, T2>(
-          parent, domain_transform.range_data[i].index_space,
-          domain_transform.range_data[i].inst,
-          domain_transform.range_data[i].field_offset, true /*ranges*/);
-      for (size_t j = 0; j < sources.size(); j++)
-       if (diff_rhss.empty())
-        uop->add_sparsity_output(sources[j], images[j]);
-       else
-        uop->add_sparsity_output_with_difference(sources[j], diff_rhss[j],
-                                                 images[j]);
+  template <int N, typename T, int N2, typename T2>
+  void ImageOperation<N,T,N2,T2>::compute_field_pieces(void)
+  {
+    field_pieces.resize(domain_transform.ptr_data.size() +
+			domain_transform.range_data.size());
+    for(size_t i = 0; i < domain_transform.ptr_data.size(); i++)
+      split_scan_space(domain_transform.ptr_data[i].index_space,
+		       DeppartConfig::cfg_image_split_size,
+		       field_pieces[i]);
+    for(size_t i = 0; i < domain_transform.range_data.size(); i++)
+      split_scan_space(domain_transform.range_data[i].index_space,
+		       DeppartConfig::cfg_image_split_size,
+		       field_pieces[i + domain_transform.ptr_data.size()]);
+  }
+
+  template <int N, typename T, int N2, typename T2>
+  void ImageOperation<N,T,N2,T2>::launch_microops(size_t field_idx,
+						  const std::set<int>& outputs)
+  {
+    bool is_ranged = (field_idx >= domain_transform.ptr_data.size());
+    RegionInstance inst;
+    size_t field_offset;
+    if(is_ranged) {
+      size_t rel_idx = field_idx - domain_transform.ptr_data.size();
+      inst = domain_transform.range_data[rel_idx].inst;
+      field_offset = domain_transform.range_data[rel_idx].field_offset;
+    } else {
+      inst = domain_transform.ptr_data[field_idx].inst;
+      field_offset = domain_transform.ptr_data[field_idx].field_offset;
+    }
 
+    // one microop per piece of the field data's index space
+    for(size_t k = 0; k < field_pieces[field_idx].size(); k++) {
+      ImageMicroOp<N,T,N2,T2> *uop = new ImageMicroOp<N,T,N2,T2>(parent,
+								 field_pieces[field_idx][k],
+								 inst,
+								 field_offset,
+								 is_ranged);
+      for(std::set<int>::const_iterator it = outputs.begin();
+	  it != outputs.end();
+	  it++) {
+	int j = *it;
+        if(diff_rhss.empty())
+	  uop->add_sparsity_output(sources[j], images[j]);
+        else
+	  uop->add_sparsity_output_with_difference(sources[j], diff_rhss[j], images[j]);
+      }
       uop->dispatch(this, true /* ok to run in this thread */);
-     }
     }
-   }
   }
 
   template <int N, typename T, int N2, typename T2>
@@ -578,6 +608,8 @@ namespace Realm {
   {
     OverlapTester<N2,T2> *overlap_tester = static_cast<OverlapTester<N2,T2> *>(tester);
 
+    compute_field_pieces();
+
     // we asked the overlap tester to prefetch all the source data we need, so we can use it
     //  right away (and then delete it)
     std::vector<std::set<int> > overlaps_by_field_data(domain_transform.ptr_data.size() +
@@ -589,7 +621,13 @@ namespace Realm {
 
       log_part.info() << overlaps_by_source.size() << " overlaps for source " << i;
 
-      SparsityMapImpl<N,T>::lookup(images[i])->set_contributor_count(overlaps_by_source.size());
+      // every piece of each overlapping field data contributes
+      size_t contributors = 0;
+      for(std::set<int>::const_iterator it = overlaps_by_source.begin();
+	  it != overlaps_by_source.end();
+	  it++)
+	contributors += field_pieces[*it].size();
+      SparsityMapImpl<N,T>::lookup(images[i])->set_contributor_count(contributors);
 
       // now scatter these values into the overlaps_by_field_data
       for(std::set<int>::const_iterator it = overlaps_by_source.begin();
@@ -599,49 +637,9 @@ namespace Realm {
     }
     delete overlap_tester;
 
-    for(size_t i = 0; i < domain_transform.ptr_data.size(); i++) {
-      const std::set<int>& overlaps = overlaps_by_field_data[i];
-      size_t n = overlaps.size();
-      if(n == 0) continue;
-
-      ImageMicroOp<N,T,N2,T2> *uop = new ImageMicroOp<N,T,N2,T2>(parent,
-								 domain_transform.ptr_data[i].index_space,
-								 domain_transform.ptr_data[i].inst,
-								 domain_transform.ptr_data[i].field_offset,
-								 false /*ptrs*/);
-      for(std::set<int>::const_iterator it = overlaps.begin();
-	  it != overlaps.end();
-	  it++) {
-	int j = *it;
-        if(diff_rhss.empty())
-	  uop->add_sparsity_output(sources[j], images[j]);
-        else
-	  uop->add_sparsity_output_with_difference(sources[j], diff_rhss[j], images[j]);
-      }
-      uop->dispatch(this, true /* ok to run in this thread */);
-    }
-
-    for(size_t i = 0; i < domain_transform.range_data.size(); i++) {
-      const std::set<int>& overlaps = overlaps_by_field_data[i + domain_transform.ptr_data.size()];
-      size_t n = overlaps.size();
-      if(n == 0) continue;
-
-      ImageMicroOp<N,T,N2,T2> *uop = new ImageMicroOp<N,T,N2,T2>(parent,
-								 domain_transform.range_data[i].index_space,
-								 domain_transform.range_data[i].inst,
-								 domain_transform.range_data[i].field_offset,
-								 true /*ranges*/);
-      for(std::set<int>::const_iterator it = overlaps.begin();
-	  it != overlaps.end();
-	  it++) {
-	int j = *it;
-        if(diff_rhss.empty())
-	  uop->add_sparsity_output(sources[j], images[j]);
-        else
-	  uop->add_sparsity_output_with_difference(sources[j], diff_rhss[j], images[j]);
-      }
-      uop->dispatch(this, true /* ok to run in this thread */);
-    }
+    for(size_t i = 0; i < overlaps_by_field_data.size(); i++)
+      if(!overlaps_by_field_data[i].empty())
+	launch_microops(i, overlaps_by_field_data[i]);
   }
 
   template <int N, typename T, int N2, typename T2>
@@ -103,11 +103,20 @@ namespace Realm {
    virtual void set_overlap_tester(void* tester);
 
   protected:
+   // splits each field data index space into the pieces scanned by separate
+   //  microops
+   void compute_field_pieces(void);
+
+   // launches microops for every piece of the given field data (ptr_data
+   //  first, then range_data) that contribute to the given outputs
+   void launch_microops(size_t field_idx, const std::set<int>& outputs);
+
    IndexSpace<N, T> parent;
    DomainTransform<N, T, N2, T2> domain_transform;
    std::vector<IndexSpace<N2, T2>> sources;
    std::vector<IndexSpace<N, T>> diff_rhss;
    std::vector<SparsityMap<N, T>> images;
+   std::vector<std::vector<IndexSpace<N2, T2>>> field_pieces;
   };
 
   template <int N, typename T, int N2, typename T2>
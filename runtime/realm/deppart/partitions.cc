@@ -28,6 +28,8 @@
 #include "realm/deppart/byfield.h"
 #include "realm/deppart/setops.h"
 
+#include <algorithm>
+
 namespace Realm {
 
   Logger log_part("part");
@@ -44,6 +46,15 @@ namespace Realm {
     int cfg_max_rects_in_approximation = 32;
     bool cfg_worker_threads_sleep = true;
     bool cfg_allow_inline_operations = false;
+    size_t cfg_byfield_split_size = 1 << 20; // points per byfield microop
+    size_t cfg_image_split_size = 1 << 20; // points per (pre)image microop
+    // number of preimage inverse indices to keep - these are only valid if
+    //  the pointer field data is not changed between preimage operations
+    size_t cfg_preimage_cache_size = 0;
+    // allow sparsity maps to encode clusters of small entries as bitmaps -
+    //  this is opt-in (-dp:bitmaps 1) because iterating over a bitmap is
+    //  slower than over the equivalent list of rectangles
+    bool cfg_enable_bitmaps = false;
   };
 
   // TODO: C++11 has type_traits and std::make_unsigned
@@ -113,7 +124,10 @@ namespace Realm {
 	it != entries.end();
 	it++) {
       for(int i = 0; i < N; i++)
-	lo_volume[i] += it->bounds.intersection(lo_half[i]).volume();
+	if(it->bitmap != 0)
+	  lo_volume[i] += it->bitmap->overlap_volume(lo_half[i]);
+	else
+	  lo_volume[i] += it->bounds.intersection(lo_half[i]).volume();
     }
     // now compute how many subspaces would fall in each half and the 
     //  inefficiency of the split
@@ -829,6 +843,49 @@ namespace Realm {
   }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class InstanceDataCache
+
+  namespace {
+    Mutex instance_data_caches_mutex;
+    std::vector<InstanceDataCache *> instance_data_caches;
+  };
+
+  InstanceDataCache::InstanceDataCache(void)
+  {
+    AutoLock<> al(instance_data_caches_mutex);
+    instance_data_caches.push_back(this);
+  }
+
+  InstanceDataCache::~InstanceDataCache(void)
+  {
+    AutoLock<> al(instance_data_caches_mutex);
+    std::vector<InstanceDataCache *>::iterator it =
+      std::find(instance_data_caches.begin(), instance_data_caches.end(), this);
+    if(it != instance_data_caches.end())
+      instance_data_caches.erase(it);
+  }
+
+  /*static*/ void InstanceDataCache::invalidate_all(RegionInstance inst)
+  {
+    AutoLock<> al(instance_data_caches_mutex);
+    for(size_t i = 0; i < instance_data_caches.size(); i++)
+      instance_data_caches[i]->invalidate(inst);
+  }
+
+  /*static*/ void InstanceDataCache::destroy_all(void)
+  {
+    std::vector<InstanceDataCache *> to_delete;
+    {
+      AutoLock<> al(instance_data_caches_mutex);
+      to_delete.swap(instance_data_caches);
+    }
+    for(size_t i = 0; i < to_delete.size(); i++)
+      delete to_delete[i];
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class PartitioningOpQueue
@@ -857,6 +914,10 @@ namespace Realm {
     cp.add_option_bool("-dp:noisectopt", DeppartConfig::cfg_disable_intersection_optimization);
     cp.add_option_int("-dp:sleep", DeppartConfig::cfg_worker_threads_sleep);
     cp.add_option_int("-dp:inline_ok", DeppartConfig::cfg_allow_inline_operations);
+    cp.add_option_int("-dp:byfield_split", DeppartConfig::cfg_byfield_split_size);
+    cp.add_option_int("-dp:image_split", DeppartConfig::cfg_image_split_size);
+    cp.add_option_int("-dp:preimage_cache", DeppartConfig::cfg_preimage_cache_size);
+    cp.add_option_int("-dp:bitmaps", DeppartConfig::cfg_enable_bitmaps);
 
     cp.parse_command_line(cmdline);
   }
@@ -901,6 +962,9 @@ namespace Realm {
 
     delete deppart_op_queue;
     deppart_op_queue = 0;
+
+    // no more microops can use the caches
+    InstanceDataCache::destroy_all();
   }
       
   void PartitioningOpQueue::enqueue_partitioning_operation(PartitioningOperation *op)
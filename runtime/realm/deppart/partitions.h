@@ -78,6 +78,15 @@ namespace Realm {
   };
 
 
+  // splits an index space into slabs of its bounds along the slowest-varying
+  //  dimension so that large instances can be scanned by several microops in
+  //  parallel - each piece covers at least 'min_volume' points of the bounds,
+  //  and a 'min_volume' of 0 disables splitting
+  template <int N, typename T>
+  void split_scan_space(const IndexSpace<N,T>& space, size_t min_volume,
+			std::vector<IndexSpace<N,T> >& pieces);
+
+
   /////////////////////////////////////////////////////////////////////////
 
   class AsyncMicroOp : public Operation::AsyncWorkItem {
@@ -185,6 +194,24 @@ namespace Realm {
   };
 
 
+  ////////////////////////////////////////
+  //
+
+  // caches of data derived from instance contents (e.g. the preimage inverse
+  //  indices) - instance IDs are reused, so every entry for an instance is
+  //  dropped when it is destroyed, and the caches are deleted at shutdown
+  class InstanceDataCache {
+  public:
+    InstanceDataCache(void);
+    virtual ~InstanceDataCache(void);
+
+    virtual void invalidate(RegionInstance inst) = 0;
+
+    static void invalidate_all(RegionInstance inst);
+    static void destroy_all(void);
+  };
+
+
   ////////////////////////////////////////
   //
 
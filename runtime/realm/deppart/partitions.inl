@@ -23,6 +23,36 @@
 
 namespace Realm {
 
+  template <int N, typename T>
+  void split_scan_space(const IndexSpace<N,T>& space, size_t min_volume,
+			std::vector<IndexSpace<N,T> >& pieces)
+  {
+    // more pieces than this just adds contributions to the outputs
+    static const size_t MAX_PIECES = 64;
+
+    size_t volume = space.bounds.volume();
+    size_t count = 1;
+    if((min_volume > 0) && (volume > min_volume)) {
+      size_t extent = size_t(space.bounds.hi[N - 1] - space.bounds.lo[N - 1]) + 1;
+      count = std::min(std::min(volume / min_volume, MAX_PIECES), extent);
+    }
+    if(count <= 1) {
+      pieces.push_back(space);
+      return;
+    }
+
+    size_t extent = size_t(space.bounds.hi[N - 1] - space.bounds.lo[N - 1]) + 1;
+    size_t step = extent / count;
+    size_t extra = extent % count;
+    for(size_t i = 0; i < count; i++) {
+      Rect<N,T> r = space.bounds;
+      r.lo[N - 1] = space.bounds.lo[N - 1] + T(i * step + std::min(i, extra));
+      r.hi[N - 1] = r.lo[N - 1] + T(step + ((i < extra) ? 1 : 0) - 1);
+      pieces.push_back(IndexSpace<N,T>(r, space.sparsity));
+    }
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class PartitioningMicroOp
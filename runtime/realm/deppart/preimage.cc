@@ -23,12 +23,224 @@
 #include "realm/deppart/image.h"
 #include "realm/logging.h"
 #include <ctime>
+#include <algorithm>
+#include <list>
 
 namespace Realm {
 
   extern Logger log_part;
   extern Logger log_uop_timing;
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class PreimageInverseIndex<N,T,N2,T2>
+
+  // the field data of an instance in inverted form: runs of source points
+  //  (along x) that hold the same pointer/range, sorted by that value so that
+  //  a target only has to look at the runs that might point into it
+  template <int N, typename T, int N2, typename T2>
+  class PreimageInverseIndex {
+  public:
+    struct Run {
+      Rect<N2,T2> value;  // pointers are stored as single-point ranges
+      Rect<N,T> source;
+    };
+
+    // orders run indices by the first coordinate of the run's value
+    struct ValueOrder {
+      const std::vector<Run> *runs;
+      bool operator()(size_t a, size_t b) const
+      { return (*runs)[a].value.lo[0] < (*runs)[b].value.lo[0]; }
+      bool operator()(size_t a, T2 v) const
+      { return (*runs)[a].value.lo[0] < v; }
+      bool operator()(T2 v, size_t b) const
+      { return v < (*runs)[b].value.lo[0]; }
+    };
+
+    PreimageInverseIndex(bool _is_ranged)
+      : is_ranged(_is_ranged), references(1)
+    {}
+
+    void add_reference(void) { references.fetch_add(1); }
+
+    void remove_reference(void)
+    {
+      if(references.fetch_sub(1) == 1)
+	delete this;
+    }
+
+    void add_point(const Point<N,T>& p, const Rect<N2,T2>& value)
+    {
+      // extend the current run if this is the next point in its row
+      if(!runs.empty()) {
+	Run& last = runs.back();
+	if((last.value == value) && (last.source.hi.x + 1 == p.x)) {
+	  Point<N,T> next = last.source.hi;
+	  next.x = p.x;
+	  if(next == p) {
+	    last.source.hi = p;
+	    return;
+	  }
+	}
+      }
+      Run r;
+      r.value = value;
+      r.source = Rect<N,T>(p, p);
+      runs.push_back(r);
+    }
+
+    void finalize(void)
+    {
+      by_value.resize(runs.size());
+      for(size_t i = 0; i < runs.size(); i++)
+	by_value[i] = i;
+      ValueOrder order;
+      order.runs = &runs;
+      std::sort(by_value.begin(), by_value.end(), order);
+    }
+
+    const bool is_ranged;
+    std::vector<Run> runs;  // in source order
+    std::vector<size_t> by_value;
+
+  protected:
+    atomic<int> references;
+  };
+
+  // keeps the inverse indices of recently used field data, up to
+  //  -dp:preimage_cache entries per dimension/type combination
+  template <int N, typename T, int N2, typename T2>
+  class PreimageIndexCache : public InstanceDataCache {
+  public:
+    struct Key {
+      RegionInstance inst;
+      size_t field_offset;
+      IndexSpace<N,T> inst_space, parent_space;
+
+      bool operator<(const Key& other) const
+      {
+	if(inst.id != other.inst.id) return (inst.id < other.inst.id);
+	if(field_offset != other.field_offset) return (field_offset < other.field_offset);
+	int c = compare(inst_space, other.inst_space);
+	if(c != 0) return (c < 0);
+	return (compare(parent_space, other.parent_space) < 0);
+      }
+
+      bool operator==(const Key& other) const
+      {
+	return !(*this < other) && !(other < *this);
+      }
+
+      static int compare(const IndexSpace<N,T>& a, const IndexSpace<N,T>& b)
+      {
+	if(a.sparsity.id != b.sparsity.id)
+	  return ((a.sparsity.id < b.sparsity.id) ? -1 : 1);
+	for(int i = 0; i < N; i++) {
+	  if(a.bounds.lo[i] != b.bounds.lo[i])
+	    return ((a.bounds.lo[i] < b.bounds.lo[i]) ? -1 : 1);
+	  if(a.bounds.hi[i] != b.bounds.hi[i])
+	    return ((a.bounds.hi[i] < b.bounds.hi[i]) ? -1 : 1);
+	}
+	return 0;
+      }
+    };
+
+    virtual ~PreimageIndexCache(void)
+    {
+      {
+	AutoLock<> al(creation_mutex);
+	if(the_cache == this)
+	  the_cache = 0;
+      }
+      for(typename std::map<Key, PreimageInverseIndex<N,T,N2,T2> *>::iterator it = entries.begin();
+	  it != entries.end();
+	  ++it)
+	it->second->remove_reference();
+    }
+
+    // created on first use and deleted by InstanceDataCache::destroy_all
+    static PreimageIndexCache<N,T,N2,T2>& get_cache(void)
+    {
+      AutoLock<> al(creation_mutex);
+      if(!the_cache)
+	the_cache = new PreimageIndexCache<N,T,N2,T2>;
+      return *the_cache;
+    }
+
+    virtual void invalidate(RegionInstance inst)
+    {
+      std::vector<PreimageInverseIndex<N,T,N2,T2> *> evicted;
+      {
+	AutoLock<> al(mutex);
+	// keys are ordered by instance first
+	typename std::map<Key, PreimageInverseIndex<N,T,N2,T2> *>::iterator it = entries.begin();
+	while(it != entries.end()) {
+	  if(it->first.inst.id < inst.id) {
+	    ++it;
+	    continue;
+	  }
+	  if(it->first.inst.id > inst.id)
+	    break;
+	  evicted.push_back(it->second);
+	  lru.remove(it->first);
+	  entries.erase(it++);
+	}
+      }
+      for(size_t i = 0; i < evicted.size(); i++)
+	evicted[i]->remove_reference();
+    }
+
+    // returns a referenced index, or null if there isn't one
+    PreimageInverseIndex<N,T,N2,T2> *lookup(const Key& key)
+    {
+      AutoLock<> al(mutex);
+      typename std::map<Key, PreimageInverseIndex<N,T,N2,T2> *>::iterator it = entries.find(key);
+      if(it == entries.end())
+	return 0;
+      // move to the back of the lru order
+      typename std::list<Key>::iterator it2 = std::find(lru.begin(), lru.end(), key);
+      lru.splice(lru.end(), lru, it2);
+      it->second->add_reference();
+      return it->second;
+    }
+
+    // adds a reference to the index for the cache to hold
+    void insert(const Key& key, PreimageInverseIndex<N,T,N2,T2> *index)
+    {
+      std::vector<PreimageInverseIndex<N,T,N2,T2> *> evicted;
+      {
+	AutoLock<> al(mutex);
+	if(entries.count(key) > 0)
+	  return;  // somebody else beat us to it
+	index->add_reference();
+	entries[key] = index;
+	lru.push_back(key);
+	while(lru.size() > DeppartConfig::cfg_preimage_cache_size) {
+	  typename std::map<Key, PreimageInverseIndex<N,T,N2,T2> *>::iterator it = entries.find(lru.front());
+	  evicted.push_back(it->second);
+	  entries.erase(it);
+	  lru.pop_front();
+	}
+      }
+      for(size_t i = 0; i < evicted.size(); i++)
+	evicted[i]->remove_reference();
+    }
+
+  protected:
+    static Mutex creation_mutex;
+    static PreimageIndexCache<N,T,N2,T2> *the_cache;
+
+    Mutex mutex;
+    std::map<Key, PreimageInverseIndex<N,T,N2,T2> *> entries;
+    std::list<Key> lru;
+  };
+
+  template <int N, typename T, int N2, typename T2>
+  /*static*/ Mutex PreimageIndexCache<N,T,N2,T2>::creation_mutex;
+
+  template <int N, typename T, int N2, typename T2>
+  /*static*/ PreimageIndexCache<N,T,N2,T2> *PreimageIndexCache<N,T,N2,T2>::the_cache = 0;
+
   template <int N, typename T>
   template <int N2, typename T2>
   Event IndexSpace<N, T>::create_subspaces_by_preimage(
@@ -140,16 +352,101 @@ namespace Realm {
     }
   }
 
+  template <int N, typename T, int N2, typename T2>
+  PreimageInverseIndex<N,T,N2,T2> *PreimageMicroOp<N,T,N2,T2>::build_inverse_index(void)
+  {
+    PreimageInverseIndex<N,T,N2,T2> *index = new PreimageInverseIndex<N,T,N2,T2>(is_ranged);
+
+    // same iteration order as the direct scans, so runs come out in
+    //  source order
+    if(is_ranged) {
+      AffineAccessor<Rect<N2,T2>,N,T> a_data(inst, field_offset);
+      for(IndexSpaceIterator<N,T> it(inst_space); it.valid; it.step())
+	for(IndexSpaceIterator<N,T> it2(parent_space, it.rect); it2.valid; it2.step())
+	  for(PointInRectIterator<N,T> pir(it2.rect); pir.valid; pir.step())
+	    index->add_point(pir.p, a_data.read(pir.p));
+    } else {
+      AffineAccessor<Point<N2,T2>,N,T> a_data(inst, field_offset);
+      for(IndexSpaceIterator<N,T> it(inst_space); it.valid; it.step())
+	for(IndexSpaceIterator<N,T> it2(parent_space, it.rect); it2.valid; it2.step())
+	  for(PointInRectIterator<N,T> pir(it2.rect); pir.valid; pir.step()) {
+	    Point<N2,T2> ptr = a_data.read(pir.p);
+	    index->add_point(pir.p, Rect<N2,T2>(ptr, ptr));
+	  }
+    }
+
+    index->finalize();
+    return index;
+  }
+
+  template <int N, typename T, int N2, typename T2>
+  template <typename BM>
+  void PreimageMicroOp<N,T,N2,T2>::populate_bitmasks_from_index(const PreimageInverseIndex<N,T,N2,T2>& index,
+								std::map<int, BM *>& bitmasks)
+  {
+    typedef typename PreimageInverseIndex<N,T,N2,T2>::Run Run;
+    typename PreimageInverseIndex<N,T,N2,T2>::ValueOrder order;
+    order.runs = &index.runs;
+
+    std::vector<size_t> matches;
+    for(size_t i = 0; i < targets.size(); i++) {
+      const Rect<N2,T2>& tb = targets[i].bounds;
+      if(tb.empty()) continue;
+
+      // runs whose values start past the target can't hit it, and neither
+      //  can pointers before it (ranges might still reach into it)
+      std::vector<size_t>::const_iterator last = std::upper_bound(index.by_value.begin(),
+								  index.by_value.end(),
+								  tb.hi[0], order);
+      std::vector<size_t>::const_iterator first = index.by_value.begin();
+      if(!index.is_ranged)
+	first = std::lower_bound(first, last, tb.lo[0], order);
+
+      matches.clear();
+      for(std::vector<size_t>::const_iterator it = first; it != last; ++it) {
+	const Run& r = index.runs[*it];
+	if(index.is_ranged ? targets[i].contains_any(r.value) :
+	                     targets[i].contains(r.value.lo))
+	  matches.push_back(*it);
+      }
+      if(matches.empty()) continue;
+
+      // add the runs back in source order
+      std::sort(matches.begin(), matches.end());
+      BM *&bmp = bitmasks[i];
+      if(!bmp) bmp = new BM;
+      for(size_t j = 0; j < matches.size(); j++)
+	bmp->add_rect(index.runs[matches[j]].source);
+    }
+  }
+
   template <int N, typename T, int N2, typename T2>
   void PreimageMicroOp<N,T,N2,T2>::execute(void)
   {
     TimeStamp ts("PreimageMicroOp::execute", true, &log_uop_timing);
     std::map<int, DenseRectangleList<N,T> *> rect_map;
 
-    if(is_ranged)
-      populate_bitmasks_ranges(rect_map);
-    else
-      populate_bitmasks_ptrs(rect_map);
+    if(DeppartConfig::cfg_preimage_cache_size > 0) {
+      // reuse (or build) the inverse index for this piece of field data
+      typename PreimageIndexCache<N,T,N2,T2>::Key key;
+      key.inst = inst;
+      key.field_offset = field_offset;
+      key.inst_space = inst_space;
+      key.parent_space = parent_space;
+      PreimageIndexCache<N,T,N2,T2>& cache = PreimageIndexCache<N,T,N2,T2>::get_cache();
+      PreimageInverseIndex<N,T,N2,T2> *index = cache.lookup(key);
+      if(!index) {
+	index = build_inverse_index();
+	cache.insert(key, index);
+      }
+      populate_bitmasks_from_index(*index, rect_map);
+      index->remove_reference();
+    } else {
+      if(is_ranged)
+	populate_bitmasks_ranges(rect_map);
+      else
+	populate_bitmasks_ptrs(rect_map);
+    }
 
 #ifdef DEBUG_PARTITIONING
     std::cout << rect_map.size() << " non-empty preimages present in instance " << inst << std::endl;
@@ -333,6 +630,7 @@ namespace Realm {
     }
     micro_op->dispatch(this, true);
    } else {
+    compute_field_pieces();
     if (!DeppartConfig::cfg_disable_intersection_optimization) {
      // build the overlap tester based on the targets, since they're at least
      // known
@@ -382,34 +680,69 @@ namespace Realm {
 
      uop->dispatch(this, true /* ok to run in this thread */);
     } else {
+     size_t total_pieces = 0;
+     for (size_t i = 0; i < field_pieces.size(); i++)
+      total_pieces += field_pieces[i].size();
      for (size_t i = 0; i < preimages.size(); i++)
       SparsityMapImpl<N, T>::lookup(preimages[i])
-          ->set_contributor_count(domain_transform.ptr_data.size() +
-                                  domain_transform.range_data.size());
-
-     for (size_t i = 0; i < domain_transform.ptr_data.size(); i++) {
-      PreimageMicroOp<N, T, N2, T2> *uop = new PreimageMicroOp<N, T, N2, T2>(
-          parent, domain_transform.ptr_data[i].index_space,
-          domain_transform.ptr_data[i].inst,
-          domain_transform.ptr_data[i].field_offset, false /*ptrs*/);
-      for (size_t j = 0; j < targets.size(); j++)
-       uop->add_sparsity_output(targets[j], preimages[j]);
-      uop->dispatch(this, true /* ok to run in this thread */);
-     }
+          ->set_contributor_count(total_pieces);
 
-     for (size_t i = 0; i < domain_transform.range_data.size(); i++) {
-      PreimageMicroOp<N, T, N2, T2> *uop = new PreimageMicroOp<N, T, N2, T2>(
-          parent, domain_transform.range_data[i].index_space,
-          domain_transform.range_data[i].inst,
-          domain_transform.range_data[i].field_offset, true /*ranges*/);
-      for (size_t j = 0; j < targets.size(); j++)
-       uop->add_sparsity_output(targets[j], preimages[j]);
-      uop->dispatch(this, true /* ok to run in this thread */);
-     }
+     std::set<int> all_targets;
+     for (size_t j = 0; j < targets.size(); j++)
+      all_targets.insert(j);
+     for (size_t i = 0; i < field_pieces.size(); i++)
+      launch_microops(i, all_targets, true /* ok to run in this thread */);
     }
    }
   }
 
+  template <int N, typename T, int N2, typename T2>
+  void PreimageOperation<N,T,N2,T2>::compute_field_pieces(void)
+  {
+    field_pieces.resize(domain_transform.ptr_data.size() +
+			domain_transform.range_data.size());
+    for(size_t i = 0; i < domain_transform.ptr_data.size(); i++)
+      split_scan_space(domain_transform.ptr_data[i].index_space,
+		       DeppartConfig::cfg_image_split_size,
+		       field_pieces[i]);
+    for(size_t i = 0; i < domain_transform.range_data.size(); i++)
+      split_scan_space(domain_transform.range_data[i].index_space,
+		       DeppartConfig::cfg_image_split_size,
+		       field_pieces[i + domain_transform.ptr_data.size()]);
+  }
+
+  template <int N, typename T, int N2, typename T2>
+  void PreimageOperation<N,T,N2,T2>::launch_microops(size_t field_idx,
+						     const std::set<int>& outputs,
+						     bool inline_ok)
+  {
+    bool is_ranged = (field_idx >= domain_transform.ptr_data.size());
+    RegionInstance inst;
+    size_t field_offset;
+    if(is_ranged) {
+      size_t rel_idx = field_idx - domain_transform.ptr_data.size();
+      inst = domain_transform.range_data[rel_idx].inst;
+      field_offset = domain_transform.range_data[rel_idx].field_offset;
+    } else {
+      inst = domain_transform.ptr_data[field_idx].inst;
+      field_offset = domain_transform.ptr_data[field_idx].field_offset;
+    }
+
+    // one microop per piece of the field data's index space
+    for(size_t k = 0; k < field_pieces[field_idx].size(); k++) {
+      PreimageMicroOp<N,T,N2,T2> *uop = new PreimageMicroOp<N,T,N2,T2>(parent,
+								       field_pieces[field_idx][k],
+								       inst,
+								       field_offset,
+								       is_ranged);
+      for(std::set<int>::const_iterator it = outputs.begin();
+	  it != outputs.end();
+	  it++)
+	uop->add_sparsity_output(targets[*it], preimages[*it]);
+      uop->dispatch(this, inline_ok);
+    }
+  }
+
   template <int N, typename T, int N2, typename T2>
   void PreimageOperation<N,T,N2,T2>::provide_sparse_image(int index, const Rect<N2,T2> *rects, size_t count)
   {
@@ -431,36 +764,16 @@ namespace Realm {
       overlap_tester->test_overlap(rects, count, overlaps);
       if((size_t)index < domain_transform.ptr_data.size()) {
 	log_part.info() << "image of ptr_data[" << index << "] overlaps " << overlaps.size() << " targets";
-        PreimageMicroOp<N, T, N2, T2> *uop = new PreimageMicroOp<N, T, N2, T2>(
-            parent, domain_transform.ptr_data[index].index_space,
-            domain_transform.ptr_data[index].inst,
-            domain_transform.ptr_data[index].field_offset, false /*ptrs*/);
-        for(std::set<int>::const_iterator it2 = overlaps.begin();
-	    it2 != overlaps.end();
-	    it2++) {
-	  int j = *it2;
-	  contrib_counts[j].fetch_add(1);
-	  uop->add_sparsity_output(targets[j], preimages[j]);
-	}
-	uop->dispatch(this, false /* do not run in this thread */);
       } else {
 	size_t rel_index = index - domain_transform.ptr_data.size();
 	assert(rel_index < domain_transform.range_data.size());
 	log_part.info() << "image of range_data[" << rel_index << "] overlaps " << overlaps.size() << " targets";
-        PreimageMicroOp<N, T, N2, T2> *uop = new PreimageMicroOp<N, T, N2, T2>(
-            parent, domain_transform.range_data[rel_index].index_space,
-            domain_transform.range_data[rel_index].inst,
-            domain_transform.range_data[rel_index].field_offset,
-            true /*ranges*/);
-        for(std::set<int>::const_iterator it2 = overlaps.begin();
-	    it2 != overlaps.end();
-	    it2++) {
-	  int j = *it2;
-	  contrib_counts[j].fetch_add(1);
-	  uop->add_sparsity_output(targets[j], preimages[j]);
-	}
-	uop->dispatch(this, false /* do not run in this thread */);
       }
+      for(std::set<int>::const_iterator it2 = overlaps.begin();
+	  it2 != overlaps.end();
+	  it2++)
+	contrib_counts[*it2].fetch_add(field_pieces[index].size());
+      launch_microops(index, overlaps, false /* do not run in this thread */);
 
       // if these were the last sparse images, we can now set the contributor counts
       int v = remaining_sparse_images.fetch_sub(1) - 1;
@@ -498,38 +811,16 @@ namespace Realm {
 	overlap_tester->test_overlap(&it->second[0], it->second.size(), overlaps);
 	if(idx < domain_transform.ptr_data.size()) {
 	  log_part.info() << "image of ptr_data[" << idx << "] overlaps " << overlaps.size() << " targets";
-          PreimageMicroOp<N, T, N2, T2> *uop =
-              new PreimageMicroOp<N, T, N2, T2>(
-                  parent, domain_transform.ptr_data[idx].index_space,
-                  domain_transform.ptr_data[idx].inst,
-                  domain_transform.ptr_data[idx].field_offset, false /*ptrs*/);
-          for(std::set<int>::const_iterator it2 = overlaps.begin();
-	      it2 != overlaps.end();
-	      it2++) {
-	    int j = *it2;
-	    contrib_counts[j].fetch_add(1);
-	    uop->add_sparsity_output(targets[j], preimages[j]);
-	  }
-	  uop->dispatch(this, true /* ok to run in this thread */);
 	} else {
 	  size_t rel_index = idx - domain_transform.ptr_data.size();
 	  assert(rel_index < domain_transform.range_data.size());
 	  log_part.info() << "image of range_data[" << rel_index << "] overlaps " << overlaps.size() << " targets";
-          PreimageMicroOp<N, T, N2, T2> *uop =
-              new PreimageMicroOp<N, T, N2, T2>(
-                  parent, domain_transform.range_data[rel_index].index_space,
-                  domain_transform.range_data[rel_index].inst,
-                  domain_transform.range_data[rel_index].field_offset,
-                  true /*ranges*/);
-          for(std::set<int>::const_iterator it2 = overlaps.begin();
-	      it2 != overlaps.end();
-	      it2++) {
-	    int j = *it2;
-	    contrib_counts[j].fetch_add(1);
-	    uop->add_sparsity_output(targets[j], preimages[j]);
-	  }
-	  uop->dispatch(this, true /* ok to run in this thread */);
 	}
+	for(std::set<int>::const_iterator it2 = overlaps.begin();
+	    it2 != overlaps.end();
+	    it2++)
+	  contrib_counts[*it2].fetch_add(field_pieces[idx].size());
+	launch_microops(idx, overlaps, true /* ok to run in this thread */);
       }
 
       // if these were the last sparse images, we can now set the contributor counts
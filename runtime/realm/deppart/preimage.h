@@ -22,6 +22,9 @@
 
 namespace Realm {
 
+  template <int N, typename T, int N2, typename T2>
+  class PreimageInverseIndex;
+
   template <int N, typename T, int N2, typename T2>
   class PreimageMicroOp : public PartitioningMicroOp {
   public:
@@ -58,6 +61,13 @@ namespace Realm {
     template <typename BM>
     void populate_bitmasks_ranges(std::map<int, BM *>& bitmasks);
 
+    // builds an inverse index of the field data for reuse by later preimages
+    PreimageInverseIndex<N,T,N2,T2> *build_inverse_index(void);
+
+    template <typename BM>
+    void populate_bitmasks_from_index(const PreimageInverseIndex<N,T,N2,T2>& index,
+				      std::map<int, BM *>& bitmasks);
+
     IndexSpace<N,T> parent_space, inst_space;
     RegionInstance inst;
     size_t field_offset;
@@ -98,6 +108,15 @@ namespace Realm {
   protected:
     static ActiveMessageHandlerReg<ApproxImageResponseMessage<PreimageOperation<N,T,N2,T2> > > areg;
 
+    // splits each field data index space into the pieces scanned by separate
+    //  microops
+    void compute_field_pieces(void);
+
+    // launches microops for every piece of the given field data (ptr_data
+    //  first, then range_data) that contribute to the given outputs
+    void launch_microops(size_t field_idx, const std::set<int>& outputs,
+			 bool inline_ok);
+
     IndexSpace<N, T> parent;
     DomainTransform<N2, T2, N, T> domain_transform;
     std::vector<IndexSpace<N2, T2> > targets;
@@ -108,6 +127,7 @@ namespace Realm {
     atomic<int> remaining_sparse_images;
     std::vector<atomic<int> > contrib_counts;
     AsyncMicroOp *dummy_overlap_uop;
+    std::vector<std::vector<IndexSpace<N, T> > > field_pieces;
   };
 
   template <typename T>
@@ -201,29 +201,169 @@ namespace Realm {
 	}
       }
     } else {
-      const std::vector<SparsityMapEntry<N,T> >& entries1 = get_entries();
-      const std::vector<SparsityMapEntry<N,T> >& entries2 = other->get_entries();
+      // walk the entries of whichever map has fewer and probe the other
+      //  one, which can use its spatial index (if it has one)
+      SparsityMapPublicImpl<N,T> *probe = this;
+      SparsityMapPublicImpl<N,T> *target = other;
+      if(get_entries().size() > other->get_entries().size())
+	std::swap(probe, target);
+      const std::vector<SparsityMapEntry<N,T> >& entries1 = probe->get_entries();
       for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it1 = entries1.begin();
 	  it1 != entries1.end();
 	  it1++) {
 	Rect<N,T> isect = it1->bounds.intersection(bounds);
 	if(isect.empty())
 	  continue;
-	for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it2 = entries2.begin();
-	    it2 != entries2.end();
-	    it2++) {
-	  if(!it2->bounds.overlaps(isect)) continue;
-	  // TODO: handle further sparsity in either side
-	  assert(!it1->sparsity.exists() && (it1->bitmap == 0) &&
-		 !it2->sparsity.exists() && (it2->bitmap == 0));
+	// TODO: handle further sparsity in either side
+	assert(!it1->sparsity.exists());
+	if(it1->bitmap != 0) {
+	  size_t pos = 0;
+	  Rect<N,T> run;
+	  while(it1->bitmap->next_run(isect, pos, run))
+	    if(target->contains_any(run))
+	      return true;
+	} else if(target->contains_any(isect))
 	  return true;
-	}
       }
     }
 
     return false;
   }
 
+  // orders entries by their lower bound in a single dimension
+  template <int N, typename T>
+  class EntryIndexCompare {
+  public:
+    EntryIndexCompare(const std::vector<SparsityMapEntry<N,T> >& _entries,
+		      int _dim)
+      : entries(_entries), dim(_dim) {}
+    bool operator()(unsigned a, unsigned b) const
+    {
+      return ((entries[a].bounds.lo[dim] < entries[b].bounds.lo[dim]) ||
+	      ((entries[a].bounds.lo[dim] == entries[b].bounds.lo[dim]) &&
+	       (entries[a].bounds.hi[dim] < entries[b].bounds.hi[dim])));
+    }
+  protected:
+    const std::vector<SparsityMapEntry<N,T> >& entries;
+    int dim;
+  };
+
+  // recursively builds the index nodes for entry_order[first, first + count)
+  //  by splitting at the median lower bound of the dimension in which the
+  //  lower bounds are most spread out
+  template <int N, typename T>
+  static void build_index_subtree(const std::vector<SparsityMapEntry<N,T> >& entries,
+				  std::vector<unsigned>& entry_order,
+				  std::vector<SparsityMapIndexNode<N,T> >& nodes,
+				  unsigned first, unsigned count,
+				  unsigned depth, size_t max_per_leaf,
+				  unsigned max_depth)
+  {
+    size_t idx = nodes.size();
+    nodes.resize(idx + 1);
+
+    Rect<N,T> bounds = entries[entry_order[first]].bounds;
+    Point<N,T> lo_min = bounds.lo;
+    Point<N,T> lo_max = bounds.lo;
+    for(unsigned i = 1; i < count; i++) {
+      const Rect<N,T>& r = entries[entry_order[first + i]].bounds;
+      bounds = bounds.union_bbox(r);
+      for(int j = 0; j < N; j++) {
+	if(r.lo[j] < lo_min[j]) lo_min[j] = r.lo[j];
+	if(r.lo[j] > lo_max[j]) lo_max[j] = r.lo[j];
+      }
+    }
+    nodes[idx].bounds = bounds;
+
+    // pick the split dimension - do the subtraction in floating point to
+    //  avoid overflow for wide coordinate types
+    int split_dim = -1;
+    double best_spread = 0;
+    for(int j = 0; j < N; j++) {
+      double spread = double(lo_max[j]) - double(lo_min[j]);
+      if(spread > best_spread) {
+	best_spread = spread;
+	split_dim = j;
+      }
+    }
+
+    if((count <= max_per_leaf) || (depth >= max_depth) || (split_dim < 0)) {
+      nodes[idx].first = first;
+      nodes[idx].count = count;
+      return;
+    }
+
+    unsigned left_count = count >> 1;
+    std::nth_element(entry_order.begin() + first,
+		     entry_order.begin() + first + left_count,
+		     entry_order.begin() + first + count,
+		     EntryIndexCompare<N,T>(entries, split_dim));
+
+    build_index_subtree(entries, entry_order, nodes,
+			first, left_count,
+			depth + 1, max_per_leaf, max_depth);
+    // don't hold a reference across the recursion - 'nodes' may reallocate
+    nodes[idx].first = nodes.size();
+    nodes[idx].count = 0;
+    build_index_subtree(entries, entry_order, nodes,
+			first + left_count, count - left_count,
+			depth + 1, max_per_leaf, max_depth);
+  }
+
+  template <int N, typename T>
+  void SparsityMapPublicImpl<N,T>::build_entry_index(void)
+  {
+    entry_index.clear();
+    entry_order.clear();
+
+    // 1-D maps are binary searched instead (see IndexSpace::contains)
+    if((N == 1) || (entries.size() < MIN_INDEXED_ENTRIES))
+      return;
+
+    entry_order.resize(entries.size());
+    for(size_t i = 0; i < entries.size(); i++)
+      entry_order[i] = i;
+    // a median-split tree has fewer than 2 * (n / leaf size) nodes
+    entry_index.reserve(2 * (entries.size() / MAX_ENTRIES_PER_LEAF) + 1);
+    build_index_subtree(entries, entry_order, entry_index,
+			0, entries.size(),
+			0, MAX_ENTRIES_PER_LEAF, MAX_INDEX_DEPTH);
+  }
+
+  template <int N, typename T>
+  void SparsityMapPublicImpl<N,T>::find_overlapping_entries(const Rect<N,T>& r,
+							    std::vector<size_t>& found)
+  {
+    if(entry_index.empty()) {
+      for(size_t i = 0; i < entries.size(); i++)
+	if(entries[i].bounds.overlaps(r))
+	  found.push_back(i);
+      return;
+    }
+
+    unsigned stack[MAX_INDEX_DEPTH + 1];
+    unsigned depth = 0;
+    unsigned cur = 0;
+    while(true) {
+      const SparsityMapIndexNode<N,T>& node = entry_index[cur];
+      if(node.bounds.overlaps(r)) {
+	if(node.count == 0) {
+	  stack[depth++] = node.first;
+	  cur++;
+	  continue;
+	}
+	for(unsigned i = 0; i < node.count; i++) {
+	  unsigned e = entry_order[node.first + i];
+	  if(entries[e].bounds.overlaps(r))
+	    found.push_back(e);
+	}
+      }
+      if(depth == 0)
+	break;
+      cur = stack[--depth];
+    }
+  }
+
   template <int N, typename T>
   class SparsityMapToRectAdapter {
   public:
@@ -374,19 +514,43 @@ namespace Realm {
     // start with a scan over all of our pieces see which ones are within
     //  the given bounds
     std::vector<size_t> in_bounds;
-    in_bounds.reserve(entries.size());
-    for(size_t i = 0; i < entries.size(); i++) {
-      assert(!entries[i].sparsity.exists() && (entries[i].bitmap == 0));
-      if(bounds.overlaps(entries[i].bounds))
-	in_bounds.push_back(i);
+    if(entry_index.empty()) {
+      in_bounds.reserve(entries.size());
+      for(size_t i = 0; i < entries.size(); i++) {
+	assert(!entries[i].sparsity.exists());
+	if(bounds.overlaps(entries[i].bounds))
+	  in_bounds.push_back(i);
+      }
+    } else {
+      // the index returns matches in tree order - the rest of this code
+      //  expects them in entry order
+      find_overlapping_entries(bounds, in_bounds);
+      std::sort(in_bounds.begin(), in_bounds.end());
+      for(size_t i = 0; i < in_bounds.size(); i++)
+	assert(!entries[in_bounds[i]].sparsity.exists());
     }
+
+    // the rest of this works on the (intersected) rectangles to cover - a
+    //  bitmap entry contributes each of its runs of points (which keeps a 1-D
+    //  list sorted)
+    std::vector<Rect<N,T> > pieces;
+    pieces.reserve(in_bounds.size());
+    for(size_t i = 0; i < in_bounds.size(); i++) {
+      const SparsityMapEntry<N,T>& e = entries[in_bounds[i]];
+      if(e.bitmap != 0) {
+	size_t pos = 0;
+	Rect<N,T> run;
+	while(e.bitmap->next_run(bounds, pos, run))
+	  pieces.push_back(run);
+      } else
+	pieces.push_back(bounds.intersection(e.bounds));
+    }
+
     // does this fit within the 'max_rects' constraint?
-    if((max_rects == 0) || (in_bounds.size() <= max_rects)) {
+    if((max_rects == 0) || (pieces.size() <= max_rects)) {
       // yay!  copy (intersected) rectangles over and we're done - there was
       //  no storage overhead
-      covering.resize(in_bounds.size());
-      for(size_t i = 0; i < in_bounds.size(); i++)
-	covering[i] = bounds.intersection(entries[in_bounds[i]].bounds);
+      covering.swap(pieces);
       return true;
     }
 
@@ -400,12 +564,11 @@ namespace Realm {
     if(max_rects == 1) {
       // compute our actual bounding box, which may be smaller than what
       //  we were given
-      Rect<N,T> bbox = bounds.intersection(entries[in_bounds[0]].bounds);
+      Rect<N,T> bbox = pieces[0];
       size_t vol = bbox.volume();
-      for(size_t i = 1; i < in_bounds.size(); i++) {
-	Rect<N,T> r = bounds.intersection(entries[in_bounds[i]].bounds);
-	bbox = bbox.union_bbox(r);
-	vol += r.volume();
+      for(size_t i = 1; i < pieces.size(); i++) {
+	bbox = bbox.union_bbox(pieces[i]);
+	vol += pieces[i].volume();
       }
       // check overhead limit
       if(max_overhead >= 0) {
@@ -424,10 +587,8 @@ namespace Realm {
       size_t max_waste = 0;
       if(max_overhead >= 0) {
 	size_t vol = 0;
-	for(size_t i = 0; i < in_bounds.size(); i++) {
-	  Rect<N,T> r = bounds.intersection(entries[in_bounds[i]].bounds);
-	  vol += r.volume();
-	}
+	for(size_t i = 0; i < pieces.size(); i++)
+	  vol += pieces[i].volume();
 	// round up to be as permissive as possible
 	max_waste = (vol * max_overhead + 99) / 100;
       }
@@ -436,7 +597,7 @@ namespace Realm {
 			      0 /*merge_dim*/,
 			      max_waste,
 			      max_rects,
-			      SparsityMapToRectAdapter<N,T>(entries),
+			      pieces,
 			      merged);
       if(ok) {
 	covering.swap(merged);
@@ -449,13 +610,13 @@ namespace Realm {
       // along the way, pay attention to which dimensions have variability
       //  across the rectangles in order to detect cases that are actually
       //  N-D masquerading as 1-D, since we can handle those optimally
-      std::vector<Rect<N,T> > to_cover(in_bounds.size());
+      std::vector<Rect<N,T> > to_cover;
+      to_cover.swap(pieces);
       size_t vol = 0;
       int mismatched_dim = -1;
       int num_mismatched = 0;
-      for(size_t i = 0; i < in_bounds.size(); i++) {
-	Rect<N,T> r = bounds.intersection(entries[in_bounds[i]].bounds);
-	to_cover[i] = r;
+      for(size_t i = 0; i < to_cover.size(); i++) {
+	const Rect<N,T>& r = to_cover[i];
 	vol += r.volume();
 	if((i > 0) && (num_mismatched < 2))
 	  for(int j = 0; j < N; j++)
@@ -679,6 +840,15 @@ namespace Realm {
     , sizeof_precise(0)
   {}
 
+  template <int N, typename T>
+  SparsityMapImpl<N,T>::~SparsityMapImpl(void)
+  {
+    // bitmaps are owned by the entries that point at them
+    for(size_t i = 0; i < this->entries.size(); i++)
+      if(this->entries[i].bitmap)
+	delete this->entries[i].bitmap;
+  }
+
   template <int N, typename T>
   inline /*static*/ SparsityMapImpl<N,T> *SparsityMapImpl<N,T>::lookup(SparsityMap<N,T> sparsity)
   {
@@ -1224,14 +1394,18 @@ namespace Realm {
       
       if(!this->entries_valid.load_acquire())
         assert(false);
-      // scan the entry list, sending bitmaps first and making a list of rects
+      // scan the entry list, making a list of rects to send
       std::vector<Rect<N,T> > rects;
       for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it = this->entries.begin();
 	  it != this->entries.end();
 	  it++) {
 	if(it->bitmap) {
-	  // TODO: send bitmap
-	  assert(0);
+	  // bitmaps are sent as their runs of points - the receiver will
+	  //  re-encode them when it finalizes its copy
+	  size_t pos = 0;
+	  Rect<N,T> run;
+	  while(it->bitmap->next_run(it->bounds, pos, run))
+	    rects.push_back(run);
 	}
 	else if(it->sparsity.exists()) {
 	  // TODO: ?
@@ -1427,6 +1601,223 @@ namespace Realm {
       return false;
   }
 
+  // a candidate for bitmap encoding - (part of) an entry and the tile that
+  //  contains it
+  template <int N, typename T>
+  struct BitmapCandidate {
+    uint64_t tile[N];
+    size_t idx;
+    Rect<N,T> piece;
+    HierarchicalBitMap<N,T> *bitmap;  // set if the tile is encoded
+    bool bitmap_goes_here;
+
+    bool same_tile(const BitmapCandidate<N,T>& rhs) const
+    {
+      for(int i = 0; i < N; i++)
+	if(tile[i] != rhs.tile[i])
+	  return false;
+      return true;
+    }
+
+    // orders by tile and then entry index
+    struct ByTile {
+      bool operator()(const BitmapCandidate<N,T>& lhs,
+		      const BitmapCandidate<N,T>& rhs) const
+      {
+	for(int i = N - 1; i >= 0; i--)
+	  if(lhs.tile[i] != rhs.tile[i])
+	    return (lhs.tile[i] < rhs.tile[i]);
+	return (lhs.idx < rhs.idx);
+      }
+    };
+
+    // orders by entry index and then tile
+    struct ByEntry {
+      bool operator()(const BitmapCandidate<N,T>& lhs,
+		      const BitmapCandidate<N,T>& rhs) const
+      {
+	if(lhs.idx != rhs.idx)
+	  return (lhs.idx < rhs.idx);
+	for(int i = N - 1; i >= 0; i--)
+	  if(lhs.tile[i] != rhs.tile[i])
+	    return (lhs.tile[i] < rhs.tile[i]);
+	return false;
+      }
+    };
+  };
+
+  // replaces clusters of small entries with bitmap entries when a bitmap is
+  //  much more compact than the equivalent list of rectangles - the space is
+  //  divided into tiles of 2^LOG2_TILE_POINTS points, and the entries (or
+  //  pieces of small entries) within a tile are encoded in that tile's bitmap
+  template <int N, typename T>
+  static void encode_bitmap_entries(std::vector<SparsityMapEntry<N,T> >& entries)
+  {
+    static const size_t MIN_ENTRIES = 64;
+    static const int LOG2_TILE_POINTS = 14;
+    // entries up to this size are split at tile boundaries - larger ones
+    //  stay as they are
+    static const size_t MAX_SPLIT_VOLUME = 64;
+    // limit on bounds checks between bitmaps and the (large) entries that
+    //  straddle tiles, which are only needed for N > 1
+    static const size_t MAX_OVERLAP_CHECKS = 1 << 24;
+
+    if(entries.size() < MIN_ENTRIES)
+      return;
+
+    int tile_shift[N];
+    for(int i = 0; i < N; i++)
+      tile_shift[i] = ((LOG2_TILE_POINTS / N) +
+		       ((i < (LOG2_TILE_POINTS % N)) ? 1 : 0));
+
+    // tile coordinates are computed relative to the low corner of all the
+    //  entries, with unsigned math to avoid overflow
+    Point<N,T> origin = entries[0].bounds.lo;
+    for(size_t i = 1; i < entries.size(); i++)
+      for(int j = 0; j < N; j++)
+	if(entries[i].bounds.lo[j] < origin[j])
+	  origin[j] = entries[i].bounds.lo[j];
+
+    std::vector<BitmapCandidate<N,T> > candidates;
+    std::vector<size_t> straddlers;
+    candidates.reserve(entries.size());
+    for(size_t i = 0; i < entries.size(); i++) {
+      const SparsityMapEntry<N,T>& e = entries[i];
+      if(e.sparsity.exists() || (e.bitmap != 0))
+	continue;
+      uint64_t tlo[N], thi[N];
+      bool single_tile = true;
+      for(int j = 0; j < N; j++) {
+	tlo[j] = (uint64_t(e.bounds.lo[j]) - uint64_t(origin[j])) >> tile_shift[j];
+	thi[j] = (uint64_t(e.bounds.hi[j]) - uint64_t(origin[j])) >> tile_shift[j];
+	if(tlo[j] != thi[j])
+	  single_tile = false;
+      }
+      if(!single_tile && (e.bounds.volume() > MAX_SPLIT_VOLUME)) {
+	straddlers.push_back(i);
+	continue;
+      }
+      // one candidate per tile touched by the entry
+      BitmapCandidate<N,T> c;
+      c.idx = i;
+      c.bitmap = 0;
+      c.bitmap_goes_here = false;
+      for(int j = 0; j < N; j++)
+	c.tile[j] = tlo[j];
+      while(true) {
+	// clip to the tile, again relative to the origin
+	for(int j = 0; j < N; j++) {
+	  uint64_t rel_lo = uint64_t(e.bounds.lo[j]) - uint64_t(origin[j]);
+	  uint64_t rel_hi = uint64_t(e.bounds.hi[j]) - uint64_t(origin[j]);
+	  uint64_t tile_lo = c.tile[j] << tile_shift[j];
+	  uint64_t tile_hi = tile_lo + ((uint64_t(1) << tile_shift[j]) - 1);
+	  c.piece.lo[j] = T(uint64_t(origin[j]) + std::max(rel_lo, tile_lo));
+	  c.piece.hi[j] = T(uint64_t(origin[j]) + std::min(rel_hi, tile_hi));
+	}
+	candidates.push_back(c);
+	int j = 0;
+	while(j < N) {
+	  if(c.tile[j] < thi[j]) {
+	    c.tile[j]++;
+	    break;
+	  }
+	  c.tile[j] = tlo[j];
+	  j++;
+	}
+	if(j >= N) break;
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(),
+	      typename BitmapCandidate<N,T>::ByTile());
+
+    size_t overlap_checks = 0;
+    size_t num_bitmaps = 0;
+    size_t group_start = 0;
+    while(group_start < candidates.size()) {
+      size_t group_end = group_start + 1;
+      Rect<N,T> bbox = candidates[group_start].piece;
+      while((group_end < candidates.size()) &&
+	    candidates[group_end].same_tile(candidates[group_start])) {
+	bbox = bbox.union_bbox(candidates[group_end].piece);
+	group_end++;
+      }
+      size_t count = group_end - group_start;
+
+      // require the bitmap to be at least twice as compact
+      size_t words = (bbox.volume() + 63) >> 6;
+      size_t bitmap_bytes = (sizeof(HierarchicalBitMap<N,T>) +
+			     (words + ((words + 63) >> 6)) * sizeof(uint64_t));
+      bool use_bitmap = ((count > 1) &&
+			 ((2 * bitmap_bytes) <= (count * sizeof(SparsityMapEntry<N,T>))));
+
+      // entries must stay disjoint - in 1-D, a large entry that straddles a
+      //  tile boundary cannot overlap the bounding box of the pieces within
+      //  the tile, but in N-D we have to check
+      if(use_bitmap && (N > 1)) {
+	overlap_checks += straddlers.size();
+	if(overlap_checks > MAX_OVERLAP_CHECKS)
+	  break;
+	for(size_t i = 0; i < straddlers.size(); i++)
+	  if(entries[straddlers[i]].bounds.overlaps(bbox)) {
+	    use_bitmap = false;
+	    break;
+	  }
+      }
+
+      if(use_bitmap) {
+	HierarchicalBitMap<N,T> *bitmap = new HierarchicalBitMap<N,T>(bbox);
+	for(size_t i = group_start; i < group_end; i++) {
+	  bitmap->set_rect(candidates[i].piece);
+	  candidates[i].bitmap = bitmap;
+	}
+	// candidates are sorted by entry index within a tile
+	candidates[group_start].bitmap_goes_here = true;
+	num_bitmaps++;
+      }
+
+      group_start = group_end;
+    }
+
+    if(num_bitmaps == 0)
+      return;
+
+    // rebuild the entry list, putting each bitmap where its first entry was -
+    //  an entry that was split is only replaced by its pieces if at least one
+    //  of them went into a bitmap
+    // in 1-D, all the entries touching a tile are contiguous, so the list
+    //  stays sorted
+    std::sort(candidates.begin(), candidates.end(),
+	      typename BitmapCandidate<N,T>::ByEntry());
+    std::vector<SparsityMapEntry<N,T> > new_entries;
+    new_entries.reserve(entries.size());
+    size_t cpos = 0;
+    for(size_t i = 0; i < entries.size(); i++) {
+      size_t cfirst = cpos;
+      bool any_bitmap = false;
+      while((cpos < candidates.size()) && (candidates[cpos].idx == i)) {
+	if(candidates[cpos].bitmap != 0)
+	  any_bitmap = true;
+	cpos++;
+      }
+      if(!any_bitmap) {
+	new_entries.push_back(entries[i]);
+	continue;
+      }
+      for(size_t j = cfirst; j < cpos; j++) {
+	const BitmapCandidate<N,T>& c = candidates[j];
+	if(c.bitmap == 0) {
+	  new_entries.push_back(entries[i]);
+	  new_entries.back().bounds = c.piece;
+	} else if(c.bitmap_goes_here) {
+	  new_entries.push_back(entries[i]);
+	  new_entries.back().bounds = c.bitmap->get_bounds();
+	  new_entries.back().bitmap = c.bitmap;
+	}
+      }
+    }
+    entries.swap(new_entries);
+  }
+
   template <int N, typename T>
   void SparsityMapImpl<N,T>::finalize(void)
   {
@@ -1482,6 +1873,10 @@ namespace Realm {
         merge_dim--;
     }
 
+    // clusters of tiny entries are much more compact as bitmaps
+    if(DeppartConfig::cfg_enable_bitmaps)
+      encode_bitmap_entries(this->entries);
+
     // now that we've got our entries nice and tidy, build a bounded approximation of them
     if(true /*ID(me).sparsity_creator_node() == Network::my_node_id*/) {
       assert(!this->approx_valid.load());
@@ -1489,6 +1884,10 @@ namespace Realm {
       this->approx_valid.store_release(true);
     }
 
+    // the entries are final, so build the spatial index before anybody can
+    //  see them
+    this->build_entry_index();
+
     {
       LoggerMessage msg = log_part.info();
       if(msg.is_active()) {
@@ -34,6 +34,7 @@ namespace Realm {
   class SparsityMapImpl : public SparsityMapPublicImpl<N,T> {
   public:
     SparsityMapImpl(SparsityMap<N,T> _me);
+    ~SparsityMapImpl(void);
 
     // actual implementation - SparsityMapPublicImpl's version just calls this one
     Event make_valid(bool precise = true);
@@ -367,6 +367,8 @@ namespace Realm {
     // if non-zero, eagerly checks deferred user event triggers for loops up to the
     //  specified limit
     int event_loop_detection_limit = 0;
+
+    int event_trigger_batch_size = 16;
   };
 
   void UserEvent::trigger(Event wait_on, bool ignore_faults) const
@@ -510,7 +512,11 @@ namespace Realm {
 
   EventTriggerNotifier::EventTriggerNotifier()
     : BackgroundWorkItem("event triggers")
-  {}
+    , draining(false)
+  {
+    // anything waiting on these events is stalled until we get to them
+    set_latency_sensitive();
+  }
 
   void EventTriggerNotifier::trigger_event_waiters(EventWaiter::EventWaiterList& to_trigger,
 						   bool poisoned,
@@ -536,39 +542,54 @@ namespace Realm {
       nested_poisoned = &second_list;
     }
 
-    do {
-      // TODO: triggers are fast - consider doing more than one per time check?
-      if(!nested_normal->empty()) {
-	EventWaiter *w = nested_normal->pop_front();
-	w->event_triggered(false /*!poisoned*/, trigger_until);
-      } else if(!nested_poisoned->empty()) {
-	EventWaiter *w = nested_poisoned->pop_front();
-	w->event_triggered(true /*poisoned*/, trigger_until);
-      } else {
-	// list is exhausted - we can return right away (after removing
-	//   trigger-catching lists)
-	nested_normal = nested_poisoned = 0;
-	return;
-      }
-    } while(!trigger_until.is_expired());
+    if(drain_waiters(*nested_normal, *nested_poisoned, trigger_until)) {
+      // list is exhausted - we can return right away (after removing
+      //   trigger-catching lists)
+      nested_normal = nested_poisoned = 0;
+      return;
+    }
 
-    // do we have any triggers we want to defer?
-    if(!nested_normal->empty() || !nested_poisoned->empty()) {
-      bool was_empty;
-      {
-	AutoLock<> al(mutex);
-	was_empty = delayed_normal.empty() && delayed_poisoned.empty();
-	delayed_normal.absorb_append(*nested_normal);
-	delayed_poisoned.absorb_append(*nested_poisoned);
-      }
-      if(was_empty)
-	make_active();
+    // defer the rest - this only needs to activate the background work item
+    //  if nothing else is deferred and it isn't already draining
+    bool need_activation;
+    {
+      AutoLock<> al(mutex);
+      need_activation = (delayed_normal.empty() && delayed_poisoned.empty() &&
+			 !draining);
+      delayed_normal.absorb_append(*nested_normal);
+      delayed_poisoned.absorb_append(*nested_poisoned);
     }
+    if(need_activation)
+      make_active();
 
     // done catching recursive event triggers
     nested_normal = nested_poisoned = 0;
   }
 
+  /*static*/ bool EventTriggerNotifier::drain_waiters(EventWaiter::EventWaiterList& normal,
+						      EventWaiter::EventWaiterList& poisoned,
+						      TimeLimit work_until)
+  {
+    // triggers are fast, so only look at the clock every so often (but
+    //  always do at least one batch)
+    int batch_size = std::max(Config::event_trigger_batch_size, 1);
+    while(true) {
+      for(int i = 0; i < batch_size; i++) {
+	if(!normal.empty()) {
+	  EventWaiter *w = normal.pop_front();
+	  w->event_triggered(false /*!poisoned*/, work_until);
+	} else if(!poisoned.empty()) {
+	  EventWaiter *w = poisoned.pop_front();
+	  w->event_triggered(true /*poisoned*/, work_until);
+	} else
+	  return true;
+      }
+
+      if(work_until.is_expired())
+	return (normal.empty() && poisoned.empty());
+    }
+  }
+
   bool EventTriggerNotifier::do_work(TimeLimit work_until)
   {
     // take the lock and grab both lists
@@ -577,52 +598,51 @@ namespace Realm {
       AutoLock<> al(mutex);
       todo_normal.swap(delayed_normal);
       todo_poisoned.swap(delayed_poisoned);
+      draining = true;
     }
 
     // any nested triggering should append to our list instead of recurse
     nested_normal = &todo_normal;
     nested_poisoned = &todo_poisoned;
 
-    // now trigger until we're out of time
-    do {
-      // TODO: triggers are fast - consider doing more than one per time check?
-      if(!todo_normal.empty()) {
-	EventWaiter *w = todo_normal.pop_front();
-	w->event_triggered(false /*!poisoned*/, work_until);
-      } else if(!todo_poisoned.empty()) {
-	EventWaiter *w = todo_poisoned.pop_front();
-	w->event_triggered(true /*poisoned*/, work_until);
-      } else
-	break;
-    } while(!work_until.is_expired());
+    // now trigger until we're out of time, picking up anything other
+    //  threads deferred in the mean time (they won't have reactivated us
+    //  while we're draining)
+    while(drain_waiters(todo_normal, todo_poisoned, work_until)) {
+      AutoLock<> al(mutex);
+      if(delayed_normal.empty() && delayed_poisoned.empty()) {
+	// all done - the next deferral will have to reactivate us
+	draining = false;
+	nested_normal = nested_poisoned = 0;
+	return false;
+      }
+      todo_normal.swap(delayed_normal);
+      todo_poisoned.swap(delayed_poisoned);
+    }
 
     // un-register nested trigger catchers
     nested_normal = nested_poisoned = 0;
 
-    // if we have anything left to do, prepend (using append+swap) them to
-    //  whatever got added by other threads while we were triggering stuff
-    if(!todo_normal.empty() || !todo_poisoned.empty()) {
-      bool was_empty;
-      {
-	AutoLock<> al(mutex);
-	was_empty = delayed_normal.empty() && delayed_poisoned.empty();
-	if(!todo_normal.empty()) {
-	  if(!delayed_normal.empty())
-	    todo_normal.absorb_append(delayed_normal);
-	  delayed_normal.swap(todo_normal);
-	}
-	if(!todo_poisoned.empty()) {
-	  if(!delayed_poisoned.empty())
-	    todo_poisoned.absorb_append(delayed_poisoned);
-	  delayed_poisoned.swap(todo_poisoned);
-	}
+    // we're out of time with work left to do, so prepend (using append+swap)
+    //  it to whatever got added by other threads while we were triggering
+    //  stuff
+    {
+      AutoLock<> al(mutex);
+      if(!todo_normal.empty()) {
+	if(!delayed_normal.empty())
+	  todo_normal.absorb_append(delayed_normal);
+	delayed_normal.swap(todo_normal);
+      }
+      if(!todo_poisoned.empty()) {
+	if(!delayed_poisoned.empty())
+	  todo_poisoned.absorb_append(delayed_poisoned);
+	delayed_poisoned.swap(todo_poisoned);
       }
-      if(was_empty)
-        return true;  // request requeuing to get more work done
+      draining = false;
     }
 
-    // no work left or already requeued
-    return false;
+    // nobody else could have requeued us while we were draining
+    return true;
   }
 
   /*static*/ REALM_THREAD_LOCAL EventWaiter::EventWaiterList *EventTriggerNotifier::nested_normal = 0;
@@ -79,9 +79,18 @@ namespace Realm {
       virtual bool do_work(TimeLimit work_until);
 
     protected:
+      // triggers waiters from both lists in batches, checking the time limit
+      //  between batches - returns true if both lists were exhausted
+      static bool drain_waiters(EventWaiter::EventWaiterList& normal,
+				EventWaiter::EventWaiterList& poisoned,
+				TimeLimit work_until);
+
       Mutex mutex;
       EventWaiter::EventWaiterList delayed_normal;
       EventWaiter::EventWaiterList delayed_poisoned;
+      // set while do_work is draining - deferred triggers are then picked
+      //  up by the running drain rather than reactivating this work item
+      bool draining;
 
       static REALM_THREAD_LOCAL EventWaiter::EventWaiterList *nested_normal;
       static REALM_THREAD_LOCAL EventWaiter::EventWaiterList *nested_poisoned;
@@ -38,6 +38,8 @@ namespace Realm {
 	os << ", inst=" << sd.inst;
       if(sd.redop_id != 0)
 	os << ", redop=" << sd.redop_id << (sd.red_fold ? "(fold)" : "(apply)");
+      if(sd.red_base_inst.exists())
+        os << ", base=" << sd.red_base_inst << "/" << sd.red_base_field_id;
       if(sd.serdez_id != 0)
 	os << ", serdez=" << sd.serdez_id;
       os << ", size=" << sd.size;
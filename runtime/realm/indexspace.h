@@ -55,6 +55,13 @@ namespace Realm {
     CopySrcDstField &set_indirect(int _indirect_index, FieldID _field_id,
 				  size_t _size, size_t _subfield_offset = 0);
     CopySrcDstField &set_redop(ReductionOpID _redop_id, bool _is_fold, bool exclusive = false);
+    // makes a reduction out-of-place: the destination is overwritten with
+    //  the result of reducing the source into the given base field (which
+    //  must match the destination's size and be in a CPU-accessible memory
+    //  on the destination's node) rather than being reduced into itself
+    CopySrcDstField &set_redop_base(RegionInstance _base_inst,
+                                    FieldID _base_field_id,
+                                    size_t _base_subfield_offset = 0);
     CopySrcDstField &set_serdez(CustomSerdezID _serdez_id);
     CopySrcDstField &set_fill(const void *_data, size_t _size);
     template <typename T>
@@ -67,6 +74,9 @@ namespace Realm {
     ReductionOpID redop_id;
     bool red_fold;
     bool red_exclusive;
+    RegionInstance red_base_inst;
+    FieldID red_base_field_id;
+    size_t red_base_subfield_offset;
     CustomSerdezID serdez_id;
     size_t subfield_offset;
     int indirect_index;
@@ -805,6 +815,7 @@ namespace Realm {
     // for iterating over SparsityMap's
     SparsityMapPublicImpl<N,T> *s_impl;
     size_t cur_entry;
+    size_t cur_bit;  // position within the current entry's bitmap (if any)
 
     IndexSpaceIterator(void);
     IndexSpaceIterator(const IndexSpace<N,T>& _space);
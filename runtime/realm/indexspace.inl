@@ -167,6 +167,9 @@ namespace Realm {
     , redop_id(0)
     , red_fold(false)
     , red_exclusive(false)
+    , red_base_inst(RegionInstance::NO_INST)
+    , red_base_field_id(FieldID(-1))
+    , red_base_subfield_offset(0)
     , serdez_id(0)
     , subfield_offset(0)
     , indirect_index(-1)
@@ -181,6 +184,9 @@ namespace Realm {
     , redop_id(copy_from.redop_id)
     , red_fold(copy_from.red_fold)
     , red_exclusive(copy_from.red_exclusive)
+    , red_base_inst(copy_from.red_base_inst)
+    , red_base_field_id(copy_from.red_base_field_id)
+    , red_base_subfield_offset(copy_from.red_base_subfield_offset)
     , serdez_id(copy_from.serdez_id)
     , subfield_offset(copy_from.subfield_offset)
     , indirect_index(copy_from.indirect_index)
@@ -213,6 +219,9 @@ namespace Realm {
     redop_id = copy_from.redop_id;
     red_fold = copy_from.red_fold;
     red_exclusive = copy_from.red_exclusive;
+    red_base_inst = copy_from.red_base_inst;
+    red_base_field_id = copy_from.red_base_field_id;
+    red_base_subfield_offset = copy_from.red_base_subfield_offset;
     serdez_id = copy_from.serdez_id;
     subfield_offset = copy_from.subfield_offset;
     indirect_index = copy_from.indirect_index;
@@ -276,6 +285,16 @@ namespace Realm {
     return *this;
   }
 
+  inline CopySrcDstField &CopySrcDstField::set_redop_base(RegionInstance _base_inst,
+                                                          FieldID _base_field_id,
+                                                          size_t _base_subfield_offset /*= 0*/)
+  {
+    red_base_inst = _base_inst;
+    red_base_field_id = _base_field_id;
+    red_base_subfield_offset = _base_subfield_offset;
+    return *this;
+  }
+
   inline CopySrcDstField &CopySrcDstField::set_serdez(CustomSerdezID _serdez_id)
   {
     serdez_id = _serdez_id;
@@ -309,6 +328,9 @@ namespace Realm {
 	 (s << v.size) &&
 	 (s << v.redop_id) &&
 	 (s << v.red_fold) &&
+	 (s << v.red_base_inst) &&
+	 (s << v.red_base_field_id) &&
+	 (s << v.red_base_subfield_offset) &&
 	 (s << v.serdez_id) &&
 	 (s << v.subfield_offset) &&
 	 (s << v.indirect_index))) return false;
@@ -333,6 +355,9 @@ namespace Realm {
 	 (s >> v.size) &&
 	 (s >> v.redop_id) &&
 	 (s >> v.red_fold) &&
+	 (s >> v.red_base_inst) &&
+	 (s >> v.red_base_field_id) &&
+	 (s >> v.red_base_subfield_offset) &&
 	 (s >> v.serdez_id) &&
 	 (s >> v.subfield_offset) &&
 	 (s >> v.indirect_index))) return false;
@@ -608,27 +633,13 @@ namespace Realm {
       if(e.sparsity.exists()) {
 	assert(0);
       }
-      if(e.bitmap != 0) {
-	assert(0);
-      }
+      if(e.bitmap != 0)
+	return e.bitmap->contains(p);
       return true;
     } else {
-      for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it = entries.begin();
-	  it != entries.end();
-	  it++) {
-	if(!it->bounds.contains(p)) continue;
-	if(it->sparsity.exists()) {
-	  assert(0);
-	} else if(it->bitmap != 0) {
-	  assert(0);
-	} else {
-	  return true;
-	}
-      }
+      // uses the sparsity map's spatial index if it has one
+      return impl->contains(p);
     }
-
-    // no entries matched, so the point is not contained in this space
-    return false;
   }
 
   template <int N, typename T>
@@ -640,25 +651,8 @@ namespace Realm {
 
     if(!dense()) {
       // test against sparsity map too
-      size_t total_volume = 0;
       SparsityMapPublicImpl<N,T> *impl = sparsity.impl();
-      const std::vector<SparsityMapEntry<N,T> >& entries = impl->get_entries();
-      for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it = entries.begin();
-	  it != entries.end();
-	  it++) {
-	if(!it->bounds.overlaps(r)) continue;
-	if(it->sparsity.exists()) {
-	  assert(0);
-	} else if(it->bitmap != 0) {
-	  assert(0);
-	} else {
-          Rect<N,T> isect = it->bounds.intersection(r);
-          total_volume += isect.volume();
-	}
-      }
-
-      // did we miss anything?
-      if(total_volume < r.volume())
+      if(!impl->contains_all(r))
         return false;
     }
 
@@ -675,21 +669,7 @@ namespace Realm {
     if(!dense()) {
       // test against sparsity map too
       SparsityMapPublicImpl<N,T> *impl = sparsity.impl();
-      const std::vector<SparsityMapEntry<N,T> >& entries = impl->get_entries();
-      for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it = entries.begin();
-	  it != entries.end();
-	  it++) {
-	if(!it->bounds.overlaps(r)) continue;
-	if(it->sparsity.exists()) {
-	  assert(0);
-	} else if(it->bitmap != 0) {
-	  assert(0);
-	} else {
-	  return true;
-	}
-      }
-      
-      return false;
+      return impl->contains_any(r);
     }
 
     return true;
@@ -737,7 +717,7 @@ namespace Realm {
       if(it->sparsity.exists()) {
 	assert(0);
       } else if(it->bitmap != 0) {
-	assert(0);
+	total += it->bitmap->overlap_volume(isect);
       } else {
 	total += isect.volume();
       }
@@ -1300,9 +1280,12 @@ namespace Realm {
 	rect = restriction.intersection(e.bounds);
 	if(!rect.empty()) {
 	  assert(!e.sparsity.exists());
-	  assert(e.bitmap == 0);
-	  valid = true;
-	  return;
+	  // bitmap entries are walked one run of points at a time
+	  cur_bit = 0;
+	  if((e.bitmap == 0) || e.bitmap->next_run(restriction, cur_bit, rect)) {
+	    valid = true;
+	    return;
+	  }
 	}
 	cur_entry++;
       }
@@ -1340,9 +1323,12 @@ namespace Realm {
 	rect = restriction.intersection(e.bounds);
 	if(!rect.empty()) {
 	  assert(!e.sparsity.exists());
-	  assert(e.bitmap == 0);
-	  valid = true;
-	  return;
+	  // bitmap entries are walked one run of points at a time
+	  cur_bit = 0;
+	  if((e.bitmap == 0) || e.bitmap->next_run(restriction, cur_bit, rect)) {
+	    valid = true;
+	    return;
+	  }
 	}
 	cur_entry++;
       }
@@ -1363,10 +1349,14 @@ namespace Realm {
       return false;
     }
 
-    // TODO: handle iteration within a sparsity entry
+    const std::vector<SparsityMapEntry<N,T> >& entries = s_impl->get_entries();
+
+    // if we're within a bitmap entry, look for its next run of points
+    if((entries[cur_entry].bitmap != 0) &&
+       entries[cur_entry].bitmap->next_run(restriction, cur_bit, rect))
+      return true;
 
     // move onto the next sparsity entry (that overlaps our restriction)
-    const std::vector<SparsityMapEntry<N,T> >& entries = s_impl->get_entries();
     for(cur_entry++; cur_entry < entries.size(); cur_entry++) {
       const SparsityMapEntry<N,T>& e = entries[cur_entry];
       rect = restriction.intersection(e.bounds);
@@ -1380,7 +1370,11 @@ namespace Realm {
       }
 
       assert(!e.sparsity.exists());
-      assert(e.bitmap == 0);
+      if(e.bitmap != 0) {
+	cur_bit = 0;
+	if(!e.bitmap->next_run(restriction, cur_bit, rect))
+	  continue;
+      }
       return true;
     }
 
@@ -20,6 +20,7 @@
 #include "realm/logging.h"
 #include "realm/runtime_impl.h"
 #include "realm/deppart/inst_helper.h"
+#include "realm/deppart/partitions.h"
 
 TYPE_IS_SERIALIZABLE(Realm::InstanceLayoutGeneric::FieldLayout);
 
@@ -1189,6 +1190,9 @@ namespace Realm {
 
     void RegionInstanceImpl::notify_deallocation(void)
     {
+      // the storage is gone, so anything derived from its contents is stale
+      InstanceDataCache::invalidate_all(me);
+
       // response needs to be handled by the instance's creator node, so forward
       //  there if it's not us
       NodeID creator_node = ID(me).instance_creator_node();
@@ -1521,6 +1525,16 @@ namespace Realm {
     return memory;
   }
 
+  Memory ExternalFileResource::suggested_mapped_memory() const
+  {
+    if(mode != LEGION_FILE_READ_ONLY)
+      return Memory::NO_MEMORY;
+    // mapped files look just like external memory resources
+    CoreModule *mod = get_runtime()->get_module<CoreModule>("core");
+    assert(mod);
+    return mod->ext_sysmem->me;
+  }
+
   ExternalInstanceResource *ExternalFileResource::clone(void) const
   {
     return new ExternalFileResource(filename, mode, offset);
@@ -346,6 +346,11 @@ namespace Realm {
     // returns the suggested memory in which this resource should be created
     Memory suggested_memory() const;
 
+    // returns a CPU-visible memory in which a read-only file resource can be
+    //  created by mapping the file directly - no data is copied and pages are
+    //  read in on first access - or NO_MEMORY if the mode is not read-only
+    Memory suggested_mapped_memory() const;
+
     virtual ExternalInstanceResource *clone(void) const;
 
     template <typename S>
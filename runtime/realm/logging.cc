@@ -21,6 +21,8 @@
 
 #include "realm/cmdline.h"
 #include "realm/timers.h"
+#include "realm/mutex.h"
+#include "realm/atomics.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -30,10 +32,15 @@
 
 #include <set>
 #include <map>
+#include <algorithm>
 
 #ifdef REALM_ON_WINDOWS
 #include <windows.h>
 #include <processthreadsapi.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 #endif
 
 namespace Realm {
@@ -134,6 +141,258 @@ namespace Realm {
     Mutex mutex;
   };
 
+#ifndef REALM_ON_WINDOWS
+  // asynchronous version of LoggerFileStream - each thread appends its
+  //  formatted messages to its own single-producer/single-consumer ring
+  //  buffer without taking any locks, and a background thread drains the
+  //  rings into large sequential writes to the (fully buffered) file
+  // messages from a single thread stay in order, but messages from
+  //  different threads may be interleaved differently than they were
+  //  generated
+  // the background thread sleeps on a condition variable - a producer wakes
+  //  it when its ring is half full, and otherwise it wakes up every
+  //  FLUSH_INTERVAL_NS to push out whatever has accumulated
+  class LoggerAsyncFileStream;
+  static atomic<LoggerAsyncFileStream *> active_async_stream(0);
+
+  class LoggerAsyncFileStream : public LoggerFileStream {
+  public:
+    static const long long FLUSH_INTERVAL_NS = 50000000;  // 50ms
+
+    LoggerAsyncFileStream(FILE *_f, bool _close_file, bool _include_timestamp,
+                          size_t _ring_size)
+      : LoggerFileStream(_f, _close_file, _include_timestamp)
+      , ring_size(_ring_size)
+      , rings(0)
+      , shutdown_flag(false)
+      , wake_requested(false)
+      , drain_cond(drain_mutex)
+    {
+      int ret = pthread_create(&drainer, 0, drain_thread_entry, this);
+      if(ret != 0) {
+        fprintf(stderr, "could not create log drain thread: %s\n",
+                strerror(ret));
+        exit(1);
+      }
+      active_async_stream.store_release(this);
+    }
+
+    virtual ~LoggerAsyncFileStream(void)
+    {
+      active_async_stream.store_release(0);
+      {
+        AutoLock<KernelMutex> al(drain_mutex);
+        shutdown_flag.store_release(true);
+        drain_cond.signal();
+      }
+      pthread_join(drainer, 0);
+      flush();
+      Ring *r = rings.load_acquire();
+      while(r) {
+        Ring *next = r->next;
+        free(r->data);
+        delete r;
+        r = next;
+      }
+    }
+
+    virtual void log_msg(Logger::LoggingLevel level, const char *name,
+                         const char *msgdata, size_t msglen)
+    {
+      LoggerFileStream::log_msg(level, name, msgdata, msglen);
+      // a fatal message is usually followed by an abort, so get everything
+      //  out to the file before returning
+      if(level >= Logger::LEVEL_FATAL)
+        flush();
+    }
+
+    virtual void flush()
+    {
+      AutoLock<> al(mutex);
+      drain_rings();
+      fflush(f);
+    }
+
+    // called from an error signal handler - the interrupted thread (or the
+    //  drain thread) may hold the mutex, so only wait for it briefly before
+    //  writing anyway, since the process is about to go away
+    void flush_from_signal_handler(void)
+    {
+      bool locked = false;
+      for(int i = 0; (i < 1000) && !locked; i++) {
+        locked = mutex.trylock();
+        if(!locked)
+          usleep(100);
+      }
+      drain_rings();
+      fflush(f);
+      if(locked)
+        mutex.unlock();
+    }
+
+  protected:
+    struct Ring {
+      char *data;
+      size_t size;
+      // head is only advanced by the owning thread, tail only by whoever
+      //  holds the stream's mutex
+      atomic<size_t> head, tail;
+      LoggerAsyncFileStream *owner;
+      Ring *next;
+    };
+
+    Ring *get_ring(void)
+    {
+      static REALM_THREAD_LOCAL Ring *my_ring = 0;
+      if(REALM_LIKELY(my_ring && (my_ring->owner == this)))
+        return my_ring;
+
+      Ring *r = new Ring;
+      r->data = static_cast<char *>(malloc(ring_size));
+      assert(r->data != 0);
+      r->size = ring_size;
+      r->head.store(0);
+      r->tail.store(0);
+      r->owner = this;
+      // rings are never removed while the stream is alive, so a simple
+      //  lock-free push is enough
+      Ring *old_head = rings.load();
+      do {
+        r->next = old_head;
+      } while(!rings.compare_exchange(old_head, r));
+      my_ring = r;
+      return r;
+    }
+
+    virtual void write(const char *buffer, size_t len)
+    {
+      Ring *r = get_ring();
+      size_t head = r->head.load();
+
+      if(REALM_UNLIKELY(len > r->size)) {
+        // too big for the ring - write it directly, after everything this
+        //  thread has already queued up
+        AutoLock<> al(mutex);
+        drain_rings();
+        write_to_file(buffer, len);
+        return;
+      }
+
+      // wait for enough space - rather than waiting for the drain thread,
+      //  drain the rings ourselves
+      while((head - r->tail.load_acquire()) > (r->size - len)) {
+        AutoLock<> al(mutex);
+        drain_rings();
+      }
+
+      size_t ofs = head % r->size;
+      size_t amt1 = std::min(len, r->size - ofs);
+      memcpy(r->data + ofs, buffer, amt1);
+      if(amt1 < len)
+        memcpy(r->data, buffer + amt1, len - amt1);
+      r->head.store_release(head + len);
+
+      // get the drain thread going early once a ring is half full so that
+      //  producers rarely have to drain it themselves
+      if(((head + len - r->tail.load()) > (r->size / 2)) &&
+         !wake_requested.load() && !wake_requested.exchange(true)) {
+        AutoLock<KernelMutex> al(drain_mutex);
+        drain_cond.signal();
+      }
+    }
+
+    // must be called while holding the mutex - returns the number of bytes
+    //  written
+    size_t drain_rings(void)
+    {
+      size_t total = 0;
+      for(Ring *r = rings.load_acquire(); r; r = r->next) {
+        size_t head = r->head.load_acquire();
+        size_t tail = r->tail.load();
+        if(head == tail)
+          continue;
+        size_t ofs = tail % r->size;
+        size_t len = head - tail;
+        size_t amt1 = std::min(len, r->size - ofs);
+        write_to_file(r->data + ofs, amt1);
+        if(amt1 < len)
+          write_to_file(r->data, len - amt1);
+        r->tail.store_release(head);
+        total += len;
+      }
+      return total;
+    }
+
+    void write_to_file(const char *buffer, size_t len)
+    {
+#ifndef NDEBUG
+      size_t amt =
+#endif
+      fwrite(buffer, 1, len, f);
+      assert(amt == len);
+    }
+
+    static void *drain_thread_entry(void *arg)
+    {
+      LoggerAsyncFileStream *s = static_cast<LoggerAsyncFileStream *>(arg);
+      bool dirty = false;
+      while(true) {
+        size_t amt;
+        {
+          AutoLock<> al(s->mutex);
+          amt = s->drain_rings();
+          // push out buffered data once things go quiet so that the file
+          //  doesn't lag too far behind
+          if(amt > 0)
+            dirty = true;
+          else if(dirty) {
+            fflush(s->f);
+            dirty = false;
+          }
+        }
+
+        AutoLock<KernelMutex> al(s->drain_mutex);
+        if(s->shutdown_flag.load_acquire())
+          break;
+        // a ring that filled up while we were draining gets another pass
+        //  right away
+        if(!s->wake_requested.load())
+          s->drain_cond.timedwait(FLUSH_INTERVAL_NS);
+        s->wake_requested.store(false);
+      }
+      return 0;
+    }
+
+    size_t ring_size;
+    atomic<Ring *> rings;
+    atomic<bool> shutdown_flag;
+    atomic<bool> wake_requested;
+    KernelMutex drain_mutex;
+    KernelMutex::CondVar drain_cond;
+    pthread_t drainer;
+  };
+#endif
+
+  // used by Realm's error signal handlers (see runtime_impl.cc) - buffered
+  //  log output is otherwise lost when the process dies from a signal
+  bool has_buffered_log_output(void)
+  {
+#ifndef REALM_ON_WINDOWS
+    return (active_async_stream.load_acquire() != 0);
+#else
+    return false;
+#endif
+  }
+
+  void flush_buffered_log_output(void)
+  {
+#ifndef REALM_ON_WINDOWS
+    LoggerAsyncFileStream *s = active_async_stream.load_acquire();
+    if(s)
+      s->flush_from_signal_handler();
+#endif
+  }
+
   class LoggerConfig {
   protected:
     LoggerConfig(void);
@@ -160,6 +419,7 @@ namespace Realm {
     bool cmdline_read;
     Logger::LoggingLevel default_level, stderr_level;
     bool include_timestamp;
+    size_t async_buffer_kb;
     std::map<std::string, Logger::LoggingLevel> category_levels;
     std::string cats_enabled;
     std::set<Logger *> pending_configs;
@@ -172,6 +432,7 @@ namespace Realm {
     , default_level(Logger::LEVEL_PRINT)
     , stderr_level(Logger::LEVEL_ERROR)
     , include_timestamp(true)
+    , async_buffer_kb(0)
     , stream(0)
     , stderr_stream(0)
     , default_output(0)
@@ -308,6 +569,7 @@ namespace Realm {
       .add_option_method("-level", this, &LoggerConfig::parse_level_argument)
       .add_option_int("-errlevel", stderr_level)
       .add_option_int("-logtime", include_timestamp)
+      .add_option_int("-logasync", async_buffer_kb)
       .parse_command_line(cmdline);
 
     if(!ok) {
@@ -371,9 +633,19 @@ namespace Realm {
           exit(1);
         }
       }
-      // TODO: consider buffering in some cases?
-      setbuf(f, 0); // disable output buffering
-      stream = new LoggerFileStream(f, true, include_timestamp);
+#ifndef REALM_ON_WINDOWS
+      if(async_buffer_kb > 0) {
+        // the drain thread does the batching, so let stdio buffer large
+        //  writes and flush when the rings go idle
+        setvbuf(f, 0, _IOFBF, 1 << 20);
+        stream = new LoggerAsyncFileStream(f, true, include_timestamp,
+                                           async_buffer_kb << 10);
+      } else
+#endif
+      {
+        setbuf(f, 0); // disable output buffering
+        stream = new LoggerFileStream(f, true, include_timestamp);
+      }
 
       // when logging to a file, also sent critical-enough messages to stderr
       if(stderr_level < Logger::LEVEL_NONE)
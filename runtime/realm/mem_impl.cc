@@ -26,6 +26,15 @@
 #include "realm/activemsg.h"
 #include "realm/transfer/transfer.h"
 
+#include <errno.h>
+// used for directly-mapped file instances
+#if defined(REALM_ON_LINUX) || defined(REALM_ON_MACOS) || defined(REALM_ON_FREEBSD)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace Realm {
 
   Logger log_malloc("malloc");
@@ -705,7 +714,11 @@ namespace Realm {
       // ignore external instances here - we can't reuse their memory for
       //  future allocations
       if(inst->metadata.ext_resource != 0) {
-        unregister_external_resource(inst);
+        // some resources (e.g. mapped files) have to stay valid until the
+        //  precondition triggers - release_storage_immediate handles the
+        //  deferred case
+        if(triggered)
+          unregister_external_resource(inst);
       } else {
 	// this release may satisfy pending allocation requests
 	std::vector<std::pair<RegionInstanceImpl *, size_t> > successful_allocs;
@@ -1325,13 +1338,91 @@ namespace Realm {
       return true;
     }
 
+    // read-only files can be mapped directly instead of copied
+    ExternalFileResource *fres = dynamic_cast<ExternalFileResource *>(inst->metadata.ext_resource);
+    if((fres != 0) && (fres->mode == LEGION_FILE_READ_ONLY))
+      return attempt_map_file_resource(inst, fres, inst_offset);
+
     // not a kind we recognize
     return false;
   }
 
+  bool LocalCPUMemory::attempt_map_file_resource(RegionInstanceImpl *inst,
+						 const ExternalFileResource *res,
+						 size_t& inst_offset)
+  {
+#if defined(REALM_ON_LINUX) || defined(REALM_ON_MACOS) || defined(REALM_ON_FREEBSD)
+    int fd = open(res->filename.c_str(), O_RDONLY);
+    if(fd < 0) {
+      log_inst.warning() << "could not open file for mapping: file='" << res->filename
+			 << "' error=" << strerror(errno);
+      return false;
+    }
+
+    // touching a mapped page beyond the end of the file is a SIGBUS rather
+    //  than an error we can report, so check the size up front
+    size_t bytes = inst->metadata.layout->bytes_used;
+    struct stat st;
+    if((fstat(fd, &st) != 0) ||
+       (size_t(st.st_size) < (res->offset + bytes))) {
+      log_inst.warning() << "file too small for mapped instance: file='" << res->filename
+			 << "' offset=" << res->offset << " bytes=" << bytes;
+      close(fd);
+      return false;
+    }
+
+    // mmap offsets must be page-aligned
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t map_offset = res->offset - (res->offset % page_size);
+    size_t map_size = bytes + (res->offset - map_offset);
+    // a private mapping means any (disallowed) writes to the instance become
+    //  copy-on-write pages rather than faults or changes to the file
+    void *map_base = mmap(0, std::max<size_t>(map_size, 1),
+			  PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, map_offset);
+    // the mapping holds its own reference to the file
+    close(fd);
+    if(map_base == MAP_FAILED) {
+      log_inst.warning() << "mmap failed: file='" << res->filename
+			 << "' bytes=" << map_size << " error=" << strerror(errno);
+      return false;
+    }
+
+    // pages are faulted in by whatever touches them first - ask for
+    //  aggressive readahead since most accesses stream through the data
+    madvise(map_base, map_size, MADV_SEQUENTIAL);
+
+    MappedFileInfo *info = new MappedFileInfo;
+    info->map_base = map_base;
+    info->map_size = map_size;
+    inst->metadata.add_mem_specific(info);
+
+    // same trick as for ExternalMemoryResource - express the mapping as an
+    //  offset relative to our own base
+    uintptr_t ptr = (reinterpret_cast<uintptr_t>(map_base) +
+		     (res->offset - map_offset));
+    void *mem_base = get_direct_ptr(0, 0);
+    inst_offset = ptr - reinterpret_cast<uintptr_t>(mem_base);
+    log_inst.info() << "mapped file: inst=" << inst->me << " file='" << res->filename
+		    << "' base=" << map_base << " size=" << map_size;
+    return true;
+#else
+    // no mmap support on this platform
+    return false;
+#endif
+  }
+
   void LocalCPUMemory::unregister_external_resource(RegionInstanceImpl *inst)
   {
-    // nothing actually to clean up
+    // nothing to clean up for memory resources, but mapped files have to be
+    //  unmapped
+    MappedFileInfo *info = inst->metadata.find_mem_specific<MappedFileInfo>();
+    if(info != 0) {
+#if defined(REALM_ON_LINUX) || defined(REALM_ON_MACOS) || defined(REALM_ON_FREEBSD)
+      munmap(info->map_base, std::max<size_t>(info->map_size, 1));
+#endif
+      info->map_base = 0;
+      info->map_size = 0;
+    }
   }
 
   // for re-registration purposes, generate an ExternalInstanceResource *
@@ -222,8 +222,12 @@ namespace Realm {
     std::map<TT, unsigned> allocated;  // direct lookup of allocated ranges by tag
 #ifdef DEBUG_REALM
     std::map<RT, unsigned> by_first;   // direct lookup of all ranges by first
-    // TODO: sized-based lookup of free ranges
 #endif
+    // sized-based lookup of free ranges - keyed by (size, first) so that
+    //  best-fit searches are O(log n) and ties are broken by address, which
+    //  keeps allocation decisions a deterministic function of the free ranges
+    //  (the current/future allocators in LocalManagedMemory rely on this)
+    std::map<std::pair<RT, RT>, unsigned> free_by_size;
 
     static const unsigned SENTINEL = 0;
     // TODO: small (medium?) vector opt
@@ -244,6 +248,11 @@ namespace Realm {
     unsigned first_free_range;
     unsigned alloc_range(RT first, RT last);
     void free_range(unsigned index);
+    // finds the smallest free range that can hold an aligned allocation of
+    //  'size' bytes, returning SENTINEL if there is none
+    unsigned find_best_fit(RT size, RT alignment, RT& ofs) const;
+    void add_free_by_size(unsigned index);
+    void remove_free_by_size(unsigned index);
   };
 
     // a memory that manages its own allocations
@@ -329,7 +338,8 @@ namespace Realm {
 
       virtual ~LocalCPUMemory(void);
 
-      // LocalCPUMemory supports ExternalMemoryResource
+      // LocalCPUMemory supports ExternalMemoryResource, and read-only
+      //  ExternalFileResources (which are mapped directly into memory)
       virtual bool attempt_register_external_resource(RegionInstanceImpl *inst,
                                                       size_t& inst_offset);
       virtual void unregister_external_resource(RegionInstanceImpl *inst);
@@ -345,6 +355,18 @@ namespace Realm {
       virtual void put_bytes(off_t offset, const void *src, size_t size);
       virtual void *get_direct_ptr(off_t offset, size_t size);
 
+      // the 'mem_specific' data for a mapped file instance
+      class MappedFileInfo : public MemSpecificInfo {
+      public:
+	void *map_base;
+	size_t map_size;
+      };
+
+    protected:
+      bool attempt_map_file_resource(RegionInstanceImpl *inst,
+				     const ExternalFileResource *res,
+				     size_t& inst_offset);
+
     public:
       const int numa_node;
     public: //protected:
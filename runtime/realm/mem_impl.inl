@@ -91,6 +91,7 @@ namespace Realm {
 #ifdef DEBUG_REALM
     by_first.swap(swap_with.by_first);
 #endif
+    free_by_size.swap(swap_with.free_by_size);
     ranges.swap(swap_with.ranges);
     std::swap(first_free_range, swap_with.first_free_range);
   }
@@ -119,6 +120,7 @@ namespace Realm {
 #ifdef DEBUG_REALM
       by_first[first] = new_idx;
 #endif
+      add_free_by_size(new_idx);
       return;
     }
 
@@ -148,37 +150,67 @@ namespace Realm {
     ranges[index].next = first_free_range;
     first_free_range = index;
   }
-  
+
   template <typename RT, typename TT>
-  inline bool BasicRangeAllocator<RT,TT>::can_allocate(TT tag,
-						       RT size, RT alignment)
+  inline void BasicRangeAllocator<RT,TT>::add_free_by_size(unsigned index)
   {
-    // empty allocation requests are trivial
-    if(size == 0) {
-      return true;
-    }
+    const Range& r = ranges[index];
+    free_by_size[std::make_pair(r.last - r.first, r.first)] = index;
+  }
 
-    // walk free ranges and just take the first that fits
-    unsigned idx = ranges[SENTINEL].next_free;
-    while(idx != SENTINEL) {
-      Range *r = &ranges[idx];
+  template <typename RT, typename TT>
+  inline void BasicRangeAllocator<RT,TT>::remove_free_by_size(unsigned index)
+  {
+    const Range& r = ranges[index];
+#ifdef DEBUG_REALM
+    size_t count =
+#endif
+      free_by_size.erase(std::make_pair(r.last - r.first, r.first));
+#ifdef DEBUG_REALM
+    assert(count == 1);
+#endif
+  }
 
-      RT ofs = 0;
+  template <typename RT, typename TT>
+  inline unsigned BasicRangeAllocator<RT,TT>::find_best_fit(RT size,
+							    RT alignment,
+							    RT& ofs) const
+  {
+    // start with the smallest range that could hold the allocation if no
+    //  alignment padding were needed - any range at least
+    //  'size + alignment - 1' long is guaranteed to fit, so the scan stops
+    //  there at the latest, but every free range shorter than that which
+    //  cannot absorb its padding is visited on the way
+    typename std::map<std::pair<RT, RT>, unsigned>::const_iterator it =
+      free_by_size.lower_bound(std::make_pair(size, RT(0)));
+    while(it != free_by_size.end()) {
+      RT first = it->first.second;
+      ofs = 0;
       if(alignment) {
-	RT rem = r->first % alignment;
+	RT rem = first % alignment;
 	if(rem > 0)
 	  ofs = alignment - rem;
       }
       // do we have enough space?
-      if((r->last - r->first) >= (size + ofs))
-	return true;
-
-      // no, go to next one
-      idx = r->next_free;
+      if(it->first.first >= (size + ofs))
+	return it->second;
+      ++it;
+    }
+    return SENTINEL;
+  }
+  
+  template <typename RT, typename TT>
+  inline bool BasicRangeAllocator<RT,TT>::can_allocate(TT tag,
+						       RT size, RT alignment)
+  {
+    // empty allocation requests are trivial
+    if(size == 0) {
+      return true;
     }
 
-    // allocation failed
-    return false;
+    // look for the best-fitting free range
+    RT ofs;
+    return (find_best_fit(size, alignment, ofs) != SENTINEL);
   }
 
   template <typename RT, typename TT>
@@ -190,92 +222,89 @@ namespace Realm {
       return true;
     }
 
-    // walk free ranges and just take the first that fits
-    unsigned idx = ranges[SENTINEL].next_free;
-    while(idx != SENTINEL) {
-      Range *r = &ranges[idx];
+    // find the smallest free range that fits
+    RT ofs;
+    unsigned idx = find_best_fit(size, alignment, ofs);
+    if(idx == SENTINEL) {
+      // allocation failed
+      return false;
+    }
 
-      RT ofs = 0;
-      if(alignment) {
-	RT rem = r->first % alignment;
-	if(rem > 0)
-	  ofs = alignment - rem;
-      }
-      // do we have enough space?
-      if((r->last - r->first) >= (size + ofs)) {
-	// yes, but we may need to chop things up to make the exact range we want
-	alloc_first = r->first + ofs;
-	RT alloc_last = alloc_first + size;
-
-        // do we need to carve off a new (free) block before us?
-        if(alloc_first != r->first) {
-	  unsigned new_idx = alloc_range(r->first, alloc_first);
-	  Range *new_prev = &ranges[new_idx];
-	  r = &ranges[idx];  // alloc may have moved this!
-	  
-	  r->first = alloc_first;
-	  // insert into all-block dllist
-	  new_prev->prev = r->prev;
-	  new_prev->next = idx;
-	  ranges[r->prev].next = new_idx;
-	  r->prev = new_idx;
-	  // insert into free-block dllist
-	  new_prev->prev_free = r->prev_free;
-	  new_prev->next_free = idx;
-	  ranges[r->prev_free].next_free = new_idx;
-	  r->prev_free = new_idx;
+    // this range is about to be trimmed or consumed, so it comes out of the
+    //  size lookup now and any leftover pieces are added back below
+    remove_free_by_size(idx);
+
+    Range *r = &ranges[idx];
+    // we may need to chop things up to make the exact range we want
+    alloc_first = r->first + ofs;
+    RT alloc_last = alloc_first + size;
+
+    // do we need to carve off a new (free) block before us?
+    if(alloc_first != r->first) {
+      unsigned new_idx = alloc_range(r->first, alloc_first);
+      Range *new_prev = &ranges[new_idx];
+      r = &ranges[idx];  // alloc may have moved this!
+
+      r->first = alloc_first;
+      // insert into all-block dllist
+      new_prev->prev = r->prev;
+      new_prev->next = idx;
+      ranges[r->prev].next = new_idx;
+      r->prev = new_idx;
+      // insert into free-block dllist
+      new_prev->prev_free = r->prev_free;
+      new_prev->next_free = idx;
+      ranges[r->prev_free].next_free = new_idx;
+      r->prev_free = new_idx;
+
+      add_free_by_size(new_idx);
 
 #ifdef DEBUG_REALM
-	  // fix up by_first entries
-	  by_first[r->first] = new_idx;
-	  by_first[alloc_first] = idx;
+      // fix up by_first entries
+      by_first[new_prev->first] = new_idx;
+      by_first[alloc_first] = idx;
 #endif
-        }
-
-	// two cases to deal with
-	if(alloc_last == r->last) {
-	  // case 1 - exact fit
-	  //
-	  // all we have to do here is remove this range from the free range dlist
-	  //  and add to the allocated lookup map
-	  ranges[r->prev_free].next_free = r->next_free;
-	  ranges[r->next_free].prev_free = r->prev_free;
-	} else {
-	  // case 2 - leftover at end - put in new range
-	  unsigned after_idx = alloc_range(alloc_last, r->last);
-	  Range *r_after = &ranges[after_idx];
-	  r = &ranges[idx];  // alloc may have moved this!
+    }
+
+    // two cases to deal with
+    if(alloc_last == r->last) {
+      // case 1 - exact fit
+      //
+      // all we have to do here is remove this range from the free range dlist
+      //  and add to the allocated lookup map
+      ranges[r->prev_free].next_free = r->next_free;
+      ranges[r->next_free].prev_free = r->prev_free;
+    } else {
+      // case 2 - leftover at end - put in new range
+      unsigned after_idx = alloc_range(alloc_last, r->last);
+      Range *r_after = &ranges[after_idx];
+      r = &ranges[idx];  // alloc may have moved this!
 
 #ifdef DEBUG_REALM
-	  by_first[alloc_last] = after_idx;
+      by_first[alloc_last] = after_idx;
 #endif
-	  r->last = alloc_last;
-	  
-	  // r_after goes after r in all block list
-	  r_after->prev = idx;
-	  r_after->next = r->next;
-	  r->next = after_idx;
-	  ranges[r_after->next].prev = after_idx;
-
-	  // r_after replaces r in the free block list
-	  r_after->prev_free = r->prev_free;
-	  r_after->next_free = r->next_free;
-	  ranges[r_after->next_free].prev_free = after_idx;
-	  ranges[r_after->prev_free].next_free = after_idx;
-	}
-
-	// tie this off because we use it to detect allocated-ness
-	r->prev_free = r->next_free = idx;
-
-	allocated[tag] = idx;
-	return true;
-      }
+      r->last = alloc_last;
+
+      // r_after goes after r in all block list
+      r_after->prev = idx;
+      r_after->next = r->next;
+      r->next = after_idx;
+      ranges[r_after->next].prev = after_idx;
+
+      // r_after replaces r in the free block list
+      r_after->prev_free = r->prev_free;
+      r_after->next_free = r->next_free;
+      ranges[r_after->next_free].prev_free = after_idx;
+      ranges[r_after->prev_free].next_free = after_idx;
 
-      // no, go to next one
-      idx = r->next_free;
+      add_free_by_size(after_idx);
     }
-    // allocation failed
-    return false;
+
+    // tie this off because we use it to detect allocated-ness
+    r->prev_free = r->next_free = idx;
+
+    allocated[tag] = idx;
+    return true;
   }
 
   template <typename RT, typename TT>
@@ -297,39 +326,42 @@ namespace Realm {
 
     Range& r = ranges[del_idx];
 
+    // the free list is not kept in address order (the size lookup is what
+    //  allocation uses), so we only need to know whether our immediate
+    //  neighbors are free - allocated ranges have their free list pointers
+    //  tied off to themselves
     unsigned pf_idx = r.prev;
-    while((pf_idx != SENTINEL) && (ranges[pf_idx].prev_free == pf_idx)) {
-      pf_idx = ranges[pf_idx].prev;
-      assert(pf_idx != del_idx);  // wrapping around would be bad
-    }
     unsigned nf_idx = r.next;
-    while((nf_idx != SENTINEL) && (ranges[nf_idx].next_free == nf_idx)) {
-      nf_idx = ranges[nf_idx].next;
-      assert(nf_idx != del_idx);
-    }
 
     // do we need to merge?
-    bool merge_prev = (pf_idx == r.prev) && (pf_idx != SENTINEL);
-    bool merge_next = (nf_idx == r.next) && (nf_idx != SENTINEL);
+    bool merge_prev = ((pf_idx != SENTINEL) &&
+		       (ranges[pf_idx].prev_free != pf_idx));
+    bool merge_next = ((nf_idx != SENTINEL) &&
+		       (ranges[nf_idx].next_free != nf_idx));
 
     // four cases - ordered to match the allocation cases
     if(!merge_next) {
       if(!merge_prev) {
 	// case 1 - no merging (exact match)
-	// just add ourselves to the free list
-	r.prev_free = pf_idx;
-	r.next_free = nf_idx;
-	ranges[pf_idx].next_free = del_idx;
-	ranges[nf_idx].prev_free = del_idx;
+	// just add ourselves to the front of the free list
+	Range& sentinel = ranges[SENTINEL];
+	r.prev_free = SENTINEL;
+	r.next_free = sentinel.next_free;
+	ranges[sentinel.next_free].prev_free = del_idx;
+	sentinel.next_free = del_idx;
+
+	add_free_by_size(del_idx);
       } else {
 	// case 2 - merge before
 	// merge ourselves into the range before
 	Range& r_before = ranges[pf_idx];
 
+	remove_free_by_size(pf_idx);
 	r_before.last = r.last;
 	r_before.next = r.next;
 	ranges[r.next].prev = pf_idx;
 	// r_before was already in free list, so no changes to that
+	add_free_by_size(pf_idx);
 
 #ifdef DEBUG_REALM
 	by_first.erase(r.first);
@@ -347,10 +379,12 @@ namespace Realm {
 	by_first.erase(r_after.first);
 #endif
 
+	remove_free_by_size(nf_idx);
 	r_after.first = r.first;
 	r_after.prev = r.prev;
 	ranges[r.prev].next = nf_idx;
 	// r_after was already in the free list, so no changes to that
+	add_free_by_size(nf_idx);
 
 	free_range(del_idx);
       } else {
@@ -359,18 +393,23 @@ namespace Realm {
 	Range& r_before = ranges[pf_idx];
 	Range& r_after = ranges[nf_idx];
 
+	remove_free_by_size(pf_idx);
+	remove_free_by_size(nf_idx);
 	r_before.last = r_after.last;
 #ifdef DEBUG_REALM
 	by_first.erase(r.first);
 	by_first.erase(r_after.first);
 #endif
 
-	// adjust both normal list and free list
+	// adjust normal list
 	r_before.next = r_after.next;
 	ranges[r_after.next].prev = pf_idx;
 
-	r_before.next_free = r_after.next_free;
-	ranges[r_after.next_free].prev_free = pf_idx;
+	// and remove r_after from the free list
+	ranges[r_after.prev_free].next_free = r_after.next_free;
+	ranges[r_after.next_free].prev_free = r_after.prev_free;
+
+	add_free_by_size(pf_idx);
 
 	free_range(del_idx);
 	free_range(nf_idx);
@@ -93,6 +93,11 @@ REGISTER_REALM_NETWORK_MODULE_STATIC(Realm::GASNetEXModule, "gasnetex", 2);
 REGISTER_REALM_NETWORK_MODULE_STATIC(Realm::MPIModule, "mpi", 100);
 #endif
 
+#ifdef REALM_USE_SHM
+#include "realm/shm/shm_module.h"
+REGISTER_REALM_NETWORK_MODULE_STATIC(Realm::SHMModule, "shm", 200);
+#endif
+
 namespace Realm {
 
   Logger log_module("module");
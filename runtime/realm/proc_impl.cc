@@ -1058,6 +1058,23 @@ namespace Realm {
     enqueue_or_defer_task(task, start_event, &deferred_spawn_cache);
   }
 
+  void LocalTaskProcessor::spawn_fused_task(Processor::TaskFuncID func_id,
+					    const void *args, size_t arglen,
+					    const std::vector<Task::FusedBody>& fused_bodies,
+					    Event start_event,
+					    GenEventImpl *finish_event,
+					    EventImpl::gen_t finish_gen,
+					    int priority)
+  {
+    Task *task = new Task(me, func_id, args, arglen, ProfilingRequestSet(),
+			  start_event, finish_event, finish_gen, priority);
+    task->fused_bodies = fused_bodies;
+    get_runtime()->optable.add_local_operation(finish_event->make_event(finish_gen),
+					       task);
+
+    enqueue_or_defer_task(task, start_event, &deferred_spawn_cache);
+  }
+
   bool LocalTaskProcessor::register_task(Processor::TaskFuncID func_id,
 					 CodeDescriptor& codedesc,
 					 const ByteArrayRef& user_data)
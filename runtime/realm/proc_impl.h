@@ -134,6 +134,16 @@ namespace Realm {
 			      EventImpl::gen_t finish_gen,
                               int priority);
 
+      // spawns a task that runs the fused bodies after its own, with no
+      //  events between them (the finish event covers all of them)
+      void spawn_fused_task(Processor::TaskFuncID func_id,
+			    const void *args, size_t arglen,
+			    const std::vector<Task::FusedBody>& fused_bodies,
+			    Event start_event,
+			    GenEventImpl *finish_event,
+			    EventImpl::gen_t finish_gen,
+			    int priority);
+
       virtual bool register_task(Processor::TaskFuncID func_id,
 				 CodeDescriptor& codedesc,
 				 const ByteArrayRef& user_data);
@@ -73,9 +73,18 @@ namespace Realm {
     //  specified limit
     extern int event_loop_detection_limit;
 
+    // number of event waiters that are triggered between checks of the
+    //  triggering thread's time limit
+    extern int event_trigger_batch_size;
+
     // if true, worker threads that might have used user-level thread switching
     //  fall back to kernel threading
     extern bool force_kernel_threads;
+
+    // if at least 2, task schedulers with multiple workers batch up to this
+    //  many equal-priority ready tasks in per-worker deques and idle workers
+    //  steal from those deques
+    extern int task_steal_batch_size;
   };
 };
 #endif
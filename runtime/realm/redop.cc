@@ -0,0 +1,185 @@
+/* Copyright 2022 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// vectorized CPU kernels for dense exclusive reductions
+
+#include "realm/redop.h"
+
+#include <cstring>
+#include <stdint.h>
+
+// the kernels are written with the GCC/clang vector extensions, which need
+//  clang 12 or later for the (elementwise) conditional operator
+#if (defined(REALM_COMPILER_IS_GCC) && (__GNUC__ >= 5)) || \
+    (defined(REALM_COMPILER_IS_CLANG) && (__clang_major__ >= 12))
+  #define REALM_REDOP_VECTOR_EXT
+  // on x86_64, wider kernels are compiled separately and chosen at runtime
+  #if defined(__x86_64__)
+    #define REALM_REDOP_DISPATCH
+  #endif
+#endif
+
+namespace Realm {
+
+  namespace ReductionKernels {
+
+    // each operation is written once for both scalars and vectors - the
+    //  conditional in min/max is elementwise for vector types
+    struct DenseSum {
+      template <typename T>
+      static inline void apply(T& lhs, const T& rhs) { lhs += rhs; }
+    };
+
+    struct DenseProd {
+      template <typename T>
+      static inline void apply(T& lhs, const T& rhs) { lhs *= rhs; }
+    };
+
+    struct DenseMin {
+      template <typename T>
+      static inline void apply(T& lhs, const T& rhs)
+      { lhs = (rhs < lhs) ? rhs : lhs; }
+    };
+
+    struct DenseMax {
+      template <typename T>
+      static inline void apply(T& lhs, const T& rhs)
+      { lhs = (rhs > lhs) ? rhs : lhs; }
+    };
+
+#ifdef REALM_REDOP_VECTOR_EXT
+    // processes VBYTES-sized vectors (two at a time to hide some latency)
+    //  and then finishes off the tail with scalars - loads and stores go
+    //  through memcpy because neither side need be aligned
+    template <typename T, typename OP, size_t VBYTES>
+    __attribute__((always_inline))
+    static inline void dense_loop(void *lhs_ptr, const void *rhs_ptr,
+                                  size_t count)
+    {
+      typedef T VT __attribute__((vector_size(VBYTES)));
+      const size_t N = VBYTES / sizeof(T);
+      T *lhs = static_cast<T *>(lhs_ptr);
+      const T *rhs = static_cast<const T *>(rhs_ptr);
+      size_t i = 0;
+      for(; (i + 2 * N) <= count; i += 2 * N) {
+        VT l0, l1, r0, r1;
+        memcpy(&l0, lhs + i, VBYTES);
+        memcpy(&l1, lhs + i + N, VBYTES);
+        memcpy(&r0, rhs + i, VBYTES);
+        memcpy(&r1, rhs + i + N, VBYTES);
+        OP::apply(l0, r0);
+        OP::apply(l1, r1);
+        memcpy(lhs + i, &l0, VBYTES);
+        memcpy(lhs + i + N, &l1, VBYTES);
+      }
+      for(; i < count; i++)
+        OP::apply(lhs[i], rhs[i]);
+    }
+
+    template <typename T, typename OP>
+    static void dense_kernel_generic(void *lhs_ptr, const void *rhs_ptr,
+                                     size_t count, const void *userdata)
+    {
+      dense_loop<T, OP, 16>(lhs_ptr, rhs_ptr, count);
+    }
+#else
+    template <typename T, typename OP>
+    static void dense_kernel_generic(void *lhs_ptr, const void *rhs_ptr,
+                                     size_t count, const void *userdata)
+    {
+      T *REALM_RESTRICT lhs = static_cast<T *>(lhs_ptr);
+      const T *REALM_RESTRICT rhs = static_cast<const T *>(rhs_ptr);
+      for(size_t i = 0; i < count; i++)
+        OP::apply(lhs[i], rhs[i]);
+    }
+#endif
+
+#ifdef REALM_REDOP_DISPATCH
+    template <typename T, typename OP>
+    __attribute__((target("avx2")))
+    static void dense_kernel_avx2(void *lhs_ptr, const void *rhs_ptr,
+                                  size_t count, const void *userdata)
+    {
+      dense_loop<T, OP, 32>(lhs_ptr, rhs_ptr, count);
+    }
+
+    template <typename T, typename OP>
+    __attribute__((target("avx512f,avx512dq")))
+    static void dense_kernel_avx512(void *lhs_ptr, const void *rhs_ptr,
+                                    size_t count, const void *userdata)
+    {
+      dense_loop<T, OP, 64>(lhs_ptr, rhs_ptr, count);
+    }
+
+    enum DenseISA {
+      ISA_GENERIC,
+      ISA_AVX2,
+      ISA_AVX512,
+    };
+
+    static DenseISA detect_dense_isa(void)
+    {
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx512f") &&
+         __builtin_cpu_supports("avx512dq"))
+        return ISA_AVX512;
+      if(__builtin_cpu_supports("avx2"))
+        return ISA_AVX2;
+      return ISA_GENERIC;
+    }
+#endif
+
+    template <typename T, typename OP>
+    static DenseKernelFn select_dense_kernel(void)
+    {
+#ifdef REALM_REDOP_DISPATCH
+      static const DenseISA isa = detect_dense_isa();
+      switch(isa) {
+      case ISA_AVX512: return &dense_kernel_avx512<T, OP>;
+      case ISA_AVX2: return &dense_kernel_avx2<T, OP>;
+      default: break;
+      }
+#endif
+      return &dense_kernel_generic<T, OP>;
+    }
+
+    template <typename T>
+    static DenseKernelFn select_dense_kernel(DenseKind kind)
+    {
+      switch(kind) {
+      case DENSE_SUM: return select_dense_kernel<T, DenseSum>();
+      case DENSE_PROD: return select_dense_kernel<T, DenseProd>();
+      case DENSE_MIN: return select_dense_kernel<T, DenseMin>();
+      case DENSE_MAX: return select_dense_kernel<T, DenseMax>();
+      default: return 0;
+      }
+    }
+
+    DenseKernelFn lookup_dense_kernel(DenseKind kind, DenseType type)
+    {
+      switch(type) {
+      case DENSE_INT32: return select_dense_kernel<int32_t>(kind);
+      case DENSE_INT64: return select_dense_kernel<int64_t>(kind);
+      case DENSE_UINT32: return select_dense_kernel<uint32_t>(kind);
+      case DENSE_UINT64: return select_dense_kernel<uint64_t>(kind);
+      case DENSE_FLOAT: return select_dense_kernel<float>(kind);
+      case DENSE_DOUBLE: return select_dense_kernel<double>(kind);
+      default: return 0;
+      }
+    }
+
+  }; // namespace ReductionKernels
+
+}; // namespace Realm
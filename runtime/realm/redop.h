@@ -29,6 +29,7 @@
 #endif
 
 #include <cstddef>
+#include <type_traits>
 
 namespace Realm {
 
@@ -72,6 +73,14 @@ namespace Realm {
                                   const void *rhs2_ptr, size_t rhs2_stride,
                                   size_t count, const void *userdata);
 
+      // optional CPU apply/fold functions for exclusive reductions where
+      //  both sides are dense (i.e. each stride equals the element size) -
+      //  these may be vectorized and are ignored if null
+      void (*cpu_apply_excl_dense_fn)(void *lhs_ptr, const void *rhs_ptr,
+                                      size_t count, const void *userdata);
+      void (*cpu_fold_excl_dense_fn)(void *rhs1_ptr, const void *rhs2_ptr,
+                                     size_t count, const void *userdata);
+
 #ifdef REALM_USE_CUDA
       // CUDA kernels for apply/fold - these are not actually the functions,
       //  but just information (e.g. host wrapper fnptr) that can be used
@@ -106,6 +115,8 @@ namespace Realm {
       , cpu_apply_nonexcl_fn(0)
       , cpu_fold_excl_fn(0)
       , cpu_fold_nonexcl_fn(0)
+      , cpu_apply_excl_dense_fn(0)
+      , cpu_fold_excl_dense_fn(0)
 #ifdef REALM_USE_CUDA
       , cuda_apply_excl_fn(0)
       , cuda_apply_nonexcl_fn(0)
@@ -160,6 +171,121 @@ namespace Realm {
           rhs2_ptr = static_cast<const char *>(rhs2_ptr) + rhs2_stride;
         }
       }
+
+      // scalar versions of the dense exclusive apply/fold - with no stride
+      //  arithmetic or aliasing to worry about, the compiler is free to
+      //  unroll (and sometimes vectorize) these itself
+      template <typename REDOP>
+      void cpu_apply_dense_wrapper(void *lhs_ptr, const void *rhs_ptr,
+                                   size_t count, const void *userdata)
+      {
+        const REDOP *redop = static_cast<const REDOP *>(userdata);
+        typename REDOP::LHS *REALM_RESTRICT lhs = static_cast<typename REDOP::LHS *>(lhs_ptr);
+        const typename REDOP::RHS *REALM_RESTRICT rhs = static_cast<const typename REDOP::RHS *>(rhs_ptr);
+        for(size_t i = 0; i < count; i++)
+          redop->template apply<true>(lhs[i], rhs[i]);
+      }
+
+      template <typename REDOP>
+      void cpu_fold_dense_wrapper(void *rhs1_ptr, const void *rhs2_ptr,
+                                  size_t count, const void *userdata)
+      {
+        const REDOP *redop = static_cast<const REDOP *>(userdata);
+        typename REDOP::RHS *REALM_RESTRICT rhs1 = static_cast<typename REDOP::RHS *>(rhs1_ptr);
+        const typename REDOP::RHS *REALM_RESTRICT rhs2 = static_cast<const typename REDOP::RHS *>(rhs2_ptr);
+        for(size_t i = 0; i < count; i++)
+          redop->template fold<true>(rhs1[i], rhs2[i]);
+      }
+
+      // a reduction op whose apply and fold are both one of these simple
+      //  elementwise operations on a builtin type (with LHS == RHS) can
+      //  define a static 'dense_kind' member to use Realm's vectorized
+      //  kernels for dense exclusive reductions, e.g.:
+      //    static constexpr ReductionKernels::DenseKind dense_kind =
+      //      ReductionKernels::DENSE_SUM;
+      // max/min must be implemented as 'if(rhs > lhs) lhs = rhs' (resp. '<')
+      //  for the vectorized kernels to match their handling of NaNs
+      enum DenseKind {
+        DENSE_NONE,
+        DENSE_SUM,   // lhs += rhs
+        DENSE_PROD,  // lhs *= rhs
+        DENSE_MIN,
+        DENSE_MAX,
+      };
+
+      enum DenseType {
+        DENSE_TYPE_NONE,
+        DENSE_INT32,
+        DENSE_INT64,
+        DENSE_UINT32,
+        DENSE_UINT64,
+        DENSE_FLOAT,
+        DENSE_DOUBLE,
+      };
+
+      template <typename T, typename ENABLE = void>
+      struct DenseTypeOf {
+        static const DenseType value = DENSE_TYPE_NONE;
+      };
+
+      template <typename T>
+      struct DenseTypeOf<T, typename std::enable_if<std::is_integral<T>::value &&
+                                                    !std::is_same<T, bool>::value &&
+                                                    ((sizeof(T) == 4) ||
+                                                     (sizeof(T) == 8))>::type> {
+        static const DenseType value = ((sizeof(T) == 4) ?
+                                          (std::is_signed<T>::value ? DENSE_INT32 :
+                                                                      DENSE_UINT32) :
+                                          (std::is_signed<T>::value ? DENSE_INT64 :
+                                                                      DENSE_UINT64));
+      };
+
+      template <> struct DenseTypeOf<float> {
+        static const DenseType value = DENSE_FLOAT;
+      };
+
+      template <> struct DenseTypeOf<double> {
+        static const DenseType value = DENSE_DOUBLE;
+      };
+
+      template <typename REDOP, typename ENABLE = void>
+      struct DenseKindOf {
+        static const DenseKind value = DENSE_NONE;
+      };
+
+      template <typename REDOP>
+      struct DenseKindOf<REDOP, decltype(void(REDOP::dense_kind))> {
+        static const DenseKind value = REDOP::dense_kind;
+      };
+
+      typedef void (*DenseKernelFn)(void *lhs_ptr, const void *rhs_ptr,
+                                    size_t count, const void *userdata);
+
+      // returns the best vectorized kernel available on this CPU for the
+      //  given operation and type, or null if there isn't one
+      REALM_PUBLIC_API
+      DenseKernelFn lookup_dense_kernel(DenseKind kind, DenseType type);
+
+      template <typename REDOP>
+      void add_dense_kernels(ReductionOpUntyped *redop)
+      {
+        typedef typename REDOP::LHS LHS;
+        typedef typename REDOP::RHS RHS;
+        const DenseKind kind = DenseKindOf<REDOP>::value;
+        DenseKernelFn apply_fn = 0;
+        DenseKernelFn fold_fn = 0;
+        if(kind != DENSE_NONE) {
+          fold_fn = lookup_dense_kernel(kind, DenseTypeOf<RHS>::value);
+          if(std::is_same<LHS, RHS>::value)
+            apply_fn = fold_fn;
+        }
+        redop->cpu_apply_excl_dense_fn = (apply_fn ?
+                                            apply_fn :
+                                            &cpu_apply_dense_wrapper<REDOP>);
+        redop->cpu_fold_excl_dense_fn = (fold_fn ?
+                                           fold_fn :
+                                           &cpu_fold_dense_wrapper<REDOP>);
+      }
     };
 
 #if defined(REALM_USE_CUDA) && defined(__CUDACC__)
@@ -240,6 +366,7 @@ namespace Realm {
         cpu_apply_nonexcl_fn = &ReductionKernels::cpu_apply_wrapper<REDOP, false>;
         cpu_fold_excl_fn = &ReductionKernels::cpu_fold_wrapper<REDOP, true>;
         cpu_fold_nonexcl_fn = &ReductionKernels::cpu_fold_wrapper<REDOP, false>;
+        ReductionKernels::add_dense_kernels<REDOP>(this);
 #if defined(REALM_USE_CUDA) && defined(__CUDACC__)
         // if REDOP defines/sets 'has_cuda_reductions' to true, try to
         //  automatically build wrappers for apply_cuda<> and fold_cuda<>
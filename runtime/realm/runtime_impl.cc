@@ -110,6 +110,10 @@ namespace Realm {
 
   extern int force_utils_cc_linkage;
 
+  // defined in logging.cc
+  extern bool has_buffered_log_output(void);
+  extern void flush_buffered_log_output(void);
+
   int *linkage_forcing[] = { &force_utils_cc_linkage };
 
 
@@ -155,8 +159,20 @@ namespace Realm {
 #endif
   }
 
+    // gets buffered log output onto disk and then lets the signal do
+    //  whatever it would have done without us
+    static void realm_flush_logs(int signal)
+    {
+      flush_buffered_log_output();
+#if defined(REALM_ON_LINUX) || defined(REALM_ON_MACOS) || defined(REALM_ON_FREEBSD)
+      unregister_error_signal_handler();
+      raise(signal);
+#endif
+    }
+
     static void realm_freeze(int signal)
     {
+      flush_buffered_log_output();
 #if defined(REALM_ON_LINUX) || defined(REALM_ON_MACOS) || defined(REALM_ON_FREEBSD)
       assert((signal == SIGINT) || (signal == SIGABRT) ||
              (signal == SIGSEGV) || (signal == SIGFPE) ||
@@ -1327,7 +1343,9 @@ namespace Realm {
 #endif
 
       cp.add_option_int("-realm:eventloopcheck", Config::event_loop_detection_limit);
+      cp.add_option_int("-ll:trigger_batch", Config::event_trigger_batch_size);
       cp.add_option_bool("-ll:force_kthreads", Config::force_kernel_threads);
+      cp.add_option_int("-ll:steal_batch", Config::task_steal_batch_size);
       cp.add_option_bool("-ll:frsrv_fallback", Config::use_fast_reservation_fallback);
       cp.add_option_int("-ll:machine_query_cache", Config::use_machine_query_cache);
       cp.add_option_int("-ll:defalloc", Config::deferred_instance_allocation);
@@ -1340,6 +1358,29 @@ namespace Realm {
       // The default of path_cache_size is 0, when it is set to non-zero, the caching is enabled.
       cp.add_option_int("-ll:path_cache_size", Config::path_cache_lru_size);
 
+      // file/disk I/O queue depth, dedicated I/O threads (0 = use the
+      //  platform's async I/O interface) and per-copy requests in flight
+      cp.add_option_int("-ll:aio_depth", Config::aio_queue_depth);
+      cp.add_option_int("-ll:aio_threads", Config::aio_worker_threads);
+      cp.add_option_int("-ll:aio_xdreqs", Config::aio_requests_per_xd);
+
+      // use dense (vectorized when possible) kernels for reduction copies
+      cp.add_option_int("-ll:dense_redop", Config::use_dense_reductions);
+
+      // launch chains of dependent subgraph tasks on the same processor as
+      //  a single task
+      cp.add_option_int("-ll:subgraph_fuse", Config::fuse_subgraph_tasks);
+
+      // minimum bytes per request for the cpu-driven dma channels, either
+      //  fixed or adapted at runtime (up to -ll:minxfer_max)
+      cp.add_option_int_units("-ll:minxfer", Config::min_xfer_size);
+      cp.add_option_int_units("-ll:minxfer_memcpy", Config::memcpy_min_xfer_size);
+      cp.add_option_int_units("-ll:minxfer_memfill", Config::memfill_min_xfer_size);
+      cp.add_option_int_units("-ll:minxfer_memreduce", Config::memreduce_min_xfer_size);
+      cp.add_option_int_units("-ll:minxfer_rwrite", Config::remote_write_min_xfer_size);
+      cp.add_option_int("-ll:minxfer_adapt", Config::adaptive_xfer_size);
+      cp.add_option_int_units("-ll:minxfer_max", Config::max_adaptive_xfer_size);
+
       bool cmdline_ok = cp.parse_command_line(cmdline);
 
       if(!cmdline_ok) {
@@ -1546,6 +1587,8 @@ namespace Realm {
         if (((realm_backtrace_env != NULL) && (atoi(realm_backtrace_env) != 0)) ||
             ((legion_backtrace_env != NULL) && (atoi(legion_backtrace_env) != 0)))
           register_error_signal_handler(realm_backtrace);
+        else if(has_buffered_log_output())
+          register_error_signal_handler(realm_flush_logs);
       }
 
       // debugging tool to dump realm event graphs after a fixed delay
@@ -1655,7 +1698,7 @@ namespace Realm {
         // warn about use of old flags
         log_runtime.warning() << "-ll:dma specified on command line no longer has effect - use -ll:bgwork to control background worker threads (which include dma work)";
       }
-      start_dma_system(&bgwork);
+      start_dma_system(&bgwork, *core_reservations, stack_size);
 
       // now that we've created all the processors/etc., we can try to come up with core
       //  allocations that satisfy everybody's requirements - this will also start up any
@@ -2771,6 +2814,7 @@ namespace Realm {
     /*static*/
     void RuntimeImpl::realm_backtrace(int signal)
     {
+      flush_buffered_log_output();
 #if defined(REALM_ON_LINUX) || defined(REALM_ON_MACOS) || defined(REALM_ON_FREEBSD)
       assert((signal == SIGILL) || (signal == SIGFPE) ||
              (signal == SIGABRT) || (signal == SIGSEGV) ||
@@ -836,6 +836,7 @@ namespace Realm {
     template void Gauge::add_gauge<AbsoluteGauge<unsigned long> >(AbsoluteGauge<unsigned long>*, SamplingProfiler*);
     template void Gauge::add_gauge<AbsoluteGauge<unsigned> >(AbsoluteGauge<unsigned>*, SamplingProfiler*);
     template void Gauge::add_gauge<AbsoluteRangeGauge<int> >(AbsoluteRangeGauge<int>*, SamplingProfiler*);
+    template void Gauge::add_gauge<EventCounter<long long> >(EventCounter<long long>*, SamplingProfiler*);
 
   };
 
@@ -0,0 +1,712 @@
+/* Copyright 2022 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// internal data structures for the shared-memory network module
+
+#include "realm/shm/shm_internal.h"
+#include "realm/shm/shm_module.h"
+
+#include "realm/runtime_impl.h"
+#include "realm/activemsg.h"
+#include "realm/logging.h"
+#include "realm/timers.h"
+
+#include <algorithm>
+#include <string>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace Realm {
+
+  extern Logger log_shm;
+
+  namespace SHM {
+
+    static size_t round_up(size_t val, size_t alignment)
+    {
+      return ((val + alignment - 1) / alignment) * alignment;
+    }
+
+    static size_t record_bytes(const RecordHeader& record)
+    {
+      size_t bytes = sizeof(RecordHeader) + record.header_size;
+      if(record.type == RECORD_INLINE)
+	bytes += record.payload_size;
+      return round_up(bytes, RECORD_ALIGNMENT);
+    }
+
+    // opens and maps a shared memory object, returning 0 if it does not
+    //  exist (yet) - a size of 0 means "use the object's current size",
+    //  which is also returned through 'bytes'
+    static void *map_object(const std::string& name, size_t& bytes)
+    {
+      int fd = shm_open(name.c_str(), O_RDWR, 0);
+      if(fd < 0) {
+	if(errno == ENOENT)
+	  return 0;
+	log_shm.fatal() << "shm_open(" << name << ") failed: " << strerror(errno);
+	abort();
+      }
+      if(bytes == 0) {
+	// the creator may not have sized the object yet
+	struct stat st;
+	if((fstat(fd, &st) != 0) || (st.st_size == 0)) {
+	  close(fd);
+	  return 0;
+	}
+	bytes = st.st_size;
+      }
+      void *base = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if(base == MAP_FAILED) {
+	log_shm.fatal() << "mmap(" << name << ", " << bytes << ") failed: "
+			<< strerror(errno);
+	abort();
+      }
+      return base;
+    }
+
+    // creates a new shared memory object, removing any stale object of the
+    //  same name left behind by a previous job that did not exit cleanly
+    static void *create_object(const std::string& name, size_t bytes)
+    {
+      shm_unlink(name.c_str());
+      int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+      if(fd < 0) {
+	log_shm.fatal() << "shm_open(" << name << ") failed: " << strerror(errno);
+	abort();
+      }
+      if(ftruncate(fd, bytes) != 0) {
+	log_shm.fatal() << "ftruncate(" << name << ", " << bytes << ") failed: "
+			<< strerror(errno);
+	abort();
+      }
+      void *base = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if(base == MAP_FAILED) {
+	log_shm.fatal() << "mmap(" << name << ", " << bytes << ") failed: "
+			<< strerror(errno);
+	abort();
+      }
+      return base;
+    }
+
+  }; // namespace SHM
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class SHMInternal
+  //
+
+  SHMInternal::SHMInternal(SHMModule *_module, RuntimeImpl *_runtime)
+    : module(_module)
+    , runtime(_runtime)
+    , num_ranks(Network::max_node_id + 1)
+    , ring_size(0)
+    , control_base(0)
+    , control_bytes(0)
+    , control(0)
+    , slots_base(0)
+    , rings_base(0)
+    , ring_stride(0)
+    , segment_bases(num_ranks, 0)
+    , segment_sizes(num_ranks, 0)
+    , outgoing(0)
+    , incoming(0)
+    , messages_sent(0)
+    , messages_rcvd(0)
+    , prev_total_rcvd(0)
+    , core_rsrv(0)
+    , poller(0)
+    , shutdown_flag(false)
+    , polls_done(0)
+  {}
+
+  SHMInternal::~SHMInternal()
+  {
+    delete[] outgoing;
+    delete[] incoming;
+  }
+
+  SHM::RankSlot *SHMInternal::rank_slot(NodeID node) const
+  {
+    return reinterpret_cast<SHM::RankSlot *>(slots_base +
+					     (node * sizeof(SHM::RankSlot)));
+  }
+
+  SHM::Ring *SHMInternal::ring(NodeID sender, NodeID receiver) const
+  {
+    size_t idx = (sender * num_ranks) + receiver;
+    return reinterpret_cast<SHM::Ring *>(rings_base + (idx * ring_stride));
+  }
+
+  char *SHMInternal::segment_base(NodeID node) const
+  {
+    return segment_bases[node];
+  }
+
+  void SHMInternal::init(const std::string& job_name, size_t _ring_size)
+  {
+    control_name = "/realm_shm." + job_name;
+
+    // the ring size has to be a power of two so that positions can be
+    //  wrapped with a mask
+    size_t act_ring_size = 4096;
+    while(act_ring_size < _ring_size)
+      act_ring_size <<= 1;
+
+    if(Network::my_node_id == 0) {
+      ring_size = act_ring_size;
+      ring_stride = sizeof(SHM::Ring) + ring_size;
+      control_bytes = (SHM::round_up(sizeof(SHM::ControlBlock), 4096) +
+		       SHM::round_up(num_ranks * sizeof(SHM::RankSlot), 4096) +
+		       (num_ranks * num_ranks * ring_stride));
+      control_base = SHM::create_object(control_name, control_bytes);
+      control = new(control_base) SHM::ControlBlock;
+      control->creator_pid = getpid();
+      control->num_ranks = num_ranks;
+      control->ring_size = ring_size;
+      control->barrier_count.store(0);
+      control->barrier_generation.store(0);
+      control->magic.store_release(SHM::CONTROL_MAGIC);
+    } else {
+      // wait for rank 0 to create and initialize the control object
+      long long t_start = Clock::current_time_in_microseconds();
+      bool warned = false;
+      while(true) {
+	size_t bytes = 0;
+	void *base = SHM::map_object(control_name, bytes);
+	if(base != 0) {
+	  SHM::ControlBlock *ctl = static_cast<SHM::ControlBlock *>(base);
+	  while(ctl->magic.load_acquire() != SHM::CONTROL_MAGIC) {
+	    if((Clock::current_time_in_microseconds() - t_start) > 1000000)
+	      break;
+	    sched_yield();
+	  }
+	  // an object whose creator is gone was left behind by an old job
+	  //  and will be replaced by rank 0 shortly
+	  if((ctl->magic.load_acquire() == SHM::CONTROL_MAGIC) &&
+	     ((kill(pid_t(ctl->creator_pid), 0) == 0) || (errno == EPERM))) {
+	    control_base = base;
+	    control_bytes = bytes;
+	    control = ctl;
+	    break;
+	  }
+	  munmap(base, bytes);
+	}
+	if(!warned &&
+	   ((Clock::current_time_in_microseconds() - t_start) > 10000000)) {
+	  log_shm.warning() << "still waiting for rank 0 to create "
+			    << control_name;
+	  warned = true;
+	}
+	usleep(1000);
+      }
+      if(control->num_ranks != size_t(num_ranks)) {
+	log_shm.fatal() << "rank count mismatch: REALM_SHM_RANKS=" << num_ranks
+			<< ", rank 0 uses " << control->num_ranks;
+	abort();
+      }
+      ring_size = control->ring_size;
+      ring_stride = sizeof(SHM::Ring) + ring_size;
+      if(ring_size != act_ring_size)
+	log_shm.info() << "using ring size " << ring_size << " from rank 0";
+    }
+
+    slots_base = (static_cast<char *>(control_base) +
+		  SHM::round_up(sizeof(SHM::ControlBlock), 4096));
+    rings_base = (slots_base +
+		  SHM::round_up(num_ranks * sizeof(SHM::RankSlot), 4096));
+    assert((rings_base + (num_ranks * num_ranks * ring_stride)) <=
+	   (static_cast<char *>(control_base) + control_bytes));
+
+    outgoing = new OutgoingRing[num_ranks];
+    incoming = new IncomingRing[num_ranks];
+    for(NodeID i = 0; i < num_ranks; i++) {
+      outgoing[i].ring = ring(Network::my_node_id, i);
+      outgoing[i].data = reinterpret_cast<char *>(outgoing[i].ring + 1);
+      incoming[i].ring = ring(i, Network::my_node_id);
+      incoming[i].data = reinterpret_cast<char *>(incoming[i].ring + 1);
+      incoming[i].in_progress = false;
+      incoming[i].partial_bytes = 0;
+    }
+
+    log_shm.info() << "rank " << Network::my_node_id << "/" << num_ranks
+		   << " attached to " << control_name << " (ring size "
+		   << ring_size << ")";
+  }
+
+  void SHMInternal::attach(std::vector<NetworkSegment *>& segments)
+  {
+    // lay out all the host memory segments that still need an allocation
+    //  in a single data segment per rank
+    size_t my_bytes = 0;
+    for(std::vector<NetworkSegment *>::iterator it = segments.begin();
+	it != segments.end();
+	++it) {
+      if((*it)->bytes == 0) continue;
+      if((*it)->base != 0) continue;
+      if((*it)->memtype != NetworkSegmentInfo::HostMem) continue;
+      size_t align = std::max((*it)->alignment, SHM::CACHE_LINE);
+      my_bytes = SHM::round_up(my_bytes, align) + (*it)->bytes;
+    }
+    my_bytes = SHM::round_up(my_bytes, 4096);
+
+    const NodeID me = Network::my_node_id;
+    std::string prefix = control_name + ".";
+    if(my_bytes > 0) {
+      char *base = static_cast<char *>(SHM::create_object(prefix + std::to_string(me),
+							  my_bytes));
+      segment_bases[me] = base;
+      segment_sizes[me] = my_bytes;
+
+      size_t offset = 0;
+      for(std::vector<NetworkSegment *>::iterator it = segments.begin();
+	  it != segments.end();
+	  ++it) {
+	if((*it)->bytes == 0) continue;
+	if((*it)->base != 0) continue;
+	if((*it)->memtype != NetworkSegmentInfo::HostMem) continue;
+	size_t align = std::max((*it)->alignment, SHM::CACHE_LINE);
+	offset = SHM::round_up(offset, align);
+	(*it)->base = base + offset;
+	// the rdma info is the offset within our data segment
+	uint64_t rdma_offset = offset;
+	(*it)->add_rdma_info(module, &rdma_offset, sizeof(rdma_offset));
+	offset += (*it)->bytes;
+      }
+    }
+    rank_slot(me)->segment_bytes.store_release(my_bytes);
+
+    // once everybody has created their segment, map everybody else's
+    barrier();
+    for(NodeID i = 0; i < num_ranks; i++) {
+      if(i == me) continue;
+      size_t bytes = rank_slot(i)->segment_bytes.load_acquire();
+      if(bytes == 0) continue;
+      void *base = SHM::map_object(prefix + std::to_string(i), bytes);
+      if(base == 0) {
+	log_shm.fatal() << "data segment for rank " << i << " is missing";
+	abort();
+      }
+      segment_bases[i] = static_cast<char *>(base);
+      segment_sizes[i] = bytes;
+    }
+
+    // after everybody has mapped everything, the names are no longer needed
+    //  and removing them now means nothing is left behind in /dev/shm
+    barrier();
+    if(my_bytes > 0)
+      shm_unlink((prefix + std::to_string(me)).c_str());
+    if(me == 0)
+      shm_unlink(control_name.c_str());
+
+    core_rsrv = new CoreReservation("SHM poller", *(runtime->core_reservations),
+				    CoreReservationParameters());
+    ThreadLaunchParameters tlp;
+    poller = Thread::create_kernel_thread<SHMInternal,
+					  &SHMInternal::poller_loop>(this, tlp,
+								     *core_rsrv);
+  }
+
+  void SHMInternal::detach()
+  {
+    // wait for everybody before the poller goes away - it keeps draining
+    //  the rings while we wait
+    barrier();
+
+    shutdown_flag.store(true);
+    poller->join();
+    delete poller;
+    poller = 0;
+    delete core_rsrv;
+    core_rsrv = 0;
+
+    for(NodeID i = 0; i < num_ranks; i++)
+      if(segment_bases[i] != 0) {
+	munmap(segment_bases[i], segment_sizes[i]);
+	segment_bases[i] = 0;
+      }
+    munmap(control_base, control_bytes);
+    control_base = 0;
+    control = 0;
+  }
+
+  void SHMInternal::barrier()
+  {
+    unsigned gen = control->barrier_generation.load_acquire();
+    if(control->barrier_count.fetch_add_acqrel(1) == unsigned(num_ranks - 1)) {
+      // last arrival resets the count before releasing everybody else
+      control->barrier_count.store(0);
+      control->barrier_generation.store_release(gen + 1);
+    } else {
+      while(control->barrier_generation.load_acquire() == gen)
+	sched_yield();
+    }
+  }
+
+  void SHMInternal::broadcast(NodeID root, const void *val_in, void *val_out,
+			      size_t bytes)
+  {
+    const NodeID me = Network::my_node_id;
+    if(me == root)
+      memcpy(val_out, val_in, bytes);
+    char *scratch = rank_slot(root)->scratch;
+    for(size_t ofs = 0; ofs < bytes; ofs += SHM::COLLECTIVE_SCRATCH) {
+      size_t chunk = std::min(bytes - ofs, SHM::COLLECTIVE_SCRATCH);
+      if(me == root)
+	memcpy(scratch, static_cast<const char *>(val_in) + ofs, chunk);
+      barrier();
+      if(me != root)
+	memcpy(static_cast<char *>(val_out) + ofs, scratch, chunk);
+      barrier();
+    }
+  }
+
+  void SHMInternal::gather(NodeID root, const void *val_in, void *vals_out,
+			   size_t bytes)
+  {
+    const NodeID me = Network::my_node_id;
+    for(size_t ofs = 0; ofs < bytes; ofs += SHM::COLLECTIVE_SCRATCH) {
+      size_t chunk = std::min(bytes - ofs, SHM::COLLECTIVE_SCRATCH);
+      memcpy(rank_slot(me)->scratch,
+	     static_cast<const char *>(val_in) + ofs, chunk);
+      barrier();
+      if(me == root)
+	for(NodeID i = 0; i < num_ranks; i++)
+	  memcpy(static_cast<char *>(vals_out) + (i * bytes) + ofs,
+		 rank_slot(i)->scratch, chunk);
+      barrier();
+    }
+  }
+
+  bool SHMInternal::check_for_quiescence()
+  {
+    // ensure some progress happens on the poller before each quiescence check
+    ensure_polling_progress();
+
+    SHM::RankSlot *slot = rank_slot(Network::my_node_id);
+    slot->message_counts[0] = messages_sent.load();
+    slot->message_counts[1] = messages_rcvd.load();
+    barrier();
+    uint64_t totals[2] = { 0, 0 };
+    for(NodeID i = 0; i < num_ranks; i++) {
+      totals[0] += rank_slot(i)->message_counts[0];
+      totals[1] += rank_slot(i)->message_counts[1];
+    }
+    // nobody may overwrite their counts until everybody has read them
+    barrier();
+
+    // we're quiescent if:
+    //  a) the total messages rcvd is the same as total sent (i.e. none in
+    //      flight), and
+    //  b) the total messages rcvd is the same as last attempt (i.e. no new
+    //      messages showed up during the check)
+    bool quiesced = ((totals[0] == totals[1]) &&
+		     (totals[1] == prev_total_rcvd));
+    prev_total_rcvd = totals[1];
+    return quiesced;
+  }
+
+  void SHMInternal::ring_write(OutgoingRing& out, uint64_t& pos,
+			       const void *data, size_t bytes)
+  {
+    const char *src = static_cast<const char *>(data);
+    while(bytes > 0) {
+      size_t avail = ring_size - (pos - out.ring->tail.load_acquire());
+      if(avail == 0) {
+	// publish what we have so far so that the receiver can drain it -
+	//  records larger than the ring are streamed this way
+	out.ring->head.store_release(pos);
+	sched_yield();
+	continue;
+      }
+      size_t ofs = pos & (ring_size - 1);
+      size_t chunk = std::min(std::min(bytes, avail), ring_size - ofs);
+      memcpy(out.data + ofs, src, chunk);
+      pos += chunk;
+      src += chunk;
+      bytes -= chunk;
+    }
+  }
+
+  void SHMInternal::ring_read(IncomingRing& in, uint64_t pos,
+			      void *data, size_t bytes)
+  {
+    char *dst = static_cast<char *>(data);
+    while(bytes > 0) {
+      size_t ofs = pos & (ring_size - 1);
+      size_t chunk = std::min(bytes, ring_size - ofs);
+      memcpy(dst, in.data + ofs, chunk);
+      pos += chunk;
+      dst += chunk;
+      bytes -= chunk;
+    }
+  }
+
+  void SHMInternal::send_message(NodeID target, unsigned short msgid,
+				 const void *hdr, size_t hdr_size,
+				 const void *payload, size_t payload_size,
+				 size_t payload_lines,
+				 size_t payload_line_stride,
+				 int64_t dest_offset, void *remote_comp)
+  {
+    assert(target != Network::my_node_id);
+
+    SHM::RecordHeader record;
+    record.header_size = hdr_size;
+    record.payload_size = payload_size;
+    record.msgid = msgid;
+    record.pad = 0;
+    record.comp_ptr = reinterpret_cast<uintptr_t>(remote_comp);
+    record.dest_offset = 0;
+
+    size_t line_size = ((payload_lines > 1) ?
+			  (payload_size / payload_lines) :
+			  payload_size);
+    if(dest_offset >= 0) {
+      // the target's data segment is mapped in our address space, so the
+      //  "put" is a plain copy that completes before the record is visible
+      assert(size_t(dest_offset + payload_size) <= segment_sizes[target]);
+      char *dst = segment_bases[target] + dest_offset;
+      if(payload_lines > 1) {
+	for(size_t i = 0; i < payload_lines; i++)
+	  memcpy(dst + (i * line_size),
+		 static_cast<const char *>(payload) + (i * payload_line_stride),
+		 line_size);
+      } else if(payload_size > 0)
+	memcpy(dst, payload, payload_size);
+      record.type = SHM::RECORD_RDMA;
+      record.dest_offset = dest_offset;
+    } else
+      record.type = SHM::RECORD_INLINE;
+
+    size_t total = SHM::record_bytes(record);
+    OutgoingRing& out = outgoing[target];
+    {
+      AutoLock<> al(out.mutex);
+      uint64_t pos = out.ring->head.load();
+      uint64_t start = pos;
+      ring_write(out, pos, &record, sizeof(record));
+      ring_write(out, pos, hdr, hdr_size);
+      if(record.type == SHM::RECORD_INLINE) {
+	if(payload_lines > 1) {
+	  for(size_t i = 0; i < payload_lines; i++)
+	    ring_write(out, pos,
+		       static_cast<const char *>(payload) + (i * payload_line_stride),
+		       line_size);
+	} else
+	  ring_write(out, pos, payload, payload_size);
+      }
+      // padding bytes are never read, so just skip over them
+      size_t padding = total - (pos - start);
+      if(padding > 0) {
+	static const char zeros[SHM::RECORD_ALIGNMENT] = { 0 };
+	ring_write(out, pos, zeros, padding);
+      }
+      out.ring->head.store_release(pos);
+    }
+    messages_sent.fetch_add(1);
+  }
+
+  /*static*/ void SHMInternal::incoming_message_handled(NodeID sender,
+							uintptr_t comp_ptr,
+							uintptr_t internal_ptr)
+  {
+    SHMInternal *internal = reinterpret_cast<SHMInternal *>(internal_ptr);
+    internal->queue_completion(sender, comp_ptr);
+  }
+
+  void SHMInternal::queue_completion(NodeID target, uintptr_t comp_ptr)
+  {
+    // completions are sent by the poller, which must never block on a
+    //  full ring (the peer's poller might be doing the same thing)
+    messages_sent.fetch_add(1);
+    AutoLock<> al(completion_mutex);
+    pending_completions.push_back(std::make_pair(target, comp_ptr));
+  }
+
+  bool SHMInternal::try_send_completion(NodeID target, uintptr_t comp_ptr)
+  {
+    OutgoingRing& out = outgoing[target];
+    if(!out.mutex.trylock())
+      return false;
+    uint64_t pos = out.ring->head.load();
+    if((ring_size - (pos - out.ring->tail.load_acquire())) <
+       sizeof(SHM::RecordHeader)) {
+      out.mutex.unlock();
+      return false;
+    }
+    SHM::RecordHeader record;
+    memset(&record, 0, sizeof(record));
+    record.type = SHM::RECORD_COMPLETION;
+    record.comp_ptr = comp_ptr;
+    ring_write(out, pos, &record, sizeof(record));
+    out.ring->head.store_release(pos);
+    out.mutex.unlock();
+    return true;
+  }
+
+  bool SHMInternal::flush_completions()
+  {
+    std::vector<std::pair<NodeID, uintptr_t> > to_send;
+    {
+      AutoLock<> al(completion_mutex);
+      if(pending_completions.empty())
+	return false;
+      to_send.swap(pending_completions);
+    }
+    std::vector<std::pair<NodeID, uintptr_t> > leftover;
+    for(size_t i = 0; i < to_send.size(); i++)
+      if(!try_send_completion(to_send[i].first, to_send[i].second))
+	leftover.push_back(to_send[i]);
+    if(!leftover.empty()) {
+      AutoLock<> al(completion_mutex);
+      pending_completions.insert(pending_completions.begin(),
+				 leftover.begin(), leftover.end());
+    }
+    return (leftover.size() < to_send.size());
+  }
+
+  bool SHMInternal::poll_ring(NodeID sender)
+  {
+    IncomingRing& in = incoming[sender];
+    // we are the only consumer, so our view of the tail is always current
+    uint64_t tail = in.ring->tail.load();
+    uint64_t head = in.ring->head.load_acquire();
+    bool progress = false;
+    while(head != tail) {
+      if(!in.in_progress) {
+	if((head - tail) < sizeof(SHM::RecordHeader))
+	  break;
+	ring_read(in, tail, &in.record, sizeof(SHM::RecordHeader));
+	size_t total = SHM::record_bytes(in.record);
+	size_t ofs = tail & (ring_size - 1);
+	if(((head - tail) >= total) && ((ofs + total) <= ring_size)) {
+	  // common case: the whole record is contiguous in the ring, so hand
+	  //  it over from there (the message manager makes copies)
+	  dispatch(sender, in.record,
+		   in.data + ofs + sizeof(SHM::RecordHeader));
+	  tail += total;
+	  in.ring->tail.store_release(tail);
+	  progress = true;
+	  continue;
+	}
+	// otherwise assemble the record in a local buffer, consuming ring
+	//  space as we go so that the sender can keep streaming
+	in.in_progress = true;
+	in.partial.resize(total - sizeof(SHM::RecordHeader));
+	in.partial_bytes = 0;
+	tail += sizeof(SHM::RecordHeader);
+      }
+      size_t needed = in.partial.size() - in.partial_bytes;
+      size_t chunk = std::min(needed, size_t(head - tail));
+      ring_read(in, tail, in.partial.data() + in.partial_bytes, chunk);
+      in.partial_bytes += chunk;
+      tail += chunk;
+      in.ring->tail.store_release(tail);
+      progress = true;
+      if(in.partial_bytes < in.partial.size())
+	break;
+      in.in_progress = false;
+      dispatch(sender, in.record, in.partial.data());
+    }
+    return progress;
+  }
+
+  void SHMInternal::dispatch(NodeID sender, const SHM::RecordHeader& record,
+			     const char *body)
+  {
+    messages_rcvd.fetch_add(1);
+
+    if(record.type == SHM::RECORD_COMPLETION) {
+      SHM::complete_remote(reinterpret_cast<void *>(record.comp_ptr));
+      return;
+    }
+
+    const void *payload;
+    int payload_mode;
+    if(record.type == SHM::RECORD_RDMA) {
+      payload = segment_bases[Network::my_node_id] + record.dest_offset;
+      payload_mode = PAYLOAD_KEEP;  // already in dest memory
+    } else {
+      payload = body + record.header_size;
+      payload_mode = PAYLOAD_COPY;
+    }
+
+    // inline handlers are not run on the poller, as a handler that sends
+    //  a message could block on a full ring while the peer's poller is
+    //  stuck the same way
+    bool handled = runtime->message_manager->add_incoming_message(sender,
+								  record.msgid,
+								  body,
+								  record.header_size,
+								  PAYLOAD_COPY,
+								  payload,
+								  record.payload_size,
+								  payload_mode,
+								  ((record.comp_ptr != 0) ?
+								     incoming_message_handled :
+								     0),
+								  record.comp_ptr,
+								  reinterpret_cast<uintptr_t>(this),
+								  TimeLimit::relative(0));
+    if(handled && (record.comp_ptr != 0))
+      queue_completion(sender, record.comp_ptr);
+  }
+
+  void SHMInternal::poller_loop()
+  {
+    unsigned idle_polls = 0;
+    while(!shutdown_flag.load()) {
+      bool progress = flush_completions();
+      for(NodeID i = 0; i < num_ranks; i++)
+	if((i != Network::my_node_id) && poll_ring(i))
+	  progress = true;
+      polls_done.fetch_add(1);
+      if(progress) {
+	idle_polls = 0;
+	continue;
+      }
+      // ranks often outnumber cores when testing on small machines, and a
+      //  poller that only yields can starve the threads that would
+      //  generate (or handle) traffic, so back off to short sleeps once
+      //  the rings have been quiet for a while
+      if(idle_polls < SPIN_POLLS) {
+	idle_polls++;
+	sched_yield();
+      } else
+	usleep(IDLE_SLEEP_US);
+    }
+  }
+
+  void SHMInternal::ensure_polling_progress()
+  {
+    assert(!shutdown_flag.load());
+    unsigned prev = polls_done.load();
+    while(prev == polls_done.load())
+      sched_yield();
+  }
+
+}; // namespace Realm
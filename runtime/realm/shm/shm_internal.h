@@ -0,0 +1,207 @@
+/* Copyright 2022 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// internal data structures for the shared-memory network module
+
+#ifndef SHM_INTERNAL_H
+#define SHM_INTERNAL_H
+
+#include "realm/network.h"
+#include "realm/atomics.h"
+#include "realm/mutex.h"
+#include "realm/threads.h"
+
+#include <string>
+#include <vector>
+
+namespace Realm {
+
+  class SHMModule;
+
+  namespace SHM {
+
+    // the job-wide control object contains a ControlBlock, one RankSlot per
+    //  rank and then one Ring for every ordered (sender, receiver) pair -
+    //  all offsets are computed identically by every rank from the number
+    //  of ranks and the ring size published by rank 0
+
+    static const uint64_t CONTROL_MAGIC = 0x5265616c6d53484dULL; // "RealmSHM"
+    static const size_t CACHE_LINE = 64;
+    static const size_t COLLECTIVE_SCRATCH = 64 << 10;
+
+    struct ControlBlock {
+      atomic<uint64_t> magic;        // written last by rank 0
+      uint64_t creator_pid;          // used to detect stale objects
+      uint64_t num_ranks;
+      uint64_t ring_size;
+      char pad0[CACHE_LINE - 4 * sizeof(uint64_t)];
+      atomic<unsigned> barrier_count;
+      char pad1[CACHE_LINE - sizeof(unsigned)];
+      atomic<unsigned> barrier_generation;
+      char pad2[CACHE_LINE - sizeof(unsigned)];
+    };
+
+    struct RankSlot {
+      atomic<uint64_t> segment_bytes;
+      uint64_t message_counts[2];  // sent, received (for quiescence checks)
+      char pad[CACHE_LINE - 3 * sizeof(uint64_t)];
+      char scratch[COLLECTIVE_SCRATCH];
+    };
+
+    // a single-producer/single-consumer byte ring - 'head' and 'tail' are
+    //  monotonically increasing byte counts and the ring data immediately
+    //  follows this structure
+    struct Ring {
+      atomic<uint64_t> head;
+      char pad0[CACHE_LINE - sizeof(uint64_t)];
+      atomic<uint64_t> tail;
+      char pad1[CACHE_LINE - sizeof(uint64_t)];
+    };
+
+    enum RecordType {
+      RECORD_INLINE,      // header and payload follow in the ring
+      RECORD_RDMA,        // payload was already written to dest_offset
+      RECORD_COMPLETION,  // remote completion for a message we sent
+    };
+
+    // every message in a ring starts with one of these - records are padded
+    //  to a multiple of 8 bytes
+    struct RecordHeader {
+      uint32_t header_size;
+      uint32_t payload_size;
+      uint16_t msgid;
+      uint16_t type;
+      uint32_t pad;
+      uint64_t comp_ptr;
+      uint64_t dest_offset;
+    };
+
+    static const size_t RECORD_ALIGNMENT = 8;
+
+    // invokes and destroys the remote completions of a message we sent
+    void complete_remote(void *comp);
+
+  }; // namespace SHM
+
+  class SHMInternal {
+  public:
+    SHMInternal(SHMModule *_module, RuntimeImpl *_runtime);
+    ~SHMInternal();
+
+    // maps (and on rank 0, creates) the job-wide control object
+    void init(const std::string& job_name, size_t ring_size);
+
+    // allocates this rank's data segment, binds the requested network
+    //  segments to it and maps every other rank's data segment
+    void attach(std::vector<NetworkSegment *>& segments);
+
+    void detach();
+
+    void barrier();
+    void broadcast(NodeID root, const void *val_in, void *val_out,
+		   size_t bytes);
+    void gather(NodeID root, const void *val_in, void *vals_out,
+		size_t bytes);
+    bool check_for_quiescence();
+
+    // sends a message - the caller guarantees 'dest_offset' (if not -1) is
+    //  an offset into the target's data segment
+    void send_message(NodeID target, unsigned short msgid,
+		      const void *hdr, size_t hdr_size,
+		      const void *payload, size_t payload_size,
+		      size_t payload_lines, size_t payload_line_stride,
+		      int64_t dest_offset, void *remote_comp);
+
+    char *segment_base(NodeID node) const;
+
+    // callback for the incoming message manager when a message that needs
+    //  a remote completion has been handled
+    static void incoming_message_handled(NodeID sender,
+					 uintptr_t comp_ptr,
+					 uintptr_t internal_ptr);
+
+  protected:
+    struct OutgoingRing {
+      SHM::Ring *ring;
+      char *data;
+      Mutex mutex;  // serializes the senders in this process
+    };
+
+    struct IncomingRing {
+      SHM::Ring *ring;
+      char *data;
+      // state for a record that could not be dispatched directly from the
+      //  ring because it wraps or is not completely written yet
+      bool in_progress;
+      SHM::RecordHeader record;
+      std::vector<char> partial;
+      size_t partial_bytes;
+    };
+
+    SHM::RankSlot *rank_slot(NodeID node) const;
+    SHM::Ring *ring(NodeID sender, NodeID receiver) const;
+
+    void ring_write(OutgoingRing& out, uint64_t& pos,
+		    const void *data, size_t bytes);
+    void ring_read(IncomingRing& in, uint64_t pos, void *data, size_t bytes);
+
+    void queue_completion(NodeID target, uintptr_t comp_ptr);
+    bool try_send_completion(NodeID target, uintptr_t comp_ptr);
+    bool flush_completions();
+
+    bool poll_ring(NodeID sender);
+    void dispatch(NodeID sender, const SHM::RecordHeader& record,
+		  const char *body);
+
+    // the poller spins for this many empty polls before it starts sleeping
+    static const unsigned SPIN_POLLS = 1024;
+    static const unsigned IDLE_SLEEP_US = 20;
+
+    void poller_loop();
+    void ensure_polling_progress();
+
+    SHMModule *module;
+    RuntimeImpl *runtime;
+    std::string control_name;
+    NodeID num_ranks;
+    size_t ring_size;
+    void *control_base;
+    size_t control_bytes;
+    SHM::ControlBlock *control;
+    char *slots_base;
+    char *rings_base;
+    size_t ring_stride;
+
+    std::vector<char *> segment_bases;
+    std::vector<size_t> segment_sizes;
+
+    OutgoingRing *outgoing;
+    IncomingRing *incoming;
+
+    Mutex completion_mutex;
+    std::vector<std::pair<NodeID, uintptr_t> > pending_completions;
+
+    atomic<size_t> messages_sent, messages_rcvd;
+    size_t prev_total_rcvd;
+
+    CoreReservation *core_rsrv;
+    Thread *poller;
+    atomic<bool> shutdown_flag;
+    atomic<unsigned> polls_done;
+  };
+
+}; // namespace Realm
+
+#endif
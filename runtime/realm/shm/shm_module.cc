@@ -0,0 +1,597 @@
+/* Copyright 2022 Stanford University, NVIDIA Corporation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// shared-memory network module implementation for Realm
+
+#include "realm/network.h"
+
+#include "realm/shm/shm_module.h"
+#include "realm/shm/shm_internal.h"
+
+#include "realm/runtime_impl.h"
+#include "realm/mem_impl.h"
+#include "realm/logging.h"
+#include "realm/cmdline.h"
+#include "realm/transfer/ib_memory.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace Realm {
+
+  Logger log_shm("shm");
+
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class SHMRemoteMemory
+    //
+
+    /* A block of memory in another process's data segment, which is mapped
+     * into our address space as well
+     * Parent class RemoteMemory has node id in me.memory_owner_node()
+     */
+    class SHMRemoteMemory : public RemoteMemory {
+      public:
+        SHMRemoteMemory(Memory _me, size_t _size, Memory::Kind k,
+			char *_base, uint64_t _segment_offset);
+
+        virtual void get_bytes(off_t offset, void *dst, size_t size);
+        virtual void put_bytes(off_t offset, const void *src, size_t size);
+
+        virtual bool get_remote_addr(off_t offset, RemoteAddress& remote_addr);
+
+      protected:
+        char *base;
+        uint64_t segment_offset;
+    };
+
+    SHMRemoteMemory::SHMRemoteMemory(Memory _me, size_t _size,
+				     Memory::Kind k,
+				     char *_base, uint64_t _segment_offset)
+        : RemoteMemory(_me, _size, k, MKIND_RDMA)
+        , base(_base)
+        , segment_offset(_segment_offset)
+    {
+    }
+
+    void SHMRemoteMemory::get_bytes(off_t offset, void *dst, size_t size)
+    {
+        memcpy(dst, base + offset, size);
+    }
+
+    void SHMRemoteMemory::put_bytes(off_t offset, const void *src, size_t size)
+    {
+        memcpy(base + offset, src, size);
+    }
+
+    bool SHMRemoteMemory::get_remote_addr(off_t offset, RemoteAddress& remote_addr)
+    {
+        // puts use offsets into the owner's data segment
+        remote_addr.ptr = (segment_offset + offset);
+	return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class SHMIBMemory
+    //
+
+    class SHMIBMemory : public IBMemory {
+    public:
+      SHMIBMemory(Memory _me, size_t _size, Memory::Kind k,
+		  uint64_t _segment_offset);
+
+      virtual bool get_remote_addr(off_t offset, RemoteAddress& remote_addr);
+
+    protected:
+      uint64_t segment_offset;
+    };
+
+    SHMIBMemory::SHMIBMemory(Memory _me, size_t _size, Memory::Kind k,
+			     uint64_t _segment_offset)
+      : IBMemory(_me, _size, MKIND_REMOTE, k, 0, 0)
+      , segment_offset(_segment_offset)
+    {}
+
+    bool SHMIBMemory::get_remote_addr(off_t offset, RemoteAddress& remote_addr)
+    {
+        // puts use offsets into the owner's data segment
+        remote_addr.ptr = (segment_offset + offset);
+	return true;
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // struct CompletionList
+    //
+
+    struct CompletionList {
+      size_t bytes;
+
+      static const size_t TOTAL_CAPACITY = 256;
+      typedef char Storage_unaligned[TOTAL_CAPACITY];
+      REALM_ALIGNED_TYPE_CONST(Storage_aligned, Storage_unaligned,
+			       Realm::CompletionCallbackBase::ALIGNMENT);
+      Storage_aligned storage;
+    };
+
+    // callback to invoke remote completions
+    void SHM::complete_remote(void *comp)
+    {
+        CompletionList *remote_comp = static_cast<CompletionList *>(comp);
+	CompletionCallbackBase::invoke_all(remote_comp->storage,
+					   remote_comp->bytes);
+	CompletionCallbackBase::destroy_all(remote_comp->storage,
+					    remote_comp->bytes);
+	delete remote_comp;
+    }
+
+
+    ////////////////////////////////////////////////////////////////////////
+    //
+    // class SHMMessageImpl
+    //
+
+    class SHMMessageImpl : public ActiveMessageImpl {
+      public:
+        SHMMessageImpl(SHMInternal *_internal,
+		       NodeID _target,
+		       unsigned short _msgid,
+		       size_t _header_size,
+		       size_t _max_payload_size,
+		       const void *_src_payload_addr,
+		       size_t _src_payload_lines,
+		       size_t _src_payload_line_stride,
+		       int64_t _dest_payload_offset);
+        SHMMessageImpl(SHMInternal *_internal,
+		       const Realm::NodeSet &_targets,
+		       unsigned short _msgid,
+		       size_t _header_size,
+		       size_t _max_payload_size,
+		       const void *_src_payload_addr,
+		       size_t _src_payload_lines,
+		       size_t _src_payload_line_stride);
+
+        virtual ~SHMMessageImpl();
+
+        // reserves space for a local/remote completion - caller will
+        //  placement-new the completion at the provided address
+        virtual void *add_local_completion(size_t size);
+        virtual void *add_remote_completion(size_t size);
+
+        virtual void commit(size_t act_payload_size);
+        virtual void cancel();
+
+      protected:
+        SHMInternal *internal;
+        NodeID target;
+        Realm::NodeSet targets;
+        bool is_multicast;
+        const void *src_payload_addr;
+        size_t src_payload_lines;
+        size_t src_payload_line_stride;
+        int64_t dest_payload_offset;
+        size_t header_size;
+        CompletionList *local_comp, *remote_comp;
+
+        unsigned short msgid;
+        unsigned long msg_header;
+        // nothing should appear after 'msg_header'
+    };
+
+    SHMMessageImpl::SHMMessageImpl(SHMInternal *_internal,
+				   NodeID _target,
+				   unsigned short _msgid,
+				   size_t _header_size,
+				   size_t _max_payload_size,
+				   const void *_src_payload_addr,
+				   size_t _src_payload_lines,
+				   size_t _src_payload_line_stride,
+				   int64_t _dest_payload_offset)
+        : internal(_internal)
+        , target(_target)
+        , is_multicast(false)
+	, src_payload_addr(_src_payload_addr)
+	, src_payload_lines(_src_payload_lines)
+	, src_payload_line_stride(_src_payload_line_stride)
+	, dest_payload_offset(_dest_payload_offset)
+        , header_size(_header_size)
+	, local_comp(0)
+	, remote_comp(0)
+        , msgid(_msgid)
+    {
+        if(_max_payload_size && (src_payload_addr == 0)) {
+            payload_base = reinterpret_cast<char *>(malloc(_max_payload_size));
+        } else {
+            payload_base = 0;
+        }
+        payload_size = _max_payload_size;
+        header_base = &msg_header;
+    }
+
+    SHMMessageImpl::SHMMessageImpl(SHMInternal *_internal,
+				   const Realm::NodeSet &_targets,
+				   unsigned short _msgid,
+				   size_t _header_size,
+				   size_t _max_payload_size,
+				   const void *_src_payload_addr,
+				   size_t _src_payload_lines,
+				   size_t _src_payload_line_stride)
+        : internal(_internal)
+        , targets(_targets)
+        , is_multicast(true)
+	, src_payload_addr(_src_payload_addr)
+	, src_payload_lines(_src_payload_lines)
+	, src_payload_line_stride(_src_payload_line_stride)
+        , dest_payload_offset(-1)
+        , header_size(_header_size)
+	, local_comp(0)
+	, remote_comp(0)
+        , msgid(_msgid)
+    {
+        if(_max_payload_size && (src_payload_addr == 0)) {
+            payload_base = reinterpret_cast<char *>(malloc(_max_payload_size));
+        } else {
+            payload_base = 0;
+        }
+        payload_size = _max_payload_size;
+        header_base = &msg_header;
+    }
+
+    SHMMessageImpl::~SHMMessageImpl()
+    {
+    }
+
+    void *SHMMessageImpl::add_local_completion(size_t size)
+    {
+      if(local_comp == 0) {
+	local_comp = new CompletionList;
+	local_comp->bytes = 0;
+      }
+      size_t ofs = local_comp->bytes;
+      local_comp->bytes += size;
+      assert(local_comp->bytes <= CompletionList::TOTAL_CAPACITY);
+      return (local_comp->storage + ofs);
+    }
+
+    void *SHMMessageImpl::add_remote_completion(size_t size)
+    {
+      if(remote_comp == 0) {
+	remote_comp = new CompletionList;
+	remote_comp->bytes = 0;
+      }
+      size_t ofs = remote_comp->bytes;
+      remote_comp->bytes += size;
+      assert(remote_comp->bytes <= CompletionList::TOTAL_CAPACITY);
+      return (remote_comp->storage + ofs);
+    }
+
+    void SHMMessageImpl::commit(size_t act_payload_size)
+    {
+        if(is_multicast) {
+	    assert(dest_payload_offset < 0);
+	    assert(remote_comp == 0);
+	    for(NodeSet::const_iterator it = targets.begin();
+		it != targets.end();
+		++it)
+	      if(src_payload_addr != 0)
+		internal->send_message(*it, msgid, &msg_header, header_size,
+				       src_payload_addr, act_payload_size,
+				       src_payload_lines, src_payload_line_stride,
+				       -1, 0);
+	      else
+		internal->send_message(*it, msgid, &msg_header, header_size,
+				       payload_base, act_payload_size, 0, 0,
+				       -1, 0);
+        } else {
+	    if(src_payload_addr != 0)
+	      internal->send_message(target, msgid, &msg_header, header_size,
+				     src_payload_addr, act_payload_size,
+				     src_payload_lines, src_payload_line_stride,
+				     dest_payload_offset, remote_comp);
+	    else
+	      internal->send_message(target, msgid, &msg_header, header_size,
+				     payload_base, act_payload_size, 0, 0,
+				     dest_payload_offset, remote_comp);
+        }
+	if(payload_size && (src_payload_addr == 0))
+	  free(payload_base);
+	// the data has been copied into the ring or the target's segment by
+	//  the time send_message returns, so we can always do local
+	//  completion here
+	if(local_comp != 0) {
+	  CompletionCallbackBase::invoke_all(local_comp->storage,
+					     local_comp->bytes);
+	  CompletionCallbackBase::destroy_all(local_comp->storage,
+					      local_comp->bytes);
+	  delete local_comp;
+	}
+    }
+
+    void SHMMessageImpl::cancel()
+    {
+	if(payload_size && (src_payload_addr == 0))
+            free(payload_base);
+    }
+
+
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class SHMModule
+  //
+
+  SHMModule::SHMModule(RuntimeImpl *_runtime)
+    : NetworkModule("shm")
+    , internal(new SHMInternal(this, _runtime))
+    , cfg_ring_size(1 << 20)
+    , cfg_max_inline(64 << 10)
+  {}
+
+  SHMModule::~SHMModule()
+  {
+    delete internal;
+  }
+
+  /*static*/ NetworkModule *SHMModule::create_network_module(RuntimeImpl *runtime,
+							    int *argc,
+							    const char ***argv)
+  {
+    // the shared memory network is only used when the launcher describes
+    //  the job through the environment
+    const char *e_ranks = getenv("REALM_SHM_RANKS");
+    const char *e_rank = getenv("REALM_SHM_RANK");
+    if(!e_ranks || !e_rank)
+      return 0;
+
+    int num_ranks = atoi(e_ranks);
+    int rank = atoi(e_rank);
+    if((num_ranks < 1) || (rank < 0) || (rank >= num_ranks)) {
+      // no loggers yet - use stderr
+      fprintf(stderr, "ERROR: invalid shm rank: REALM_SHM_RANK=%s REALM_SHM_RANKS=%s\n",
+	      e_rank, e_ranks);
+      return 0;
+    }
+
+    Network::my_node_id = rank;
+    Network::max_node_id = num_ranks - 1;
+    Network::all_peers.add_range(0, num_ranks - 1);
+    Network::all_peers.remove(rank);
+
+    SHMModule *m = new SHMModule(runtime);
+    const char *e_job = getenv("REALM_SHM_JOB");
+    if(e_job)
+      m->job_name = e_job;
+    else
+      m->job_name = std::to_string(getppid());
+    return m;
+  }
+
+  // actual parsing of the command line should wait until here if at all
+  //  possible
+  void SHMModule::parse_command_line(RuntimeImpl *runtime,
+				     std::vector<std::string>& cmdline)
+  {
+    CommandLineParser cp;
+    cp.add_option_int_units("-ll:shm_ring", cfg_ring_size, 'k')
+      .add_option_int_units("-ll:shm_inline", cfg_max_inline, 'k');
+
+    bool ok = cp.parse_command_line(cmdline);
+    assert(ok);
+
+    // rank 0 creates the shared objects, using its ring size for everybody
+    internal->init(job_name, cfg_ring_size);
+  }
+
+  // "attaches" to the network, if that is meaningful - attempts to
+  //  bind/register/(pick your network-specific verb) the requested memory
+  //  segments with the network
+  void SHMModule::attach(RuntimeImpl *runtime,
+			 std::vector<NetworkSegment *>& segments)
+  {
+    internal->attach(segments);
+  }
+
+  // detaches from the network
+  void SHMModule::detach(RuntimeImpl *runtime,
+			 std::vector<NetworkSegment *>& segments)
+  {
+    internal->detach();
+  }
+
+  // collective communication within this network
+  void SHMModule::barrier(void)
+  {
+    internal->barrier();
+  }
+
+  void SHMModule::broadcast(NodeID root, const void *val_in, void *val_out, size_t bytes)
+  {
+    internal->broadcast(root, val_in, val_out, bytes);
+  }
+
+  void SHMModule::gather(NodeID root, const void *val_in, void *vals_out, size_t bytes)
+  {
+    internal->gather(root, val_in, vals_out, bytes);
+  }
+
+  size_t SHMModule::sample_messages_received_count(void)
+  {
+    // we don't have the right count to match the incoming message manager
+    //  (since we count completion replies too), so use a count of 0 that
+    //  merely waits until the incoming manager is temporarily idle
+    return 0;
+  }
+
+  bool SHMModule::check_for_quiescence(size_t sampled_receive_count)
+  {
+    return internal->check_for_quiescence();
+  }
+
+  // used to create a remote proxy for a memory
+  MemoryImpl *SHMModule::create_remote_memory(Memory m, size_t size, Memory::Kind kind,
+					      const ByteArray& rdma_info)
+  {
+    // rdma info is the offset of the memory in the owner's data segment
+    assert(rdma_info.size() == sizeof(uint64_t));
+    uint64_t segment_offset;
+    memcpy(&segment_offset, rdma_info.base(), sizeof(uint64_t));
+    NodeID owner = ID(m).memory_owner_node();
+    char *base = internal->segment_base(owner);
+    assert(base != 0);
+
+    return new SHMRemoteMemory(m, size, kind, base + segment_offset,
+			       segment_offset);
+  }
+
+  IBMemory *SHMModule::create_remote_ib_memory(Memory m, size_t size, Memory::Kind kind,
+					       const ByteArray& rdma_info)
+  {
+    // rdma info is the offset of the memory in the owner's data segment
+    assert(rdma_info.size() == sizeof(uint64_t));
+    uint64_t segment_offset;
+    memcpy(&segment_offset, rdma_info.base(), sizeof(uint64_t));
+
+    return new SHMIBMemory(m, size, kind, segment_offset);
+  }
+
+  ActiveMessageImpl *SHMModule::create_active_message_impl(NodeID target,
+							   unsigned short msgid,
+							   size_t header_size,
+							   size_t max_payload_size,
+							   const void *src_payload_addr,
+							   size_t src_payload_lines,
+							   size_t src_payload_line_stride,
+							   void *storage_base,
+							   size_t storage_size)
+  {
+    assert(storage_size >= sizeof(SHMMessageImpl));
+    SHMMessageImpl *impl = new(storage_base) SHMMessageImpl(internal,
+							    target,
+							    msgid,
+							    header_size,
+							    max_payload_size,
+							    src_payload_addr,
+							    src_payload_lines,
+							    src_payload_line_stride,
+							    -1);
+    return impl;
+  }
+
+  ActiveMessageImpl *SHMModule::create_active_message_impl(NodeID target,
+							   unsigned short msgid,
+							   size_t header_size,
+							   size_t max_payload_size,
+							   const void *src_payload_addr,
+							   size_t src_payload_lines,
+							   size_t src_payload_line_stride,
+							   const RemoteAddress& dest_payload_addr,
+							   void *storage_base,
+							   size_t storage_size)
+  {
+    assert(storage_size >= sizeof(SHMMessageImpl));
+    SHMMessageImpl *impl = new(storage_base) SHMMessageImpl(internal,
+							    target,
+							    msgid,
+							    header_size,
+							    max_payload_size,
+							    src_payload_addr,
+							    src_payload_lines,
+							    src_payload_line_stride,
+							    dest_payload_addr.ptr);
+    return impl;
+  }
+
+  ActiveMessageImpl *SHMModule::create_active_message_impl(const NodeSet& targets,
+							   unsigned short msgid,
+							   size_t header_size,
+							   size_t max_payload_size,
+							   const void *src_payload_addr,
+							   size_t src_payload_lines,
+							   size_t src_payload_line_stride,
+							   void *storage_base,
+							   size_t storage_size)
+  {
+    assert(storage_size >= sizeof(SHMMessageImpl));
+    SHMMessageImpl *impl = new(storage_base) SHMMessageImpl(internal,
+							    targets,
+							    msgid,
+							    header_size,
+							    max_payload_size,
+							    src_payload_addr,
+							    src_payload_lines,
+							    src_payload_line_stride);
+    return impl;
+  }
+
+  size_t SHMModule::recommended_max_payload(NodeID target,
+					    bool with_congestion,
+					    size_t header_size)
+  {
+    // larger messages work (they're streamed through the ring), but keep
+    //  them small enough that they don't hold up other senders
+    return (cfg_max_inline - header_size);
+  }
+
+  size_t SHMModule::recommended_max_payload(const NodeSet& targets,
+					    bool with_congestion,
+					    size_t header_size)
+  {
+    return (cfg_max_inline - header_size);
+  }
+
+  size_t SHMModule::recommended_max_payload(NodeID target,
+					    const RemoteAddress& dest_payload_addr,
+					    bool with_congestion,
+					    size_t header_size)
+  {
+    // puts are plain copies into the target's segment, so this only bounds
+    //  how long a single transfer keeps the sending thread busy
+    return 1 << 20; // 1 MB
+  }
+
+  size_t SHMModule::recommended_max_payload(NodeID target,
+					    const void *data, size_t bytes_per_line,
+					    size_t lines, size_t line_stride,
+					    bool with_congestion,
+					    size_t header_size)
+  {
+    // we don't care about source data location
+    return recommended_max_payload(target, with_congestion, header_size);
+  }
+
+  size_t SHMModule::recommended_max_payload(const NodeSet& targets,
+					    const void *data, size_t bytes_per_line,
+					    size_t lines, size_t line_stride,
+					    bool with_congestion,
+					    size_t header_size)
+  {
+    // we don't care about source data location
+    return recommended_max_payload(targets, with_congestion, header_size);
+  }
+
+  size_t SHMModule::recommended_max_payload(NodeID target,
+					    const void *data, size_t bytes_per_line,
+					    size_t lines, size_t line_stride,
+					    const RemoteAddress& dest_payload_addr,
+					    bool with_congestion,
+					    size_t header_size)
+  {
+    // we don't care about source data location
+    return recommended_max_payload(target, dest_payload_addr,
+				   with_congestion, header_size);
+  }
+
+
+}; // namespace Realm
@@ -29,6 +29,7 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 namespace Realm {
 
@@ -99,6 +100,68 @@ namespace Realm {
   REALM_PUBLIC_API
   std::ostream& operator<<(std::ostream& os, const SparsityMapEntry<N,T>& entry);
 
+  // a HierarchicalBitMap is a dense bitmap describing which points of a
+  //  rectangle are present (with dimension 0 varying fastest) - a second,
+  //  summary level has one bit per 64-bit word of the bitmap so that iteration
+  //  can skip over empty stretches quickly
+  // sparsity maps use these for clusters of small entries that would be much
+  //  larger when described as a list of rectangles
+  template <int N, typename T>
+  class REALM_INTERNAL_API_EXTERNAL_LINKAGE HierarchicalBitMap {
+  public:
+    HierarchicalBitMap(const Rect<N,T>& _bounds);
+
+    // population - 'r' must be contained in the bitmap's bounds, and a bitmap
+    //  must not be modified once it is part of a valid sparsity map
+    void set_rect(const Rect<N,T>& r);
+
+    const Rect<N,T>& get_bounds(void) const;
+
+    // number of points present, and the same within a given rectangle
+    size_t volume(void) const;
+    size_t overlap_volume(const Rect<N,T>& r) const;
+
+    // memory footprint of the bitmap, including this object
+    size_t bytes_used(void) const;
+
+    bool contains(const Point<N,T>& p) const;
+    bool contains_any(const Rect<N,T>& r) const;
+
+    // finds the next run of present points (contiguous in dimension 0 and
+    //  within 'restriction') at or after linear position 'pos' - on success,
+    //  sets 'run' and advances 'pos' past it
+    bool next_run(const Rect<N,T>& restriction, size_t& pos,
+		  Rect<N,T>& run) const;
+
+  protected:
+    size_t linearize(const Point<N,T>& p) const;
+    // return the first set/clear bit in [pos, limit), or 'limit' if none
+    size_t find_set_bit(size_t pos, size_t limit) const;
+    size_t find_clear_bit(size_t pos, size_t limit) const;
+    size_t count_bits(size_t pos, size_t limit) const;
+
+    static unsigned lowest_set_bit(uint64_t v);
+    static unsigned count_set_bits(uint64_t v);
+
+    Rect<N,T> bounds;
+    // linear strides for each dimension - strides[N] is the total bit count
+    size_t strides[N + 1];
+    size_t num_set;
+    std::vector<uint64_t> words;
+    std::vector<uint64_t> summary;
+  };
+
+  // a node of the flattened bounding volume hierarchy that indexes the entries
+  //  of a multi-dimensional sparsity map - nodes are stored in depth-first
+  //  order, so the left child of an interior node is always the next node
+  template <int N, typename T>
+  struct SparsityMapIndexNode {
+    Rect<N,T> bounds;
+    // for a leaf, [first, first + count) is a range of the entry order - for
+    //  an interior node, count is 0 and 'first' is the index of the right child
+    unsigned first, count;
+  };
+
   template <int N, typename T>
   class REALM_INTERNAL_API_EXTERNAL_LINKAGE SparsityMapPublicImpl {
   protected:
@@ -135,10 +198,34 @@ namespace Realm {
 			  size_t max_rects, int max_overhead,
 			  std::vector<Rect<N,T> >& covering);
 
+    // point and rectangle queries against the precise entries (which must be
+    //  valid) - multi-dimensional maps with many entries answer these from a
+    //  spatial index, everything else scans the entry list
+    bool contains(const Point<N,T>& p);
+    bool contains_all(const Rect<N,T>& r);
+    bool contains_any(const Rect<N,T>& r);
+
   protected:
+    // builds the spatial index - must be called before entries_valid is set
+    void build_entry_index(void);
+
+    // appends the index of every entry overlapping 'r' to 'found', in no
+    //  particular order
+    void find_overlapping_entries(const Rect<N,T>& r,
+				  std::vector<size_t>& found);
+
+    // maps with fewer entries than this are not worth indexing
+    static const size_t MIN_INDEXED_ENTRIES = 32;
+    // and this is the most entries stored in a single leaf
+    static const size_t MAX_ENTRIES_PER_LEAF = 8;
+    // bounds the depth of the index (and therefore the traversal stack)
+    static const unsigned MAX_INDEX_DEPTH = 48;
+
     atomic<bool> entries_valid, approx_valid;
     std::vector<SparsityMapEntry<N,T> > entries;
     std::vector<Rect<N,T> > approx_rects;
+    std::vector<SparsityMapIndexNode<N,T> > entry_index;
+    std::vector<unsigned> entry_order;
   };
 
 }; // namespace Realm
@@ -73,6 +73,271 @@ namespace Realm {
   }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class HierarchicalBitMap<N,T>
+
+  template <int N, typename T>
+  inline HierarchicalBitMap<N,T>::HierarchicalBitMap(const Rect<N,T>& _bounds)
+    : bounds(_bounds)
+    , num_set(0)
+  {
+    strides[0] = 1;
+    for(int i = 0; i < N; i++)
+      strides[i + 1] = strides[i] * size_t(bounds.hi[i] - bounds.lo[i] + 1);
+    words.resize((strides[N] + 63) >> 6, 0);
+    summary.resize((words.size() + 63) >> 6, 0);
+  }
+
+  template <int N, typename T>
+  inline /*static*/ unsigned HierarchicalBitMap<N,T>::lowest_set_bit(uint64_t v)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    unsigned n = 0;
+    while(!(v & 1)) { v >>= 1; n++; }
+    return n;
+#endif
+  }
+
+  template <int N, typename T>
+  inline /*static*/ unsigned HierarchicalBitMap<N,T>::count_set_bits(uint64_t v)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+#else
+    unsigned n = 0;
+    while(v) { v &= (v - 1); n++; }
+    return n;
+#endif
+  }
+
+  template <int N, typename T>
+  inline size_t HierarchicalBitMap<N,T>::linearize(const Point<N,T>& p) const
+  {
+    size_t pos = 0;
+    for(int i = 0; i < N; i++)
+      pos += size_t(p[i] - bounds.lo[i]) * strides[i];
+    return pos;
+  }
+
+  template <int N, typename T>
+  inline void HierarchicalBitMap<N,T>::set_rect(const Rect<N,T>& r)
+  {
+    assert(bounds.contains(r));
+    if(r.empty()) return;
+    // walk the rows (i.e. runs in dimension 0) of the rectangle
+    size_t row_len = size_t(r.hi[0] - r.lo[0] + 1);
+    Point<N,T> p = r.lo;
+    while(true) {
+      size_t pos = linearize(p);
+      size_t limit = pos + row_len;
+      while(pos < limit) {
+	size_t w = pos >> 6;
+	size_t bits = std::min(limit - pos, 64 - (pos & 63));
+	uint64_t mask = ((bits == 64) ? ~uint64_t(0) :
+			 (((uint64_t(1) << bits) - 1) << (pos & 63)));
+	num_set += count_set_bits(mask & ~words[w]);
+	words[w] |= mask;
+	summary[w >> 6] |= (uint64_t(1) << (w & 63));
+	pos += bits;
+      }
+      // step to the next row
+      int dim = 1;
+      while(dim < N) {
+	if(p[dim] < r.hi[dim]) {
+	  p[dim]++;
+	  break;
+	}
+	p[dim] = r.lo[dim];
+	dim++;
+      }
+      if(dim >= N) break;
+    }
+  }
+
+  template <int N, typename T>
+  inline const Rect<N,T>& HierarchicalBitMap<N,T>::get_bounds(void) const
+  {
+    return bounds;
+  }
+
+  template <int N, typename T>
+  inline size_t HierarchicalBitMap<N,T>::volume(void) const
+  {
+    return num_set;
+  }
+
+  template <int N, typename T>
+  inline size_t HierarchicalBitMap<N,T>::bytes_used(void) const
+  {
+    return (sizeof(*this) +
+	    (words.capacity() + summary.capacity()) * sizeof(uint64_t));
+  }
+
+  template <int N, typename T>
+  inline size_t HierarchicalBitMap<N,T>::find_set_bit(size_t pos,
+							size_t limit) const
+  {
+    if(pos >= limit) return limit;
+    size_t w = pos >> 6;
+    uint64_t bits = words[w] & (~uint64_t(0) << (pos & 63));
+    if(bits == 0) {
+      // use the summary to find the next nonempty word
+      size_t next = w + 1;
+      size_t last_word = (limit - 1) >> 6;
+      while(true) {
+	if(next > last_word) return limit;
+	size_t s = next >> 6;
+	uint64_t sbits = summary[s] & (~uint64_t(0) << (next & 63));
+	if(sbits != 0) {
+	  w = (s << 6) + lowest_set_bit(sbits);
+	  if(w > last_word) return limit;
+	  bits = words[w];
+	  break;
+	}
+	next = (s + 1) << 6;
+      }
+    }
+    size_t found = (w << 6) + lowest_set_bit(bits);
+    return ((found < limit) ? found : limit);
+  }
+
+  template <int N, typename T>
+  inline size_t HierarchicalBitMap<N,T>::find_clear_bit(size_t pos,
+							  size_t limit) const
+  {
+    while(pos < limit) {
+      size_t w = pos >> 6;
+      uint64_t bits = ~words[w] & (~uint64_t(0) << (pos & 63));
+      if(bits != 0) {
+	size_t found = (w << 6) + lowest_set_bit(bits);
+	return ((found < limit) ? found : limit);
+      }
+      pos = (w + 1) << 6;
+    }
+    return limit;
+  }
+
+  template <int N, typename T>
+  inline size_t HierarchicalBitMap<N,T>::count_bits(size_t pos,
+						      size_t limit) const
+  {
+    size_t total = 0;
+    while(pos < limit) {
+      size_t w = pos >> 6;
+      size_t bits = std::min(limit - pos, 64 - (pos & 63));
+      uint64_t mask = ((bits == 64) ? ~uint64_t(0) :
+		       (((uint64_t(1) << bits) - 1) << (pos & 63)));
+      total += count_set_bits(words[w] & mask);
+      pos += bits;
+    }
+    return total;
+  }
+
+  template <int N, typename T>
+  inline bool HierarchicalBitMap<N,T>::contains(const Point<N,T>& p) const
+  {
+    if(!bounds.contains(p)) return false;
+    size_t pos = linearize(p);
+    return ((words[pos >> 6] >> (pos & 63)) & 1) != 0;
+  }
+
+  template <int N, typename T>
+  inline size_t HierarchicalBitMap<N,T>::overlap_volume(const Rect<N,T>& r) const
+  {
+    Rect<N,T> isect = bounds.intersection(r);
+    if(isect.empty()) return 0;
+    if(isect == bounds) return num_set;
+    size_t total = 0;
+    size_t row_len = size_t(isect.hi[0] - isect.lo[0] + 1);
+    Point<N,T> p = isect.lo;
+    while(true) {
+      size_t pos = linearize(p);
+      total += count_bits(pos, pos + row_len);
+      int dim = 1;
+      while(dim < N) {
+	if(p[dim] < isect.hi[dim]) {
+	  p[dim]++;
+	  break;
+	}
+	p[dim] = isect.lo[dim];
+	dim++;
+      }
+      if(dim >= N) break;
+    }
+    return total;
+  }
+
+  template <int N, typename T>
+  inline bool HierarchicalBitMap<N,T>::contains_any(const Rect<N,T>& r) const
+  {
+    size_t pos = 0;
+    Rect<N,T> run;
+    return next_run(r, pos, run);
+  }
+
+  template <int N, typename T>
+  inline bool HierarchicalBitMap<N,T>::next_run(const Rect<N,T>& restriction,
+						size_t& pos,
+						Rect<N,T>& run) const
+  {
+    if(!bounds.overlaps(restriction))
+      return false;
+    // the common case of iterating over the whole bitmap needs no clipping
+    bool clip = !restriction.contains(bounds);
+
+    while(true) {
+      pos = find_set_bit(pos, strides[N]);
+      if(pos >= strides[N])
+	return false;
+
+      Point<N,T> p;
+      if(N == 1) {
+	p[0] = bounds.lo[0] + T(pos);
+      } else {
+	size_t rem = pos;
+	for(int i = N - 1; i >= 1; i--) {
+	  p[i] = bounds.lo[i] + T(rem / strides[i]);
+	  rem = rem % strides[i];
+	}
+	p[0] = bounds.lo[0] + T(rem);
+      }
+
+      if(clip) {
+	// if the point is outside the restriction, skip ahead based on the
+	//  most significant dimension that's out of range
+	int bad_dim = -1;
+	for(int i = N - 1; i >= 0; i--)
+	  if((p[i] < restriction.lo[i]) || (p[i] > restriction.hi[i])) {
+	    bad_dim = i;
+	    break;
+	  }
+	if(bad_dim >= 0) {
+	  size_t base = pos - (pos % strides[bad_dim + 1]);
+	  if(p[bad_dim] < restriction.lo[bad_dim])
+	    pos = base + (size_t(restriction.lo[bad_dim] - bounds.lo[bad_dim]) *
+			  strides[bad_dim]);
+	  else
+	    pos = base + strides[bad_dim + 1];
+	  continue;
+	}
+      }
+
+      // extend the run as far as the row and the restriction allow
+      T last = (clip ? std::min(restriction.hi[0], bounds.hi[0]) : bounds.hi[0]);
+      size_t limit = pos + size_t(last - p[0]) + 1;
+      size_t stop = find_clear_bit(pos, limit);
+      run.lo = p;
+      run.hi = p;
+      run.hi[0] = p[0] + T(stop - pos - 1);
+      pos = stop;
+      return true;
+    }
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class SparsityMapPublicImpl<N,T>
@@ -102,6 +367,144 @@ namespace Realm {
     return approx_rects;
   }
 
+  template <int N, typename T>
+  inline bool SparsityMapPublicImpl<N,T>::contains(const Point<N,T>& p)
+  {
+    if(!entries_valid.load_acquire())
+      REALM_ASSERT(0, "contains called on sparsity map without valid data");
+
+    if(entry_index.empty()) {
+      for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it = entries.begin();
+	  it != entries.end();
+	  it++) {
+	if(!it->bounds.contains(p)) continue;
+	assert(!it->sparsity.exists());
+	// entries are disjoint, so no other entry can contain the point
+	return ((it->bitmap == 0) || it->bitmap->contains(p));
+      }
+      return false;
+    }
+
+    // depth-first traversal of the index - the left child of an interior
+    //  node is the next node, so only right children need to be stacked
+    unsigned stack[MAX_INDEX_DEPTH + 1];
+    unsigned depth = 0;
+    unsigned cur = 0;
+    while(true) {
+      const SparsityMapIndexNode<N,T>& node = entry_index[cur];
+      if(node.bounds.contains(p)) {
+	if(node.count == 0) {
+	  stack[depth++] = node.first;
+	  cur++;
+	  continue;
+	}
+	for(unsigned i = 0; i < node.count; i++) {
+	  const SparsityMapEntry<N,T>& e = entries[entry_order[node.first + i]];
+	  if(!e.bounds.contains(p)) continue;
+	  assert(!e.sparsity.exists());
+	  return ((e.bitmap == 0) || e.bitmap->contains(p));
+	}
+      }
+      if(depth == 0)
+	return false;
+      cur = stack[--depth];
+    }
+  }
+
+  template <int N, typename T>
+  inline bool SparsityMapPublicImpl<N,T>::contains_all(const Rect<N,T>& r)
+  {
+    if(!entries_valid.load_acquire())
+      REALM_ASSERT(0, "contains_all called on sparsity map without valid data");
+
+    // entries are disjoint, so the rectangle is covered iff the number of
+    //  its points in each entry adds up to its own volume
+    size_t total_volume = 0;
+    if(entry_index.empty()) {
+      for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it = entries.begin();
+	  it != entries.end();
+	  it++) {
+	if(!it->bounds.overlaps(r)) continue;
+	assert(!it->sparsity.exists());
+	if(it->bitmap)
+	  total_volume += it->bitmap->overlap_volume(r);
+	else
+	  total_volume += it->bounds.intersection(r).volume();
+      }
+    } else {
+      unsigned stack[MAX_INDEX_DEPTH + 1];
+      unsigned depth = 0;
+      unsigned cur = 0;
+      while(true) {
+	const SparsityMapIndexNode<N,T>& node = entry_index[cur];
+	if(node.bounds.overlaps(r)) {
+	  if(node.count == 0) {
+	    stack[depth++] = node.first;
+	    cur++;
+	    continue;
+	  }
+	  for(unsigned i = 0; i < node.count; i++) {
+	    const SparsityMapEntry<N,T>& e = entries[entry_order[node.first + i]];
+	    if(!e.bounds.overlaps(r)) continue;
+	    assert(!e.sparsity.exists());
+	    if(e.bitmap)
+	      total_volume += e.bitmap->overlap_volume(r);
+	    else
+	      total_volume += e.bounds.intersection(r).volume();
+	  }
+	}
+	if(depth == 0)
+	  break;
+	cur = stack[--depth];
+      }
+    }
+
+    return (total_volume >= r.volume());
+  }
+
+  template <int N, typename T>
+  inline bool SparsityMapPublicImpl<N,T>::contains_any(const Rect<N,T>& r)
+  {
+    if(!entries_valid.load_acquire())
+      REALM_ASSERT(0, "contains_any called on sparsity map without valid data");
+
+    if(entry_index.empty()) {
+      for(typename std::vector<SparsityMapEntry<N,T> >::const_iterator it = entries.begin();
+	  it != entries.end();
+	  it++) {
+	if(!it->bounds.overlaps(r)) continue;
+	assert(!it->sparsity.exists());
+	if((it->bitmap == 0) || it->bitmap->contains_any(r))
+	  return true;
+      }
+      return false;
+    }
+
+    unsigned stack[MAX_INDEX_DEPTH + 1];
+    unsigned depth = 0;
+    unsigned cur = 0;
+    while(true) {
+      const SparsityMapIndexNode<N,T>& node = entry_index[cur];
+      if(node.bounds.overlaps(r)) {
+	if(node.count == 0) {
+	  stack[depth++] = node.first;
+	  cur++;
+	  continue;
+	}
+	for(unsigned i = 0; i < node.count; i++) {
+	  const SparsityMapEntry<N,T>& e = entries[entry_order[node.first + i]];
+	  if(!e.bounds.overlaps(r)) continue;
+	  assert(!e.sparsity.exists());
+	  if((e.bitmap == 0) || e.bitmap->contains_any(r))
+	    return true;
+	}
+      }
+      if(depth == 0)
+	return false;
+      cur = stack[--depth];
+    }
+  }
+
 
 }; // namespace Realm
 
@@ -247,6 +247,10 @@ namespace Realm {
 
     ConcurrencyMode concurrency_mode;
 
+    // allows chains of dependent tasks on the same local processor to be
+    //  launched as a single task (only if -ll:subgraph_fuse is also enabled)
+    bool fuse_tasks /*= true*/;
+
     // longer term possibilites:
     //  conditional execution
     //  loops
@@ -39,6 +39,7 @@ namespace Realm {
 
   inline SubgraphDefinition::SubgraphDefinition()
     : concurrency_mode(CONCURRENT)
+    , fuse_tasks(true)
   {}
 
   template <typename S>
@@ -52,7 +53,8 @@ namespace Realm {
 	    (serdez & s.releases) &&
 	    (serdez & s.dependencies) &&
 	    (serdez & s.interpolations) &&
-	    (serdez & s.concurrency_mode));
+	    (serdez & s.concurrency_mode) &&
+	    (serdez & s.fuse_tasks));
   }
 
 
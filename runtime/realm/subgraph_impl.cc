@@ -17,11 +17,16 @@
 
 #include "realm/subgraph_impl.h"
 #include "realm/runtime_impl.h"
+#include "realm/proc_impl.h"
 
 namespace Realm {
 
   Logger log_subgraph("subgraph");
 
+  namespace Config {
+    bool fuse_subgraph_tasks = true;
+  };
+
 
   ////////////////////////////////////////////////////////////////////////
   //
@@ -600,9 +605,93 @@ namespace Realm {
       }
     }
 
+    fuse_task_chains();
+
     return true;
   }
 
+  void SubgraphImpl::fuse_task_chains(void)
+  {
+    fused_chains.clear();
+    for(std::vector<SubgraphScheduleEntry>::iterator it = schedule.begin();
+	it != schedule.end();
+	++it) {
+      it->fused_chain = -1;
+      it->is_fused = false;
+    }
+    if(!Config::fuse_subgraph_tasks || !defn->fuse_tasks ||
+       (defn->tasks.size() < 2))
+      return;
+
+    // count the consumers of each intermediate event (external
+    //  postconditions included) and remember who produced it
+    std::vector<unsigned> consumers(num_intermediate_events, 0);
+    std::vector<unsigned> producers(num_intermediate_events, 0);
+    for(size_t i = 0; i < schedule.size(); i++) {
+      const SubgraphScheduleEntry& e = schedule[i];
+      for(unsigned j = 0; j < e.intermediate_event_count; j++)
+	producers[e.intermediate_event_base + j] = i;
+      for(std::vector<std::pair<unsigned, int> >::const_iterator it = e.preconditions.begin();
+	  it != e.preconditions.end();
+	  ++it)
+	if(it->second >= 0)
+	  consumers[it->second]++;
+    }
+
+    // the schedule is in topological order, so a chain's head is always
+    //  seen before any of the tasks fused onto it
+    std::vector<int> member_chains(schedule.size(), -1);
+    for(size_t i = 0; i < schedule.size(); i++) {
+      SubgraphScheduleEntry& e = schedule[i];
+      if(e.op_kind != SubgraphDefinition::OPKIND_TASK)
+	continue;
+      // a fused task's arguments are fixed at compile time and it can't
+      //  have its own profiling since it doesn't have its own launch
+      const SubgraphDefinition::TaskDesc& td = defn->tasks[e.op_index];
+      if(!td.prs.empty() || (e.num_interps > 0))
+	continue;
+      // the only thing it waits on must be another task...
+      if((e.preconditions.size() != 1) ||
+	 (e.preconditions[0].first != 0) ||
+	 (e.preconditions[0].second < 0))
+	continue;
+      unsigned ev_idx = e.preconditions[0].second;
+      SubgraphScheduleEntry& pred = schedule[producers[ev_idx]];
+      if(pred.op_kind != SubgraphDefinition::OPKIND_TASK)
+	continue;
+      // ...on the same local processor, whose event nobody else needs
+      const SubgraphDefinition::TaskDesc& pd = defn->tasks[pred.op_index];
+      if((pd.proc != td.proc) || !pd.prs.empty() || (consumers[ev_idx] != 1))
+	continue;
+      if(NodeID(ID(td.proc).proc_owner_node()) != Network::my_node_id)
+	continue;
+      LocalTaskProcessor *proc = dynamic_cast<LocalTaskProcessor *>(get_runtime()->get_processor_impl(td.proc));
+      if(proc == 0)
+	continue;
+
+      int chain = (pred.is_fused ?
+		     member_chains[producers[ev_idx]] :
+		     pred.fused_chain);
+      if(chain < 0) {
+	chain = fused_chains.size();
+	fused_chains.resize(chain + 1);
+	fused_chains[chain].proc = proc;
+	pred.fused_chain = chain;
+      }
+      Task::FusedBody body;
+      body.func_id = td.task_id;
+      body.args = td.args;
+      fused_chains[chain].bodies.push_back(body);
+      fused_chains[chain].entries.push_back(i);
+      e.is_fused = true;
+      member_chains[i] = chain;
+    }
+
+    if(!fused_chains.empty())
+      log_subgraph.info() << "subgraph " << me << ": fused "
+			  << fused_chains.size() << " task chains";
+  }
+
   void SubgraphImpl::instantiate(const void *args, size_t arglen,
 				 const ProfilingRequestSet& prs,
 				 span<const Event> preconditions,
@@ -631,6 +720,13 @@ namespace Realm {
     for(std::vector<SubgraphScheduleEntry>::const_iterator it = schedule.begin();
 	it != schedule.end();
 	++it) {
+      // fused tasks were launched (and their events filled in) along with
+      //  the head of their chain
+      if(it->is_fused) {
+	cur_intermediate_events += it->intermediate_event_count;
+	continue;
+      }
+
       // assemble precondition
       size_t num_preconds = 0;
       bool need_global_precond = start_event.exists();
@@ -681,8 +777,14 @@ namespace Realm {
 	continue;
       }
 
-      span<const Event> s(preconds, num_preconds);
-      Event pre = GenEventImpl::merge_events(s, false);
+      // a single precondition can be used directly
+      Event pre = Event::NO_EVENT;
+      if(num_preconds == 1)
+	pre = preconds[0];
+      else if(num_preconds > 1) {
+	span<const Event> s(preconds, num_preconds);
+	pre = GenEventImpl::merge_events(s, false);
+      }
 #if 0
       Event pre = GenEventImpl::merge_events(make_span<const Event>(preconds,
 								    num_preconds),
@@ -719,10 +821,29 @@ namespace Realm {
 						   td.args.base(), td.args.size(),
 						   ish);
 
-	  e = proc.spawn(task_id, task_args, td.args.size(),
-			 td.prs,
-			 pre,
-			 priority + priority_adjust);
+	  if(it->fused_chain >= 0) {
+	    const SubgraphFusedChain& chain = fused_chains[it->fused_chain];
+	    GenEventImpl *finish = GenEventImpl::create_genevent();
+	    e = finish->current_event();
+	    chain.proc->spawn_fused_task(task_id, task_args, td.args.size(),
+					 chain.bodies,
+					 pre,
+					 finish, ID(e).event_generation(),
+					 priority + priority_adjust);
+	    // every task in the chain is done when the whole chain is
+	    for(std::vector<unsigned>::const_iterator it2 = chain.entries.begin();
+		it2 != chain.entries.end();
+		++it2) {
+	      const SubgraphScheduleEntry& fused = schedule[*it2];
+	      intermediate_events[fused.intermediate_event_base] = e;
+	      if(fused.is_final_event)
+		event_impl->merger.add_precondition(e);
+	    }
+	  } else
+	    e = proc.spawn(task_id, task_args, td.args.size(),
+			   td.prs,
+			   pre,
+			   priority + priority_adjust);
 	  intermediate_events[cur_intermediate_events++] = e;
 	  break;
 	}
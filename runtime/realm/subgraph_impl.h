@@ -21,9 +21,18 @@
 #include "realm/subgraph.h"
 #include "realm/id.h"
 #include "realm/event_impl.h"
+#include "realm/tasks.h"
 
 namespace Realm {
 
+  class LocalTaskProcessor;
+
+  namespace Config {
+    // fuse chains of dependent tasks on the same local processor into a
+    //  single task launch when compiling subgraphs
+    extern bool fuse_subgraph_tasks;
+  };
+
   struct SubgraphScheduleEntry {
     SubgraphDefinition::OpKind op_kind;
     unsigned op_index;
@@ -31,6 +40,21 @@ namespace Realm {
     unsigned first_interp, num_interps;
     unsigned intermediate_event_base, intermediate_event_count;
     bool is_final_event;
+    // index of the fused chain this task starts (or -1), and whether this
+    //  task is part of an earlier chain and is not launched on its own
+    int fused_chain;
+    bool is_fused;
+  };
+
+  // a chain of tasks on the same local processor where each one depends
+  //  only on the previous one and nothing else uses the previous one's
+  //  event - the whole chain is launched as one task and the events between
+  //  the tasks are never created
+  struct SubgraphFusedChain {
+    LocalTaskProcessor *proc;
+    std::vector<Task::FusedBody> bodies;
+    // schedule entries of the fused tasks (i.e. not including the head)
+    std::vector<unsigned> entries;
   };
 
   class SubgraphImpl {
@@ -44,6 +68,9 @@ namespace Realm {
     // compile/analyze the subgraph
     bool compile(void);
 
+    // finds chains of tasks that can be launched as one
+    void fuse_task_chains(void);
+
     void instantiate(const void *args, size_t arglen,
 		     const ProfilingRequestSet& prs,
 		     span<const Event> preconditions,
@@ -69,6 +96,7 @@ namespace Realm {
     SubgraphImpl *next_free;
     SubgraphDefinition *defn;
     std::vector<SubgraphScheduleEntry> schedule;
+    std::vector<SubgraphFusedChain> fused_chains;
     size_t num_intermediate_events, num_final_events, max_preconditions;
 
     DeferredDestroy deferred_destroy;
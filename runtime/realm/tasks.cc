@@ -19,11 +19,17 @@
 
 #include "realm/runtime_impl.h"
 
+#include <algorithm>
+
 namespace Realm {
 
   Logger log_task("task");
   Logger log_sched("sched");
 
+  namespace Config {
+    int task_steal_batch_size = 0;
+  };
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class Task
@@ -235,6 +241,16 @@ namespace Realm {
       t->set_priority(new_priority);
   }
 
+  void Task::execute_bodies(Processor p)
+  {
+    ProcessorImpl *impl = get_runtime()->get_processor_impl(p);
+    impl->execute_task(func_id, ByteArrayRef(argdata, arglen));
+    for(std::vector<FusedBody>::const_iterator it = fused_bodies.begin();
+	it != fused_bodies.end();
+	++it)
+      impl->execute_task(it->func_id, it->args);
+  }
+
   void Task::execute_on_processor(Processor p)
   {
     // if the processor isn't specified, use what's in the task object
@@ -282,8 +298,7 @@ namespace Realm {
 	try {
 	  Thread::ExceptionHandlerPresence ehp;
 	  thread->start_perf_counters();
-	  get_runtime()->get_processor_impl(p)->execute_task(func_id,
-							     ByteArrayRef(argdata, arglen));
+	  execute_bodies(p);
 	  thread->stop_perf_counters();
 	  thread->stop_operation(this);
 	  thread->record_perf_counters(measurements);
@@ -299,8 +314,7 @@ namespace Realm {
       {
 	// just run the task - if it completes, we assume it was successful
 	thread->start_perf_counters();
-	get_runtime()->get_processor_impl(p)->execute_task(func_id,
-							   ByteArrayRef(argdata, arglen));
+	execute_bodies(p);
 	thread->stop_perf_counters();
 	thread->stop_operation(this);
 	thread->record_perf_counters(measurements);
@@ -456,7 +470,8 @@ namespace Realm {
 
   // gets highest priority task available from any task queue
   /*static*/ Task *TaskQueue::get_best_task(const std::vector<TaskQueue *>& queues,
-					    int& task_priority)
+					    int& task_priority,
+					    TaskQueue **task_source_out /*= 0*/)
   {
     // remember where a task has come from in case we want to put it back
     Task *task = 0;
@@ -490,6 +505,9 @@ namespace Realm {
       }
     }
 
+    if(task_source_out)
+      *task_source_out = task_source;
+
     return task;
   }
 
@@ -684,6 +702,8 @@ namespace Realm {
     : shutdown_flag(false)
     , active_worker_count(0)
     , unassigned_worker_count(0)
+    , preempt_counter(0)
+    , batch_priority(TaskQueue::PRI_POS_INF)
     , wcu_task_queues(this)
     , wcu_resume_queue(this)
     , bgworker_interrupt(false)
@@ -692,6 +712,7 @@ namespace Realm {
     , cfg_max_idle_workers(1)
     , cfg_min_active_workers(1)
     , cfg_max_active_workers(1)
+    , cfg_steal_batch_size(Config::task_steal_batch_size)
   {
     // hook up the work counter updates for the resumable worker queue
     resumable_workers.add_subscription(&wcu_resume_queue);
@@ -703,6 +724,13 @@ namespace Realm {
     assert(active_worker_count == 0);
     assert(unassigned_worker_count == 0);
     assert(idle_workers.empty());
+
+    for(std::vector<WorkerDeque *>::iterator it = worker_deques.begin();
+	it != worker_deques.end();
+	++it) {
+      assert((*it)->tasks.empty());
+      delete *it;
+    }
   }
 
   void ThreadedTaskScheduler::add_task_queue(TaskQueue *queue)
@@ -843,6 +871,17 @@ namespace Realm {
 
     log_sched.debug() << "scheduler worker blocking: sched=" << this << " worker=" << thread;
 
+    // don't strand the blocked worker's deque - the worker that takes over
+    //  might otherwise run lower-priority tasks from the task queues first
+    for(std::vector<WorkerDeque *>::iterator it = worker_deques.begin();
+	it != worker_deques.end();
+	++it)
+      if((*it)->owner == thread) {
+	end_batch(*it);
+	drain_worker_deque(*it);
+	break;
+      }
+
     while(true) {//thread->get_state() != Thread::STATE_READY) {
       bool alerted = try_update_thread_state(thread,
 					     Thread::STATE_ALERTED,
@@ -980,6 +1019,10 @@ namespace Realm {
       it->second = new_priority;
     }
 
+    // a worker running a batch from its deque must go back through the
+    //  scheduler to pick up the new priority
+    preempt_counter.fetch_add(1);
+
     log_sched.debug() << "thread priority change: thread=" << (void *)thread << " old=" << old_priority << " new=" << new_priority;
   }
 
@@ -988,9 +1031,232 @@ namespace Realm {
     // no need to take the main mutex - just add to the internal task list and
     //   bump the work counter
     internal_tasks.push_back(itask);
+    preempt_counter.fetch_add(1);
     work_counter.increment_counter();
   }
 
+  ThreadedTaskScheduler::WorkerDeque::WorkerDeque(void)
+    : priority(TaskQueue::PRI_NEG_INF)
+    , source(0)
+    , owner(0)
+    , batching(false)
+  {}
+
+  ThreadedTaskScheduler::WorkerDeque *ThreadedTaskScheduler::claim_worker_deque(void)
+  {
+    // caller holds lock
+
+    // reuse a deque left behind by a terminated worker if possible
+    WorkerDeque *wdq = 0;
+    for(std::vector<WorkerDeque *>::iterator it = worker_deques.begin();
+	it != worker_deques.end();
+	++it)
+      if((*it)->owner == 0) {
+	wdq = *it;
+	break;
+      }
+    if(!wdq) {
+      wdq = new WorkerDeque;
+      worker_deques.push_back(wdq);
+    }
+    wdq->owner = Thread::self();
+    return wdq;
+  }
+
+  void ThreadedTaskScheduler::release_worker_deque(WorkerDeque *wdq)
+  {
+    // caller holds lock
+    drain_worker_deque(wdq);
+    AutoLock<> al(wdq->mutex);
+    wdq->owner = 0;
+  }
+
+  void ThreadedTaskScheduler::fill_worker_deque(WorkerDeque *wdq,
+						TaskQueue *source, int priority)
+  {
+    // caller holds lock
+    size_t count;
+    {
+      AutoLock<> al(wdq->mutex);
+      assert(wdq->tasks.empty());
+
+      AutoLock<FIFOMutex> al2(source->mutex);
+      // workers of other schedulers subscribed to this queue (e.g. for a
+      //  processor group) can't steal from our deques, so leave its tasks
+      //  where they can see them
+      if(source->callbacks.size() > 1)
+	return;
+
+      wdq->priority = priority;
+      wdq->source = source;
+      while(wdq->tasks.size() < size_t(cfg_steal_batch_size - 1)) {
+	Task *task = source->ready_task_list.pop_front(priority);
+	if(!task) break;
+	// leave higher-priority tasks that just showed up to the next pass
+	//  through the scheduler loop
+	if(task->priority != priority) {
+	  source->ready_task_list.push_front(task);
+	  break;
+	}
+	wdq->tasks.push_back(task);
+      }
+      count = wdq->tasks.size();
+    }
+
+    if(count > 0) {
+      if(source->task_count_gauge)
+	*(source->task_count_gauge) -= count;
+
+      // wake up any of our idle workers so they can steal some of these
+      work_counter.increment_counter();
+    }
+  }
+
+  void ThreadedTaskScheduler::drain_worker_deque(WorkerDeque *wdq)
+  {
+    // caller holds lock
+    size_t count;
+    TaskQueue *source;
+    {
+      AutoLock<> al(wdq->mutex);
+      count = wdq->tasks.size();
+      if(count == 0) return;
+      source = wdq->source;
+
+      // return tasks to the front of the source queue in their original order
+      AutoLock<FIFOMutex> al2(source->mutex);
+      while(!wdq->tasks.empty()) {
+	source->ready_task_list.push_front(wdq->tasks.back());
+	wdq->tasks.pop_back();
+      }
+    }
+
+    if(source->task_count_gauge)
+      *(source->task_count_gauge) += count;
+
+    work_counter.increment_counter();
+  }
+
+  Task *ThreadedTaskScheduler::pop_own_task(WorkerDeque *wdq, int& task_priority)
+  {
+    // caller holds lock
+    AutoLock<> al(wdq->mutex);
+    if(wdq->tasks.empty() || (wdq->priority <= task_priority))
+      return 0;
+    Task *task = wdq->tasks.front();
+    wdq->tasks.pop_front();
+    task_priority = wdq->priority;
+    return task;
+  }
+
+  Task *ThreadedTaskScheduler::steal_task(WorkerDeque *wdq, int& task_priority)
+  {
+    // caller holds lock, and has nothing better to do than the tasks sitting
+    //  in other workers' deques - the set of deques only changes under the
+    //  scheduler lock, so each one just needs its own mutex to look inside
+
+    // choose the victim with the highest priority work, which must beat
+    //  'task_priority' (i.e. any resumable worker)
+    WorkerDeque *victim = 0;
+    int victim_priority = task_priority;
+    for(std::vector<WorkerDeque *>::iterator it = worker_deques.begin();
+	it != worker_deques.end();
+	++it) {
+      if(*it == wdq) continue;
+      AutoLock<> al((*it)->mutex);
+      if(!(*it)->tasks.empty() && ((*it)->priority > victim_priority)) {
+	victim = *it;
+	victim_priority = (*it)->priority;
+      }
+    }
+    if(!victim) return 0;
+
+    // take the newest half (rounded up) of the victim's tasks - the oldest of
+    //  those is returned and the rest go into our own deque
+    Task *task;
+    {
+      AutoLock<> al(victim->mutex);
+      // the victim may have run through its tasks since we looked
+      if(victim->tasks.empty()) return 0;
+
+      size_t count = (victim->tasks.size() + 1) / 2;
+      std::deque<Task *>::iterator first = victim->tasks.end() - count;
+      task = *first;
+
+      AutoLock<> al2(wdq->mutex);
+      assert(wdq->tasks.empty());
+      wdq->tasks.insert(wdq->tasks.end(), first + 1, victim->tasks.end());
+      wdq->priority = victim->priority;
+      wdq->source = victim->source;
+      victim->tasks.erase(first, victim->tasks.end());
+    }
+
+    log_sched.debug() << "task stolen: sched=" << this << " task=" << task
+		      << " priority=" << victim_priority;
+
+    task_priority = victim_priority;
+    return task;
+  }
+
+  bool ThreadedTaskScheduler::start_batch(WorkerDeque *wdq, int priority)
+  {
+    // caller holds lock
+    {
+      AutoLock<> al(wdq->mutex);
+      // a deque holding lower-priority work than the task we're about to run
+      //  waits for the next pass through the scheduler loop
+      if(wdq->tasks.empty() || (wdq->priority != priority)) return false;
+      wdq->batching = true;
+    }
+    update_batch_priority();
+
+    // a task that was enqueued before the new batch priority was visible may
+    //  not have bumped the preempt counter, so check for one now - a queue's
+    //  mutex orders this against its enqueue_task
+    for(std::vector<TaskQueue *>::const_iterator it = task_queues.begin();
+	it != task_queues.end();
+	++it) {
+      AutoLock<FIFOMutex> al((*it)->mutex);
+      if(!(*it)->ready_task_list.empty(priority + 1))
+	return false;
+    }
+    return internal_tasks.empty();
+  }
+
+  void ThreadedTaskScheduler::end_batch(WorkerDeque *wdq)
+  {
+    // caller holds lock
+    {
+      AutoLock<> al(wdq->mutex);
+      if(!wdq->batching) return;
+      wdq->batching = false;
+    }
+    update_batch_priority();
+  }
+
+  void ThreadedTaskScheduler::update_batch_priority(void)
+  {
+    // caller holds lock
+    int min_priority = TaskQueue::PRI_POS_INF;
+    for(std::vector<WorkerDeque *>::const_iterator it = worker_deques.begin();
+	it != worker_deques.end();
+	++it) {
+      AutoLock<> al((*it)->mutex);
+      if((*it)->batching && ((*it)->priority < min_priority))
+	min_priority = (*it)->priority;
+    }
+    batch_priority.store(min_priority);
+  }
+
+  bool ThreadedTaskScheduler::should_preempt_batch(uint64_t old_preempt_counter)
+  {
+    // caller does NOT hold lock, so we can't look at the task queues - new
+    //  tasks that beat the lowest running batch priority bump the preempt
+    //  counter, as does everything else that should send us back through
+    //  the scheduler
+    return (preempt_counter.load_acquire() != old_preempt_counter);
+  }
+
   // the main scheduler loop
   void ThreadedTaskScheduler::scheduler_loop(void)
   {
@@ -1001,6 +1267,10 @@ namespace Realm {
 
       // we're a new, and initially unassigned, worker - counters have already been updated
 
+      // our own deque of ready tasks, claimed the first time we use work stealing
+      WorkerDeque *my_deque = 0;
+      bool use_stealing = (cfg_steal_batch_size > 1) && cfg_reuse_workers;
+
       while(true) {
 	// remember the work counter value before we start so that we don't iterate
 	//   unnecessarily
@@ -1063,9 +1333,33 @@ namespace Realm {
 	int resumable_priority = ResumableQueue::PRI_NEG_INF;
 	resumable_workers.peek(&resumable_priority);
 
-	// try to get a new task then
+	// try to get a new task then - with work stealing, tasks already in
+	//  our own deque win ties with the task queues (they were enqueued
+	//  first), but not with resumable workers
 	int task_priority = resumable_priority;
-	Task *task = TaskQueue::get_best_task(task_queues, task_priority);
+	int own_priority = TaskQueue::PRI_NEG_INF;
+	if(use_stealing && my_deque) {
+	  AutoLock<> al(my_deque->mutex);
+	  if(!my_deque->tasks.empty())
+	    own_priority = my_deque->priority;
+	}
+	if(own_priority > task_priority)
+	  task_priority = own_priority;
+	TaskQueue *task_source = 0;
+	Task *task = TaskQueue::get_best_task(task_queues, task_priority,
+					      &task_source);
+
+	if(use_stealing && !task) {
+	  task_priority = resumable_priority;
+	  if(my_deque)
+	    task = pop_own_task(my_deque, task_priority);
+	  // only a worker with nothing else to do steals from another's deque
+	  if(!task && (own_priority == TaskQueue::PRI_NEG_INF)) {
+	    if(!my_deque)
+	      my_deque = claim_worker_deque();
+	    task = steal_task(my_deque, task_priority);
+	  }
+	}
 
 	// did we find work to do?
 	if(task) {
@@ -1084,37 +1378,68 @@ namespace Realm {
 	  //  priority here
 	  worker_priorities[Thread::self()] = task_priority;
 
+	  // with work stealing, grab more tasks of the same priority to run
+	  //  without coming back through the scheduler lock (a stolen task's
+	  //  companions are already in our deque) - a deque that still holds
+	  //  lower-priority tasks keeps them for later
+	  if(use_stealing && task_source) {
+	    if(!my_deque)
+	      my_deque = claim_worker_deque();
+	    if(own_priority == TaskQueue::PRI_NEG_INF)
+	      fill_worker_deque(my_deque, task_source, task_priority);
+	  }
+	  uint64_t batch_preempt_counter = preempt_counter.load_acquire();
+	  bool run_batch = (my_deque && start_batch(my_deque, task_priority));
+
 	  // release the lock while we run the task
 	  lock.unlock();
 
-	  // if we have any context managers, create the necessary contexts
-	  std::vector<void *> contexts(context_managers.size(), 0);
-	  if(!context_managers.empty()) {
-	    for(size_t i = 0; i < context_managers.size(); i++)
-	      contexts[i] = context_managers[i]->create_context(task);
-	    // add a reference to the task to prevent it from being deleted
-	    //  before we destroy our contexts
-	    // NOTE: this does NOT prevent the task from finishing - a context
-	    //  should add an AsyncWorkItem to the task if that is needed
-	    task->add_reference();
-	  }
+	  while(true) {
+	    // if we have any context managers, create the necessary contexts
+	    std::vector<void *> contexts(context_managers.size(), 0);
+	    if(!context_managers.empty()) {
+	      for(size_t i = 0; i < context_managers.size(); i++)
+		contexts[i] = context_managers[i]->create_context(task);
+	      // add a reference to the task to prevent it from being deleted
+	      //  before we destroy our contexts
+	      // NOTE: this does NOT prevent the task from finishing - a context
+	      //  should add an AsyncWorkItem to the task if that is needed
+	      task->add_reference();
+	    }
 
 #ifndef NDEBUG
-	  bool ok =
+	    bool ok =
 #endif
-	    execute_task(task);
-	  assert(ok);  // no fault recovery yet
+	      execute_task(task);
+	    assert(ok);  // no fault recovery yet
+
+	    if(!context_managers.empty()) {
+	      // destroy contexts in reverse order
+	      for(size_t i = context_managers.size(); i > 0; i--)
+		context_managers[i-1]->destroy_context(task, contexts[i-1]);
+	      // and only then remove the extra reference we were holding
+	      task->remove_reference();
+	    }
 
-	  if(!context_managers.empty()) {
-	    // destroy contexts in reverse order
-	    for(size_t i = context_managers.size(); i > 0; i--)
-	      context_managers[i-1]->destroy_context(task, contexts[i-1]);
-	    // and only then remove the extra reference we were holding
-	    task->remove_reference();
+	    // keep working through our own deque unless somebody has stolen
+	    //  it all or higher-priority work may have shown up
+	    if(!run_batch || should_preempt_batch(batch_preempt_counter))
+	      break;
+
+	    AutoLock<> al(my_deque->mutex);
+	    if(my_deque->tasks.empty())
+	      break;
+	    task = my_deque->tasks.front();
+	    my_deque->tasks.pop_front();
 	  }
 
 	  lock.lock();
 
+	  // anything left in our deque stays there (and can be stolen) while
+	  //  we go back through the scheduler loop
+	  if(my_deque)
+	    end_batch(my_deque);
+
 	  worker_priorities.erase(Thread::self());
 
 	  // and we're back to being unassigned
@@ -1138,6 +1463,10 @@ namespace Realm {
 	  // unassigned worker count by one
 	  update_worker_count(0, -1);
 
+	  // our deque can't wait for us while we sleep
+	  if(my_deque)
+	    drain_worker_deque(my_deque);
+
 	  idle_workers.push_back(Thread::self());
 	  worker_sleep(yield_to);
 
@@ -1155,11 +1484,15 @@ namespace Realm {
 	      Thread *to_wake = idle_workers.back();
 	      idle_workers.pop_back();
 	      // no net change in worker counts
+	      if(my_deque)
+		release_worker_deque(my_deque);
 	      worker_terminate(to_wake);
 	      break;
 	    } else {
 	      // nobody to wake, so -1 active/unassigned worker
 	      update_worker_count(-1, -1, false); // ok to drop below mins
+	      if(my_deque)
+		release_worker_deque(my_deque);
 	      worker_terminate(0);
 	      break;
 	    }
@@ -1176,6 +1509,8 @@ namespace Realm {
 	      assert(to_wake != Thread::self());
 	      idle_workers.pop_back();
 	      // no net change in worker counts
+	      if(my_deque)
+		release_worker_deque(my_deque);
 	      worker_terminate(to_wake);
 	      break;
 	    } else {
@@ -1184,6 +1519,8 @@ namespace Realm {
 	      if((unassigned_worker_count > 1) &&
 		 (active_worker_count > cfg_min_active_workers)) {
 		update_worker_count(-1, -1, false);
+		if(my_deque)
+		  release_worker_deque(my_deque);
 		worker_terminate(0);
 		break;
 	      } else {
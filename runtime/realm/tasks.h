@@ -31,6 +31,8 @@
 #include "realm/mutex.h"
 #include "realm/bgwork.h"
 
+#include <deque>
+
 namespace Realm {
 
     class ProcessorImpl;
@@ -65,6 +67,14 @@ namespace Realm {
       Processor proc;
       Processor::TaskFuncID func_id;
 
+      // additional task bodies run back to back after this one - used by
+      //  subgraphs to fuse chains of dependent tasks on the same processor
+      struct FusedBody {
+	Processor::TaskFuncID func_id;
+	ByteArray args;
+      };
+      std::vector<FusedBody> fused_bodies;
+
       // "small-vector" optimization for task args
       char *argdata;
       size_t arglen;
@@ -112,6 +122,8 @@ namespace Realm {
 
       virtual Status::Result get_state(void);
 
+      void execute_bodies(Processor p);
+
       Thread *executing_thread;
 
       // to spread out the cost of marking a long list of tasks ready, we
@@ -156,8 +168,10 @@ namespace Realm {
 
       void free_gauge();
       // gets highest priority task available from any task queue in list
+      //  (and optionally which queue it came from)
       static Task *get_best_task(const std::vector<TaskQueue *>& queues,
-				 int& task_priority);
+				 int& task_priority,
+				 TaskQueue **task_source = 0);
 
       void enqueue_task(Task *task);
       void enqueue_tasks(Task::TaskList& tasks, size_t num_tasks);
@@ -247,6 +261,46 @@ namespace Realm {
       // gets highest priority task available from any task queue
       Task *get_best_ready_task(int& task_priority);
 
+      // when work stealing is enabled, a worker that takes a task from a
+      //  task queue used only by this scheduler also moves up to
+      //  cfg_steal_batch_size-1 more tasks of the same priority into its own
+      //  deque - the deque persists across passes through the scheduler loop
+      //  and its owner runs those tasks without retaking the scheduler lock,
+      //  while a worker that finds no other work steals from the back of
+      //  another worker's deque
+      class WorkerDeque {
+      public:
+	WorkerDeque(void);
+
+	Mutex mutex;
+	std::deque<Task *> tasks;  // all have the same priority
+	int priority;
+	TaskQueue *source;  // where unrun tasks are returned to
+	Thread *owner;      // 0 if not claimed by any worker
+	bool batching;      // owner is running tasks from this deque
+      };
+
+      // all of these are called with the scheduler lock held
+      WorkerDeque *claim_worker_deque(void);
+      void release_worker_deque(WorkerDeque *wdq);
+      void fill_worker_deque(WorkerDeque *wdq, TaskQueue *source, int priority);
+      // returns the deque's tasks to their source queue
+      void drain_worker_deque(WorkerDeque *wdq);
+      // takes the front of our own deque if it beats 'task_priority'
+      Task *pop_own_task(WorkerDeque *wdq, int& task_priority);
+      // only used when the caller found nothing else to do
+      Task *steal_task(WorkerDeque *wdq, int& task_priority);
+      // returns false if higher-priority work is already waiting
+      bool start_batch(WorkerDeque *wdq, int priority);
+      void end_batch(WorkerDeque *wdq);
+      void update_batch_priority(void);
+
+      // called WITHOUT the scheduler lock by a worker between tasks from its
+      //  own deque - returns true if higher-priority work may have shown up
+      bool should_preempt_batch(uint64_t old_preempt_counter);
+
+      std::vector<WorkerDeque *> worker_deques;
+
       // TODO: switch this to DelegatingMutex - goal is that callers of
       //  things like thread_ready() should not have to block on
       //  contention
@@ -268,6 +322,12 @@ namespace Realm {
       atomic<bool> shutdown_flag;
       int active_worker_count;  // workers that are awake (i.e. using a core)
       int unassigned_worker_count;  // awake but unassigned workers
+      // bumped for anything that should end a worker's batch early: new
+      //  tasks with a higher priority than batch_priority (the lowest
+      //  priority of any running batch), resumable workers, internal tasks
+      //  and priority changes
+      atomic<uint64_t> preempt_counter;
+      atomic<int> batch_priority;
 
       // helper for tracking/sanity-checking worker counts
       void update_worker_count(int active_delta, int unassigned_delta, bool check = true);
@@ -324,22 +384,31 @@ namespace Realm {
       public:
         WorkCounterUpdater(ThreadedTaskScheduler *sched)
 	  : work_counter(&sched->work_counter)
+	  , preempt_counter(&sched->preempt_counter)
+	  , batch_priority(&sched->batch_priority)
 	{}
 
 	// TaskQueue-style
-	virtual void item_available(typename PQ::priority_t)
+	virtual void item_available(typename PQ::priority_t priority)
 	{
+	  // only higher-priority tasks need to preempt a running batch
+	  if(priority > batch_priority->load())
+	    preempt_counter->fetch_add(1);
 	  work_counter->increment_counter();
 	}
 
 	// PriorityQueue-style
 	virtual bool item_available(Thread *, typename PQ::priority_t) 
 	{ 
+	  // resumable workers may need to preempt a batch of queued tasks
+	  preempt_counter->fetch_add(1);
 	  work_counter->increment_counter();
 	  return false;  // never consumes the work
 	}
       protected:
 	WorkCounter *work_counter;
+	atomic<uint64_t> *preempt_counter;
+	atomic<int> *batch_priority;
       };
 
       WorkCounterUpdater<TaskQueue> wcu_task_queues;
@@ -355,6 +424,8 @@ namespace Realm {
       int cfg_max_idle_workers;
       int cfg_min_active_workers;
       int cfg_max_active_workers;
+      // 0 (or 1) disables work stealing
+      int cfg_steal_batch_size;
     };
 
     inline uint64_t ThreadedTaskScheduler::WorkCounter::read_counter(void) const
@@ -3029,7 +3029,9 @@ namespace Realm {
 	WriteSequenceCache wseqcache(this, 2 << 20);
 
 	while(true) {
-	  size_t min_xfer_size = 4096;  // TODO: make controllable
+	  size_t min_xfer_size = channel->xfer_size_policy.get_min_xfer_size();
+	  long long xfer_start = (channel->xfer_size_policy.is_adaptive() ?
+				   Clock::current_time_in_nanoseconds() : 0);
 	  size_t max_bytes = get_addresses(min_xfer_size, &rseqcache);
 	  if(max_bytes == 0)
 	    break;
@@ -3213,8 +3215,11 @@ namespace Realm {
 		total_bytes += bytes;
 
 		// stop if it's been too long, but make sure we do at least the
-		//  minimum number of bytes
-		if((total_bytes >= min_xfer_size) && work_until.is_expired()) break;
+		//  minimum number of bytes - an adaptive policy also ends the
+		//  request there so that its size is what gets tuned
+		if((total_bytes >= min_xfer_size) &&
+		   (channel->xfer_size_policy.is_adaptive() ||
+		    work_until.is_expired())) break;
 	      }
 	    } else {
 	      // input but no output, so skip input bytes
@@ -3244,6 +3249,11 @@ namespace Realm {
 
 	  bool done = record_address_consumption(total_bytes, total_bytes);
 
+	  if(channel->xfer_size_policy.is_adaptive())
+	    channel->xfer_size_policy.record_xfer(total_bytes,
+						  (Clock::current_time_in_nanoseconds() -
+						   xfer_start));
+
 	  did_work = true;
 
 	  if(done || work_until.is_expired())
@@ -3318,7 +3328,9 @@ namespace Realm {
 	WriteSequenceCache wseqcache(this, 2 << 20);
 
 	while(true) {
-	  size_t min_xfer_size = 4096;  // TODO: make controllable
+	  size_t min_xfer_size = channel->xfer_size_policy.get_min_xfer_size();
+	  long long xfer_start = (channel->xfer_size_policy.is_adaptive() ?
+				   Clock::current_time_in_nanoseconds() : 0);
 	  size_t max_bytes = get_addresses(min_xfer_size, &rseqcache);
 	  if(max_bytes == 0)
 	    break;
@@ -3399,8 +3411,11 @@ namespace Realm {
 	      total_bytes += bytes;
 
 	      // stop if it's been too long, but make sure we do at least the
-	      //  minimum number of bytes
-	      if((total_bytes >= min_xfer_size) && work_until.is_expired()) break;
+	      //  minimum number of bytes - an adaptive policy also ends the
+	      //  request there so that its size is what gets tuned
+	      if((total_bytes >= min_xfer_size) &&
+	         (channel->xfer_size_policy.is_adaptive() ||
+	          work_until.is_expired())) break;
 	    }
 	  } else {
 	    // fill with no output, so just count the bytes
@@ -3415,6 +3430,11 @@ namespace Realm {
 
 	  bool done = record_address_consumption(total_bytes, total_bytes);
 
+	  if(channel->xfer_size_policy.is_adaptive())
+	    channel->xfer_size_policy.record_xfer(total_bytes,
+						  (Clock::current_time_in_nanoseconds() -
+						   xfer_start));
+
 	  did_work = true;
 
 	  if(done || work_until.is_expired())
@@ -3447,6 +3467,9 @@ namespace Realm {
 	kind = XFER_MEM_CPY;
         redop = get_runtime()->reduce_op_table.get(redop_info.id, 0);
         assert(redop);
+        // out-of-place reductions have a second input holding the lhs
+        assert(redop_info.in_place ? (input_ports.size() == 1) :
+                                     (input_ports.size() == 2));
       }
 
       long MemreduceXferDes::get_requests(Request** requests, long nr)
@@ -3465,10 +3488,34 @@ namespace Realm {
 
         const size_t in_elem_size = redop->sizeof_rhs;
         const size_t out_elem_size = (redop_info.is_fold ? redop->sizeof_rhs : redop->sizeof_lhs);
-        assert(redop_info.in_place);  // TODO: support for out-of-place reduces
+
+        // an out-of-place reduction reads the lhs from the base port (which
+        //  walks the same domain as the output) and writes lhs (+) rhs to
+        //  the output in a single pass
+        XferPort *base_port = 0;
+        uintptr_t base_base = 0;
+        if(!redop_info.in_place) {
+          base_port = &input_ports[1];
+          base_base = reinterpret_cast<uintptr_t>(base_port->mem->get_direct_ptr(0, 0));
+          assert(base_base != 0);
+        }
+        // the base data is copied to the output in blocks small enough to
+        //  still be in cache when the reduction is applied on top
+        const size_t max_block_elems = (base_port ?
+                                          std::max<size_t>(1, 16384 / out_elem_size) :
+                                          size_t(-1));
+
+        // exclusive reductions where both sides are dense can use the
+        //  redop's dense kernels, which are vectorized for common cases
+        ReductionKernels::DenseKernelFn dense_fn = 0;
+        if(Config::use_dense_reductions && redop_info.is_exclusive)
+          dense_fn = (redop_info.is_fold ? redop->cpu_fold_excl_dense_fn :
+                                           redop->cpu_apply_excl_dense_fn);
 
 	while(true) {
-	  size_t min_xfer_size = 4096;  // TODO: make controllable
+	  size_t min_xfer_size = channel->xfer_size_policy.get_min_xfer_size();
+	  long long xfer_start = (channel->xfer_size_policy.is_adaptive() ?
+				   Clock::current_time_in_nanoseconds() : 0);
 	  size_t max_bytes = get_addresses(min_xfer_size, &rseqcache);
 	  if(max_bytes == 0)
 	    break;
@@ -3510,6 +3557,17 @@ namespace Realm {
             }
           }
 
+          if((base_port != 0) && (out_port != 0)) {
+            // make sure we have base addresses to match the output
+            if(base_port->addrlist.bytes_pending() < (max_elems * out_elem_size)) {
+              const InstanceLayoutPieceBase *base_nonaffine;
+              base_port->iter->get_addresses(base_port->addrlist, base_nonaffine);
+              assert(!base_nonaffine);
+            }
+            max_elems = std::min(max_elems,
+                                 base_port->addrlist.bytes_pending() / out_elem_size);
+          }
+
 	  size_t total_elems = 0;
 	  if(in_port != 0) {
 	    if(out_port != 0) {
@@ -3558,34 +3616,78 @@ namespace Realm {
 
 		size_t elems_left = max_elems - total_elems;
                 size_t elems = std::min(std::min(icount, ocount), elems_left);
+
+                // the base is treated just like the output
+                int base_dim = 0;
+                size_t bstride = 0;
+                uintptr_t base_offset = 0;
+                if(base_port != 0) {
+                  AddressListCursor& base_alc = base_port->addrcursor;
+                  base_offset = base_alc.get_offset();
+                  base_dim = base_alc.get_dim();
+                  size_t bcount = base_alc.remaining(0) / out_elem_size;
+                  if((base_dim > 1) && (bcount == 1)) {
+                    base_dim = 2;
+                    bcount = base_alc.remaining(1);
+                    bstride = base_alc.get_stride(1);
+                  } else {
+                    base_dim = 1;
+                    bstride = out_elem_size;
+                  }
+                  elems = std::min(elems, bcount);
+                }
                 assert(elems > 0);
 
-                void *out_ptr = reinterpret_cast<void *>(out_base + out_offset);
-                const void *in_ptr = reinterpret_cast<const void *>(in_base + in_offset);
-                if(redop_info.is_fold) {
-                  if(redop_info.is_exclusive)
-                    (redop->cpu_fold_excl_fn)(out_ptr, ostride,
-                                              in_ptr, istride,
-                                              elems, redop->userdata);
-                  else
-                    (redop->cpu_fold_nonexcl_fn)(out_ptr, ostride,
+                size_t block;
+                for(size_t done = 0; done < elems; done += block) {
+                  block = std::min(elems - done, max_block_elems);
+                  void *out_ptr = reinterpret_cast<void *>(out_base + out_offset +
+                                                           (done * ostride));
+                  const void *in_ptr = reinterpret_cast<const void *>(in_base + in_offset +
+                                                                      (done * istride));
+                  if(base_port != 0) {
+                    const char *base_ptr = reinterpret_cast<const char *>(base_base + base_offset +
+                                                                         (done * bstride));
+                    if((ostride == out_elem_size) && (bstride == out_elem_size)) {
+                      memcpy(out_ptr, base_ptr, block * out_elem_size);
+                    } else {
+                      char *optr = static_cast<char *>(out_ptr);
+                      for(size_t k = 0; k < block; k++)
+                        memcpy(optr + (k * ostride), base_ptr + (k * bstride),
+                               out_elem_size);
+                    }
+                  }
+
+                  if((dense_fn != 0) && (in_dim == 1) && (out_dim == 1)) {
+                    (*dense_fn)(out_ptr, in_ptr, block, redop->userdata);
+                  } else if(redop_info.is_fold) {
+                    if(redop_info.is_exclusive)
+                      (redop->cpu_fold_excl_fn)(out_ptr, ostride,
+                                                in_ptr, istride,
+                                                block, redop->userdata);
+                    else
+                      (redop->cpu_fold_nonexcl_fn)(out_ptr, ostride,
+                                                   in_ptr, istride,
+                                                   block, redop->userdata);
+                  } else {
+                    if (redop_info.is_exclusive)
+                      (redop->cpu_apply_excl_fn)(out_ptr, ostride,
                                                  in_ptr, istride,
-                                                 elems, redop->userdata);
-                } else {
-                  if (redop_info.is_exclusive)
-                    (redop->cpu_apply_excl_fn)(out_ptr, ostride,
-                                               in_ptr, istride,
-                                               elems, redop->userdata);
-                  else
-                    (redop->cpu_apply_nonexcl_fn)(out_ptr, ostride,
-                                                  in_ptr, istride,
-                                                  elems, redop->userdata);
+                                                 block, redop->userdata);
+                    else
+                      (redop->cpu_apply_nonexcl_fn)(out_ptr, ostride,
+                                                    in_ptr, istride,
+                                                    block, redop->userdata);
+                  }
                 }
 
                 in_alc.advance(in_dim-1,
                                elems * ((in_dim == 1) ? in_elem_size : 1));
                 out_alc.advance(out_dim-1,
                                 elems * ((out_dim == 1) ? out_elem_size : 1));
+                if(base_port != 0)
+                  base_port->addrcursor.advance(base_dim-1,
+                                                elems * ((base_dim == 1) ? out_elem_size : 1));
 
 #ifdef DEBUG_REALM
 		assert(elems <= elems_left);
@@ -3593,9 +3695,11 @@ namespace Realm {
 		total_elems += elems;
 
 		// stop if it's been too long, but make sure we do at least the
-		//  minimum number of bytes
+		//  minimum number of bytes - an adaptive policy also ends the
+		//  request there so that its size is what gets tuned
 		if(((total_elems * in_elem_size) >= min_xfer_size) &&
-                   work_until.is_expired()) break;
+		   (channel->xfer_size_policy.is_adaptive() ||
+		    work_until.is_expired())) break;
 	      }
 	    } else {
 	      // input but no output, so skip input bytes
@@ -3607,6 +3711,8 @@ namespace Realm {
 	      // output but no input, so skip output bytes
               total_elems = max_elems;
 	      out_port->addrcursor.skip_bytes(total_elems * out_elem_size);
+              if(base_port != 0)
+                base_port->addrcursor.skip_bytes(total_elems * out_elem_size);
 	    } else {
 	      // skipping both input and output is possible for simultaneous
 	      //  gather+scatter
@@ -3614,6 +3720,11 @@ namespace Realm {
 	    }
 	  }
 
+          if((base_port != 0) && (out_port != 0)) {
+            base_port->local_bytes_total += total_elems * out_elem_size;
+            base_port->local_bytes_cons.fetch_add(total_elems * out_elem_size);
+          }
+
 	  // memcpy is always immediate, so handle both skip and copy with the
 	  //  same code
 	  rseqcache.add_span(input_control.current_io_port,
@@ -3626,6 +3737,11 @@ namespace Realm {
 	  bool done = record_address_consumption(total_elems * in_elem_size,
                                                  total_elems * out_elem_size);
 
+	  if(channel->xfer_size_policy.is_adaptive())
+	    channel->xfer_size_policy.record_xfer(total_elems * out_elem_size,
+						  (Clock::current_time_in_nanoseconds() -
+						   xfer_start));
+
 	  did_work = true;
 
 	  if(done || work_until.is_expired())
@@ -3834,7 +3950,9 @@ namespace Realm {
 
 	const size_t MAX_ASSEMBLY_SIZE = 4096;
 	while(true) {
-	  size_t min_xfer_size = 4096;  // TODO: make controllable
+	  size_t min_xfer_size = channel->xfer_size_policy.get_min_xfer_size();
+	  long long xfer_start = (channel->xfer_size_policy.is_adaptive() ?
+				   Clock::current_time_in_nanoseconds() : 0);
 	  size_t max_bytes = get_addresses(min_xfer_size, &rseqcache);
 	  if(max_bytes == 0)
 	    break;
@@ -4122,8 +4240,11 @@ namespace Realm {
 		total_bytes += bytes;
 
 		// stop if it's been too long, but make sure we do at least the
-		//  minimum number of bytes
-		if((total_bytes >= min_xfer_size) && work_until.is_expired()) break;
+		//  minimum number of bytes - an adaptive policy also ends the
+		//  request there so that its size is what gets tuned
+		if((total_bytes >= min_xfer_size) &&
+		   (channel->xfer_size_policy.is_adaptive() ||
+		    work_until.is_expired())) break;
 	      }
 	    } else {
 	      // input but no output, so skip input bytes
@@ -4150,6 +4271,11 @@ namespace Realm {
 
 	  bool done = record_address_consumption(total_bytes, total_bytes);
 
+	  if(channel->xfer_size_policy.is_adaptive())
+	    channel->xfer_size_policy.record_xfer(total_bytes,
+						  (Clock::current_time_in_nanoseconds() -
+						   xfer_start));
+
 	  did_work = true;
 
 	  if(done || work_until.is_expired())
@@ -4259,6 +4385,110 @@ namespace Realm {
       }
 
 
+  ////////////////////////////////////////////////////////////////////////
+  //
+  // class XferSizePolicy
+  //
+
+  XferSizePolicy::XferSizePolicy()
+    : cur_size(4096)
+    , adaptive(false)
+    , lo(4096)
+    , hi(4096)
+    , epoch_bytes(0)
+    , epoch_ns(0)
+    , epoch_samples(0)
+    , prev_rate(0)
+    , growing(true)
+  {}
+
+  void XferSizePolicy::configure(size_t _initial, bool _adaptive,
+                                 size_t _lo, size_t _hi)
+  {
+    assert((_lo <= _initial) && (_initial <= _hi));
+    cur_size.store(_initial);
+    adaptive = _adaptive;
+    lo = _lo;
+    hi = _hi;
+  }
+
+  void XferSizePolicy::record_xfer(size_t bytes, long long elapsed_ns)
+  {
+    if(!adaptive || (bytes == 0))
+      return;
+
+    epoch_bytes.fetch_add(bytes);
+    // clock granularity can make tiny requests look free
+    epoch_ns.fetch_add(std::max<long long>(elapsed_ns, 1));
+
+    // whoever completes an epoch gets to evaluate it
+    if(epoch_samples.fetch_add(1) != (SAMPLES_PER_EPOCH - 1))
+      return;
+
+    // samples that race with the reset below just count toward the next
+    //  epoch - this is a heuristic, not an accounting
+    uint64_t bytes_total = epoch_bytes.exchange(0);
+    uint64_t ns_total = epoch_ns.exchange(0);
+    epoch_samples.store(0);
+
+    adapt(bytes_total, ns_total);
+  }
+
+  void XferSizePolicy::adapt(uint64_t bytes, uint64_t ns)
+  {
+    // if somebody else is still evaluating the previous epoch, drop this one
+    if(!adapt_mutex.trylock())
+      return;
+
+    double rate = double(bytes) / double(ns);
+
+    // keep moving in the same direction while throughput improves, turn
+    //  around when it drops noticeably or a bound is reached
+    if((prev_rate > 0) && (rate < (0.95 * prev_rate)))
+      growing = !growing;
+    prev_rate = rate;
+
+    size_t cur = cur_size.load();
+    size_t next;
+    if(growing) {
+      next = std::min(cur * 2, hi);
+      if(next == cur) {
+        growing = false;
+        next = std::max(cur / 2, lo);
+      }
+    } else {
+      next = std::max(cur / 2, lo);
+      if(next == cur) {
+        growing = true;
+        next = std::min(cur * 2, hi);
+      }
+    }
+
+    if(next != cur) {
+      log_xd.debug() << "min_xfer_size: " << cur << " -> " << next
+                     << " (rate=" << rate << " B/ns)";
+      cur_size.store(next);
+    }
+
+    adapt_mutex.unlock();
+  }
+
+  // applies the runtime configuration to a channel's policy
+  static void configure_xfer_size_policy(XferSizePolicy& policy,
+                                         size_t channel_size)
+  {
+    size_t initial = (channel_size ? channel_size : Config::min_xfer_size);
+    if(initial == 0)
+      initial = 1;
+    if(Config::adaptive_xfer_size)
+      policy.configure(initial, true,
+                       std::max<size_t>(initial >> 4, 1),
+                       std::max(initial, Config::max_adaptive_xfer_size));
+    else
+      policy.configure(initial, false, initial, initial);
+  }
+
+
   ////////////////////////////////////////////////////////////////////////
   //
   // class Channel::SupportedPath
@@ -5144,6 +5374,9 @@ namespace Realm {
 							XFER_MEM_CPY,
 							"memcpy channel")
       {
+        configure_xfer_size_policy(xfer_size_policy,
+                                   Config::memcpy_min_xfer_size);
+
         //cbs = (MemcpyRequest**) calloc(max_nr, sizeof(MemcpyRequest*));
 	unsigned bw = 5000; // HACK - estimate at 5 GB/s
 	unsigned latency = 100; // HACK - estimate at 100ns
@@ -5709,6 +5942,9 @@ namespace Realm {
 						      XFER_MEM_FILL,
 						      "memfill channel")
   {
+    configure_xfer_size_policy(xfer_size_policy,
+                               Config::memfill_min_xfer_size);
+
     unsigned bw = 10000; // HACK - estimate at 10 GB/s
     unsigned latency = 100; // HACK - estimate at 100ns
     unsigned frag_overhead = 100; // HACK - estimate at 100ns
@@ -5764,6 +6000,9 @@ namespace Realm {
                                                           XFER_MEM_CPY,
                                                           "memreduce channel")
   {
+    configure_xfer_size_policy(xfer_size_policy,
+                               Config::memreduce_min_xfer_size);
+
     unsigned bw = 1000; // HACK - estimate at 1 GB/s
     unsigned latency = 100; // HACK - estimate at 100ns
     unsigned frag_overhead = 100; // HACK - estimate at 100ns
@@ -5916,6 +6155,9 @@ namespace Realm {
 								   XFER_REMOTE_WRITE,
 								   "remote write channel")
       {
+	configure_xfer_size_policy(xfer_size_policy,
+				   Config::remote_write_min_xfer_size);
+
 	unsigned bw = 5000;  // HACK - estimate at 5 GB/s
 	unsigned latency = 2000;  // HACK - estimate at 2 us
         unsigned frag_overhead = 1000; // HACK - estimate at 1 us
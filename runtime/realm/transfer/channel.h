@@ -733,6 +733,41 @@ namespace Realm {
       uintptr_t channel;
     };
 
+    // decides the minimum number of bytes a cpu-driven channel waits for
+    //  (and moves) per request - either a fixed size or one that is
+    //  hill-climbed between [lo, hi] based on the throughput observed by
+    //  recent requests; an adaptive size also ends each request once it is
+    //  reached, so it sets how many fragments are batched per request (the
+    //  last fragment can overshoot it)
+    class XferSizePolicy {
+    public:
+      XferSizePolicy();
+
+      void configure(size_t _initial, bool _adaptive,
+                     size_t _lo, size_t _hi);
+
+      size_t get_min_xfer_size() const { return cur_size.load(); }
+      bool is_adaptive() const { return adaptive; }
+
+      // reports that a request moved 'bytes' bytes in 'elapsed_ns'
+      void record_xfer(size_t bytes, long long elapsed_ns);
+
+    protected:
+      void adapt(uint64_t bytes, uint64_t ns);
+
+      static const unsigned SAMPLES_PER_EPOCH = 64;
+
+      atomic<size_t> cur_size;
+      bool adaptive;
+      size_t lo, hi;
+      atomic<uint64_t> epoch_bytes, epoch_ns;
+      atomic<unsigned> epoch_samples;
+      // only touched while holding 'adapt_mutex'
+      Mutex adapt_mutex;
+      double prev_rate;
+      bool growing;
+    };
+
     class RemoteChannelInfo;
     class RemoteChannel;
 
@@ -754,6 +789,8 @@ namespace Realm {
       NodeID node;
       // the kind of XferDes this channel can accept
       XferDesKind kind;
+      // chunk size used by channels that move data with the cpu
+      XferSizePolicy xfer_size_policy;
 
       // attempt to make progress on the specified xferdes
       virtual long progress_xd(XferDes *xd, long max_nr);
@@ -67,8 +67,9 @@ namespace Realm {
       RegionInstanceImpl *impl = get_runtime()->get_instance_impl(inst);
       file_info = static_cast<FileMemory::OpenFileInfo *>(impl->metadata.mem_specific);
 
-      const int max_nr = 10; // FIXME
-      file_reqs = (FileRequest*) calloc(max_nr, sizeof(DiskRequest));
+      const int max_nr = Config::aio_requests_per_xd;
+      assert(max_nr > 0);
+      file_reqs = (FileRequest*) calloc(max_nr, sizeof(FileRequest));
       for (int i = 0; i < max_nr; i++) {
         file_reqs[i].xd = this;
         available_reqs.push(&file_reqs[i]);
@@ -170,7 +171,8 @@ namespace Realm {
 	assert(0 && "neither source nor dest of DiskXferDes is disk!?");
       }
 
-      const int max_nr = 10; // FIXME
+      const int max_nr = Config::aio_requests_per_xd;
+      assert(max_nr > 0);
       disk_reqs = (DiskRequest*) calloc(max_nr, sizeof(DiskRequest));
       for (int i = 0; i < max_nr; i++) {
         disk_reqs[i].xd = this;
@@ -92,7 +92,8 @@ namespace Realm {
       FileChannel(BackgroundWorkManager *bgwork);
       ~FileChannel();
 
-      // TODO: farm I/O work off to dedicated threads if needed
+      // I/O may be farmed off to dedicated threads (-ll:aio_threads), but
+      //  completions are still reported in order
       static const bool is_ordered = true;
 
       virtual XferDes *create_xfer_des(uintptr_t dma_op,
@@ -113,7 +114,8 @@ namespace Realm {
       DiskChannel(BackgroundWorkManager *bgwork);
       ~DiskChannel();
 
-      // TODO: farm I/O work off to dedicated threads if needed
+      // I/O may be farmed off to dedicated threads (-ll:aio_threads), but
+      //  completions are still reported in order
       static const bool is_ordered = true;
 
       virtual XferDes *create_xfer_des(uintptr_t dma_op,
@@ -56,6 +56,20 @@ namespace Realm {
     //extern Logger log_new_dma;
     Logger log_aio("aio");
 
+    namespace Config {
+      int aio_queue_depth = 256;
+      int aio_worker_threads = 0;
+      int aio_requests_per_xd = 10;
+      bool use_dense_reductions = true;
+      size_t min_xfer_size = 4096;
+      size_t memcpy_min_xfer_size = 0;
+      size_t memfill_min_xfer_size = 0;
+      size_t memreduce_min_xfer_size = 0;
+      size_t remote_write_min_xfer_size = 0;
+      bool adaptive_xfer_size = false;
+      size_t max_adaptive_xfer_size = 1 << 20;
+    };
+
     static atomic<unsigned> rdma_sequence_no(1);
 
     static AsyncFileIOContext *aio_context = 0;
@@ -261,6 +275,91 @@ namespace Realm {
     }
 #endif
 
+    // an I/O operation performed synchronously by one of the context's
+    //  dedicated worker threads
+    class ThreadedAIOOperation : public AsyncFileIOContext::AIOOperation {
+    public:
+      ThreadedAIOOperation(AsyncFileIOContext *_ctx, bool _is_write,
+			   int _fd, size_t _offset, size_t _bytes,
+			   void *_buffer, Request* request = NULL);
+      virtual void launch(void);
+      virtual bool check_completion(void);
+
+      // called on a worker thread
+      void perform(void);
+
+    public:
+      AsyncFileIOContext *ctx;
+      bool is_write;
+      int fd;
+      size_t offset, bytes;
+      void *buffer;
+      atomic<bool> done;
+    };
+
+    ThreadedAIOOperation::ThreadedAIOOperation(AsyncFileIOContext *_ctx,
+					       bool _is_write,
+					       int _fd, size_t _offset,
+					       size_t _bytes, void *_buffer,
+					       Request* request)
+      : ctx(_ctx), is_write(_is_write)
+      , fd(_fd), offset(_offset), bytes(_bytes), buffer(_buffer)
+      , done(false)
+    {
+      completed = false;
+      req = request;
+    }
+
+    void ThreadedAIOOperation::launch(void)
+    {
+      log_aio.debug("%s queued: op=%p fd=%d offset=%zd bytes=%zd",
+		    (is_write ? "write" : "read"), this, fd, offset, bytes);
+      ctx->enqueue_worker_operation(this);
+    }
+
+    bool ThreadedAIOOperation::check_completion(void)
+    {
+      return done.load_acquire();
+    }
+
+    void ThreadedAIOOperation::perform(void)
+    {
+#if defined(REALM_ON_LINUX) || defined(REALM_ON_MACOS) || defined(REALM_ON_FREEBSD)
+      char *ptr = static_cast<char *>(buffer);
+      size_t left = bytes;
+      off_t pos = offset;
+      while(left > 0) {
+	ssize_t ret = (is_write ? pwrite(fd, ptr, left, pos) :
+		                  pread(fd, ptr, left, pos));
+	if(ret < 0) {
+	  if(errno == EINTR) continue;
+	  log_aio.fatal() << (is_write ? "pwrite" : "pread")
+			  << " failed: fd=" << fd << " offset=" << pos
+			  << " bytes=" << left << " error=" << strerror(errno);
+	  abort();
+	}
+	if(ret == 0) {
+	  // reads past the end of a file see zeros, matching what the
+	  //  AIO paths leave in a (pre-zeroed) destination
+	  if(!is_write) {
+	    memset(ptr, 0, left);
+	    break;
+	  }
+	  log_aio.fatal() << "pwrite made no progress: fd=" << fd
+			  << " offset=" << pos << " bytes=" << left;
+	  abort();
+	}
+	ptr += ret;
+	pos += ret;
+	left -= ret;
+      }
+#else
+      assert(0 && "threaded file I/O not supported on this platform");
+#endif
+      log_aio.debug("%s completed: op=%p", (is_write ? "write" : "read"), this);
+      done.store_release(true);
+    }
+
     class AIOFence : public Operation::AsyncWorkItem {
     public:
       AIOFence(Operation *_op) : Operation::AsyncWorkItem(_op) {}
@@ -304,6 +403,10 @@ namespace Realm {
     AsyncFileIOContext::AsyncFileIOContext(int _max_depth)
       : BackgroundWorkItem("async file IO")
       , max_depth(_max_depth)
+      , use_worker_threads(false)
+      , worker_shutdown(false)
+      , worker_condvar(worker_mutex)
+      , worker_rsrv(0)
     {
 #ifdef REALM_USE_KERNEL_AIO
       aio_ctx = 0;
@@ -319,6 +422,8 @@ namespace Realm {
     {
       assert(pending_operations.empty());
       assert(launched_operations.empty());
+      assert(worker_threads.empty());
+      delete worker_rsrv;
 #ifdef REALM_USE_KERNEL_AIO
 #ifndef NDEBUG
       int ret =
@@ -332,14 +437,18 @@ namespace Realm {
 					   size_t bytes, const void *buffer,
                                            Request* req)
     {
+      AsyncFileIOContext::AIOOperation* op;
+      if(use_worker_threads)
+	op = new ThreadedAIOOperation(this, true /*is_write*/,
+				      fd, offset, bytes,
+				      const_cast<void *>(buffer), req);
+      else
 #ifdef REALM_USE_KERNEL_AIO
-      KernelAIOWrite *op = new KernelAIOWrite(aio_ctx,
-					      fd, offset, bytes, buffer, req);
+	op = new KernelAIOWrite(aio_ctx, fd, offset, bytes, buffer, req);
 #elif defined(REALM_USE_LIBAIO)
-      PosixAIOWrite *op = new PosixAIOWrite(fd, offset, bytes, buffer, req);
+	op = new PosixAIOWrite(fd, offset, bytes, buffer, req);
 #else
-      AsyncFileIOContext::AIOOperation* op = 0;
-      assert(0);
+	assert(0);
 #endif
       bool was_empty;
       {
@@ -360,14 +469,17 @@ namespace Realm {
 					  size_t bytes, void *buffer,
                                           Request* req)
     {
+      AsyncFileIOContext::AIOOperation* op;
+      if(use_worker_threads)
+	op = new ThreadedAIOOperation(this, false /*!is_write*/,
+				      fd, offset, bytes, buffer, req);
+      else
 #ifdef REALM_USE_KERNEL_AIO
-      KernelAIORead *op = new KernelAIORead(aio_ctx,
-					    fd, offset, bytes, buffer, req);
+	op = new KernelAIORead(aio_ctx, fd, offset, bytes, buffer, req);
 #elif defined(REALM_USE_LIBAIO)
-      PosixAIORead *op = new PosixAIORead(fd, offset, bytes, buffer, req);
+	op = new PosixAIORead(fd, offset, bytes, buffer, req);
 #else
-      AsyncFileIOContext::AIOOperation* op = 0;
-      assert(0);
+	assert(0);
 #endif
       bool was_empty;
       {
@@ -538,6 +650,71 @@ namespace Realm {
       return aio_context;
     }
 
+    void AsyncFileIOContext::start_worker_threads(int num_threads,
+						  CoreReservationSet& crs,
+						  size_t stack_size)
+    {
+      assert(num_threads > 0);
+      assert(worker_threads.empty());
+
+      worker_rsrv = new CoreReservation("file I/O workers", crs,
+					CoreReservationParameters());
+
+      ThreadLaunchParameters tlp;
+      tlp.set_stack_size(stack_size);
+
+      for(int i = 0; i < num_threads; i++)
+	worker_threads.push_back(Thread::create_kernel_thread<AsyncFileIOContext,
+				                              &AsyncFileIOContext::worker_thread_loop>(this,
+													tlp,
+													*worker_rsrv));
+      use_worker_threads = true;
+    }
+
+    void AsyncFileIOContext::stop_worker_threads(void)
+    {
+      {
+	AutoLock<> al(worker_mutex);
+	worker_shutdown = true;
+	worker_condvar.broadcast();
+      }
+
+      for(std::vector<Thread *>::iterator it = worker_threads.begin();
+	  it != worker_threads.end();
+	  ++it) {
+	(*it)->join();
+	delete (*it);
+      }
+      worker_threads.clear();
+      use_worker_threads = false;
+    }
+
+    void AsyncFileIOContext::enqueue_worker_operation(AIOOperation *op)
+    {
+      AutoLock<> al(worker_mutex);
+      worker_queue.push_back(op);
+      worker_condvar.signal();
+    }
+
+    void AsyncFileIOContext::worker_thread_loop(void)
+    {
+      while(true) {
+	ThreadedAIOOperation *op;
+	{
+	  AutoLock<> al(worker_mutex);
+	  while(worker_queue.empty() && !worker_shutdown)
+	    worker_condvar.wait();
+	  // finish any queued work before honoring a shutdown request
+	  if(worker_queue.empty())
+	    break;
+	  op = checked_cast<ThreadedAIOOperation *>(worker_queue.front());
+	  worker_queue.pop_front();
+	}
+
+	op->perform();
+      }
+    }
+
     Channel *get_xfer_channel(Memory src_mem, Memory dst_mem,
 			      CustomSerdezID src_serdez_id,
 			      CustomSerdezID dst_serdez_id,
@@ -824,10 +1001,14 @@ namespace Realm {
   }
 
 
-    void start_dma_system(BackgroundWorkManager *bgwork)
+    void start_dma_system(BackgroundWorkManager *bgwork,
+			  CoreReservationSet& crs, size_t stack_size)
     {
-      aio_context = new AsyncFileIOContext(256);
+      aio_context = new AsyncFileIOContext(Config::aio_queue_depth);
       aio_context->add_to_manager(bgwork);
+      if(Config::aio_worker_threads > 0)
+	aio_context->start_worker_threads(Config::aio_worker_threads,
+					  crs, stack_size);
     }
 
     void stop_dma_system(void)
@@ -835,6 +1016,7 @@ namespace Realm {
 #ifdef DEBUG_REALM
       aio_context->shutdown_work_item();
 #endif
+      aio_context->stop_worker_threads();
       delete aio_context;
       aio_context = 0;
     }
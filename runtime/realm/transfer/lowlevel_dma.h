@@ -32,11 +32,34 @@ namespace Realm {
     namespace Config {
       // the size of the LRU of the cache
       extern size_t path_cache_lru_size;
+      // maximum number of file/disk I/O operations in flight at once
+      extern int aio_queue_depth;
+      // if nonzero, file/disk I/O is performed by this many dedicated
+      //  threads instead of the platform's asynchronous I/O interface
+      extern int aio_worker_threads;
+      // maximum number of outstanding requests per file/disk XferDes
+      extern int aio_requests_per_xd;
+      // if true, exclusive reductions between dense source and destination
+      //  data use the reduction op's (possibly vectorized) dense kernels
+      extern bool use_dense_reductions;
+      // minimum number of bytes a cpu-driven channel moves per request,
+      //  with optional per-channel overrides (0 = use min_xfer_size)
+      extern size_t min_xfer_size;
+      extern size_t memcpy_min_xfer_size;
+      extern size_t memfill_min_xfer_size;
+      extern size_t memreduce_min_xfer_size;
+      extern size_t remote_write_min_xfer_size;
+      // if true, channels tune their minimum transfer size at runtime from
+      //  observed throughput, between 1/16th of the configured size and
+      //  max_adaptive_xfer_size
+      extern bool adaptive_xfer_size;
+      extern size_t max_adaptive_xfer_size;
     };
 
     extern void init_dma_handler(void);
 
-    extern void start_dma_system(BackgroundWorkManager *bgwork);
+    extern void start_dma_system(BackgroundWorkManager *bgwork,
+				 CoreReservationSet& crs, size_t stack_size);
 
     extern void stop_dma_system(void);
 
@@ -114,6 +137,14 @@ namespace Realm {
       AsyncFileIOContext(int _max_depth);
       ~AsyncFileIOContext(void);
 
+      // switches from the platform's asynchronous I/O interface to a pool of
+      //  dedicated threads that perform blocking pread/pwrite calls - this
+      //  keeps many requests in flight even for buffered files, which the
+      //  kernel and posix AIO paths effectively serialize
+      void start_worker_threads(int num_threads, CoreReservationSet& crs,
+				size_t stack_size);
+      void stop_worker_threads(void);
+
       void enqueue_write(int fd, size_t offset, size_t bytes, const void *buffer, Request* req = NULL);
       void enqueue_read(int fd, size_t offset, size_t bytes, void *buffer, Request* req = NULL);
       void enqueue_fence(Operation *req);
@@ -134,6 +165,10 @@ namespace Realm {
         void* req;
       };
 
+      // used by the worker thread pool
+      void enqueue_worker_operation(AIOOperation *op);
+      void worker_thread_loop(void);
+
     protected:
       void make_progress(void);
 
@@ -143,6 +178,15 @@ namespace Realm {
 #ifdef REALM_USE_KERNEL_AIO
       aio_context_t aio_ctx;
 #endif
+
+      // worker thread pool state (only used if start_worker_threads is called)
+      bool use_worker_threads;
+      bool worker_shutdown;
+      std::deque<AIOOperation *> worker_queue;
+      Mutex worker_mutex;
+      Mutex::CondVar worker_condvar;
+      CoreReservation *worker_rsrv;
+      std::vector<Thread *> worker_threads;
     };
 
   class WrappingFIFOIterator : public TransferIterator {
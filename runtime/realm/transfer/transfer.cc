@@ -1799,7 +1799,17 @@ namespace Realm {
             num_rects = 1;
           } else {
             SparsityMapPublicImpl<N,T> *s_impl = is.sparsity.impl();
-            num_rects = s_impl->get_entries().size();
+            const std::vector<SparsityMapEntry<N,T> >& entries = s_impl->get_entries();
+            // a bitmap entry is iterated as one rectangle per run of points
+            num_rects = 0;
+            for(size_t i = 0; i < entries.size(); i++)
+              if(entries[i].bitmap != 0) {
+                size_t pos = 0;
+                Rect<N,T> run;
+                while(entries[i].bitmap->next_run(is.bounds, pos, run))
+                  num_rects++;
+              } else
+                num_rects++;
           }
 
           for(int i = 0; i < (N + 2); i++)
@@ -4078,6 +4088,33 @@ namespace Realm {
           log_new_dma.fatal() << "FATAL: no path found from " << src_mem << " to " << dst_mem << " (redop=" << dsts[i].redop_id << ")";
           assert(0);
         }
+
+        // an out-of-place reduction reads its lhs from the base field as a
+        //  second input to the final (cpu) reduction xd, so the base has to
+        //  be somewhere that xd can get a direct pointer to
+        bool in_place = true;
+        unsigned base_fld_idx = 0;
+        if(dsts[i].red_base_inst.exists()) {
+          Memory base_mem = dsts[i].red_base_inst.get_location();
+          Memory::Kind base_kind = base_mem.kind();
+          const Channel *last_channel = path_info.xd_channels.back();
+          if((last_channel->kind != XFER_MEM_CPY) ||
+             (NodeID(ID(base_mem).memory_owner_node()) != last_channel->node) ||
+             !((base_kind == Memory::SYSTEM_MEM) ||
+               (base_kind == Memory::REGDMA_MEM) ||
+               (base_kind == Memory::Z_COPY_MEM) ||
+               (base_kind == Memory::SOCKET_MEM) ||
+               (base_kind == Memory::GPU_MANAGED_MEM))) {
+            log_new_dma.fatal() << "FATAL: out-of-place reduction not supported from " << src_mem << " to " << dst_mem << " with base in " << base_mem;
+            abort();
+          }
+          in_place = false;
+          base_fld_idx = src_fields.size();
+          src_fields.push_back(FieldInfo { dsts[i].red_base_field_id,
+                                           dsts[i].red_base_subfield_offset,
+                                           dsts[i].size, 0 });
+        }
+
         size_t pathlen = path_info.xd_channels.size();
         size_t xd_idx = graph.xd_nodes.size();
         size_t ib_idx = graph.ib_edges.size();
@@ -4100,13 +4137,16 @@ namespace Realm {
           if(j == (pathlen - 1))
             xdn.redop = XferDesRedopInfo(dsts[i].redop_id,
                                          dsts[i].red_fold,
-                                         true /*in_place*/,
+                                         in_place,
                                          dsts[i].red_exclusive);
-          xdn.inputs.resize(1);
+          xdn.inputs.resize((in_place || (j < (pathlen - 1))) ? 1 : 2);
           xdn.inputs[0] = ((j == 0) ?
                              TransferGraph::XDTemplate::mk_inst(srcs[i].inst,
                                                                 fld_start, 1) :
                              TransferGraph::XDTemplate::mk_edge(ib_idx - 1));
+          if(xdn.inputs.size() > 1)
+            xdn.inputs[1] = TransferGraph::XDTemplate::mk_inst(dsts[i].red_base_inst,
+                                                               base_fld_idx, 1);
           //xdn.inputs[0].indirect_inst = RegionInstance::NO_INST;
           xdn.outputs.resize(1);
           xdn.outputs[0] = ((j == (pathlen - 1)) ?
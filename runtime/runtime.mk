@@ -680,7 +680,7 @@ ifeq ($(findstring gasnet,$(REALM_NETWORKS)),gasnet)
     ifeq ($(strip $(REALM_NETWORKS)),gasnet1)
       REALM_CC_FLAGS	+= -DREALM_USE_GASNET1
     else
-      $(error Illegal value for REALM_NETWORKS: $(REALM_NETWORKS), needs to be either gasnet1, gasnetex, or mpi)
+      $(error Illegal value for REALM_NETWORKS: $(REALM_NETWORKS), needs to be either gasnet1, gasnetex, mpi, or shm)
     endif
   endif
   ifeq ($(GASNET),)
@@ -721,7 +721,11 @@ ifeq ($(strip $(REALM_NETWORKS)),mpi)
     REALM_CC_FLAGS        += -DREALM_USE_MPI
     USE_MPI = 1
 else
-  $(error Illegal value for REALM_NETWORKS: $(REALM_NETWORKS), needs to be either gasnet1, gasnetex, or mpi)
+ifeq ($(strip $(REALM_NETWORKS)),shm)
+    REALM_CC_FLAGS        += -DREALM_USE_SHM
+else
+  $(error Illegal value for REALM_NETWORKS: $(REALM_NETWORKS), needs to be either gasnet1, gasnetex, mpi, or shm)
+endif # Test for shared memory
 endif # Test for MPI
 endif # Test for GASNet
 endif # Only turn on networks if USE_NETWORK=1
@@ -938,6 +942,7 @@ REALM_SRC 	+= $(LG_RT_DIR)/realm/runtime_impl.cc \
 		   $(LG_RT_DIR)/realm/inst_impl.cc \
 		   $(LG_RT_DIR)/realm/inst_layout.cc \
 		   $(LG_RT_DIR)/realm/machine_impl.cc \
+		   $(LG_RT_DIR)/realm/redop.cc \
 		   $(LG_RT_DIR)/realm/sampling_impl.cc \
 		   $(LG_RT_DIR)/realm/subgraph_impl.cc \
                    $(LG_RT_DIR)/realm/transfer/lowlevel_disk.cc
@@ -961,6 +966,10 @@ ifeq ($(findstring mpi,$(REALM_NETWORKS)),mpi)
 REALM_SRC 	+= $(LG_RT_DIR)/realm/mpi/mpi_module.cc \
                    $(LG_RT_DIR)/realm/mpi/am_mpi.cc
 endif
+ifeq ($(findstring shm,$(REALM_NETWORKS)),shm)
+REALM_SRC 	+= $(LG_RT_DIR)/realm/shm/shm_module.cc \
+                   $(LG_RT_DIR)/realm/shm/shm_internal.cc
+endif
 endif
 ifeq ($(strip $(USE_OPENMP)),1)
 REALM_SRC 	+= $(LG_RT_DIR)/realm/openmp/openmp_module.cc \
@@ -78,6 +78,11 @@ legion_cxx_tests = [
     # Tests
     ['test/rendering/rendering', ['-i', '2', '-n', '64', '-ll:cpu', '4']],
     ['test/legion_stl/test_stl', []],
+    ['test/auto_trace/auto_trace', ['-lg:auto_trace', '-lg:auto_trace_min', '2']],
+    ['test/expr_cache/expr_cache', []],
+    ['test/prof_summary/prof_summary', []],
+    ['test/subgraph_replay/subgraph_replay', []],
+    ['test/subgraph_replay/subgraph_replay', ['-lg:parallel_replay', '2']],
     ['test/output_requirements/output_requirements', []],
     ['test/output_requirements/output_requirements', ['-replicate']],
     ['test/output_requirements/output_requirements', ['-index']],
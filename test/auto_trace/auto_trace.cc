@@ -0,0 +1,243 @@
+/* Copyright 2022 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs the same loop body many times so that automatic tracing
+// (-lg:auto_trace) picks it up and checks that the results match
+// what the untraced program computes
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#include "legion.h"
+
+using namespace Legion;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+  INCREMENT_TASK_ID,
+  SCALE_TASK_ID,
+  SUM_TASK_ID,
+};
+
+enum FieldIDs {
+  FID_VAL,
+};
+
+static Logger log_test("auto_trace");
+
+void increment_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  assert(task->arglen == sizeof(long long));
+  const long long delta = *(const long long*)task->args;
+  const FieldAccessor<LEGION_READ_WRITE,long long,1> acc(regions[0], FID_VAL);
+  Rect<1> rect = runtime->get_index_space_domain(ctx,
+                  task->regions[0].region.get_index_space());
+  for (PointInRectIterator<1> pir(rect); pir(); pir++)
+    acc[*pir] = acc[*pir] + delta;
+}
+
+void scale_task(const Task *task,
+                const std::vector<PhysicalRegion> &regions,
+                Context ctx, Runtime *runtime)
+{
+  const FieldAccessor<LEGION_READ_WRITE,long long,1> acc(regions[0], FID_VAL);
+  Rect<1> rect = runtime->get_index_space_domain(ctx,
+                  task->regions[0].region.get_index_space());
+  for (PointInRectIterator<1> pir(rect); pir(); pir++)
+    acc[*pir] = 2 * acc[*pir];
+}
+
+long long sum_task(const Task *task,
+                   const std::vector<PhysicalRegion> &regions,
+                   Context ctx, Runtime *runtime)
+{
+  const FieldAccessor<LEGION_READ_ONLY,long long,1> acc(regions[0], FID_VAL);
+  Rect<1> rect = runtime->get_index_space_domain(ctx,
+                  task->regions[0].region.get_index_space());
+  long long sum = 0;
+  for (PointInRectIterator<1> pir(rect); pir(); pir++)
+    sum += acc[*pir];
+  return sum;
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  int num_elements = 64;
+  int num_pieces = 4;
+  int num_iterations = 32;
+  {
+    const InputArgs &command_args = Runtime::get_input_args();
+    for (int i = 1; i < command_args.argc; i++)
+    {
+      if (!strcmp(command_args.argv[i],"-n"))
+        num_elements = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i],"-p"))
+        num_pieces = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i],"-i"))
+        num_iterations = atoi(command_args.argv[++i]);
+    }
+  }
+
+  const Rect<1> elem_rect(0, num_elements-1);
+  IndexSpace is = runtime->create_index_space(ctx, elem_rect);
+  FieldSpace fs = runtime->create_field_space(ctx);
+  {
+    FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+    allocator.allocate_field(sizeof(long long), FID_VAL);
+  }
+  LogicalRegion lr = runtime->create_logical_region(ctx, is, fs);
+  const Rect<1> color_bounds(0, num_pieces-1);
+  IndexSpace color_is = runtime->create_index_space(ctx, color_bounds);
+  IndexPartition ip = runtime->create_equal_partition(ctx, is, color_is);
+  LogicalPartition lp = runtime->get_logical_partition(ctx, lr, ip);
+
+  const long long zero = 0;
+  runtime->fill_field(ctx, lr, lr, FID_VAL, &zero, sizeof(zero));
+
+  // The loop body is the same every iteration so it should be traced
+  // after the first couple of iterations
+  const long long delta = 1;
+  ArgumentMap arg_map;
+  std::vector<Future> sums;
+  long long expected = 0;
+  std::vector<long long> expected_sums;
+  for (int iter = 0; iter < num_iterations; iter++)
+  {
+    IndexTaskLauncher increment_launcher(INCREMENT_TASK_ID, color_is,
+        TaskArgument(&delta, sizeof(delta)), arg_map);
+    increment_launcher.add_region_requirement(
+        RegionRequirement(lp, 0/*projection ID*/,
+                          LEGION_READ_WRITE, LEGION_EXCLUSIVE, lr));
+    increment_launcher.add_field(0, FID_VAL);
+    runtime->execute_index_space(ctx, increment_launcher);
+
+    IndexTaskLauncher scale_launcher(SCALE_TASK_ID, color_is,
+        TaskArgument(), arg_map);
+    scale_launcher.add_region_requirement(
+        RegionRequirement(lp, 0/*projection ID*/,
+                          LEGION_READ_WRITE, LEGION_EXCLUSIVE, lr));
+    scale_launcher.add_field(0, FID_VAL);
+    runtime->execute_index_space(ctx, scale_launcher);
+
+    TaskLauncher sum_launcher(SUM_TASK_ID, TaskArgument());
+    sum_launcher.add_region_requirement(
+        RegionRequirement(lr, LEGION_READ_ONLY, LEGION_EXCLUSIVE, lr));
+    sum_launcher.add_field(0, FID_VAL);
+    Future sum = runtime->execute_task(ctx, sum_launcher);
+    sums.push_back(sum);
+
+    expected = 2 * (expected + delta);
+    expected_sums.push_back(expected * num_elements);
+
+    // Poll on the result without blocking every few iterations which
+    // should not hang while operations are held back for tracing
+    if ((iter % 8) == 7)
+    {
+      while (!sum.is_ready())
+        runtime->yield(ctx);
+    }
+    // A predicated false launch in the middle of the loop must not
+    // get ahead of the operations that have already been issued
+    if ((iter % 8) == 3)
+    {
+      TaskLauncher false_launcher(INCREMENT_TASK_ID,
+          TaskArgument(&delta, sizeof(delta)), Predicate::FALSE_PRED);
+      false_launcher.add_region_requirement(
+          RegionRequirement(lr, LEGION_READ_WRITE, LEGION_EXCLUSIVE, lr));
+      false_launcher.add_field(0, FID_VAL);
+      runtime->execute_task(ctx, false_launcher);
+    }
+    // Keep the values from overflowing
+    if (((iter % 16) == 15) && ((iter + 1) < num_iterations))
+    {
+      runtime->fill_field(ctx, lr, lr, FID_VAL, &zero, sizeof(zero));
+      expected = 0;
+    }
+  }
+
+  bool success = true;
+  for (unsigned idx = 0; idx < sums.size(); idx++)
+  {
+    const long long actual = sums[idx].get_result<long long>();
+    if (actual != expected_sums[idx])
+    {
+      log_test.error("Iteration %u: expected sum %lld but got %lld",
+                     idx, expected_sums[idx], actual);
+      success = false;
+    }
+  }
+  {
+    InlineLauncher launcher(
+        RegionRequirement(lr, LEGION_READ_ONLY, LEGION_EXCLUSIVE, lr));
+    launcher.add_field(FID_VAL);
+    PhysicalRegion region = runtime->map_region(ctx, launcher);
+    const FieldAccessor<LEGION_READ_ONLY,long long,1> acc(region, FID_VAL);
+    for (PointInRectIterator<1> pir(elem_rect); pir(); pir++)
+    {
+      if (acc[*pir] != expected)
+      {
+        log_test.error("Element %lld: expected %lld but got %lld",
+                       (*pir)[0], expected, acc[*pir]);
+        success = false;
+      }
+    }
+    runtime->unmap_region(ctx, region);
+  }
+  if (success)
+    log_test.print("SUCCESS!");
+  else
+    log_test.error("FAILURE!");
+
+  runtime->destroy_logical_region(ctx, lr);
+  runtime->destroy_field_space(ctx, fs);
+  runtime->destroy_index_space(ctx, color_is);
+  runtime->destroy_index_space(ctx, is);
+  if (!success)
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+  {
+    TaskVariantRegistrar registrar(INCREMENT_TASK_ID, "increment");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<increment_task>(registrar, "increment");
+  }
+  {
+    TaskVariantRegistrar registrar(SCALE_TASK_ID, "scale");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<scale_task>(registrar, "scale");
+  }
+  {
+    TaskVariantRegistrar registrar(SUM_TASK_ID, "sum");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<long long, sum_task>(registrar, "sum");
+  }
+  return Runtime::start(argc, argv);
+}
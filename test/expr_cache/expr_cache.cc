@@ -0,0 +1,193 @@
+/* Copyright 2022 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Churns through many index space unions with a small expression cache
+// (-lg:expr_cache) and checks the cache statistics written at shutdown:
+// dead unions must get evicted while a union that is still in use must
+// keep hitting in the cache
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+
+#include "legion.h"
+
+using namespace Legion;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+};
+
+#define NUM_SPACES 256
+#define NUM_ROUNDS 4
+#define CACHE_CAPACITY "16"
+
+static Logger log_test("expr_cache");
+
+static bool check_volume(Runtime *runtime, Context ctx, IndexSpace space,
+                         size_t expected)
+{
+  const Domain domain = runtime->get_index_space_domain(ctx, space);
+  if (domain.get_volume() == expected)
+    return true;
+  log_test.error("Expected union volume %zd but got %zd",
+                 expected, domain.get_volume());
+  return false;
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  // Disjoint spaces with two points each
+  std::vector<IndexSpace> spaces(NUM_SPACES);
+  for (int i = 0; i < NUM_SPACES; i++)
+    spaces[i] = runtime->create_index_space(ctx, Rect<1>(3*i, 3*i+1));
+
+  bool success = true;
+  std::vector<IndexSpace> operands(2);
+  // This union stays alive for the whole test
+  operands[0] = spaces[0];
+  operands[1] = spaces[1];
+  IndexSpace keep = runtime->union_index_spaces(ctx, operands);
+  success = check_volume(runtime, ctx, keep, 4) && success;
+  for (int round = 0; round < NUM_ROUNDS; round++)
+  {
+    // Make lots of unions that are dead as soon as we delete them
+    for (int i = 2; i < (NUM_SPACES-1); i++)
+    {
+      operands[0] = spaces[i];
+      operands[1] = spaces[i+1];
+      IndexSpace temp = runtime->union_index_spaces(ctx, operands);
+      success = check_volume(runtime, ctx, temp, 4) && success;
+      runtime->destroy_index_space(ctx, temp);
+    }
+    // The union that is still in use should not have been evicted
+    operands[0] = spaces[0];
+    operands[1] = spaces[1];
+    IndexSpace again = runtime->union_index_spaces(ctx, operands);
+    success = check_volume(runtime, ctx, again, 4) && success;
+    runtime->destroy_index_space(ctx, again);
+  }
+  runtime->destroy_index_space(ctx, keep);
+  for (int i = 0; i < NUM_SPACES; i++)
+    runtime->destroy_index_space(ctx, spaces[i]);
+  if (!success)
+  {
+    log_test.error("FAILURE!");
+    exit(1);
+  }
+}
+
+// Returns true if the union cache statistics show evictions and at
+// least one hit for every lookup of the union that is still in use
+static bool check_statistics(const char *filename)
+{
+  FILE *f = fopen(filename, "r");
+  if (f == NULL)
+  {
+    fprintf(stderr, "Unable to open log file %s\n", filename);
+    return false;
+  }
+  bool found = false;
+  unsigned long long hits = 0, misses = 0, evictions = 0;
+  char line[1024];
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    const char *stats = strstr(line, "Expression cache for union operations");
+    if (stats == NULL)
+      continue;
+    stats = strchr(stats, ':');
+    if ((stats == NULL) || (sscanf(stats, ": %llu hits, %llu misses",
+                                   &hits, &misses) != 2))
+    {
+      fprintf(stderr, "Malformed statistics line: %s", line);
+      fclose(f);
+      return false;
+    }
+    const char *evicted = strstr(stats, "), ");
+    if ((evicted == NULL) || (sscanf(evicted, "), %llu evictions",
+                                     &evictions) != 1))
+    {
+      fprintf(stderr, "Malformed statistics line: %s", line);
+      fclose(f);
+      return false;
+    }
+    found = true;
+  }
+  fclose(f);
+  if (!found)
+  {
+    fprintf(stderr, "No union cache statistics in %s\n", filename);
+    return false;
+  }
+  printf("union cache: %llu hits, %llu misses, %llu evictions\n",
+         hits, misses, evictions);
+  bool success = true;
+  if (hits < NUM_ROUNDS)
+  {
+    fprintf(stderr, "Expected at least %d hits for the live union\n",
+            NUM_ROUNDS);
+    success = false;
+  }
+  if (misses < (NUM_SPACES - 2))
+  {
+    fprintf(stderr, "Expected at least %d misses for the distinct unions\n",
+            NUM_SPACES - 2);
+    success = false;
+  }
+  if (evictions == 0)
+  {
+    fprintf(stderr, "Expected dead unions to be evicted\n");
+    success = false;
+  }
+  return success;
+}
+
+int main(int argc, char **argv)
+{
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+
+  // Use a small cache and log its statistics to a file that we can check
+  char filename[64];
+  snprintf(filename, sizeof(filename), "expr_cache_%d.log", getpid());
+  std::vector<char*> args(argv, argv + argc);
+  const char *const cache_args[] = { "-lg:expr_cache", CACHE_CAPACITY,
+    "-level", "index_spaces=2", "-logfile", filename };
+  for (unsigned idx = 0; idx < (sizeof(cache_args)/sizeof(char*)); idx++)
+    args.push_back(const_cast<char*>(cache_args[idx]));
+  args.push_back(NULL);
+
+  // Start returns once the runtime has shut down and reported statistics
+  const int result = Runtime::start(args.size() - 1, &args[0]);
+  if (result != 0)
+    return result;
+  const bool success = check_statistics(filename);
+  unlink(filename);
+  if (!success)
+  {
+    fprintf(stderr, "FAILURE!\n");
+    return 1;
+  }
+  printf("SUCCESS!\n");
+  return 0;
+}
@@ -0,0 +1,241 @@
+/* Copyright 2022 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Builds the kd-trees used for finding interfering children of a partition
+// from a blockified partition with tens of thousands of children over an
+// irregular parent, the same way IndexPartNodeT::find_interfering_children_kd
+// does, and checks the interfering colors for single and batched queries
+// against a brute-force intersection with every child rectangle. The tree
+// is large enough that subtrees get built in parallel by meta-tasks, so the
+// result is also compared against a tree built serially.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "legion.h"
+// The kd-tree is internal to the runtime so pull in the same headers
+// as the instantiations of the region tree templates
+#include "legion/runtime.h"
+#include "legion/legion_ops.h"
+#include "legion/legion_tasks.h"
+#include "legion/region_tree.h"
+#include "legion/legion_context.h"
+#include "legion/legion_instances.h"
+#include "legion/legion_views.h"
+#include "legion/legion_analysis.h"
+#include "legion/legion_trace.h"
+#include "legion/legion_replication.h"
+
+#define DEFINE_NT_TEMPLATES
+#include "legion/region_tree.inl"
+
+using namespace Legion;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+};
+
+// The parent is a ragged disc with a hole in the middle inside of a
+// SIDE x SIDE square, which is partitioned into TILE x TILE blocks
+#define SIDE 1024
+#define TILE 4
+#define HOLE 96
+#define NUM_QUERIES 384
+#define BATCH_SIZE 8
+
+static Logger log_test("kd_tree");
+
+typedef Internal::FlatKDTree<2,coord_t,LegionColor> KDTree64;
+
+template<typename T>
+static void brute_force(
+    const std::vector<std::pair<Rect<2,T>,LegionColor> > &rects,
+    const Rect<2,T> &test, std::vector<LegionColor> &colors)
+{
+  for (typename std::vector<std::pair<Rect<2,T>,LegionColor> >::const_iterator
+        it = rects.begin(); it != rects.end(); it++)
+    if (it->first.overlaps(test))
+      colors.push_back(it->second);
+}
+
+static void sort_unique(std::vector<LegionColor> &colors)
+{
+  std::sort(colors.begin(), colors.end());
+  colors.erase(std::unique(colors.begin(), colors.end()), colors.end());
+}
+
+template<typename T>
+static bool check_colors(const char *kind, unsigned query,
+                         const std::vector<LegionColor> &expected,
+                         const std::vector<LegionColor> &actual)
+{
+  if (expected == actual)
+    return true;
+  log_test.error("%s query %u of %zd-bit tree found %zd interfering colors "
+                 "but expected %zd", kind, query, 8*sizeof(T),
+                 actual.size(), expected.size());
+  return false;
+}
+
+template<typename T>
+static bool check_tree(Internal::Runtime *runtime, const Rect<2,T> &bounds,
+                const std::vector<std::pair<Rect<2,T>,LegionColor> > &rects,
+                const std::vector<Rect<2,T> > &queries)
+{
+  typedef Internal::FlatKDTree<2,T,LegionColor> KDTree;
+  // The trees consume the rectangles they are built from
+  std::vector<std::pair<Rect<2,T>,LegionColor> > parallel_rects(rects);
+  const KDTree parallel(runtime, bounds, parallel_rects);
+  std::vector<std::pair<Rect<2,T>,LegionColor> > serial_rects(rects);
+  const KDTree serial(NULL/*runtime*/, bounds, serial_rects);
+  bool success = true;
+  if (parallel.count_rectangles() != serial.count_rectangles())
+  {
+    log_test.error("Parallel %zd-bit tree has %zd rectangles but the serial "
+                   "tree has %zd", 8*sizeof(T), parallel.count_rectangles(),
+                   serial.count_rectangles());
+    success = false;
+  }
+  std::vector<LegionColor> batch_expected;
+  for (unsigned idx = 0; idx < queries.size(); idx++)
+  {
+    std::vector<LegionColor> expected;
+    brute_force(rects, queries[idx], expected);
+    batch_expected.insert(batch_expected.end(),
+                          expected.begin(), expected.end());
+    sort_unique(expected);
+    std::vector<LegionColor> colors;
+    parallel.find_interfering(queries[idx], colors);
+    success = check_colors<T>("Single", idx, expected, colors) && success;
+    colors.clear();
+    serial.find_interfering(queries[idx], colors);
+    success = check_colors<T>("Serial", idx, expected, colors) && success;
+    if (((idx + 1) % BATCH_SIZE) != 0)
+      continue;
+    // Test the last batch of queries together
+    const std::vector<Rect<2,T> > batch(
+        queries.begin() + (idx + 1 - BATCH_SIZE), queries.begin() + (idx + 1));
+    sort_unique(batch_expected);
+    colors.clear();
+    parallel.find_interfering(batch, colors);
+    success = check_colors<T>("Batched", idx, batch_expected, colors) &&
+      success;
+    batch_expected.clear();
+  }
+  return success;
+}
+
+static Rect<2,int> narrow(const Rect<2,coord_t> &rect)
+{
+  return Rect<2,int>(Point<2,int>(rect.lo[0], rect.lo[1]),
+                     Point<2,int>(rect.hi[0], rect.hi[1]));
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  // Each row of the disc is one or two rectangles with ragged ends
+  const coord_t center = SIDE / 2;
+  std::vector<Rect<2> > rows;
+  for (coord_t y = 0; y < SIDE; y++)
+  {
+    const double dy = double(y - center) + 0.5;
+    const coord_t half = coord_t(sqrt(double(center * center) - dy * dy));
+    const coord_t lo = center - half + (y % 5);
+    const coord_t hi = center + half - (y % 3) - 1;
+    if (std::abs(y - center) < HOLE)
+    {
+      rows.push_back(Rect<2>(Point<2>(lo, y), Point<2>(center - HOLE, y)));
+      rows.push_back(Rect<2>(Point<2>(center + HOLE, y), Point<2>(hi, y)));
+    }
+    else
+      rows.push_back(Rect<2>(Point<2>(lo, y), Point<2>(hi, y)));
+  }
+  IndexSpaceT<2> parent = runtime->create_index_space(ctx, rows);
+  IndexPartitionT<2> partition =
+    runtime->create_partition_by_blockify(ctx, parent, Point<2>(TILE, TILE));
+  const Rect<2> bounds = runtime->get_index_space_domain(parent).bounds;
+
+  // Gather the rectangles of all the children like the runtime does
+  std::vector<std::pair<Rect<2,coord_t>,LegionColor> > rects64;
+  std::vector<std::pair<Rect<2,int>,LegionColor> > rects32;
+  const Rect<2> colors =
+    runtime->get_index_partition_color_space<2,coord_t,2,coord_t>(
+        partition).bounds;
+  LegionColor color = 0;
+  for (PointInRectIterator<2> pir(colors); pir(); pir++, color++)
+  {
+    IndexSpaceT<2> child = runtime->get_index_subspace(partition, *pir);
+    const DomainT<2> space = runtime->get_index_space_domain(child);
+    for (RectInDomainIterator<2> it(space); it(); it++)
+    {
+      rects64.push_back(std::make_pair(*it, color));
+      rects32.push_back(std::make_pair(narrow(*it), color));
+    }
+  }
+  log_test.print("%zd rectangles in %llu children", rects64.size(), color);
+  bool success = true;
+  if (rects64.size() < (4 * KDTree64::PARALLEL_BUILD_RECTS))
+  {
+    log_test.error("Too few rectangles to build the kd-tree in parallel");
+    success = false;
+  }
+
+  // Small, medium and large queries, some of which hang off the bounds
+  std::vector<Rect<2,coord_t> > queries64;
+  std::vector<Rect<2,int> > queries32;
+  srand48(12345);
+  const coord_t extents[3] = { 8, 64, SIDE / 2 };
+  for (unsigned idx = 0; idx < NUM_QUERIES; idx++)
+  {
+    Point<2> lo, hi;
+    for (int d = 0; d < 2; d++)
+    {
+      lo[d] = (lrand48() % (SIDE + 32)) - 16;
+      hi[d] = lo[d] + (lrand48() % extents[idx % 3]);
+    }
+    queries64.push_back(Rect<2>(lo, hi));
+    queries32.push_back(narrow(queries64.back()));
+  }
+
+  Internal::Runtime *internal = Internal::implicit_runtime;
+  success = check_tree<coord_t>(internal, bounds, rects64, queries64) &&
+    success;
+  success = check_tree<int>(internal, narrow(bounds), rects32, queries32) &&
+    success;
+
+  runtime->destroy_index_space(ctx, parent);
+  if (!success)
+  {
+    log_test.error("FAILURE!");
+    exit(1);
+  }
+  log_test.print("SUCCESS!");
+}
+
+int main(int argc, char **argv)
+{
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+  return Runtime::start(argc, argv);
+}
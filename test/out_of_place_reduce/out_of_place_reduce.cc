@@ -0,0 +1,223 @@
+/* Copyright 2022 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Reads a region into a fresh instance after reducing to it so that the
+// runtime has to build the new instance from the old base instance and
+// the reduction instance, which it does with a single out-of-place
+// reduction (dst = base + reduction) when both are in system memory.
+// A second round does the same with two reduction instances.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "legion.h"
+#include "default_mapper.h"
+
+using namespace Legion;
+using namespace Legion::Mapping;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+  INIT_TASK_ID,
+  REDUCE_TASK_ID,
+  CHECK_TASK_ID,
+};
+
+enum FieldIDs {
+  FID_VALUE,
+};
+
+#define NUM_ELEMENTS 4096
+
+static Logger log_test("out_of_place_reduce");
+
+typedef ReductionAccessor<SumReduction<int64_t>,true/*exclusive*/,1,coord_t,
+          Realm::AffineAccessor<int64_t,1,coord_t> > SumAccessor;
+
+// Always maps the check task to a new instance so its contents have to
+// be rebuilt from the valid instances
+class FreshInstanceMapper : public DefaultMapper {
+public:
+  FreshInstanceMapper(MapperRuntime *rt, Machine machine, Processor local)
+    : DefaultMapper(rt, machine, local, "fresh_instance_mapper") { }
+public:
+  virtual void map_task(const MapperContext ctx, const Task &task,
+                        const MapTaskInput &input, MapTaskOutput &output)
+  {
+    DefaultMapper::map_task(ctx, task, input, output);
+    if (task.task_id != CHECK_TASK_ID)
+      return;
+    const RegionRequirement &req = task.regions[0];
+    const Memory memory = output.chosen_instances[0].front().get_location();
+    LayoutConstraintSet constraints;
+    constraints.add_constraint(MemoryConstraint(memory.kind()))
+      .add_constraint(FieldConstraint(req.privilege_fields, false, false))
+      .add_constraint(SpecializedConstraint());
+    const std::vector<LogicalRegion> regions(1, req.region);
+    PhysicalInstance instance;
+    if (!runtime->create_physical_instance(ctx, memory, constraints,
+                                           regions, instance))
+    {
+      log_test.error("Unable to create a new instance for the check task");
+      abort();
+    }
+    output.chosen_instances[0].clear();
+    output.chosen_instances[0].push_back(instance);
+  }
+};
+
+void init_task(const Task *task,
+               const std::vector<PhysicalRegion> &regions,
+               Context ctx, Runtime *runtime)
+{
+  const FieldAccessor<WRITE_DISCARD,int64_t,1> acc(regions[0], FID_VALUE);
+  const Rect<1> rect = runtime->get_index_space_domain(ctx,
+                          task->regions[0].region.get_index_space());
+  for (PointInRectIterator<1> pir(rect); pir(); pir++)
+    acc[*pir] = (*pir)[0];
+}
+
+void reduce_task(const Task *task,
+                 const std::vector<PhysicalRegion> &regions,
+                 Context ctx, Runtime *runtime)
+{
+  const int64_t scale = *(const int64_t*)task->args;
+  const SumAccessor acc(regions[0], FID_VALUE, LEGION_REDOP_SUM_INT64);
+  const Rect<1> rect = runtime->get_index_space_domain(ctx,
+                          task->regions[0].region.get_index_space());
+  for (PointInRectIterator<1> pir(rect); pir(); pir++)
+    acc[*pir] <<= scale * ((*pir)[0] + 1);
+}
+
+bool check_task(const Task *task,
+                const std::vector<PhysicalRegion> &regions,
+                Context ctx, Runtime *runtime)
+{
+  const int64_t scale = *(const int64_t*)task->args;
+  const FieldAccessor<READ_ONLY,int64_t,1> acc(regions[0], FID_VALUE);
+  const Rect<1> rect = runtime->get_index_space_domain(ctx,
+                          task->regions[0].region.get_index_space());
+  for (PointInRectIterator<1> pir(rect); pir(); pir++)
+  {
+    const int64_t expected = (*pir)[0] + scale * ((*pir)[0] + 1);
+    if (acc[*pir] != expected)
+    {
+      log_test.error("Value at %lld is %lld but expected %lld",
+          (*pir)[0], (long long)acc[*pir], (long long)expected);
+      return false;
+    }
+  }
+  return true;
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  IndexSpaceT<1> is =
+    runtime->create_index_space(ctx, Rect<1>(0, NUM_ELEMENTS - 1));
+  FieldSpace fs = runtime->create_field_space(ctx);
+  {
+    FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+    allocator.allocate_field(sizeof(int64_t), FID_VALUE);
+  }
+  LogicalRegion lr = runtime->create_logical_region(ctx, is, fs);
+
+  {
+    TaskLauncher launcher(INIT_TASK_ID, TaskArgument());
+    launcher.add_region_requirement(
+        RegionRequirement(lr, WRITE_DISCARD, EXCLUSIVE, lr));
+    launcher.add_field(0, FID_VALUE);
+    runtime->execute_task(ctx, launcher);
+  }
+
+  bool success = true;
+  // The first round has one reduction instance that gets folded into the
+  // new instance together with the base and the second round has two
+  const int64_t scales[2][2] = { { 10, 0 }, { 100, 1000 } };
+  int64_t total = 0;
+  for (unsigned round = 0; round < 2; round++)
+  {
+    for (unsigned idx = 0; idx < 2; idx++)
+    {
+      if (scales[round][idx] == 0)
+        continue;
+      TaskLauncher launcher(REDUCE_TASK_ID,
+          TaskArgument(&scales[round][idx], sizeof(int64_t)));
+      launcher.add_region_requirement(
+          RegionRequirement(lr, LEGION_REDOP_SUM_INT64, EXCLUSIVE, lr));
+      launcher.add_field(0, FID_VALUE);
+      runtime->execute_task(ctx, launcher);
+      total += scales[round][idx];
+    }
+    TaskLauncher launcher(CHECK_TASK_ID, TaskArgument(&total, sizeof(total)));
+    launcher.add_region_requirement(
+        RegionRequirement(lr, READ_ONLY, EXCLUSIVE, lr));
+    launcher.add_field(0, FID_VALUE);
+    Future f = runtime->execute_task(ctx, launcher);
+    success = f.get_result<bool>() && success;
+  }
+
+  runtime->destroy_logical_region(ctx, lr);
+  runtime->destroy_field_space(ctx, fs);
+  runtime->destroy_index_space(ctx, is);
+  if (!success)
+  {
+    log_test.error("FAILURE!");
+    exit(1);
+  }
+  log_test.print("SUCCESS!");
+}
+
+static void create_mappers(Machine machine, Runtime *runtime,
+                           const std::set<Processor> &local_procs)
+{
+  for (std::set<Processor>::const_iterator it = local_procs.begin();
+        it != local_procs.end(); it++)
+    runtime->replace_default_mapper(
+        new FreshInstanceMapper(runtime->get_mapper_runtime(), machine, *it),
+        *it);
+}
+
+int main(int argc, char **argv)
+{
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+  {
+    TaskVariantRegistrar registrar(INIT_TASK_ID, "init");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<init_task>(registrar, "init");
+  }
+  {
+    TaskVariantRegistrar registrar(REDUCE_TASK_ID, "reduce");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<reduce_task>(registrar, "reduce");
+  }
+  {
+    TaskVariantRegistrar registrar(CHECK_TASK_ID, "check");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<bool,check_task>(registrar, "check");
+  }
+  Runtime::add_registration_callback(create_mappers);
+  return Runtime::start(argc, argv);
+}
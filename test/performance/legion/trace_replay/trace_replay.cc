@@ -0,0 +1,196 @@
+/* Copyright 2022 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Microbenchmark for the cost of replaying physical traces. Every
+// iteration launches a chain of empty index tasks over a partitioned
+// region inside the same trace so that once the template is captured
+// the time per iteration is dominated by replaying its instructions.
+// Compare runs with and without -lg:no_compiled_replay and with
+// different values of -lg:replay_parallelism. Passing -fill adds an
+// index fill before each task so that runs with -lg:subgraph_replay
+// have copies to lower onto a Realm subgraph.
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+
+#include "legion.h"
+
+#include "mappers/default_mapper.h"
+
+using namespace Legion;
+using namespace Legion::Mapping;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+  EMPTY_TASK_ID,
+};
+
+enum {
+  TRACE_ID_REPLAY = 1,
+};
+
+class TraceReplayMapper : public DefaultMapper {
+public:
+  TraceReplayMapper(MapperRuntime *rt, Machine machine, Processor local)
+    : DefaultMapper(rt, machine, local, "trace_replay_mapper") { }
+public:
+  virtual void memoize_operation(const MapperContext ctx,
+                                 const Mappable &mappable,
+                                 const MemoizeInput &input,
+                                 MemoizeOutput &output)
+  {
+    output.memoize = true;
+  }
+};
+
+static void create_mappers(Machine machine, Runtime *runtime,
+                           const std::set<Processor> &local_procs)
+{
+  for (std::set<Processor>::const_iterator it = local_procs.begin();
+        it != local_procs.end(); it++)
+    runtime->replace_default_mapper(new TraceReplayMapper(
+          runtime->get_mapper_runtime(), machine, *it), *it);
+}
+
+void empty_task(const Task *task,
+                const std::vector<PhysicalRegion> &regions,
+                Context ctx, Runtime *runtime)
+{
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  int num_iterations = 100;
+  int num_warmup = 5;
+  int num_tasks = 64;
+  int num_pieces = 4;
+  int num_fields = 4;
+  bool with_fills = false;
+  const InputArgs &command_args = Runtime::get_input_args();
+  for (int i = 1; i < command_args.argc; i++)
+  {
+    if (!strcmp(command_args.argv[i], "-i"))
+      num_iterations = atoi(command_args.argv[++i]);
+    else if (!strcmp(command_args.argv[i], "-w"))
+      num_warmup = atoi(command_args.argv[++i]);
+    else if (!strcmp(command_args.argv[i], "-t"))
+      num_tasks = atoi(command_args.argv[++i]);
+    else if (!strcmp(command_args.argv[i], "-p"))
+      num_pieces = atoi(command_args.argv[++i]);
+    else if (!strcmp(command_args.argv[i], "-f"))
+      num_fields = atoi(command_args.argv[++i]);
+    else if (!strcmp(command_args.argv[i], "-fill"))
+      with_fills = true;
+  }
+  assert(num_iterations > 0);
+  assert(num_warmup > 0);
+  assert((num_tasks > 0) && (num_pieces > 0) && (num_fields > 1));
+
+  const Rect<1> elements(0, 16 * num_pieces - 1);
+  IndexSpace is = runtime->create_index_space(ctx, elements);
+  FieldSpace fs = runtime->create_field_space(ctx);
+  {
+    FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+    for (int idx = 0; idx < num_fields; idx++)
+      allocator.allocate_field(sizeof(double), idx);
+  }
+  LogicalRegion lr = runtime->create_logical_region(ctx, is, fs);
+  const Rect<1> colors(0, num_pieces - 1);
+  IndexSpace cs = runtime->create_index_space(ctx, colors);
+  IndexPartition ip = runtime->create_equal_partition(ctx, is, cs);
+  LogicalPartition lp = runtime->get_logical_partition(ctx, lr, ip);
+
+  for (int idx = 0; idx < num_fields; idx++)
+    runtime->fill_field<double>(ctx, lr, lr, idx, 0.0);
+
+  // Each task writes one field and reads the next one so that the
+  // template has a mix of task launches and event merges to replay
+  IndexTaskLauncher launcher(EMPTY_TASK_ID, colors, TaskArgument(),
+                             ArgumentMap());
+  launcher.add_region_requirement(
+      RegionRequirement(lp, 0/*projection*/, READ_WRITE, EXCLUSIVE, lr));
+  launcher.add_region_requirement(
+      RegionRequirement(lp, 0/*projection*/, READ_ONLY, EXCLUSIVE, lr));
+  const double zero = 0.0;
+  IndexFillLauncher fill_launcher(colors, lp, lr,
+                                  UntypedBuffer(&zero, sizeof(zero)));
+  double start = 0.0;
+  for (int iter = 0; iter < (num_warmup + num_iterations); iter++)
+  {
+    if (iter == num_warmup)
+    {
+      runtime->issue_execution_fence(ctx).get_void_result();
+      start = Realm::Clock::current_time_in_microseconds();
+    }
+    runtime->begin_trace(ctx, TRACE_ID_REPLAY);
+    for (int t = 0; t < num_tasks; t++)
+    {
+      launcher.region_requirements[0].privilege_fields.clear();
+      launcher.region_requirements[0].instance_fields.clear();
+      launcher.region_requirements[0].add_field(t % num_fields);
+      launcher.region_requirements[1].privilege_fields.clear();
+      launcher.region_requirements[1].instance_fields.clear();
+      launcher.region_requirements[1].add_field((t + 1) % num_fields);
+      if (with_fills)
+      {
+        fill_launcher.fields.clear();
+        fill_launcher.add_field(t % num_fields);
+        runtime->fill_fields(ctx, fill_launcher);
+      }
+      runtime->execute_index_space(ctx, launcher);
+    }
+    runtime->end_trace(ctx, TRACE_ID_REPLAY);
+  }
+  runtime->issue_execution_fence(ctx).get_void_result();
+  const double stop = Realm::Clock::current_time_in_microseconds();
+
+  const double per_iteration = (stop - start) / num_iterations;
+  printf("Replayed %d iterations of %d index tasks over %d pieces\n",
+         num_iterations, num_tasks, num_pieces);
+  printf("  %.2f us/iteration, %.3f us/point task\n", per_iteration,
+         per_iteration / (num_tasks * num_pieces));
+
+  runtime->destroy_logical_region(ctx, lr);
+  runtime->destroy_field_space(ctx, fs);
+  runtime->destroy_index_space(ctx, cs);
+  runtime->destroy_index_space(ctx, is);
+}
+
+int main(int argc, char **argv)
+{
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_replicable();
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+
+  {
+    TaskVariantRegistrar registrar(EMPTY_TASK_ID, "empty");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<empty_task>(registrar, "empty");
+  }
+
+  Runtime::add_registration_callback(create_mappers);
+
+  return Runtime::start(argc, argv);
+}
@@ -18,6 +18,8 @@
 #include <cstdlib>
 #include <cassert>
 #include <cstring>
+#include <algorithm>
+#include <vector>
 
 #include <time.h>
 
@@ -28,6 +30,8 @@ using namespace Realm;
 #define DEFAULT_LEVELS 32 
 #define DEFAULT_TRACKS 32 
 #define DEFAULT_FANOUT 16 
+#define DEFAULT_SAMPLES 1000
+#define DEFAULT_WAITERS 4
 
 // TASK IDs
 enum {
@@ -35,6 +39,7 @@ enum {
   LEVEL_BUILDER  = Processor::TASK_ID_FIRST_AVAILABLE+1,
   SET_REMOTE_EVENT = Processor::TASK_ID_FIRST_AVAILABLE+2,
   DUMMY_TASK = Processor::TASK_ID_FIRST_AVAILABLE+3,
+  RECORD_WAKE_TASK = Processor::TASK_ID_FIRST_AVAILABLE+4,
 };
 
 struct InputArgs {
@@ -56,6 +61,13 @@ EventSet& get_event_set(void)
   return event_set;
 }
 
+// when each waiter in the latency test started running
+std::vector<long long>& get_wake_times(void)
+{
+  static std::vector<long long> wake_times;
+  return wake_times;
+}
+
 void send_level_commands(int fanout, Processor local, const EventSet &send_events, 
 			 const std::set<Processor> &all_procs, bool first)
 {
@@ -129,6 +141,8 @@ void top_level_task(const void *args, size_t arglen,
   int levels = DEFAULT_LEVELS;
   int tracks = DEFAULT_TRACKS;
   int fanout = DEFAULT_FANOUT;
+  int samples = DEFAULT_SAMPLES;
+  int waiters = DEFAULT_WAITERS;
   // Parse the input arguments
 #define INT_ARG(argname, varname) do { \
         if(!strcmp((argv)[i], argname)) {		\
@@ -149,10 +163,14 @@ void top_level_task(const void *args, size_t arglen,
       INT_ARG("-l", levels);
       INT_ARG("-t", tracks);
       INT_ARG("-f", fanout);
+      INT_ARG("-s", samples);
+      INT_ARG("-w", waiters);
     }
     assert(levels > 0);
     assert(tracks > 0);
     assert(fanout > 0);
+    assert(samples >= 0);
+    assert(waiters > 0);
   }
 #undef INT_ARG
 #undef BOOL_ARG
@@ -208,6 +226,50 @@ void top_level_task(const void *args, size_t arglen,
     fprintf(stdout,"Events throughput: %7.3f Thousands/s\n",(double(total_events)/latency));
     fprintf(stdout,"Triggers performed: %ld\n", total_triggers);
     fprintf(stdout,"Triggers throughput: %7.3f Thousands/s\n",(double(total_triggers)/latency));
+    fprintf(stdout,"Triggers per second: %.0f\n",(double(total_triggers)*1000.0/latency));
+  }
+
+  // Now measure trigger-to-wake latency: each sample triggers a user event
+  //  that 'waiters' tasks on local processors are waiting on, and records how
+  //  long it takes each of them to start running
+  if (samples > 0)
+  {
+    fprintf(stdout,"Measuring trigger-to-wake latency with %d samples and %d waiters per event...\n",samples,waiters);
+    std::vector<Processor> local_procs;
+    Machine::ProcessorQuery pq = Machine::ProcessorQuery(Machine::get_machine())
+      .same_address_space_as(p)
+      .only_kind(Processor::LOC_PROC);
+    for (Machine::ProcessorQuery::iterator it = pq.begin(); it != pq.end(); ++it)
+      local_procs.push_back(*it);
+    assert(!local_procs.empty());
+
+    std::vector<long long> &wake_times = get_wake_times();
+    wake_times.assign(size_t(samples) * waiters, 0);
+    std::vector<long long> latencies;
+    latencies.reserve(wake_times.size());
+    for (int s = 0; s < samples; s++)
+    {
+      UserEvent trigger_event = UserEvent::create_user_event();
+      std::vector<Event> done;
+      for (int w = 0; w < waiters; w++)
+      {
+        int index = s * waiters + w;
+        done.push_back(local_procs[w % local_procs.size()].spawn(RECORD_WAKE_TASK,
+                                                                  &index, sizeof(index),
+                                                                  trigger_event));
+      }
+      long long trigger_time = Realm::Clock::current_time_in_nanoseconds();
+      trigger_event.trigger();
+      Event::merge_events(done).wait();
+      for (int w = 0; w < waiters; w++)
+        latencies.push_back(wake_times[s * waiters + w] - trigger_time);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    size_t count = latencies.size();
+    fprintf(stdout,"Trigger-to-wake latency (us): p50 %7.3f  p99 %7.3f  max %7.3f\n",
+            1e-3 * latencies[count / 2],
+            1e-3 * latencies[std::min(count - 1, (count * 99) / 100)],
+            1e-3 * latencies[count - 1]);
   }
 
   fprintf(stdout,"Cleaning up...\n");
@@ -286,6 +348,15 @@ void dummy_task(const void *args, size_t arglen,
   // Do nothing
 }
 
+void record_wake_task(const void *args, size_t arglen, 
+                      const void *userdata, size_t userlen, Processor p)
+{
+  long long now = Realm::Clock::current_time_in_nanoseconds();
+  assert(arglen == sizeof(int));
+  int index = *((const int *)args);
+  get_wake_times()[index] = now;
+}
+
 
 int main(int argc, char **argv)
 {
@@ -298,6 +369,7 @@ int main(int argc, char **argv)
   r.register_task(LEVEL_BUILDER, level_builder);
   r.register_task(SET_REMOTE_EVENT, set_remote_event);
   r.register_task(DUMMY_TASK, dummy_task);
+  r.register_task(RECORD_WAKE_TASK, record_wake_task);
 
   // Set the input args
   get_input_args().argv = argv;
@@ -42,6 +42,7 @@ enum {
 // reduction op IDs
 enum {
   REDOP_BUCKET_ADD = 1,
+  REDOP_FLOAT_ADD = 2,
 };
 
 Logger log_app("appl");
@@ -100,6 +101,36 @@ struct InputArgs {
   char **argv;
 };
 
+// a reduction op that's eligible for Realm's vectorized dense kernels
+struct FloatAdd {
+  typedef float LHS;
+  typedef float RHS;
+  static constexpr ReductionKernels::DenseKind dense_kind =
+    ReductionKernels::DENSE_SUM;
+  template <bool EXCL>
+  static void apply(LHS& lhs, RHS rhs)
+  {
+    if(EXCL) {
+      lhs += rhs;
+    } else {
+      union { float f; int i; } oldval, newval;
+      do {
+        oldval.f = lhs;
+        newval.f = oldval.f + rhs;
+      } while(!__sync_bool_compare_and_swap(reinterpret_cast<int *>(&lhs),
+                                            oldval.i, newval.i));
+    }
+  }
+  static const RHS identity;
+  template <bool EXCL>
+  static void fold(RHS& rhs1, RHS rhs2)
+  {
+    apply<EXCL>(rhs1, rhs2);
+  }
+};
+
+/*static*/ const FloatAdd::RHS FloatAdd::identity = 0;
+
 typedef unsigned BucketType;
 typedef ReductionAdd<BucketType, int> BucketReduction;
 
@@ -217,6 +248,73 @@ static void run_case(const char *name, int task_id,
   printf("ELAPSED(%s) = %f\n", name, (end_time - start_time)*1e-6);
 }		     
 
+// measures the throughput of reduction copies between two dense instances
+//  (which is what MemreduceChannel's dense kernels are for) - each element
+//  reads the source and the destination and writes the destination
+static void run_redcopy_case(const char *name, Processor p, int elements,
+                             int iterations, bool fold)
+{
+  Memory m = closest_memory(p);
+  IndexSpace<1, coord_t> is = Rect<1, coord_t>(0, elements - 1);
+
+  RegionInstance src_inst, dst_inst;
+  RegionInstance::create_instance(src_inst, m, is,
+                                  std::vector<size_t>(1, sizeof(float)),
+                                  0, // SOA
+                                  ProfilingRequestSet()).wait();
+  RegionInstance::create_instance(dst_inst, m, is,
+                                  std::vector<size_t>(1, sizeof(float)),
+                                  0, // SOA
+                                  ProfilingRequestSet()).wait();
+  assert(src_inst.exists() && dst_inst.exists());
+
+  std::vector<CopySrcDstField> src(1);
+  src[0].inst = src_inst;
+  src[0].field_id = 0;
+  src[0].size = sizeof(float);
+  std::vector<CopySrcDstField> dst(1);
+  dst[0].inst = dst_inst;
+  dst[0].field_id = 0;
+  dst[0].size = sizeof(float);
+
+  float one = 1.0f;
+  Event e1 = is.fill(src, ProfilingRequestSet(), &one, sizeof(one));
+  Event e2 = is.fill(dst, ProfilingRequestSet(),
+                     &FloatAdd::identity, sizeof(FloatAdd::identity));
+  Event::merge_events(e1, e2).wait();
+
+  dst[0].set_redop(REDOP_FLOAT_ADD, fold, true /*exclusive*/);
+
+  log_app.info("starting %s reduction copies...\n", name);
+
+  double start_time = Realm::Clock::current_time_in_microseconds();
+
+  // copies are serialized - they all reduce into the same instance
+  Event e = Event::NO_EVENT;
+  for(int i = 0; i < iterations; i++)
+    e = is.copy(src, dst, ProfilingRequestSet(), e);
+  e.wait();
+
+  double end_time = Realm::Clock::current_time_in_microseconds();
+
+  double bytes = 3.0 * sizeof(float) * elements * iterations;
+  printf("ELAPSED(%s) = %f\n", name, (end_time - start_time)*1e-6);
+  printf("BANDWIDTH(%s) = %f GB/s\n", name,
+         bytes / ((end_time - start_time) * 1e3));
+
+  // every element should have had 1.0 added 'iterations' times
+  AffineAccessor<float, 1, coord_t> acc(dst_inst, 0);
+  int errors = 0;
+  for(int i = 0; i < elements; i++)
+    if(acc[i] != float(iterations))
+      errors++;
+  if(errors > 0)
+    log_app.error() << name << ": " << errors << " mismatched elements";
+
+  src_inst.destroy();
+  dst_inst.destroy();
+}
+
 void top_level_task(const void *args, size_t arglen, 
                     const void *userdata, size_t userlen, Processor p)
 {
@@ -226,6 +324,8 @@ void top_level_task(const void *args, size_t arglen,
   int seed1 = 12345;
   int seed2 = 54321;
   int do_slow = 0;
+  int redcopy_elements = 16 << 20;
+  int redcopy_iterations = 10;
 
   // Parse the input arguments
 #define INT_ARG(argname, varname) do { \
@@ -248,6 +348,8 @@ void top_level_task(const void *args, size_t arglen,
       INT_ARG("-buckets", buckets);
       INT_ARG("-batches", num_batches);
       INT_ARG("-bsize", batch_size);
+      INT_ARG("-rcsize", redcopy_elements);
+      INT_ARG("-rciters", redcopy_iterations);
     }
   }
 #undef INT_ARG
@@ -285,6 +387,13 @@ void top_level_task(const void *args, size_t arglen,
   if(do_slow)
     run_case("redsingle", HIST_BATCH_REDSINGLE_TASK, hbargs, num_batches, false);
 
+  if(redcopy_iterations > 0) {
+    run_redcopy_case("redcopy_apply", p, redcopy_elements, redcopy_iterations,
+                     false /*!fold*/);
+    run_redcopy_case("redcopy_fold", p, redcopy_elements, redcopy_iterations,
+                     true /*fold*/);
+  }
+
 #if 0
   {
     RegionInstanceAccessor<BucketType,AccessorGeneric> ria = hist_inst.get_accessor();
@@ -546,6 +655,7 @@ int main(int argc, char **argv)
   r.register_task(HIST_BATCH_REDLIST_TASK, hist_batch_redlist_task<BucketReduction>);
   r.register_task(HIST_BATCH_REDSINGLE_TASK, hist_batch_redsingle_task<BucketReduction>);
   r.register_reduction(REDOP_BUCKET_ADD, ReductionOpUntyped::create_reduction_op<BucketReduction>());
+  r.register_reduction(REDOP_FLOAT_ADD, ReductionOpUntyped::create_reduction_op<FloatAdd>());
 
   // Set the input args
   get_input_args().argv = argv;
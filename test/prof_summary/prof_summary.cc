@@ -0,0 +1,173 @@
+/* Copyright 2022 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs a known number of tasks with the summary profiling serializer
+// (-lg:serializer summary) and checks the summary written at shutdown
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "legion.h"
+
+using namespace Legion;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+  WORKER_TASK_ID,
+};
+
+#define NUM_WORKERS 16
+
+void worker_task(const Task *task,
+                 const std::vector<PhysicalRegion> &regions,
+                 Context ctx, Runtime *runtime)
+{
+  // Make sure the task is long enough to show up in the histogram
+  usleep(1000);
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  std::vector<Future> futures;
+  for (int i = 0; i < NUM_WORKERS; i++)
+  {
+    TaskLauncher launcher(WORKER_TASK_ID, TaskArgument());
+    futures.push_back(runtime->execute_task(ctx, launcher));
+  }
+  for (unsigned idx = 0; idx < futures.size(); idx++)
+    futures[idx].get_void_result();
+}
+
+// Returns true if the summary has every section and the expected number
+// of worker task executions with sensible latencies
+static bool check_summary(const char *filename)
+{
+  FILE *f = fopen(filename, "r");
+  if (f == NULL)
+  {
+    fprintf(stderr, "Unable to open profiling summary %s\n", filename);
+    return false;
+  }
+  const char *const sections[] = { "[tasks]", "[meta-tasks]",
+    "[mapper-calls]", "[runtime-calls]", "[copies]", "[fills]" };
+  const unsigned num_sections = sizeof(sections) / sizeof(sections[0]);
+  bool found_sections[num_sections];
+  for (unsigned idx = 0; idx < num_sections; idx++)
+    found_sections[idx] = false;
+  unsigned long long worker_count = 0;
+  double worker_min = 0.0, worker_max = 0.0;
+  bool in_tasks = false;
+  char line[1024];
+  while (fgets(line, sizeof(line), f) != NULL)
+  {
+    if (line[0] == '[')
+    {
+      for (unsigned idx = 0; idx < num_sections; idx++)
+        if (!strncmp(line, sections[idx], strlen(sections[idx])))
+          found_sections[idx] = true;
+      in_tasks = !strncmp(line, "[tasks]", 7);
+      continue;
+    }
+    if (!in_tasks || strncmp(line, "worker (", 8))
+      continue;
+    // There might be one line per processor so add them all up
+    const char *count = strstr(line, "count=");
+    const char *min = strstr(line, "min=");
+    const char *max = strstr(line, "max=");
+    if ((count == NULL) || (min == NULL) || (max == NULL))
+    {
+      fprintf(stderr, "Malformed summary line: %s", line);
+      fclose(f);
+      return false;
+    }
+    worker_count += strtoull(count + 6, NULL, 10);
+    const double line_min = strtod(min + 4, NULL);
+    const double line_max = strtod(max + 4, NULL);
+    if ((worker_min == 0.0) || (line_min < worker_min))
+      worker_min = line_min;
+    if (line_max > worker_max)
+      worker_max = line_max;
+  }
+  fclose(f);
+  bool success = true;
+  for (unsigned idx = 0; idx < num_sections; idx++)
+  {
+    if (found_sections[idx])
+      continue;
+    fprintf(stderr, "Missing section %s in profiling summary\n",
+            sections[idx]);
+    success = false;
+  }
+  if (worker_count != NUM_WORKERS)
+  {
+    fprintf(stderr, "Expected %d worker tasks in profiling summary "
+            "but found %llu\n", NUM_WORKERS, worker_count);
+    success = false;
+  }
+  // Latencies are in microseconds and every worker sleeps for 1ms
+  if ((worker_min < 1000.0) || (worker_max < worker_min))
+  {
+    fprintf(stderr, "Unexpected worker latencies min=%.3f max=%.3f\n",
+            worker_min, worker_max);
+    success = false;
+  }
+  return success;
+}
+
+int main(int argc, char **argv)
+{
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+  {
+    TaskVariantRegistrar registrar(WORKER_TASK_ID, "worker");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<worker_task>(registrar, "worker");
+  }
+
+  // Turn on the summary serializer in addition to any user arguments
+  char filename[64];
+  snprintf(filename, sizeof(filename), "prof_summary_%d.txt", getpid());
+  std::vector<char*> args(argv, argv + argc);
+  const char *const prof_args[] = { "-lg:prof", "1",
+    "-lg:serializer", "summary", "-lg:prof_logfile", filename };
+  for (unsigned idx = 0; idx < (sizeof(prof_args)/sizeof(char*)); idx++)
+    args.push_back(const_cast<char*>(prof_args[idx]));
+  args.push_back(NULL);
+
+  // Start returns once the runtime has shut down and written the summary
+  const int result = Runtime::start(args.size() - 1, &args[0]);
+  if (result != 0)
+    return result;
+  const bool success = check_summary(filename);
+  unlink(filename);
+  if (!success)
+  {
+    fprintf(stderr, "FAILURE!\n");
+    return 1;
+  }
+  printf("SUCCESS!\n");
+  return 0;
+}
@@ -0,0 +1,145 @@
+#include "realm.h"
+#include "realm/cmdline.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+#include "osdep.h"
+#include "philox.h"
+
+using namespace Realm;
+
+Logger log_app("app");
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+};
+
+namespace TestConfig {
+  // measures instance allocation/release throughput in a single memory with
+  //  a varying number of live instances - each point in the sweep first fills
+  //  the memory to 'live' instances and then does 'churn' random
+  //  destroy/create pairs
+  size_t min_live = 10000;
+  size_t max_live = 100000;   // use -max 1000000 for the full sweep
+  size_t churn = 20000;
+  size_t min_elmts = 4;       // instance sizes are chosen uniformly in
+  size_t max_elmts = 256;     //  [min_elmts, max_elmts] 8-byte elements
+  int random_seed = 12345;
+};
+
+typedef Philox_2x32<> PRNG;
+
+static size_t pick_size(unsigned ctr)
+{
+  return (TestConfig::min_elmts +
+	  PRNG::rand_int(TestConfig::random_seed, ctr, 0,
+			 (TestConfig::max_elmts - TestConfig::min_elmts + 1)));
+}
+
+static RegionInstance create_inst(Memory m, size_t elmts)
+{
+  std::vector<size_t> field_sizes(1, sizeof(double));
+  RegionInstance inst;
+  Event e = RegionInstance::create_instance(inst, m,
+					    Rect<1>(0, elmts - 1),
+					    field_sizes,
+					    0 /*SOA*/,
+					    ProfilingRequestSet());
+  // allocations in an otherwise-idle memory should succeed immediately
+  assert(inst.exists());
+  e.wait();
+  return inst;
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  Memory m = Machine::MemoryQuery(Machine::get_machine())
+    .only_kind(Memory::SYSTEM_MEM)
+    .has_affinity_to(p)
+    .first();
+  assert(m.exists());
+
+  log_app.print() << "alloc_perf: memory=" << m
+		  << " capacity=" << m.capacity()
+		  << " live=" << TestConfig::min_live << ".." << TestConfig::max_live
+		  << " churn=" << TestConfig::churn;
+
+  unsigned ctr = 0;
+  for(size_t live = TestConfig::min_live;
+      live <= TestConfig::max_live;
+      live *= 10) {
+    std::vector<RegionInstance> insts(live);
+
+    // fill phase
+    long long t1 = Clock::current_time_in_nanoseconds();
+    for(size_t i = 0; i < live; i++)
+      insts[i] = create_inst(m, pick_size(ctr++));
+    long long t2 = Clock::current_time_in_nanoseconds();
+
+    // churn phase - random frees leave holes of varying sizes, which is what
+    //  makes free range lookups expensive
+    for(size_t i = 0; i < TestConfig::churn; i++) {
+      size_t idx = PRNG::rand_int(TestConfig::random_seed, ctr++, 1, live);
+      insts[idx].destroy();
+      insts[idx] = create_inst(m, pick_size(ctr++));
+    }
+    long long t3 = Clock::current_time_in_nanoseconds();
+
+    // drain phase
+    for(size_t i = 0; i < live; i++)
+      insts[i].destroy();
+    long long t4 = Clock::current_time_in_nanoseconds();
+
+    log_app.print() << "live=" << live
+		    << " fill=" << (1e9 * live / (t2 - t1)) << " allocs/s"
+		    << " churn=" << (1e9 * TestConfig::churn / (t3 - t2)) << " alloc+free/s"
+		    << " drain=" << (1e9 * live / (t4 - t3)) << " frees/s";
+  }
+
+  // HACK: there's a shutdown race condition related to instance destruction
+  usleep(100000);
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  CommandLineParser cp;
+  cp.add_option_int("-min", TestConfig::min_live)
+    .add_option_int("-max", TestConfig::max_live)
+    .add_option_int("-churn", TestConfig::churn)
+    .add_option_int("-minsize", TestConfig::min_elmts)
+    .add_option_int("-maxsize", TestConfig::max_elmts)
+    .add_option_int("-seed", TestConfig::random_seed);
+  bool ok = cp.parse_command_line(argc, const_cast<const char **>(argv));
+  assert(ok);
+  assert((TestConfig::min_live > 0) &&
+	 (TestConfig::min_elmts > 0) &&
+	 (TestConfig::min_elmts <= TestConfig::max_elmts));
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+
+  Processor p = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::LOC_PROC)
+    .first();
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
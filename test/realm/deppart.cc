@@ -1076,11 +1076,17 @@ public:
     for(int i = 0; i < num_pieces; i++)
       colors[i] = i;
 
+    long long t_byfield = Clock::current_time_in_nanoseconds();
     Event e1 = is_nodes.create_subspaces_by_field(subckt_field_data,
 						  colors,
 						  p_nodes,
 						  Realm::ProfilingRequestSet());
-    if(wait_on_events) e1.wait();
+    if(wait_on_events) {
+      e1.wait();
+      log_app.print() << "byfield time: "
+		      << (1e-3 * (Clock::current_time_in_nanoseconds() - t_byfield))
+		      << " us";
+    }
 
     // now compute p_edges based on the color of their in_node (i.e. a preimage)
     Event e2 = is_edges.create_subspaces_by_preimage(in_node_field_data,
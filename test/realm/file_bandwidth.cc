@@ -0,0 +1,209 @@
+#include "realm.h"
+#include "realm/cmdline.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "osdep.h"
+
+using namespace Realm;
+
+Logger log_app("app");
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK = Processor::TASK_ID_FIRST_AVAILABLE+0,
+};
+
+enum {
+  FID_DATA = 100,
+};
+
+namespace TestConfig {
+  // measures file attach + copy + detach bandwidth in both directions - use
+  //  -ll:aio_threads/-ll:aio_depth/-ll:aio_xdreqs to compare I/O backends
+  size_t file_size = 16 << 20;
+  int num_files = 4;      // files written/read concurrently
+  int reps = 2;
+  std::string file_prefix = "file_bandwidth";
+  bool verify = true;
+  bool mmap_reads = false;  // read back through directly-mapped instances
+};
+
+typedef long long FT;
+
+static InstanceLayoutGeneric *create_layout(const Rect<1>& bounds)
+{
+  std::map<FieldID, size_t> fields;
+  fields[FID_DATA] = sizeof(FT);
+  InstanceLayoutConstraints ilc(fields, 0 /*SOA*/);
+  int dim_order[1] = { 0 };
+  return InstanceLayoutGeneric::choose_instance_layout<1,int>(bounds,
+								ilc,
+								dim_order);
+}
+
+// attaches each file, copies every source instance into (or out of) its
+//  file and then detaches, returning the elapsed time in nanoseconds
+static long long attach_copy_detach(const std::vector<std::string>& filenames,
+				    std::vector<RegionInstance>& mem_insts,
+				    const Rect<1>& bounds,
+				    bool to_file)
+{
+  long long t_start = Clock::current_time_in_nanoseconds();
+
+  std::vector<Event> done;
+  for(size_t i = 0; i < filenames.size(); i++) {
+    ExternalFileResource res(filenames[i],
+			     (to_file ? LEGION_FILE_CREATE :
+			                LEGION_FILE_READ_ONLY));
+    Memory file_mem = ((!to_file && TestConfig::mmap_reads) ?
+		         res.suggested_mapped_memory() :
+		         res.suggested_memory());
+    assert(file_mem.exists());
+    RegionInstance file_inst;
+    Event e = RegionInstance::create_external_instance(file_inst,
+						       file_mem,
+						       create_layout(bounds),
+						       res,
+						       ProfilingRequestSet());
+
+    std::vector<CopySrcDstField> srcs(1), dsts(1);
+    if(to_file) {
+      srcs[0].set_field(mem_insts[i], FID_DATA, sizeof(FT));
+      dsts[0].set_field(file_inst, FID_DATA, sizeof(FT));
+    } else {
+      srcs[0].set_field(file_inst, FID_DATA, sizeof(FT));
+      dsts[0].set_field(mem_insts[i], FID_DATA, sizeof(FT));
+    }
+    e = IndexSpace<1>(bounds).copy(srcs, dsts, ProfilingRequestSet(), e);
+
+    // detach (which also closes the file) once the copy is done
+    file_inst.destroy(e);
+    done.push_back(e);
+  }
+  Event::merge_events(done).wait();
+
+  return (Clock::current_time_in_nanoseconds() - t_start);
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  Memory m = Machine::MemoryQuery(Machine::get_machine())
+    .only_kind(Memory::SYSTEM_MEM)
+    .has_affinity_to(p)
+    .first();
+  assert(m.exists());
+
+  size_t elements = TestConfig::file_size / sizeof(FT);
+  assert(elements > 0);
+  Rect<1> bounds(0, elements - 1);
+  size_t total_bytes = elements * sizeof(FT) * TestConfig::num_files;
+
+  log_app.print() << "file_bandwidth: files=" << TestConfig::num_files
+		  << " size=" << (elements * sizeof(FT)) << " reps=" << TestConfig::reps
+		  << " mmap=" << TestConfig::mmap_reads;
+
+  std::vector<std::string> filenames;
+  std::vector<RegionInstance> src_insts, dst_insts;
+  for(int i = 0; i < TestConfig::num_files; i++) {
+    char name[256];
+    snprintf(name, sizeof(name), "%s.%d.%d.dat",
+	     TestConfig::file_prefix.c_str(), getpid(), i);
+    filenames.push_back(name);
+
+    RegionInstance src_inst, dst_inst;
+    RegionInstance::create_instance(src_inst, m, create_layout(bounds),
+				    ProfilingRequestSet()).wait();
+    RegionInstance::create_instance(dst_inst, m, create_layout(bounds),
+				    ProfilingRequestSet()).wait();
+
+    AffineAccessor<FT,1> acc(src_inst, FID_DATA);
+    for(size_t j = 0; j < elements; j++)
+      acc[Point<1>(j)] = (FT(i) << 40) + j;
+
+    src_insts.push_back(src_inst);
+    dst_insts.push_back(dst_inst);
+  }
+
+  int errors = 0;
+  for(int rep = 0; rep < TestConfig::reps; rep++) {
+    long long t_write = attach_copy_detach(filenames, src_insts,
+					   bounds, true /*to_file*/);
+    long long t_read = attach_copy_detach(filenames, dst_insts,
+					  bounds, false /*!to_file*/);
+
+    log_app.print() << "rep " << rep
+		    << ": write=" << (double(total_bytes) / t_write) << " GB/s"
+		    << " read=" << (double(total_bytes) / t_read) << " GB/s";
+
+    if(TestConfig::verify) {
+      for(int i = 0; i < TestConfig::num_files; i++) {
+	AffineAccessor<FT,1> acc(dst_insts[i], FID_DATA);
+	for(size_t j = 0; j < elements; j++) {
+	  FT exp = (FT(i) << 40) + j;
+	  if(acc[Point<1>(j)] != exp) {
+	    if(errors++ < 10)
+	      log_app.error() << "mismatch: file=" << i << " index=" << j
+			      << " exp=" << exp << " act=" << acc[Point<1>(j)];
+	    break;
+	  }
+	}
+      }
+    }
+  }
+
+  for(int i = 0; i < TestConfig::num_files; i++) {
+    src_insts[i].destroy();
+    dst_insts[i].destroy();
+    unlink(filenames[i].c_str());
+  }
+
+  if(errors > 0) {
+    log_app.fatal() << errors << " errors detected";
+    abort();
+  }
+
+  // HACK: there's a shutdown race condition related to instance destruction
+  usleep(100000);
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  CommandLineParser cp;
+  cp.add_option_int_units("-s", TestConfig::file_size, 'M')
+    .add_option_int("-n", TestConfig::num_files)
+    .add_option_int("-reps", TestConfig::reps)
+    .add_option_string("-prefix", TestConfig::file_prefix)
+    .add_option_int("-verify", TestConfig::verify)
+    .add_option_bool("-mmap", TestConfig::mmap_reads);
+  bool ok = cp.parse_command_line(argc, const_cast<const char **>(argv));
+  assert(ok);
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+
+  Processor p = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::LOC_PROC)
+    .first();
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  rt.wait_for_shutdown();
+
+  return 0;
+}
@@ -66,10 +66,47 @@ namespace TestConfig {
   int copy_fields = 1;    // number of distinct fields to copy
   size_t sparse_chunk = 0;  // if nonzero, test sparse copies with chunk size
   size_t sparse_gap = 16;   // gap between sparse chunks (if used)
+  size_t sweep_min = 1;     // if sweep_max is nonzero, time sparse copies
+  size_t sweep_max = 0;     //  with chunk sizes doubling from min to max
   bool copy_aos = false;   // if true, use an AOS memory layout
   bool slow_mems = false;  // show slow memories be tested?
 };
 
+// builds a 1-D index space made of 'chunk'-element pieces separated by
+//  'gap' elements, covering at most 'elements' elements
+static IndexSpace<1> make_sparse_space(size_t elements, size_t chunk,
+                                       size_t gap, size_t& sparse_elements)
+{
+  std::vector<Rect<1> > rects;
+  sparse_elements = 0;
+  for(size_t ofs = 0;
+      ofs <= (elements - chunk);
+      ofs += (chunk + gap)) {
+    rects.push_back(Rect<1>(ofs, ofs + chunk - 1));
+    sparse_elements += chunk;
+  }
+  return IndexSpace<1>(rects);
+}
+
+// performs a copy over 'is' and returns its duration as measured by the
+//  operation timeline
+static long long timed_copy(Processor p, IndexSpace<1> is,
+                            const std::vector<CopySrcDstField>& srcs,
+                            const std::vector<CopySrcDstField>& dsts)
+{
+  long long copy_time = -1;
+  UserEvent copy_done = UserEvent::create_user_event();
+  CopyProfResult result;
+  result.nanoseconds = &copy_time;
+  result.done = copy_done;
+  ProfilingRequestSet prs;
+  prs.add_request(p, COPYPROF_TASK, &result, sizeof(CopyProfResult))
+    .add_measurement<ProfilingMeasurements::OperationTimeline>();
+  is.copy(srcs, dsts, prs).wait();
+  copy_done.wait();
+  return copy_time;
+}
+
 void memspeed_cpu_task(const void *args, size_t arglen, 
 		       const void *userdata, size_t userlen, Processor p)
 {
@@ -316,16 +353,9 @@ void top_level_task(const void *args, size_t arglen,
     // do we need a sparse index space?
     IndexSpace<1> d_sparse;
     size_t sparse_elements = 0;
-    if(TestConfig::sparse_chunk > 0) {
-      std::vector<Rect<1> > rects;
-      for(size_t ofs = 0;
-          ofs <= (elements - TestConfig::sparse_chunk);
-          ofs += (TestConfig::sparse_chunk + TestConfig::sparse_gap)) {
-        rects.push_back(Rect<1>(ofs, ofs + TestConfig::sparse_chunk - 1));
-        sparse_elements += TestConfig::sparse_chunk;
-      }
-      d_sparse = IndexSpace<1>(rects);
-    }
+    if(TestConfig::sparse_chunk > 0)
+      d_sparse = make_sparse_space(elements, TestConfig::sparse_chunk,
+                                   TestConfig::sparse_gap, sparse_elements);
     
     for(std::vector<Memory>::const_iterator it = memories.begin();
 	it != memories.end();
@@ -466,6 +496,34 @@ void top_level_task(const void *args, size_t arglen,
           log_app.info() << "copy " << m1 << " -> " << m2 << ": bw:" << bw << " lat:" << latency << " sparse_bw:" << sparse_bw;
         }
 
+        // optional fragment size sweep - useful for tuning -ll:minxfer
+        for(size_t chunk = TestConfig::sweep_min;
+            (TestConfig::sweep_max > 0) && (chunk <= TestConfig::sweep_max) &&
+              (chunk <= elements);
+            chunk *= 2) {
+          size_t chunk_elements;
+          IndexSpace<1> d_chunks = make_sparse_space(elements, chunk,
+                                                     TestConfig::sparse_gap,
+                                                     chunk_elements);
+          long long total_chunk_copy_time = 0;
+          for(int rep = 0; rep <= TestConfig::copy_reps; rep++) {
+            long long chunk_copy_time = timed_copy(p, d_chunks, srcs, dsts);
+            if((rep > 0) || (TestConfig::copy_reps == 0))
+              total_chunk_copy_time += chunk_copy_time;
+          }
+          if(TestConfig::copy_reps > 1)
+            total_chunk_copy_time /= TestConfig::copy_reps;
+
+          double chunk_bw = (1.0 * chunk_elements * TestConfig::copy_fields * sizeof(void *) /
+                             total_chunk_copy_time);
+          log_app.info() << "sweep " << m1 << " -> " << m2
+                         << ": frag:" << (chunk * sizeof(void *))
+                         << " frags:" << (chunk_elements / chunk)
+                         << " bw:" << chunk_bw;
+
+          d_chunks.destroy();
+        }
+
 	inst2.destroy();
       }
 
@@ -491,10 +549,15 @@ int main(int argc, char **argv)
     .add_option_int("-fields", TestConfig::copy_fields)
     .add_option_int("-sparse", TestConfig::sparse_chunk)
     .add_option_int("-gap", TestConfig::sparse_gap)
+    .add_option_int("-sweep_min", TestConfig::sweep_min)
+    .add_option_int("-sweep_max", TestConfig::sweep_max)
     .add_option_int("-aos", TestConfig::copy_aos)
     .add_option_int("-slowmem", TestConfig::slow_mems);
   bool ok = cp.parse_command_line(argc, const_cast<const char **>(argv));
   assert(ok);
+  // the sweep doubles the fragment size, so it has to start at one or more
+  if(TestConfig::sweep_min == 0)
+    TestConfig::sweep_min = 1;
 
   rt.register_task(TOP_LEVEL_TASK, top_level_task);
 
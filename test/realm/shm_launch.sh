@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# Copyright 2022 Stanford University
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# launches <ranks> copies of a program connected by the shm network, e.g.:
+#   shm_launch.sh 2 ./barrier_reduce -ll:cpu 1
+# the exit status is nonzero if any rank fails
+
+if [ $# -lt 2 ]; then
+  echo "usage: $0 <ranks> <program> [args...]" >&2
+  exit 1
+fi
+
+ranks=$1
+shift
+
+REALM_SHM_RANKS=$ranks
+REALM_SHM_JOB=launch$$
+export REALM_SHM_RANKS REALM_SHM_JOB
+
+pids=""
+rank=0
+while [ $rank -lt $ranks ]; do
+  REALM_SHM_RANK=$rank "$@" &
+  pids="$pids $!"
+  rank=$((rank + 1))
+done
+
+status=0
+for pid in $pids; do
+  wait $pid || status=$?
+done
+exit $status
@@ -42,6 +42,21 @@ namespace TestConfig {
 
 const ReductionOpMixedAdd::RHS ReductionOpMixedAdd::identity = 0;
 
+// out-of-place reductions are only supported when everything is in memory
+//  the cpu can reduce in directly
+static bool is_cpu_memory(Memory m)
+{
+  switch(m.kind()) {
+  case Memory::SYSTEM_MEM:
+  case Memory::REGDMA_MEM:
+  case Memory::Z_COPY_MEM:
+  case Memory::SOCKET_MEM:
+    return true;
+  default:
+    return false;
+  }
+}
+
 template <int N, typename T>
 bool test_reduction(IndexSpace<N,T> domain, IndexSpace<N,T> bloat,
                     Memory dst_mem,
@@ -160,6 +175,34 @@ bool test_reduction(IndexSpace<N,T> domain, IndexSpace<N,T> bloat,
       }
   }
 
+  // and finally out-of-place application, using the result of the direct
+  //  application as the base and writing directly into the check instance
+  if(is_cpu_memory(dst_mem) && is_cpu_memory(chk_mem) &&
+     (ID(dst_mem).memory_owner_node() == ID(chk_mem).memory_owner_node())) {
+    for(size_t i = 0; i < src_mems.size(); i++) {
+      if(!is_cpu_memory(src_mems[i])) continue;
+
+      std::vector<CopySrcDstField> srcs(1), dsts(1);
+      srcs[0].set_field(src_insts[i], FID_INT, sizeof(int));
+      dsts[0].set_field(chk_inst, FID_DOUBLE, sizeof(double));
+      dsts[0].set_redop(REDOP_MIXED_ADD, false /*!is_fold*/, true /*exclusive*/);
+      dsts[0].set_redop_base(dst_inst, FID_DOUBLE);
+      domain.copy(srcs, dsts, ProfilingRequestSet()).wait();
+
+      AffineAccessor<double,N,T> acc(chk_inst, FID_DOUBLE);
+      for(IndexSpaceIterator<N,T> it(domain); it.valid; it.step())
+        for(PointInRectIterator<N,T> it2(it.rect); it2.valid; it2.step()) {
+          double exp = (1 + (src_mems.size() + 1) * (src_mems.size() + 1) +
+                        (2*i + 3));
+          double act = acc[it2.p];
+          if(act != exp) {
+            if(++errors < 10)
+              log_app.error() << "out-of-place mismatch: [" << it2.p << "] = " << act << " (expected " << exp << ")";
+          }
+        }
+    }
+  }
+
   chk_inst.destroy();
   dst_inst.destroy();
   for(size_t i = 0; i < src_insts.size(); i++)
@@ -38,6 +38,13 @@ namespace TestConfig {
   int random_tests = 200;
   int random_seed = 12345;
   int max_holes = 3;
+  int check_side = 16;  // checkerboard size and query count for the query
+  int check_queries = 500;  //  check that always runs (0 to skip)
+  int bench_side = 0;  // query benchmark is opt-in: checkerboard size and
+  int bench_queries = 0;  //  query count, e.g. -bench 64 -queries 100000
+  int check_scatter = 4096;  // scattered points checked in every run
+  int scatter_points = 0;  // scattered benchmark is opt-in, e.g. -scatter 65536
+  int scatter_density = 10;  // percentage of grid points present
   bool verbose = false;
 };
 
@@ -261,6 +268,261 @@ bool test_case(int seed)
   return true;
 }
 
+// a checkerboard (i.e. points whose coordinates have an even sum) cannot be
+//  merged into larger rectangles, so it makes a worst-case sparsity map for
+//  point and rectangle queries, and membership is trivial to check - the
+//  points are spread out so that they are not encoded as bitmaps
+static const int CHECKERBOARD_SPACING = 64;
+
+template <int N, typename T>
+Point<N,T> spread_out(const Point<N,T>& p)
+{
+  Point<N,T> s;
+  for(int i = 0; i < N; i++)
+    s[i] = p[i] * CHECKERBOARD_SPACING;
+  return s;
+}
+
+template <int N, typename T>
+bool in_checkerboard(const Point<N,T>& p)
+{
+  T sum = 0;
+  for(int i = 0; i < N; i++)
+    sum += p[i];
+  return ((sum % 2) == 0);
+}
+
+// checks point and rectangle queries against a linear scan of the entries
+//  and against the checkerboard itself - the checkerboard needs enough
+//  entries (i.e. more than a few dozen) for the map to build its spatial
+//  index, and the timings are only reported for the benchmark
+template <int N, typename T>
+bool check_queries(int seed, int grid_side, int num_queries, bool benchmark)
+{
+  // keep the number of points roughly the same for each dimension
+  T side = 1;
+  while(true) {
+    T vol = 1;
+    for(int i = 0; i < N; i++)
+      vol *= (side + 1);
+    if(vol > (T(grid_side) * grid_side))
+      break;
+    side++;
+  }
+
+  Rect<N,T> grid;
+  for(int i = 0; i < N; i++) {
+    grid.lo[i] = 0;
+    grid.hi[i] = side - 1;
+  }
+
+  std::vector<Point<N,T> > pts;
+  for(PointInRectIterator<N,T> it(grid); it.valid; it.step())
+    if(in_checkerboard(it.p))
+      pts.push_back(spread_out(it.p));
+  IndexSpace<N,T> is(pts, true /*disjoint*/);
+  const std::vector<SparsityMapEntry<N,T> >& entries =
+    is.sparsity.impl()->get_entries();
+
+  // generate queries (in grid coordinates) up front so that only the
+  //  lookups are timed
+  PRNG prng(seed, 3);
+  std::vector<Point<N,T> > gpts(num_queries);
+  std::vector<Rect<N,T> > grects(num_queries);
+  std::vector<Point<N,T> > qpts(num_queries);
+  std::vector<Rect<N,T> > qrects(num_queries);
+  for(int q = 0; q < num_queries; q++) {
+    for(int i = 0; i < N; i++) {
+      gpts[q][i] = prng.rand_int(side);
+      grects[q].lo[i] = prng.rand_int(side);
+      grects[q].hi[i] = grects[q].lo[i] + prng.rand_int(2);
+    }
+    qpts[q] = spread_out(gpts[q]);
+    qrects[q].lo = spread_out(grects[q].lo);
+    qrects[q].hi = spread_out(grects[q].hi);
+  }
+
+  bool ok = true;
+  size_t hits = 0;
+
+  long long t1 = Clock::current_time_in_nanoseconds();
+  for(int q = 0; q < num_queries; q++)
+    if(is.contains(qpts[q]))
+      hits++;
+  long long t2 = Clock::current_time_in_nanoseconds();
+
+  // reference: linear scan of the entry list
+  size_t scan_hits = 0;
+  for(int q = 0; q < num_queries; q++)
+    for(size_t i = 0; i < entries.size(); i++)
+      if(entries[i].bounds.contains(qpts[q])) {
+        if(!entries[i].bitmap || entries[i].bitmap->contains(qpts[q]))
+          scan_hits++;
+        break;
+      }
+  long long t3 = Clock::current_time_in_nanoseconds();
+
+  for(int q = 0; q < num_queries; q++)
+    if(is.contains(qpts[q]) != in_checkerboard(gpts[q])) {
+      log_app.error() << "contains mismatch: p=" << qpts[q] << " is=" << is;
+      ok = false;
+      break;
+    }
+  if(hits != scan_hits) {
+    log_app.error() << "contains hit mismatch: index=" << hits
+                    << " scan=" << scan_hits;
+    ok = false;
+  }
+
+  long long t4 = Clock::current_time_in_nanoseconds();
+  size_t any_hits = 0;
+  size_t all_hits = 0;
+  for(int q = 0; q < num_queries; q++) {
+    if(is.contains_any(qrects[q]))
+      any_hits++;
+    if(is.contains_all(qrects[q]))
+      all_hits++;
+  }
+  long long t5 = Clock::current_time_in_nanoseconds();
+
+  for(int q = 0; (q < num_queries) && ok; q++) {
+    // any rectangle covering more than one grid point includes gaps
+    bool exp_any = false;
+    bool exp_all = (grects[q].volume() == 1);
+    for(PointInRectIterator<N,T> it(grects[q]); it.valid; it.step()) {
+      bool inside = grid.contains(it.p) && in_checkerboard(it.p);
+      exp_any = exp_any || inside;
+      exp_all = exp_all && inside;
+    }
+    if((is.contains_any(qrects[q]) != exp_any) ||
+       (is.contains_all(qrects[q]) != exp_all)) {
+      log_app.error() << "rect query mismatch: r=" << qrects[q]
+                      << " is=" << is;
+      ok = false;
+    }
+  }
+
+  if(benchmark) {
+    double nq = num_queries;
+    log_app.print() << "query benchmark: N=" << N << " T=" << sizeof(T)
+                    << " entries=" << entries.size()
+                    << " contains=" << ((t2 - t1) / nq) << " ns"
+                    << " scan=" << ((t3 - t2) / nq) << " ns"
+                    << " contains_any+all=" << ((t5 - t4) / nq) << " ns"
+                    << " (hits=" << hits << "/" << any_hits << "/" << all_hits
+                    << ")";
+  } else if(TestConfig::verbose)
+    log_app.print() << "query check: N=" << N << " T=" << sizeof(T)
+                    << " entries=" << entries.size()
+                    << " queries=" << num_queries
+                    << " (hits=" << hits << "/" << any_hits << "/" << all_hits
+                    << ")";
+
+  is.destroy();
+  return ok;
+}
+
+// scattered points (e.g. particles) produce lots of tiny rectangles - check
+//  the space (which is where bitmap entries show up when -dp:bitmaps is
+//  enabled) and, for the benchmark, report the footprint of its sparsity map
+//  and how quickly it can be iterated over
+template <int N, typename T>
+bool check_scattered(int seed, int num_points, bool benchmark)
+{
+  size_t target = (size_t(num_points) * 100 /
+                   TestConfig::scatter_density);
+  T side = 1;
+  while(true) {
+    size_t vol = 1;
+    for(int i = 0; i < N; i++)
+      vol *= (side + 1);
+    if(vol > target)
+      break;
+    side++;
+  }
+
+  Rect<N,T> grid;
+  for(int i = 0; i < N; i++) {
+    grid.lo[i] = 0;
+    grid.hi[i] = side - 1;
+  }
+
+  PRNG prng(seed, 4);
+  std::vector<Point<N,T> > pts;
+  std::vector<bool> present;
+  for(PointInRectIterator<N,T> it(grid); it.valid; it.step()) {
+    bool p = (prng.rand_int(100) < unsigned(TestConfig::scatter_density));
+    present.push_back(p);
+    if(p)
+      pts.push_back(it.p);
+  }
+  random_permute(pts, prng);
+  IndexSpace<N,T> is(pts, true /*disjoint*/);
+
+  bool ok = true;
+  if(is.volume() != pts.size()) {
+    log_app.error() << "scattered volume mismatch: is=" << is
+                    << " expected=" << pts.size() << " actual=" << is.volume();
+    ok = false;
+  }
+  {
+    size_t idx = 0;
+    for(PointInRectIterator<N,T> it(grid); it.valid; it.step(), idx++)
+      if(is.contains(it.p) != present[idx]) {
+        log_app.error() << "scattered contains mismatch: p=" << it.p
+                        << " is=" << is;
+        ok = false;
+        break;
+      }
+  }
+
+  const std::vector<SparsityMapEntry<N,T> >& entries =
+    is.sparsity.impl()->get_entries();
+  size_t bytes = entries.size() * sizeof(SparsityMapEntry<N,T>);
+  size_t num_bitmaps = 0;
+  for(size_t i = 0; i < entries.size(); i++)
+    if(entries[i].bitmap) {
+      bytes += entries[i].bitmap->bytes_used();
+      num_bitmaps++;
+    }
+
+  const int ITER_REPS = (benchmark ? 10 : 1);
+  size_t iter_volume = 0;
+  size_t pieces = 0;
+  long long t1 = Clock::current_time_in_nanoseconds();
+  for(int rep = 0; rep < ITER_REPS; rep++)
+    for(IndexSpaceIterator<N,T> it(is); it.valid; it.step()) {
+      iter_volume += it.rect.volume();
+      pieces++;
+    }
+  long long t2 = Clock::current_time_in_nanoseconds();
+  if(iter_volume != (ITER_REPS * pts.size())) {
+    log_app.error() << "scattered iteration mismatch: is=" << is
+                    << " expected=" << (ITER_REPS * pts.size())
+                    << " actual=" << iter_volume;
+    ok = false;
+  }
+
+  if(benchmark)
+    log_app.print() << "scattered benchmark: N=" << N << " T=" << sizeof(T)
+                    << " points=" << pts.size()
+                    << " entries=" << entries.size()
+                    << " bitmaps=" << num_bitmaps
+                    << " bytes=" << bytes
+                    << " (" << (double(bytes) / pts.size()) << "/point)"
+                    << " pieces=" << (pieces / ITER_REPS)
+                    << " iteration=" << (1e3 * iter_volume / (t2 - t1))
+                    << " Mpoints/s";
+  else if(TestConfig::verbose)
+    log_app.print() << "scattered check: N=" << N << " T=" << sizeof(T)
+                    << " points=" << pts.size()
+                    << " entries=" << entries.size()
+                    << " bitmaps=" << num_bitmaps;
+
+  is.destroy();
+  return ok;
+}
+
 template <int N, typename T>
 bool test_dim_and_type(int& seed)
 {
@@ -268,6 +530,26 @@ bool test_dim_and_type(int& seed)
     if(!test_case<N,T>(seed++)) return false;
   }
 
+  if((TestConfig::check_side > 0) && (TestConfig::check_queries > 0) &&
+     !check_queries<N,T>(seed++, TestConfig::check_side,
+                         TestConfig::check_queries, false /*!benchmark*/))
+    return false;
+
+  if((TestConfig::bench_side > 0) && (TestConfig::bench_queries > 0) &&
+     !check_queries<N,T>(seed++, TestConfig::bench_side,
+                         TestConfig::bench_queries, true /*benchmark*/))
+    return false;
+
+  if((TestConfig::check_scatter > 0) &&
+     !check_scattered<N,T>(seed++, TestConfig::check_scatter,
+                           false /*!benchmark*/))
+    return false;
+
+  if((TestConfig::scatter_points > 0) &&
+     !check_scattered<N,T>(seed++, TestConfig::scatter_points,
+                           true /*benchmark*/))
+    return false;
+
   return true;
 }
 
@@ -318,6 +600,13 @@ int main(int argc, char **argv)
   cp.add_option_int("-rand", TestConfig::random_tests);
   cp.add_option_int("-seed", TestConfig::random_seed);
   cp.add_option_int("-grid", TestConfig::log2_maxgrid);
+  cp.add_option_int("-check", TestConfig::check_side);
+  cp.add_option_int("-checkqueries", TestConfig::check_queries);
+  cp.add_option_int("-bench", TestConfig::bench_side);
+  cp.add_option_int("-queries", TestConfig::bench_queries);
+  cp.add_option_int("-checkscatter", TestConfig::check_scatter);
+  cp.add_option_int("-scatter", TestConfig::scatter_points);
+  cp.add_option_int("-density", TestConfig::scatter_density);
   cp.add_option_bool("-verbose", TestConfig::verbose);
   bool ok = cp.parse_command_line(argc, const_cast<const char **>(argv));
   assert(ok);
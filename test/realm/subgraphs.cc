@@ -21,6 +21,7 @@ enum {
   WRITER_TASK,
   READER_TASK,
   CLEANUP_TASK,
+  CHAIN_TASK,
 };
 
 enum {
@@ -73,6 +74,19 @@ void writer_task(const void *args, size_t arglen,
 
 int correct = 0;
 
+// settings for the task chain latency benchmark - each chain is launched
+//  directly and as a subgraph, with and without task fusion
+int chain_length = 16;
+int chain_iters = 100;
+int chain_count = 0;
+
+void chain_task(const void *args, size_t arglen,
+		const void *userdata, size_t userlen, Processor p)
+{
+  // tasks in a chain run one after another, so no atomics needed
+  chain_count++;
+}
+
 void reader_task(const void *args, size_t arglen, 
 		 const void *userdata, size_t userlen, Processor p)
 {
@@ -388,6 +402,74 @@ void top_level_task(const void *args, size_t arglen,
     ok = false;
   }
 
+  // latency benchmark: a chain of empty tasks launched directly vs. as a
+  //  subgraph, with and without task fusion
+  if(chain_length > 0) {
+    SubgraphDefinition sd_chain;
+    sd_chain.tasks.resize(chain_length);
+    sd_chain.dependencies.resize(chain_length - 1);
+    for(int i = 0; i < chain_length; i++) {
+      sd_chain.tasks[i].proc = p;
+      sd_chain.tasks[i].task_id = CHAIN_TASK;
+      if(i > 0) {
+	sd_chain.dependencies[i - 1].src_op_kind = SubgraphDefinition::OPKIND_TASK;
+	sd_chain.dependencies[i - 1].src_op_index = i - 1;
+	sd_chain.dependencies[i - 1].tgt_op_kind = SubgraphDefinition::OPKIND_TASK;
+	sd_chain.dependencies[i - 1].tgt_op_index = i;
+      }
+    }
+
+    Subgraph sg_fused, sg_unfused;
+    sd_chain.fuse_tasks = true;
+    Event e1 = Subgraph::create_subgraph(sg_fused,
+					 sd_chain,
+					 ProfilingRequestSet());
+    sd_chain.fuse_tasks = false;
+    Event e2 = Subgraph::create_subgraph(sg_unfused,
+					 sd_chain,
+					 ProfilingRequestSet());
+    Event::merge_events(e1, e2).wait();
+
+    chain_count = 0;
+    long long t1 = Clock::current_time_in_nanoseconds();
+    e = Event::NO_EVENT;
+    for(int i = 0; i < chain_iters; i++)
+      for(int j = 0; j < chain_length; j++)
+	e = p.spawn(CHAIN_TASK, 0, 0, e);
+    e.wait();
+    long long t2 = Clock::current_time_in_nanoseconds();
+    e = Event::NO_EVENT;
+    for(int i = 0; i < chain_iters; i++)
+      e = sg_unfused.instantiate(0, 0, ProfilingRequestSet(), e);
+    e.wait();
+    long long t3 = Clock::current_time_in_nanoseconds();
+    e = Event::NO_EVENT;
+    for(int i = 0; i < chain_iters; i++)
+      e = sg_fused.instantiate(0, 0, ProfilingRequestSet(), e);
+    e.wait();
+    long long t4 = Clock::current_time_in_nanoseconds();
+
+    sg_fused.destroy();
+    sg_unfused.destroy();
+
+    double spawn_us = 1e-3 * (t2 - t1) / chain_iters;
+    double unfused_us = 1e-3 * (t3 - t2) / chain_iters;
+    double fused_us = 1e-3 * (t4 - t3) / chain_iters;
+    // fusion has no effect if it's disabled with -ll:subgraph_fuse 0
+    log_app.print() << "chain of " << chain_length << " tasks x " << chain_iters
+		    << " iterations: spawn=" << spawn_us
+		    << " us/iter, unfused subgraph=" << unfused_us
+		    << " us/iter, fused subgraph=" << fused_us
+		    << " us/iter (" << (unfused_us - fused_us)
+		    << " us/iter saved by fusion)";
+
+    if(chain_count != (3 * chain_length * chain_iters)) {
+      log_app.error() << "chain tasks: " << chain_count << " ran (expected "
+		      << (3 * chain_length * chain_iters) << ")";
+      ok = false;
+    }
+  }
+
   Runtime::get_runtime().shutdown(Event::NO_EVENT,
 				  ok ? 0 : 1);
 }
@@ -398,20 +480,23 @@ int main(int argc, char **argv)
 
   rt.init(&argc, &argv);
 
-#if 0
   for(int i = 1; i < argc; i++) {
-    if(!strcmp(argv[i], "-b")) {
-      buffer_size = strtoll(argv[++i], 0, 10);
+    if(!strcmp(argv[i], "-chain")) {
+      chain_length = strtol(argv[++i], 0, 10);
       continue;
     }
 
+    if(!strcmp(argv[i], "-iters")) {
+      chain_iters = strtol(argv[++i], 0, 10);
+      continue;
+    }
   }
-#endif
 
   rt.register_task(TOP_LEVEL_TASK, top_level_task);
   rt.register_task(WRITER_TASK, writer_task);
   rt.register_task(READER_TASK, reader_task);
   rt.register_task(CLEANUP_TASK, cleanup_task);
+  rt.register_task(CHAIN_TASK, chain_task);
 
   rt.register_reduction<ReductionOpIntAdd>(REDOP_INT_ADD);
 
@@ -0,0 +1,187 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <cstring>
+
+#include "osdep.h"
+
+#include "realm.h"
+#include "realm/cmdline.h"
+
+using namespace Realm;
+
+Logger log_app("app");
+
+// Task IDs, some IDs are reserved so start at first available number
+enum {
+  TOP_LEVEL_TASK  = Processor::TASK_ID_FIRST_AVAILABLE+0,
+  RENDEZVOUS_TASK = Processor::TASK_ID_FIRST_AVAILABLE+1,
+  HOLD_TASK       = Processor::TASK_ID_FIRST_AVAILABLE+2,
+  LOW_TASK        = Processor::TASK_ID_FIRST_AVAILABLE+3,
+  HIGH_TASK       = Processor::TASK_ID_FIRST_AVAILABLE+4,
+};
+
+namespace TestConfig {
+  int workers = 4;          // must match -ll:concurrent_io
+  int low_tasks = 8;
+  int timeout = 10;         // seconds a rendezvous task waits for the others
+};
+
+// state shared by the tasks - everything runs in a single process
+static int rendezvous_arrived = 0;
+static int rendezvous_failed = 0;
+static int run_sequence = 0;
+static int high_sequence = -1;
+static int last_low_sequence = -1;
+
+void rendezvous_task(const void *args, size_t arglen,
+		     const void *userdata, size_t userlen, Processor p)
+{
+  // every rendezvous task must be running at the same time for any of them
+  //  to finish - the ones that end up in a busy worker's deque only get to
+  //  run if an idle worker steals them
+  __sync_fetch_and_add(&rendezvous_arrived, 1);
+  double deadline = Clock::current_time() + TestConfig::timeout;
+  while(__sync_fetch_and_add(&rendezvous_arrived, 0) < TestConfig::workers) {
+    if(Clock::current_time() > deadline) {
+      __sync_fetch_and_add(&rendezvous_failed, 1);
+      return;
+    }
+    usleep(100);
+  }
+}
+
+void hold_task(const void *args, size_t arglen,
+	       const void *userdata, size_t userlen, Processor p)
+{
+  // keep the processor's only worker busy (without telling the scheduler)
+  //  while the low-priority tasks pile up in its queue
+  usleep(*(const int *)args);
+}
+
+void low_task(const void *args, size_t arglen,
+	      const void *userdata, size_t userlen, Processor p)
+{
+  int seq = __sync_fetch_and_add(&run_sequence, 1);
+  last_low_sequence = seq;
+
+  // the first one to run launches a higher-priority task, which should
+  //  preempt the batch of low-priority tasks that the worker is holding
+  if(seq == 0)
+    p.spawn(HIGH_TASK, 0, 0, Event::NO_EVENT, 1 /*priority*/);
+
+  usleep(2000);
+}
+
+void high_task(const void *args, size_t arglen,
+	       const void *userdata, size_t userlen, Processor p)
+{
+  high_sequence = __sync_fetch_and_add(&run_sequence, 1);
+}
+
+void top_level_task(const void *args, size_t arglen,
+		    const void *userdata, size_t userlen, Processor p)
+{
+  int errors = 0;
+
+  // part 1: stealing - launch exactly as many rendezvous tasks as the IO
+  //  processor has concurrent workers, all released at once
+  Processor io_proc = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::IO_PROC)
+    .local_address_space()
+    .first();
+  if(io_proc.exists()) {
+    UserEvent start = UserEvent::create_user_event();
+    std::set<Event> events;
+    for(int i = 0; i < TestConfig::workers; i++)
+      events.insert(io_proc.spawn(RENDEZVOUS_TASK, 0, 0, start));
+    start.trigger();
+    Event::merge_events(events).wait();
+
+    if(rendezvous_failed > 0) {
+      log_app.error() << "ERROR: " << rendezvous_failed << " of "
+		      << TestConfig::workers << " rendezvous tasks timed out";
+      errors++;
+    } else
+      log_app.info() << "rendezvous of " << TestConfig::workers << " tasks completed";
+  } else
+    log_app.warning() << "no IO processor - skipping stealing test (use -ll:io 1 -ll:concurrent_io "
+		      << TestConfig::workers << ")";
+
+  // part 2: preemption - a CPU processor has a single worker, so any task
+  //  it holds in its deque waits behind the high-priority task
+  Processor cpu_proc = Processor::NO_PROC;
+  {
+    Machine::ProcessorQuery pq(Machine::get_machine());
+    pq.only_kind(Processor::LOC_PROC).local_address_space();
+    for(Machine::ProcessorQuery::iterator it = pq.begin(); it != pq.end(); ++it)
+      if(*it != p) {
+	cpu_proc = *it;
+	break;
+      }
+  }
+  if(cpu_proc.exists()) {
+    int hold_us = 50000;
+    Event e = cpu_proc.spawn(HOLD_TASK, &hold_us, sizeof(hold_us));
+    std::set<Event> events;
+    events.insert(e);
+    for(int i = 0; i < TestConfig::low_tasks; i++)
+      events.insert(cpu_proc.spawn(LOW_TASK, 0, 0, Event::NO_EVENT, 0 /*priority*/));
+    Event::merge_events(events).wait();
+    // the high-priority task isn't in the merged event, so wait for it
+    while(__sync_fetch_and_add(&run_sequence, 0) < (TestConfig::low_tasks + 1))
+      usleep(1000);
+
+    if(high_sequence != 1) {
+      log_app.error() << "ERROR: high-priority task ran at position " << high_sequence
+		      << " (expected 1, last low-priority task at " << last_low_sequence << ")";
+      errors++;
+    } else
+      log_app.info() << "high-priority task preempted the low-priority tasks";
+  } else
+    log_app.warning() << "no second CPU processor - skipping preemption test (use -ll:cpu 2)";
+
+  if(errors > 0) {
+    printf("Exiting with errors\n");
+    exit(1);
+  }
+
+  printf("all tests passed\n");
+}
+
+int main(int argc, char **argv)
+{
+  Runtime rt;
+
+  rt.init(&argc, &argv);
+
+  CommandLineParser cp;
+  cp.add_option_int("-workers", TestConfig::workers)
+    .add_option_int("-low", TestConfig::low_tasks)
+    .add_option_int("-timeout", TestConfig::timeout);
+  bool ok = cp.parse_command_line(argc, const_cast<const char **>(argv));
+  assert(ok);
+
+  rt.register_task(TOP_LEVEL_TASK, top_level_task);
+  rt.register_task(RENDEZVOUS_TASK, rendezvous_task);
+  rt.register_task(HOLD_TASK, hold_task);
+  rt.register_task(LOW_TASK, low_task);
+  rt.register_task(HIGH_TASK, high_task);
+
+  // select a processor to run the top level task on
+  Processor p = Machine::ProcessorQuery(Machine::get_machine())
+    .only_kind(Processor::LOC_PROC)
+    .first();
+  assert(p.exists());
+
+  // collective launch of a single task - everybody gets the same finish event
+  Event e = rt.collective_spawn(p, TOP_LEVEL_TASK, 0, 0);
+
+  // request shutdown once that task is complete
+  rt.shutdown(e);
+
+  // now sleep this thread until that shutdown actually happens
+  int ret = rt.wait_for_shutdown();
+
+  return ret;
+}
@@ -0,0 +1,247 @@
+/* Copyright 2022 Stanford University
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs the same loop of fills, copies and tasks once inside a trace and
+// once without tracing and checks that both give the same results. The
+// trace is memoized with its copies and fills lowered onto Realm subgraphs
+// (-lg:subgraph_replay), add -lg:parallel_replay to replay it in slices.
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+
+#include "legion.h"
+
+using namespace Legion;
+
+enum TaskIDs {
+  TOP_LEVEL_TASK_ID,
+  INCREMENT_TASK_ID,
+  SCALE_TASK_ID,
+};
+
+enum FieldIDs {
+  FID_A,
+  FID_B,
+  FID_C,
+};
+
+static Logger log_test("subgraph_replay");
+
+// A += C
+void increment_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  const FieldAccessor<LEGION_READ_WRITE,long long,1> acc_a(regions[0], FID_A);
+  const FieldAccessor<LEGION_READ_ONLY,long long,1> acc_c(regions[1], FID_C);
+  Rect<1> rect = runtime->get_index_space_domain(ctx,
+                  task->regions[0].region.get_index_space());
+  for (PointInRectIterator<1> pir(rect); pir(); pir++)
+    acc_a[*pir] = acc_a[*pir] + acc_c[*pir];
+}
+
+// B = 2 * B + point
+void scale_task(const Task *task,
+                const std::vector<PhysicalRegion> &regions,
+                Context ctx, Runtime *runtime)
+{
+  const FieldAccessor<LEGION_READ_WRITE,long long,1> acc_b(regions[0], FID_B);
+  Rect<1> rect = runtime->get_index_space_domain(ctx,
+                  task->regions[0].region.get_index_space());
+  for (PointInRectIterator<1> pir(rect); pir(); pir++)
+    acc_b[*pir] = 2 * acc_b[*pir] + (*pir)[0];
+}
+
+static void run_iteration(Context ctx, Runtime *runtime, LogicalRegion lr,
+                          LogicalPartition lp, IndexSpace color_is)
+{
+  ArgumentMap arg_map;
+  // C = 1
+  {
+    const long long one = 1;
+    IndexFillLauncher launcher(color_is, lp, lr,
+        TaskArgument(&one, sizeof(one)));
+    launcher.add_field(FID_C);
+    runtime->fill_fields(ctx, launcher);
+  }
+  // A += C
+  {
+    IndexTaskLauncher launcher(INCREMENT_TASK_ID, color_is,
+                               TaskArgument(), arg_map);
+    launcher.add_region_requirement(
+        RegionRequirement(lp, 0/*projection ID*/,
+                          LEGION_READ_WRITE, LEGION_EXCLUSIVE, lr));
+    launcher.add_field(0, FID_A);
+    launcher.add_region_requirement(
+        RegionRequirement(lp, 0/*projection ID*/,
+                          LEGION_READ_ONLY, LEGION_EXCLUSIVE, lr));
+    launcher.add_field(1, FID_C);
+    runtime->execute_index_space(ctx, launcher);
+  }
+  // B = A
+  {
+    IndexCopyLauncher launcher(color_is);
+    launcher.add_copy_requirements(
+        RegionRequirement(lp, 0/*projection ID*/,
+                          LEGION_READ_ONLY, LEGION_EXCLUSIVE, lr),
+        RegionRequirement(lp, 0/*projection ID*/,
+                          LEGION_WRITE_DISCARD, LEGION_EXCLUSIVE, lr));
+    launcher.add_src_field(0, FID_A);
+    launcher.add_dst_field(0, FID_B);
+    runtime->issue_copy_operation(ctx, launcher);
+  }
+  // B = 2 * B + point
+  {
+    IndexTaskLauncher launcher(SCALE_TASK_ID, color_is,
+                               TaskArgument(), arg_map);
+    launcher.add_region_requirement(
+        RegionRequirement(lp, 0/*projection ID*/,
+                          LEGION_READ_WRITE, LEGION_EXCLUSIVE, lr));
+    launcher.add_field(0, FID_B);
+    runtime->execute_index_space(ctx, launcher);
+  }
+}
+
+void top_level_task(const Task *task,
+                    const std::vector<PhysicalRegion> &regions,
+                    Context ctx, Runtime *runtime)
+{
+  int num_elements = 64;
+  int num_pieces = 4;
+  int num_iterations = 10;
+  {
+    const InputArgs &command_args = Runtime::get_input_args();
+    for (int i = 1; i < command_args.argc; i++)
+    {
+      if (!strcmp(command_args.argv[i],"-n"))
+        num_elements = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i],"-p"))
+        num_pieces = atoi(command_args.argv[++i]);
+      if (!strcmp(command_args.argv[i],"-i"))
+        num_iterations = atoi(command_args.argv[++i]);
+    }
+  }
+
+  const Rect<1> elem_rect(0, num_elements-1);
+  IndexSpace is = runtime->create_index_space(ctx, elem_rect);
+  FieldSpace fs = runtime->create_field_space(ctx);
+  {
+    FieldAllocator allocator = runtime->create_field_allocator(ctx, fs);
+    allocator.allocate_field(sizeof(long long), FID_A);
+    allocator.allocate_field(sizeof(long long), FID_B);
+    allocator.allocate_field(sizeof(long long), FID_C);
+  }
+  const Rect<1> color_bounds(0, num_pieces-1);
+  IndexSpace color_is = runtime->create_index_space(ctx, color_bounds);
+  IndexPartition ip = runtime->create_equal_partition(ctx, is, color_is);
+
+  // One region is updated inside a trace and the other one without
+  LogicalRegion lrs[2];
+  LogicalPartition lps[2];
+  for (int r = 0; r < 2; r++)
+  {
+    lrs[r] = runtime->create_logical_region(ctx, is, fs);
+    lps[r] = runtime->get_logical_partition(ctx, lrs[r], ip);
+    const long long zero = 0;
+    runtime->fill_field(ctx, lrs[r], lrs[r], FID_A, &zero, sizeof(zero));
+    runtime->fill_field(ctx, lrs[r], lrs[r], FID_B, &zero, sizeof(zero));
+  }
+  const TraceID tid = 1;
+  for (int iter = 0; iter < num_iterations; iter++)
+  {
+    runtime->begin_trace(ctx, tid);
+    run_iteration(ctx, runtime, lrs[0], lps[0], color_is);
+    runtime->end_trace(ctx, tid);
+    run_iteration(ctx, runtime, lrs[1], lps[1], color_is);
+  }
+
+  bool success = true;
+  {
+    PhysicalRegion mapped[2];
+    for (int r = 0; r < 2; r++)
+    {
+      InlineLauncher launcher(
+          RegionRequirement(lrs[r], LEGION_READ_ONLY, LEGION_EXCLUSIVE,lrs[r]));
+      launcher.add_field(FID_A);
+      launcher.add_field(FID_B);
+      mapped[r] = runtime->map_region(ctx, launcher);
+    }
+    const FieldAccessor<LEGION_READ_ONLY,long long,1>
+      traced_a(mapped[0], FID_A), traced_b(mapped[0], FID_B),
+      untraced_a(mapped[1], FID_A), untraced_b(mapped[1], FID_B);
+    for (PointInRectIterator<1> pir(elem_rect); pir(); pir++)
+    {
+      const long long expected_a = num_iterations;
+      const long long expected_b = 2 * expected_a + (*pir)[0];
+      if ((traced_a[*pir] != untraced_a[*pir]) ||
+          (traced_b[*pir] != untraced_b[*pir]) ||
+          (untraced_a[*pir] != expected_a) ||
+          (untraced_b[*pir] != expected_b))
+      {
+        log_test.error("Element %lld: traced (%lld,%lld) untraced (%lld,%lld)"
+            " expected (%lld,%lld)", (*pir)[0], traced_a[*pir],
+            traced_b[*pir], untraced_a[*pir], untraced_b[*pir],
+            expected_a, expected_b);
+        success = false;
+      }
+    }
+    for (int r = 0; r < 2; r++)
+      runtime->unmap_region(ctx, mapped[r]);
+  }
+  if (success)
+    log_test.print("SUCCESS!");
+  else
+    log_test.error("FAILURE!");
+
+  for (int r = 0; r < 2; r++)
+    runtime->destroy_logical_region(ctx, lrs[r]);
+  runtime->destroy_field_space(ctx, fs);
+  runtime->destroy_index_space(ctx, color_is);
+  runtime->destroy_index_space(ctx, is);
+  if (!success)
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+  Runtime::set_top_level_task_id(TOP_LEVEL_TASK_ID);
+  {
+    TaskVariantRegistrar registrar(TOP_LEVEL_TASK_ID, "top_level");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    Runtime::preregister_task_variant<top_level_task>(registrar, "top_level");
+  }
+  {
+    TaskVariantRegistrar registrar(INCREMENT_TASK_ID, "increment");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<increment_task>(registrar, "increment");
+  }
+  {
+    TaskVariantRegistrar registrar(SCALE_TASK_ID, "scale");
+    registrar.add_constraint(ProcessorConstraint(Processor::LOC_PROC));
+    registrar.set_leaf();
+    Runtime::preregister_task_variant<scale_task>(registrar, "scale");
+  }
+
+  // Memoize the trace and lower its copies and fills onto subgraphs
+  std::vector<char*> args(argv, argv + argc);
+  const char *const replay_args[] = { "-dm:memoize", "-lg:subgraph_replay" };
+  for (unsigned idx = 0; idx < (sizeof(replay_args)/sizeof(char*)); idx++)
+    args.push_back(const_cast<char*>(replay_args[idx]));
+  args.push_back(NULL);
+  return Runtime::start(args.size() - 1, &args[0]);
+}
@@ -4,7 +4,7 @@ use std::io;
 use std::io::Read;
 use std::path::Path;
 
-use flate2::read::GzDecoder;
+use flate2::read::MultiGzDecoder;
 
 use nom;
 use nom::{
@@ -1005,9 +1005,18 @@ fn parse(input: &[u8]) -> IResult<&[u8], Vec<Record>> {
 }
 
 pub fn deserialize<P: AsRef<Path>>(path: P) -> io::Result<Vec<Record>> {
-    let mut gz = GzDecoder::new(File::open(path)?);
+    let mut f = File::open(path)?;
     let mut s = Vec::<u8>::new();
-    gz.read_to_end(&mut s)?;
+    f.read_to_end(&mut s)?;
+    // The runtime writes the log either uncompressed or as a sequence of
+    // independently compressed gzip members (one per flushed chunk), so
+    // check for the gzip magic and decode all of the members
+    if s.starts_with(&[0x1f, 0x8b]) {
+        let mut gz = MultiGzDecoder::new(&s[..]);
+        let mut decoded = Vec::<u8>::new();
+        gz.read_to_end(&mut decoded)?;
+        s = decoded;
+    }
     // throw error here if parse failed
     let (rest, records) = parse(&s).unwrap();
     assert_eq!(rest.len(), 0);
@@ -18,6 +18,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <type_traits>
 
 #include "../runtime/legion/bitmask.h"
 #include "../runtime/legion/legion_allocation.h"
@@ -1030,7 +1031,10 @@ void test_mask_operation(const int num_iterations, const char *mask_name)
   }
   unsigned long long total = stop - start;
   unsigned long long avg = total / num_iterations; 
-  printf("    Mask %s: %lld ns (total=%lld)\n", mask_name, avg, total);
+  const double throughput = (total > 0) ? 
+    (1e3 * num_iterations / total) : 0.0; // operations per microsecond
+  printf("    Mask %s: %lld ns (total=%lld, %.2f Mops/s)\n",
+          mask_name, avg, total, throughput);
 }
 
 template<OpKind OP>
@@ -1228,6 +1232,22 @@ void test_operation_128(const int num_iterations)
 #endif
 }
 
+#ifdef __AVX512F__
+template<int MAX, int SCALE, OpKind OP>
+void test_avx512_operation(const int num_iterations, std::true_type)
+{
+  test_mask_operation<MAX,SCALE,OP,AVX512BitMask<MAX> >(num_iterations,
+                                                        "AVX512BitMask");
+  test_mask_operation<MAX,SCALE,OP,AVX512TLBitMask<MAX> >(num_iterations,
+                                                          "AVX512TLBitMask");
+}
+
+template<int MAX, int SCALE, OpKind OP>
+void test_avx512_operation(const int /*num_iterations*/, std::false_type)
+{
+}
+#endif
+
 template<int MAX, int SCALE, OpKind OP>
 void test_operation(const int num_iterations)
 {
@@ -1243,6 +1263,10 @@ void test_operation(const int num_iterations)
 #ifdef __AVX__
   test_mask_operation<MAX,SCALE,OP,AVXBitMask<MAX> >(num_iterations, "AVXBitMask");
   test_mask_operation<MAX,SCALE,OP,AVXTLBitMask<MAX> >(num_iterations, "AVXTLBitMask");
+#endif
+#ifdef __AVX512F__
+  test_avx512_operation<MAX,SCALE,OP>(num_iterations,
+      std::integral_constant<bool,((MAX % 512) == 0)>());
 #endif
   test_mask_operation<MAX,SCALE,OP,
     CompoundBitMask<BitMask<uint64_t,MAX,6,0x3F> > >(
@@ -1392,6 +1416,101 @@ void test_perf(const int num_iterations)
   test_operation<MAX,SCALE,SRA_OP>(num_iterations);
 }
 
+#ifdef LEGION_BITMASK_DISPATCH
+void print_kernel_perf(const char *kernel, const char *level,
+                       unsigned long long total, const int num_iterations,
+                       size_t bytes_per_iteration)
+{
+  unsigned long long avg = total / num_iterations;
+  const double throughput = (total > 0) ?
+    (1e3 * num_iterations / total) : 0.0; // operations per microsecond
+  const double bandwidth = (total > 0) ?
+    (double(bytes_per_iteration) * num_iterations / total) : 0.0;
+  printf("    Kernel %s (%s): %lld ns (total=%lld, %.2f Mops/s, %.2f GB/s)\n",
+          kernel, level, avg, total, throughput, bandwidth);
+}
+
+// Measure the runtime dispatched kernels at each SIMD level that is
+// supported by this processor and check they all agree with each other
+template<int MAX>
+void test_dispatch_perf(const int num_iterations)
+{
+  const unsigned words = MAX / 64;
+  const size_t bytes = words * sizeof(uint64_t);
+  const BitMaskHelp::SIMDLevel best = BitMaskHelp::detect_simd_level();
+  printf("Running dispatch kernel perf for MAX=%d (best=%s)...\n",
+          MAX, BitMaskHelp::simd_level_name(best));
+  const size_t total_words = size_t(num_iterations) * words;
+  uint64_t *lhs = (uint64_t*)malloc(total_words * sizeof(uint64_t));
+  uint64_t *rhs = (uint64_t*)malloc(total_words * sizeof(uint64_t));
+  uint64_t *dst = (uint64_t*)malloc(total_words * sizeof(uint64_t));
+  uint64_t *expected = (uint64_t*)malloc(total_words * sizeof(uint64_t));
+  for (size_t idx = 0; idx < total_words; idx++)
+  {
+    lhs[idx] = (uint64_t(lrand48()) << 32) ^ uint64_t(lrand48());
+    rhs[idx] = (uint64_t(lrand48()) << 32) ^ uint64_t(lrand48());
+  }
+  // Touch the output pages up front so we don't time page faults
+  memset(dst, 0, total_words * sizeof(uint64_t));
+  memset(expected, 0, total_words * sizeof(uint64_t));
+  unsigned expected_count = 0;
+  for (int i = 0; i < num_iterations; i++)
+    expected_count += BitMaskHelp::pop_count_generic(lhs + i*words, words);
+  for (int level = BitMaskHelp::SIMD_GENERIC; level <= best; level++)
+  {
+    const BitMaskHelp::SIMDKernels kernels =
+      BitMaskHelp::select_simd_kernels(BitMaskHelp::SIMDLevel(level));
+    const char *name = BitMaskHelp::simd_level_name(kernels.level);
+    bool success = true;
+    // pop count
+    unsigned count = 0;
+    unsigned long long start = current_time_in_nanoseconds();
+    for (int i = 0; i < num_iterations; i++)
+      count += kernels.pop_count(lhs + i*words, words);
+    unsigned long long stop = current_time_in_nanoseconds();
+    print_kernel_perf("pop_count", name, stop - start, num_iterations, bytes);
+    if (count != expected_count)
+      success = false;
+    // intersect
+    uint64_t sum = 0;
+    start = current_time_in_nanoseconds();
+    for (int i = 0; i < num_iterations; i++)
+      sum |= kernels.intersect(dst + i*words, lhs + i*words,
+                               rhs + i*words, words);
+    stop = current_time_in_nanoseconds();
+    print_kernel_perf("intersect", name, stop - start, num_iterations, 3*bytes);
+    uint64_t expected_sum = 0;
+    for (int i = 0; i < num_iterations; i++)
+      expected_sum |= BitMaskHelp::intersect_generic(expected + i*words,
+                                  lhs + i*words, rhs + i*words, words);
+    if ((sum != expected_sum) ||
+        memcmp(dst, expected, total_words * sizeof(uint64_t)))
+      success = false;
+    // difference
+    sum = 0;
+    start = current_time_in_nanoseconds();
+    for (int i = 0; i < num_iterations; i++)
+      sum |= kernels.difference(dst + i*words, lhs + i*words,
+                                rhs + i*words, words);
+    stop = current_time_in_nanoseconds();
+    print_kernel_perf("difference", name, stop - start, num_iterations,3*bytes);
+    expected_sum = 0;
+    for (int i = 0; i < num_iterations; i++)
+      expected_sum |= BitMaskHelp::difference_generic(expected + i*words,
+                                  lhs + i*words, rhs + i*words, words);
+    if ((sum != expected_sum) ||
+        memcmp(dst, expected, total_words * sizeof(uint64_t)))
+      success = false;
+    if (!success)
+      printf("    Kernels (%s) FAILURE!\n", name);
+  }
+  free(lhs);
+  free(rhs);
+  free(dst);
+  free(expected);
+}
+#endif
+
 int main(int argc, const char **argv)
 {
   int num_iterations = 1024;
@@ -1463,6 +1582,20 @@ int main(int argc, const char **argv)
   test_mask<AVXTLBitMask<2048> >(num_iterations,"AVXTLBitMask<2048>");
 #endif
 
+#ifdef __AVX512F__
+  printf("\nAVX512BitMask Tests\n");
+  test_mask<AVX512BitMask<512> >(num_iterations,"AVX512BitMask<512>");
+  test_mask<AVX512BitMask<1024> >(num_iterations,"AVX512BitMask<1024>");
+  test_mask<AVX512BitMask<1536> >(num_iterations,"AVX512BitMask<1536>");
+  test_mask<AVX512BitMask<2048> >(num_iterations,"AVX512BitMask<2048>");
+
+  printf("\nAVX512TLBitMask Tests\n");
+  test_mask<AVX512TLBitMask<512> >(num_iterations,"AVX512TLBitMask<512>");
+  test_mask<AVX512TLBitMask<1024> >(num_iterations,"AVX512TLBitMask<1024>");
+  test_mask<AVX512TLBitMask<1536> >(num_iterations,"AVX512TLBitMask<1536>");
+  test_mask<AVX512TLBitMask<2048> >(num_iterations,"AVX512TLBitMask<2048>");
+#endif
+
   printf("\nCompoundBitMask Tests\n");
   test_mask<CompoundBitMask<BitMask<uint64_t,64,6,0x3F> > >(
                               num_iterations,"CompoundBitMask<64,2>");
@@ -1596,5 +1729,12 @@ int main(int argc, const char **argv)
 #endif
   test_perf<2048,1>(num_iterations);
 
+#ifdef LEGION_BITMASK_DISPATCH
+  test_dispatch_perf<256>(num_iterations);
+  test_dispatch_perf<512>(num_iterations);
+  test_dispatch_perf<1024>(num_iterations);
+  test_dispatch_perf<2048>(num_iterations);
+#endif
+
   return 0;
 }